@@ -0,0 +1,126 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average frame time of the forward light loop (light slots of the shader)
+ * with clustered shading for 8, 64, 512 and 4096 omnilights spread over a field of cubes.
+ *
+ * NOTE: With the forward loop, each mesh is only lit by its RLG_MAX_LIGHTS_PER_MATERIAL most
+ *       influential lights. Build with a larger value (e.g. -DRLG_MAX_LIGHTS_PER_MATERIAL=64)
+ *       to compare against a loop that evaluates more lights, as far as the driver allows it.
+ */
+
+#define RLG_MAX_LIGHTS 4096
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES        300
+#define BENCH_GRID_SIZE     16      // Number of cubes along each side of the field
+
+static void DrawScene(Model cube, Model plane)
+{
+    RLG_DrawModel(plane, Vector3Zero(), 1.0f, WHITE);
+
+    for (int z = 0; z < BENCH_GRID_SIZE; z++)
+    {
+        for (int x = 0; x < BENCH_GRID_SIZE; x++)
+        {
+            Vector3 position = {
+                (x - BENCH_GRID_SIZE/2)*4.0f + 2.0f, 0.5f,
+                (z - BENCH_GRID_SIZE/2)*4.0f + 2.0f
+            };
+
+            RLG_DrawModel(cube, position, 1.0f, WHITE);
+        }
+    }
+}
+
+static double MeasureFrameTime(Camera camera, Model cube, Model plane)
+{
+    double start = 0.0;
+
+    for (int i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; i++)
+    {
+        if (i == BENCH_WARMUP_FRAMES) start = GetTime();
+
+        BeginDrawing();
+            ClearBackground(BLACK);
+            BeginMode3D(camera);
+                DrawScene(cube, plane);
+            EndMode3D();
+        EndDrawing();
+
+        glFinish(); // Wait for the GPU so that the shading cost is measured
+    }
+
+    return 1000.0*(GetTime() - start)/BENCH_FRAMES;
+}
+
+int main(void)
+{
+    InitWindow(1280, 720, "clustered shading benchmark");
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 12.0f, 36.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    Model cube = LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+    Model plane = LoadModelFromMesh(GenMeshPlane(4.0f*BENCH_GRID_SIZE, 4.0f*BENCH_GRID_SIZE, 1, 1));
+
+    // Place all the lights once, each pass then enables the number it needs
+    SetRandomSeed(1337);
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        Vector3 position = {
+            GetRandomValue(-2000*BENCH_GRID_SIZE, 2000*BENCH_GRID_SIZE)/1000.0f,
+            GetRandomValue(200, 3000)/1000.0f,
+            GetRandomValue(-2000*BENCH_GRID_SIZE, 2000*BENCH_GRID_SIZE)/1000.0f
+        };
+
+        RLG_SetLightType(i, RLG_OMNILIGHT);
+        RLG_SetLightVec3(i, RLG_LIGHT_POSITION, position);
+        RLG_SetLightColor(i, ColorFromHSV(GetRandomValue(0, 360), 0.8f, 1.0f));
+        RLG_SetLightValue(i, RLG_LIGHT_DISTANCE, 3.0f);
+    }
+
+    const int lightCounts[] = { 8, 64, 512, 4096 };
+
+    printf("forward: %i most influential lights per mesh, clustered: all the lights\n\n", RLG_MAX_LIGHTS_PER_MATERIAL);
+    printf("%8s %14s %14s\n", "lights", "forward (ms)", "clustered (ms)");
+
+    for (int i = 0; i < (int)(sizeof(lightCounts)/sizeof(lightCounts[0])); i++)
+    {
+        for (int j = 0; j < RLG_MAX_LIGHTS; j++)
+        {
+            RLG_UseLight(j, j < lightCounts[i]);
+        }
+
+        RLG_UseClusteredShading(false);
+        double forward = MeasureFrameTime(camera, cube, plane);
+
+        RLG_UseClusteredShading(true);
+        double clustered = MeasureFrameTime(camera, cube, plane);
+
+        printf("%8i %14.3f %14.3f\n", lightCounts[i], forward, clustered);
+    }
+
+    UnloadModel(cube);
+    UnloadModel(plane);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average time of the shadow map updates and of the whole frame for 8 shadow
+ * casting omnilights over a field of stacked cubes, with the shadow maps storing hardware depth
+ * (early-Z kept) and the distance to the light written through gl_FragDepth (default).
+ *
+ * NOTE: The cubes are stacked so that each face of the lights has a lot of overdraw,
+ *       which is where the early depth test makes a difference. The lighting time is the
+ *       rest of the frame, it reads the shadow maps and barely depends on the depth format.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES        300
+#define BENCH_GRID_SIZE     16      // Number of cube columns along each side of the field
+#define BENCH_STACK_SIZE    4       // Number of cubes per column
+#define BENCH_LIGHTS        8
+
+static Model cube = { 0 };
+static Model plane = { 0 };
+
+static void DrawScene(Shader shader)
+{
+    RLG_CastModel(shader, plane, Vector3Zero(), 1.0f);
+
+    for (int z = 0; z < BENCH_GRID_SIZE; z++)
+    {
+        for (int x = 0; x < BENCH_GRID_SIZE; x++)
+        {
+            for (int y = 0; y < BENCH_STACK_SIZE; y++)
+            {
+                Vector3 position = {
+                    (x - BENCH_GRID_SIZE/2)*2.0f + 1.0f, y + 0.5f,
+                    (z - BENCH_GRID_SIZE/2)*2.0f + 1.0f
+                };
+
+                RLG_CastModel(shader, cube, position, 1.0f);
+            }
+        }
+    }
+}
+
+static void DrawFrame(void)
+{
+    RLG_DrawModel(plane, Vector3Zero(), 1.0f, WHITE);
+
+    for (int z = 0; z < BENCH_GRID_SIZE; z++)
+    {
+        for (int x = 0; x < BENCH_GRID_SIZE; x++)
+        {
+            for (int y = 0; y < BENCH_STACK_SIZE; y++)
+            {
+                Vector3 position = {
+                    (x - BENCH_GRID_SIZE/2)*2.0f + 1.0f, y + 0.5f,
+                    (z - BENCH_GRID_SIZE/2)*2.0f + 1.0f
+                };
+
+                RLG_DrawModel(cube, position, 1.0f, WHITE);
+            }
+        }
+    }
+}
+
+static double MeasureFrameTime(Camera camera, double *shadowTime)
+{
+    double start = 0.0;
+    *shadowTime = 0.0;
+
+    for (int i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; i++)
+    {
+        if (i == BENCH_WARMUP_FRAMES) start = GetTime();
+
+        double shadowStart = GetTime();
+
+        for (int j = 0; j < BENCH_LIGHTS; j++)
+        {
+            RLG_UpdateShadowMap(j, DrawScene);
+        }
+
+        glFinish(); // Wait for the GPU so that the cost of the depth passes is measured
+
+        if (i >= BENCH_WARMUP_FRAMES) *shadowTime += GetTime() - shadowStart;
+
+        BeginDrawing();
+            ClearBackground(BLACK);
+            BeginMode3D(camera);
+                DrawFrame();
+            EndMode3D();
+        EndDrawing();
+
+        glFinish();
+    }
+
+    *shadowTime = 1000.0*(*shadowTime)/BENCH_FRAMES;
+
+    return 1000.0*(GetTime() - start)/BENCH_FRAMES;
+}
+
+int main(void)
+{
+    InitWindow(1280, 720, "omnilight shadows benchmark");
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 12.0f, 24.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    cube = LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+    plane = LoadModelFromMesh(GenMeshPlane(2.0f*BENCH_GRID_SIZE, 2.0f*BENCH_GRID_SIZE, 1, 1));
+
+    // Spread the lights in the alleys between the cube columns
+    SetRandomSeed(1337);
+
+    for (int i = 0; i < BENCH_LIGHTS; i++)
+    {
+        Vector3 position = {
+            2.0f*GetRandomValue(-BENCH_GRID_SIZE/2 + 1, BENCH_GRID_SIZE/2 - 1), 2.0f,
+            2.0f*GetRandomValue(-BENCH_GRID_SIZE/2 + 1, BENCH_GRID_SIZE/2 - 1)
+        };
+
+        RLG_UseLight(i, true);
+        RLG_SetLightType(i, RLG_OMNILIGHT);
+        RLG_SetLightVec3(i, RLG_LIGHT_POSITION, position);
+        RLG_SetLightColor(i, ColorFromHSV(360.0f*i/BENCH_LIGHTS, 0.8f, 1.0f));
+        RLG_SetLightValue(i, RLG_LIGHT_DISTANCE, 2.0f*BENCH_GRID_SIZE);
+        RLG_EnableShadow(i, 512);
+    }
+
+    const char *names[] = { "hardware", "linear" };
+
+    printf("%-10s %12s %14s %12s\n", "depth", "shadow (ms)", "lighting (ms)", "frame (ms)");
+
+    for (int i = 0; i < 2; i++)
+    {
+        RLG_UseLinearOmniShadows(i == 1);
+
+        double shadow = 0.0;
+        double frame = MeasureFrameTime(camera, &shadow);
+
+        printf("%-10s %12.3f %14.3f %12.3f\n", names[i], shadow, frame - shadow, frame);
+    }
+
+    UnloadModel(cube);
+    UnloadModel(plane);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average frame time and the binds per frame of a scene of 10k draws (4 meshes,
+ * 8 textured materials) submitted in a shuffled order, drawn with RLG_DrawMesh() in that order,
+ * with RLG_DrawMesh() in that order inside a batch, and through the sorted draw queue.
+ *
+ * NOTE: The queue time includes the computation and the sort of the keys on the CPU.
+ *       The submission time is spent in the draw calls before waiting for the GPU, with a
+ *       software rasterizer it also includes most of the rendering.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES        300
+#define BENCH_DRAWS         10000
+#define BENCH_MESHES        4
+#define BENCH_MATERIALS     8
+
+typedef enum {
+    BENCH_IMMEDIATE,
+    BENCH_BATCH,
+    BENCH_QUEUE
+} BenchMode;
+
+typedef struct {
+    int mesh;
+    int material;
+    Matrix transform;
+} Draw;
+
+static Mesh meshes[BENCH_MESHES];
+static Material materials[BENCH_MATERIALS];
+static Draw draws[BENCH_DRAWS];
+
+static void DrawScene(BenchMode mode)
+{
+    if (mode == BENCH_BATCH) RLG_BeginBatch();
+    if (mode == BENCH_QUEUE) RLG_BeginQueue();
+
+    for (int i = 0; i < BENCH_DRAWS; i++)
+    {
+        const Draw *draw = &draws[i];
+
+        if (mode == BENCH_QUEUE) RLG_Submit(meshes[draw->mesh], materials[draw->material], draw->transform);
+        else RLG_DrawMesh(meshes[draw->mesh], materials[draw->material], draw->transform);
+    }
+
+    if (mode == BENCH_BATCH) RLG_EndBatch();
+    if (mode == BENCH_QUEUE) RLG_FlushQueue();
+}
+
+static double MeasureFrameTime(Camera camera, BenchMode mode, RLG_Stats *stats, double *submit)
+{
+    double start = 0.0;
+    double submitStart = 0.0;
+
+    *submit = 0.0;
+
+    for (int i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; i++)
+    {
+        if (i == BENCH_WARMUP_FRAMES) start = GetTime();
+
+        RLG_ResetStats();
+
+        BeginDrawing();
+            ClearBackground(BLACK);
+            BeginMode3D(camera);
+                submitStart = GetTime();
+                DrawScene(mode);
+                if (i >= BENCH_WARMUP_FRAMES) *submit += GetTime() - submitStart;
+            EndMode3D();
+        EndDrawing();
+
+        glFinish(); // Wait for the GPU so that the cost of the state changes is measured
+    }
+
+    *stats = RLG_GetStats();
+    *submit = 1000.0*(*submit)/BENCH_FRAMES;
+
+    return 1000.0*(GetTime() - start)/BENCH_FRAMES;
+}
+
+int main(void)
+{
+    InitWindow(1280, 720, "draw queue benchmark");
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 30.0f, 60.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    RLG_UseLight(0, true);
+    RLG_SetLightType(0, RLG_DIRLIGHT);
+    RLG_SetLightXYZ(0, RLG_LIGHT_DIRECTION, -1.0f, -1.0f, -1.0f);
+
+    meshes[0] = GenMeshCube(1.0f, 1.0f, 1.0f);
+    meshes[1] = GenMeshSphere(0.5f, 16, 16);
+    meshes[2] = GenMeshCylinder(0.5f, 1.0f, 16);
+    meshes[3] = GenMeshTorus(0.25f, 1.0f, 16, 16);
+
+    for (int i = 0; i < BENCH_MATERIALS; i++)
+    {
+        Color color = ColorFromHSV(360.0f*i/BENCH_MATERIALS, 0.8f, 1.0f);
+        Image image = GenImageChecked(64, 64, 8, 8, color, WHITE);
+
+        materials[i] = LoadMaterialDefault();
+        materials[i].maps[MATERIAL_MAP_ALBEDO].texture = LoadTextureFromImage(image);
+
+        UnloadImage(image);
+    }
+
+    // Place the draws on a grid, then shuffle them as game logic would submit them
+    SetRandomSeed(1337);
+
+    for (int i = 0; i < BENCH_DRAWS; i++)
+    {
+        float x = (i%100 - 50)*1.5f;
+        float z = (i/100 - 50)*1.5f;
+
+        draws[i].mesh = GetRandomValue(0, BENCH_MESHES - 1);
+        draws[i].material = GetRandomValue(0, BENCH_MATERIALS - 1);
+        draws[i].transform = MatrixTranslate(x, 0.5f, z);
+    }
+
+    for (int i = BENCH_DRAWS - 1; i > 0; i--)
+    {
+        int j = GetRandomValue(0, i);
+        Draw draw = draws[i];
+        draws[i] = draws[j];
+        draws[j] = draw;
+    }
+
+    const char *names[] = { "immediate", "batch", "queue" };
+
+    printf("%-10s %10s %12s %12s %14s %14s\n", "mode", "time (ms)", "submit (ms)", "shader binds", "texture binds", "vao binds");
+
+    for (int i = BENCH_IMMEDIATE; i <= BENCH_QUEUE; i++)
+    {
+        RLG_Stats stats = { 0 };
+        double submit = 0.0;
+        double time = MeasureFrameTime(camera, (BenchMode)i, &stats, &submit);
+
+        printf("%-10s %10.3f %12.3f %12u %14u %14u\n", names[i], time, submit,
+            stats.shaderBinds, stats.textureBinds, stats.vertexArrayBinds);
+    }
+
+    for (int i = 0; i < BENCH_MESHES; i++) UnloadMesh(meshes[i]);
+    for (int i = 0; i < BENCH_MATERIALS; i++) UnloadMaterial(materials[i]);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "raylib.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average time taken to load a skybox from its HDR panorama (decoding, cubemap
+ * conversion, irradiance and prefiltered convolutions), with the cubemap conversion done by a
+ * shader or on the CPU, with the time taken to load the same skybox from the bake file written
+ * by RLG_SaveSkyboxBake.
+ *
+ * NOTE: glFinish() is called before measuring, the drivers can defer the rendering
+ *       of the convolutions until the textures are used.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_ROUNDS        5
+#define BENCH_SKYBOX_SIZE   1024
+#define BENCH_BAKE_FILE     "skybox.rlgs"
+
+typedef enum {
+    BENCH_PANORAMA_GPU,
+    BENCH_PANORAMA_CPU,
+    BENCH_BAKE
+} BenchMode;
+
+static double MeasureLoad(BenchMode mode)
+{
+    RLG_UseSkyboxCPUConversion(mode == BENCH_PANORAMA_CPU);
+
+    double start = GetTime();
+
+    RLG_Skybox skybox = (mode == BENCH_BAKE)
+        ? RLG_LoadSkyboxBake(BENCH_BAKE_FILE)
+        : RLG_LoadSkyboxHDR("resources/skybox.hdr", BENCH_SKYBOX_SIZE, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+
+    glFinish();
+
+    double time = 1000.0*(GetTime() - start);
+
+    RLG_UnloadSkybox(skybox);
+
+    return time;
+}
+
+int main(void)
+{
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(320, 180, "skybox loading benchmark");
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    // Write the bake file once, from the textures generated from the panorama
+    RLG_Skybox skybox = RLG_LoadSkyboxHDR("resources/skybox.hdr", BENCH_SKYBOX_SIZE, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+
+    if (!RLG_SaveSkyboxBake(skybox, BENCH_BAKE_FILE))
+    {
+        printf("Failed to write the bake file\n");
+    }
+
+    RLG_UnloadSkybox(skybox);
+
+    const char *names[] = { "panorama (gpu)", "panorama (cpu)", "bake" };
+    double times[3] = { 0 };
+
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+    {
+        for (int j = BENCH_PANORAMA_GPU; j <= BENCH_BAKE; j++) times[j] += MeasureLoad((BenchMode)j);
+    }
+
+    remove(BENCH_BAKE_FILE);
+
+    printf("%-16s %12s\n", "source", "time (ms)");
+
+    for (int i = BENCH_PANORAMA_GPU; i <= BENCH_BAKE; i++)
+    {
+        printf("%-16s %12.3f\n", names[i], times[i]/BENCH_ROUNDS);
+    }
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "raylib.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average frame time of a scene covering most of the screen with a skybox drawn
+ * first as a cube (default, every pixel of the sky shaded) and drawn after the opaque geometry
+ * as a fullscreen triangle tested against the depth (RLG_UseSkyboxDepthTest).
+ *
+ * NOTE: The skybox shader is cheap, the difference grows with the resolution
+ *       and the fill rate of the GPU, the window is therefore large.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES        600
+#define BENCH_GRID_SIZE     24
+
+static Model cube = { 0 };
+static RLG_Skybox skybox = { 0 };
+
+static void DrawScene(void)
+{
+    for (int y = 0; y < BENCH_GRID_SIZE; y++)
+    {
+        for (int x = 0; x < BENCH_GRID_SIZE; x++)
+        {
+            Vector3 position = { x - BENCH_GRID_SIZE/2 + 0.5f, y - BENCH_GRID_SIZE/2 + 0.5f, 0.0f };
+            RLG_DrawModel(cube, position, 0.9f, WHITE);
+        }
+    }
+}
+
+static double MeasureFrameTime(Camera camera, bool depthTest)
+{
+    double start = 0.0;
+
+    RLG_UseSkyboxDepthTest(depthTest);
+
+    for (int i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; i++)
+    {
+        if (i == BENCH_WARMUP_FRAMES) start = GetTime();
+
+        BeginDrawing();
+            ClearBackground(BLACK);
+            BeginMode3D(camera);
+                if (!depthTest) RLG_DrawSkybox(skybox);
+                DrawScene();
+                if (depthTest) RLG_DrawSkybox(skybox);
+            EndMode3D();
+        EndDrawing();
+
+        glFinish(); // Wait for the GPU so that the cost of the shaded pixels is measured
+    }
+
+    return 1000.0*(GetTime() - start)/BENCH_FRAMES;
+}
+
+int main(void)
+{
+    InitWindow(1920, 1080, "skybox pass benchmark");
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 0.0f, 20.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    RLG_SetViewPositionV(camera.position);
+
+    RLG_UseLight(0, true);
+    RLG_SetLightType(0, RLG_DIRLIGHT);
+    RLG_SetLightXYZ(0, RLG_LIGHT_DIRECTION, -1.0f, -1.0f, -1.0f);
+
+    cube = LoadModelFromMesh(GenMeshCube(1.0f, 1.0f, 1.0f));
+    skybox = RLG_LoadSkybox("resources/skybox.png");
+
+    const char *names[] = { "first", "last" };
+
+    printf("%-10s %12s\n", "skybox", "frame (ms)");
+
+    for (int i = 0; i < 2; i++)
+    {
+        printf("%-10s %12.3f\n", names[i], MeasureFrameTime(camera, i == 1));
+    }
+
+    UnloadModel(cube);
+    RLG_UnloadSkybox(skybox);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "raylib.h"
+
+#include <stdio.h>
+
+/*
+ * Compares the average and the worst frame time of a scene whose skybox is regenerated from a
+ * dynamic sky cubemap every BENCH_UPDATE_PERIOD frames, by loading the skybox again in one frame,
+ * and with RLG_UpdateSkybox spreading the passes over the frames with a few budgets.
+ *
+ * NOTE: The sky cubemap is the one of a skybox loaded from the panorama, only its textures
+ *       are regenerated, the benchmark measures the cost of the convolutions.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_WARMUP_FRAMES 30
+#define BENCH_FRAMES        600
+#define BENCH_UPDATE_PERIOD 60
+#define BENCH_SKYBOX_SIZE   1024
+
+static RLG_Skybox sky = { 0 };
+static RLG_Skybox skybox = { 0 };
+
+static double MeasureFrameTime(Camera camera, int budget, double *worst)
+{
+    double total = 0.0;
+    *worst = 0.0;
+
+    for (int i = 0; i < BENCH_WARMUP_FRAMES + BENCH_FRAMES; i++)
+    {
+        double start = GetTime();
+
+        if (budget == 0)
+        {
+            // Reload the whole skybox in one frame, as done without incremental updates
+            if (i%BENCH_UPDATE_PERIOD == 0)
+            {
+                RLG_UnloadSkybox(skybox);
+                skybox = RLG_LoadSkyboxHDR("resources/skybox.hdr", BENCH_SKYBOX_SIZE, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+            }
+        }
+        else
+        {
+            RLG_UpdateSkybox(&skybox, sky.cubemap, budget);
+        }
+
+        BeginDrawing();
+            ClearBackground(BLACK);
+            BeginMode3D(camera);
+                RLG_DrawSkybox(skybox);
+            EndMode3D();
+        EndDrawing();
+
+        glFinish(); // Wait for the GPU so that the cost of the passes is measured in their frame
+
+        double time = 1000.0*(GetTime() - start);
+
+        if (i >= BENCH_WARMUP_FRAMES)
+        {
+            total += time;
+            if (time > *worst) *worst = time;
+        }
+    }
+
+    return total/BENCH_FRAMES;
+}
+
+int main(void)
+{
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(1280, 720, "skybox update benchmark");
+
+    Camera camera = { 0 };
+    camera.position = (Vector3){ 0.0f, 0.0f, 0.0f };
+    camera.target = (Vector3){ 0.0f, 0.0f, 1.0f };
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 60.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    sky = RLG_LoadSkyboxHDR("resources/skybox.hdr", BENCH_SKYBOX_SIZE, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+    skybox = RLG_LoadSkyboxHDR("resources/skybox.hdr", BENCH_SKYBOX_SIZE, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+
+    const int budgets[] = { 0, 1, 2, 4 };
+
+    printf("%-10s %12s %12s\n", "budget", "avg (ms)", "worst (ms)");
+
+    for (int i = 0; i < (int)(sizeof(budgets)/sizeof(budgets[0])); i++)
+    {
+        double worst = 0.0;
+        double average = MeasureFrameTime(camera, budgets[i], &worst);
+
+        if (budgets[i] == 0) printf("%-10s %12.3f %12.3f\n", "reload", average, worst);
+        else printf("%-10i %12.3f %12.3f\n", budgets[i], average, worst);
+    }
+
+    RLG_UnloadSkybox(sky);
+    RLG_UnloadSkybox(skybox);
+
+    RLG_DestroyContext(rlgCtx);
+    CloseWindow();
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "raylib.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#   include <direct.h>
+#   define MAKE_DIRECTORY(path) _mkdir(path)
+#else
+#   include <sys/stat.h>
+#   define MAKE_DIRECTORY(path) mkdir(path, 0755)
+#endif
+
+/*
+ * Compares the time taken by RLG_CreateContext, followed by the loading of a few model
+ * shader permutations, without program binary cache, with an empty cache (cold startup,
+ * the programs are compiled then saved) and with a filled cache (warm startup).
+ *
+ * Also measures RLG_CreateContextAsync without cache (context shaders only, no permutations):
+ * the time before it returns, during which a loading screen is blocked, and the time before
+ * RLG_IsContextReady returns true.
+ *
+ * NOTE: Most drivers also keep their own cache of compiled shaders, disable it to measure
+ *       a real cold startup (e.g. MESA_SHADER_CACHE_DISABLE=true, __GL_SHADER_DISK_CACHE=0).
+ *       Mesa then exposes no program binary format, the cold and warm startups do not use
+ *       the cache either, start with an empty MESA_SHADER_CACHE_DIR to measure them.
+ */
+
+#define RLIGHTS_IMPLEMENTATION
+#include "../rlights.h"
+
+#define BENCH_CACHE_DIRECTORY   "shader_cache"
+#define BENCH_ROUNDS            5
+
+static const unsigned int permutations[] = {
+    RLG_USE_ALBEDO_MAP,
+    RLG_USE_ALBEDO_MAP | RLG_RECEIVE_SHADOW,
+    RLG_USE_ALBEDO_MAP | RLG_USE_NORMAL_MAP,
+    RLG_USE_ALBEDO_MAP | RLG_USE_NORMAL_MAP | RLG_RECEIVE_SHADOW,
+    RLG_USE_ALBEDO_MAP | RLG_USE_NORMAL_MAP | RLG_USE_METALNESS_MAP | RLG_USE_ROUGHNESS_MAP | RLG_USE_OCCLUSION_MAP,
+    RLG_USE_ALBEDO_MAP | RLG_USE_NORMAL_MAP | RLG_USE_HEIGHT_MAP | RLG_USE_DEEP_PARALLAX,
+    RLG_USE_ALBEDO_MAP | RLG_USE_CUBEMAP | RLG_USE_IRRADIANCE_MAP,
+    RLG_USE_ALBEDO_MAP | RLG_USE_EMISSION_MAP
+};
+
+static void ClearCache(void)
+{
+    FilePathList files = LoadDirectoryFilesEx(BENCH_CACHE_DIRECTORY, ".bin", false);
+
+    for (unsigned int i = 0; i < files.count; i++)
+    {
+        remove(files.paths[i]);
+    }
+
+    UnloadDirectoryFiles(files);
+}
+
+static double MeasureStartup(void)
+{
+    double start = GetTime();
+
+    RLG_Context rlgCtx = RLG_CreateContext();
+    RLG_SetContext(rlgCtx);
+
+    for (int i = 0; i < (int)(sizeof(permutations)/sizeof(permutations[0])); i++)
+    {
+        RLG_GetShaderPermutation(permutations[i]);
+    }
+
+    glFinish(); // Wait for the driver in case it compiles in the background
+
+    double time = 1000.0*(GetTime() - start);
+
+    RLG_DestroyContext(rlgCtx);
+    RLG_SetContext(NULL);
+
+    return time;
+}
+
+static double MeasureAsyncStartup(double *submit)
+{
+    double start = GetTime();
+
+    RLG_Context rlgCtx = RLG_CreateContextAsync();
+    RLG_SetContext(rlgCtx);
+
+    *submit += 1000.0*(GetTime() - start);
+
+    while (!RLG_IsContextReady()) { }
+
+    double time = 1000.0*(GetTime() - start);
+
+    RLG_DestroyContext(rlgCtx);
+    RLG_SetContext(NULL);
+
+    return time;
+}
+
+int main(void)
+{
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(320, 180, "startup benchmark");
+
+    MAKE_DIRECTORY(BENCH_CACHE_DIRECTORY);
+
+    double uncached = 0.0, cold = 0.0, warm = 0.0;
+    double asyncSubmit = 0.0, asyncReady = 0.0;
+
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+    {
+        RLG_SetShaderCacheDirectory(NULL);
+        uncached += MeasureStartup();
+        asyncReady += MeasureAsyncStartup(&asyncSubmit);
+
+        RLG_SetShaderCacheDirectory(BENCH_CACHE_DIRECTORY);
+
+        ClearCache();
+        cold += MeasureStartup();
+
+        warm += MeasureStartup();
+    }
+
+    ClearCache();
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    if (formatCount == 0) printf("NOTE: No program binary format supported, the cache is not used\n\n");
+
+    printf("%-16s %12s\n", "startup", "time (ms)");
+    printf("%-16s %12.3f\n", "no cache", uncached/BENCH_ROUNDS);
+    printf("%-16s %12.3f\n", "cold cache", cold/BENCH_ROUNDS);
+    printf("%-16s %12.3f\n", "warm cache", warm/BENCH_ROUNDS);
+    printf("%-16s %12.3f\n", "async (submit)", asyncSubmit/BENCH_ROUNDS);
+    printf("%-16s %12.3f\n", "async (ready)", asyncReady/BENCH_ROUNDS);
+
+    CloseWindow();
+
+    return 0;
+}
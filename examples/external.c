@@ -1,30 +1,9 @@
 #include "raylib.h"
 #include "raymath.h"
 
-#include <stdio.h>
-#include <string.h>
-
 #define RLIGHTS_IMPLEMENTATION
 #include "../rlights.h"
 
-static void LoadShaderCode(int lightCount, char** lightVS, char** lightFS)
-{
-    char *tempVS = LoadFileText("../shaders/glsl330/model.vs");
-    char *tempFS = LoadFileText("../shaders/glsl330/model.fs");
-
-    unsigned int lenVS = strlen(tempVS);
-    unsigned int lenFS = strlen(tempFS);
-
-    *lightVS = malloc(lenVS + 1);
-    *lightFS = malloc(lenFS + 1);
-
-    sprintf(*lightVS, tempVS, lightCount);
-    sprintf(*lightFS, tempFS, lightCount);
-
-    free(tempVS);
-    free(tempFS);
-}
-
 int main(void)
 {
     InitWindow(800, 600, "external shader");
@@ -36,10 +15,11 @@ int main(void)
         .fovy = 45.0f
     };
 
-    char *lightVS, *lightFS;
-    const int lightCount = 1;
+    // NOTE: The code is kept until the context is destroyed, rlights.h adds the '#version'
+    //       directive and the 'NUM_LIGHTS' definition when it compiles the permutations
+    char *lightVS = LoadFileText("../shaders/glsl330/model.vs");
+    char *lightFS = LoadFileText("../shaders/glsl330/model.fs");
 
-    LoadShaderCode(lightCount, &lightVS, &lightFS);
     RLG_SetCustomShaderCode(RLG_SHADER_MODEL, lightVS, lightFS);
 
     RLG_Context rlgCtx = RLG_CreateContext();
@@ -75,8 +55,8 @@ int main(void)
     RLG_DestroyContext(rlgCtx);
     CloseWindow();
 
-    free(lightVS);
-    free(lightFS);
+    UnloadFileText(lightVS);
+    UnloadFileText(lightFS);
 
     return 0;
 }
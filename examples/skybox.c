@@ -23,6 +23,11 @@ int main(void)
 
     RLG_UseMap(MATERIAL_MAP_CUBEMAP, true);
     RLG_UseMap(MATERIAL_MAP_IRRADIANCE, true);
+    RLG_UseMap(MATERIAL_MAP_PREFILTER, true);
+    RLG_UseMap(MATERIAL_MAP_BRDF, true);
+
+    // The skybox is drawn after the spheres, only on the pixels they leave uncovered
+    RLG_UseSkyboxDepthTest(true);
 
     RLG_UseLight(0, true);
     RLG_SetLightType(0, RLG_OMNILIGHT);
@@ -35,6 +40,8 @@ int main(void)
     Model sphere = LoadModelFromMesh(GenMeshSphere(1.0f, 32, 64));
     sphere.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = skybox.cubemap;
     sphere.materials[0].maps[MATERIAL_MAP_IRRADIANCE].texture = skybox.irradiance;
+    sphere.materials[0].maps[MATERIAL_MAP_PREFILTER].texture = skybox.prefilter;
+    sphere.materials[0].maps[MATERIAL_MAP_BRDF].texture = skybox.brdf;
 
     DisableCursor();
 
@@ -55,8 +62,6 @@ int main(void)
 
             BeginMode3D(camera);
 
-                RLG_DrawSkybox(skybox);
-
                 for (int x = -5; x <= 5; x += 2)
                 {
                     for (int y = -5; y <= 5; y += 2)
@@ -67,6 +72,8 @@ int main(void)
                     }
                 }
 
+                RLG_DrawSkybox(skybox);
+
             EndMode3D();
 
         EndDrawing();
@@ -3,31 +3,52 @@
 
 #include <raylib.h>
 
-/*
- * TODO: Implement `RLG_MAX_LIGHTS`, which would be a separate array containing all user-defined lights.
- *       Then, during the rendering of a mesh, we will perform an AABB test to determine which light illuminates which mesh,
- *       with a limit per shader defined by `RLG_MAX_LIGHTS_PER_MATERIAL`.
- *
- *       However, this would require a separate RLG_Model and/or RLG_Mesh struct...
- *
- *       With this, we would need to create a system where we can create multiple materials, each with its own specifications
- *       defined by flags like `RLG_USE_NORMAL_MAP`, `RLG_RECEIVE_SHADOW`, etc. This would avoid all the branching
- *       in the shaders since everything would be decided at compilation. This would replace the need for creating different contexts.
- *
- *       But again, this would probably require us to create our own RLG_Material...
- */
-
-
 /* Config Defintions */
 
-//#ifndef RLG_MAX_LIGHTS
-//#   define RLG_MAX_LIGHTS                32   // Indicates the total number of lights manageable by a context
-//#endif
+#ifndef RLG_MAX_LIGHTS
+#   define RLG_MAX_LIGHTS                  32   // Indicates the total number of lights manageable by a context
+#endif
 
 #ifndef RLG_MAX_LIGHTS_PER_MATERIAL
 #   define RLG_MAX_LIGHTS_PER_MATERIAL     8    // Indicates the total number of lights that can illuminate a mesh
 #endif
 
+#ifndef RLG_CLUSTER_GRID_X
+#   define RLG_CLUSTER_GRID_X              16   // Number of screen tiles along X used by clustered shading
+#endif
+
+#ifndef RLG_CLUSTER_GRID_Y
+#   define RLG_CLUSTER_GRID_Y              9    // Number of screen tiles along Y used by clustered shading
+#endif
+
+#ifndef RLG_CLUSTER_GRID_Z
+#   define RLG_CLUSTER_GRID_Z              24   // Number of depth slices used by clustered shading
+#endif
+
+#ifndef RLG_MAX_SHADER_PERMUTATIONS
+#   define RLG_MAX_SHADER_PERMUTATIONS     32   // Indicates the total number of model shader permutations a context can keep loaded
+#endif
+
+#ifndef RLG_SHADOW_CASCADE_LAMBDA
+#   define RLG_SHADOW_CASCADE_LAMBDA       0.75f // Blend between the logarithmic (1.0) and uniform (0.0) distribution of the shadow cascades
+#endif
+
+#ifndef RLG_SHADOW_ATLAS_SIZE
+#   define RLG_SHADOW_ATLAS_SIZE           4096 // Resolution of the depth texture shared by the shadow maps of all the lights
+#endif
+
+#ifndef RLG_SHADOW_MAX_AGE
+#   define RLG_SHADOW_MAX_AGE              8    // RLG_UpdateShadowMaps() renders each shadow tile at least once every N calls
+#endif
+
+#ifndef RLG_MAX_WORKER_THREADS
+#   define RLG_MAX_WORKER_THREADS          4    // Threads sharing the CPU processing of the skyboxes (1 to process them on the calling thread)
+#endif
+
+#ifndef RLG_PREFILTER_MIP_LEVELS
+#   define RLG_PREFILTER_MIP_LEVELS        5    // Mip levels of the prefiltered skybox cubemaps, from smooth (level 0) to fully rough (last level)
+#endif
+
 /* Definitions for managing OpenGL */
 
 #ifndef GL_HEADER
@@ -78,7 +99,19 @@ typedef enum {
     RLG_SHADER_DEPTH_CUBEMAP,               ///< Enum representing the depth writing shader for shadow cubemaps.
     RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP,  ///< Enum representing the shader for generating skyboxes from HDR textures.
     RLG_SHADER_IRRADIANCE_CONVOLUTION,      ///< Enum representing the shader for generating irradiance maps from skyboxes.
-    RLG_SHADER_SKYBOX                       ///< Enum representing the shader for rendering skyboxes.
+    RLG_SHADER_SKYBOX,                      ///< Enum representing the shader for rendering skyboxes.
+    RLG_SHADER_GBUFFER,                     ///< Enum representing the G-buffer writing shader (model shader compiled for deferred shading).
+    RLG_SHADER_DEFERRED_AMBIENT,            ///< Enum representing the deferred pass copying emission, ambient and depth from the G-buffer.
+    RLG_SHADER_DEFERRED_LIGHTING,           ///< Enum representing the deferred pass adding the contribution of one light.
+    RLG_SHADER_DEPTH_INSTANCED,             ///< Enum representing the depth writing shader for shadow maps, with per-instance transformations.
+    RLG_SHADER_DEPTH_CUBEMAP_INSTANCED,     ///< Enum representing the depth writing shader for shadow cubemaps, with per-instance transformations.
+    RLG_SHADER_DEPTH_CUBEMAP_LAYERED,       ///< Enum representing the depth writing shader rendering the six shadow cubemap faces in a single pass.
+    RLG_SHADER_DEPTH_CUBEMAP_LAYERED_INSTANCED, ///< Enum representing the single pass shadow cubemap shader, with per-instance transformations.
+    RLG_SHADER_DEPTH_LAYERED,               ///< Enum representing the single pass shadow cubemap shader writing hardware depth (early-Z kept).
+    RLG_SHADER_DEPTH_LAYERED_INSTANCED,     ///< Enum representing the single pass hardware depth shader, with per-instance transformations.
+    RLG_SHADER_PREFILTER_CONVOLUTION,       ///< Enum representing the shader for generating the prefiltered specular mips of skyboxes.
+    RLG_SHADER_BRDF_INTEGRATION,            ///< Enum representing the shader for generating the split-sum BRDF lookup texture.
+    RLG_SHADER_SKYBOX_FULLSCREEN            ///< Enum representing the shader for rendering skyboxes after the opaque geometry, as a fullscreen triangle.
 } RLG_Shader;
 
 /**
@@ -97,6 +130,29 @@ typedef enum {
     RLG_LIGHT_ATTENUATION,                  ///< Light attenuation factor along the illumination distance of spotlights and omnilights.
 } RLG_LightProperty;
 
+/**
+ * @brief Enum representing the features of the model shader that can be decided at compile time.
+ *
+ * The flags of a draw are deduced from the used maps, the parallax layers, the shadows of the
+ * lights illuminating the mesh and the clustered shading state. A permutation of the model shader
+ * is compiled for each combination, without the branches of the disabled features.
+ */
+typedef enum {
+    RLG_USE_ALBEDO_MAP          = 1 << 0,   ///< Albedo map sampled (same bit as MATERIAL_MAP_ALBEDO).
+    RLG_USE_METALNESS_MAP       = 1 << 1,   ///< Metalness map sampled.
+    RLG_USE_NORMAL_MAP          = 1 << 2,   ///< Normal map sampled.
+    RLG_USE_ROUGHNESS_MAP       = 1 << 3,   ///< Roughness map sampled.
+    RLG_USE_OCCLUSION_MAP       = 1 << 4,   ///< Occlusion map sampled.
+    RLG_USE_EMISSION_MAP        = 1 << 5,   ///< Emission map sampled.
+    RLG_USE_HEIGHT_MAP          = 1 << 6,   ///< Height map sampled (parallax mapping).
+    RLG_USE_CUBEMAP             = 1 << 7,   ///< Skybox reflection.
+    RLG_USE_IRRADIANCE_MAP      = 1 << 8,   ///< Irradiance cubemap used for the ambient light.
+    RLG_USE_DEEP_PARALLAX       = 1 << 9,   ///< Steep parallax mapping with the layers set by RLG_SetParallaxLayers().
+    RLG_RECEIVE_SHADOW          = 1 << 10,  ///< At least one of the lights illuminating the mesh casts shadows.
+    RLG_USE_CLUSTERS            = 1 << 11,  ///< Clustered lights are evaluated (GLSL 330 or higher).
+    RLG_USE_INSTANCING          = 1 << 12,  ///< Per-instance model matrices of RLG_DrawMeshInstanced() (GLSL 330 or higher).
+} RLG_ShaderFlag;
+
 /**
  * @brief Enum representing all shader locations used by rlights.
  */
@@ -138,6 +194,8 @@ typedef enum {
     RLG_LOC_ROUGHNESS_SCALE,
     RLG_LOC_AO_LIGHT_AFFECT,
     RLG_LOC_HEIGHT_SCALE,
+    RLG_LOC_AMBIENT_SH,
+    RLG_LOC_USE_AMBIENT_SH,
 
     /* Internal use */
 
@@ -145,6 +203,8 @@ typedef enum {
 
 } RLG_ShaderLocationIndex;
 
+#define RLG_SH_COEFFICIENTS 9   ///< Number of coefficients of the L2 spherical harmonics of the irradiance
+
 /**
  * @brief Structure representing a skybox with associated textures and buffers.
  *
@@ -152,10 +212,17 @@ typedef enum {
  * a skybox. It includes the cubemap texture, the irradiance texture, vertex
  * buffer object (VBO) IDs, vertex array object (VAO) ID, and a flag indicating
  * whether the skybox is in high dynamic range (HDR).
+ *
+ * The prefiltered cubemap and the BRDF lookup texture are the two terms of the split-sum
+ * reflection, used by the model shader when MATERIAL_MAP_PREFILTER and MATERIAL_MAP_BRDF are
+ * enabled with MATERIAL_MAP_CUBEMAP. Both are only generated with GLSL 330 or higher.
  */
 typedef struct {
     TextureCubemap cubemap;       ///< The cubemap texture representing the skybox.
     TextureCubemap irradiance;    ///< The irradiance cubemap texture for diffuse lighting.
+    TextureCubemap prefilter;     ///< The specular cubemap, prefiltered for one roughness per mip level (see RLG_PREFILTER_MIP_LEVELS).
+    Texture2D brdf;               ///< The BRDF lookup texture of the split-sum, shared by the skyboxes of the context.
+    Vector3 irradianceSH[RLG_SH_COEFFICIENTS];  ///< Spherical harmonics of the irradiance (see RLG_UseSkyboxIrradianceSH).
     bool isHDR;                   ///< Flag indicating if the skybox is HDR (high dynamic range).
 } RLG_Skybox;
 
@@ -177,6 +244,43 @@ typedef void* RLG_Context;
  */
 typedef void (*RLG_DrawFunc)(Shader);
 
+/**
+ * @brief Structure of counters about the GPU work done by the context.
+ *
+ * The setters only modify the context, the values they change are uploaded to the
+ * shaders at the start of the next RLG_DrawMesh() or RLG_UpdateShadowMap(). These
+ * counters allow to check how many uploads and binds were actually done, and how
+ * many were skipped because the shader or the GL state already had the value.
+ */
+typedef struct {
+    unsigned int uniformUploads;        ///< Number of uniform values sent to the shaders.
+    unsigned int bufferUploads;         ///< Number of uniform block updates (GLSL 330 or higher).
+    unsigned int lightUploads;          ///< Number of lights (fully or partially) uploaded into a shader light slot.
+    unsigned int shaderBinds;           ///< Number of shader programs bound.
+    unsigned int textureBinds;          ///< Number of textures bound to a texture unit by the drawing functions.
+    unsigned int vertexArrayBinds;      ///< Number of vertex arrays bound by the drawing functions.
+    unsigned int skippedUniformUploads; ///< Number of material uniforms not sent because the shader already had their value.
+    unsigned int skippedShaderBinds;    ///< Number of program binds skipped because the program was already bound.
+    unsigned int skippedTextureBinds;   ///< Number of texture binds skipped because the texture was already bound to the unit.
+    unsigned int skippedVertexArrayBinds; ///< Number of vertex array binds skipped because the vertex array was already bound.
+    unsigned int skippedBufferBinds;    ///< Number of uniform block binds skipped during a batch (GLSL 330 or higher).
+    unsigned int skippedUnbinds;        ///< Number of programs, textures and vertex arrays left bound for the next draw of a batch.
+    unsigned int culledMeshes;          ///< Number of meshes of RLG_DrawModelEx() and RLG_CastModelEx() skipped because outside of the view or light frustum.
+    unsigned int cachedShadowMaps;      ///< Number of RLG_UpdateShadowMapCached() calls that did not render the static casters again.
+    unsigned int shadowTileUpdates;     ///< Number of shadow tiles (cube faces or cascades) rendered, a single pass omnilight update counts 6.
+    unsigned int skippedShadowTileUpdates; ///< Number of shadow tiles left as is by RLG_UpdateShadowMaps() to stay within its budget.
+} RLG_Stats;
+
+/**
+ * @brief Decision of the shadow update scheduler for a light, see RLG_UpdateShadowMaps().
+ */
+typedef struct {
+    unsigned int updatedTiles;          ///< Bit mask of the tiles (cube faces or cascades) rendered by the last RLG_UpdateShadowMaps().
+    unsigned int forcedTiles;           ///< Bit mask of the rendered tiles that had reached RLG_SHADOW_MAX_AGE, rendered beyond the budget if needed.
+    unsigned int age;                   ///< Number of RLG_UpdateShadowMaps() calls since the oldest tile of the light was rendered.
+    float priority;                     ///< Score of the light at the last RLG_UpdateShadowMaps(), from its screen influence.
+} RLG_ShadowUpdateInfo;
+
 
 #if defined(__cplusplus)
 extern "C" {
@@ -189,6 +293,20 @@ extern "C" {
  */
 RLG_Context RLG_CreateContext(void);
 
+/**
+ * @brief Create a new rlights management context without waiting for its shaders to be compiled.
+ *
+ * All the shader programs are submitted to the driver before returning, with the
+ * KHR_parallel_shader_compile extension the driver compiles them in the background.
+ * Call RLG_IsContextReady() (e.g. at each frame of a loading screen) until it returns true.
+ *
+ * @note The functions using the shaders of the context (drawing, shadow maps, skyboxes,
+ *       RLG_GetShader) wait for the end of the compilation if the context is not ready.
+ *
+ * @return A new RLG_Context object representing the created lighting context.
+ */
+RLG_Context RLG_CreateContextAsync(void);
+
 /**
  * @brief Destroy a previously created lighting context and release associated resources.
  * 
@@ -210,10 +328,31 @@ void RLG_SetContext(RLG_Context ctx);
  */
 RLG_Context RLG_GetContext(void);
 
+/**
+ * @brief Check if the shaders of the current context are compiled and set up.
+ *
+ * Sets up the programs that the driver has finished to link. Without KHR_parallel_shader_compile
+ * their completion cannot be polled, each call then waits for a single program.
+ *
+ * @return true if the context is ready, false if shaders are still compiling.
+ */
+bool RLG_IsContextReady(void);
+
 /**
  * @brief Set custom shader code for a specific shader type.
  * 
  * @note This function should be called before RLG_Init to define your own shaders.
+ * @note With GLSL 330 or higher, a custom model shader receives the lights and material
+ *       parameters through the 'LightBlock' and 'MaterialBlock' std140 uniform blocks
+ *       (see shaders/glsl330/model.fs).
+ * @note The model shader code must not contain a `#version` directive, it is compiled after the
+ *       one of GLSL_VERSION and the `NUM_LIGHTS` definition (RLG_MAX_LIGHTS_PER_MATERIAL).
+ * @note The model shader code is compiled for each permutation with `PERMUTATION` and the
+ *       `USE_*`/`RECEIVE_SHADOW` flags defined as `true` or `false` (see RLG_ShaderFlag).
+ * @note The single pass shadow cubemap shaders are linked with the code of RLG_SHADER_DEPTH_CUBEMAP
+ *       and RLG_SHADER_DEPTH_CUBEMAP_INSTANCED, whose vertex shaders must then write `mvp*position`
+ *       to `gl_Position`, they cannot be replaced themselves. The hardware depth variants
+ *       (RLG_SHADER_DEPTH_LAYERED) use the fragment shaders of RLG_SHADER_DEPTH(_INSTANCED) instead.
  * 
  * @param shader The type of shader to set the custom code for.
  * @param vsCode Vertex shader code for the specified shader type.
@@ -231,6 +370,95 @@ void RLG_SetCustomShaderCode(RLG_Shader shader, const char *vsCode, const char *
  */
 const Shader* RLG_GetShader(RLG_Shader shader);
 
+/**
+ * @brief Set the directory in which the linked shader programs are cached.
+ *
+ * The binaries of the programs are saved in this directory and reloaded at the next launches
+ * instead of compiling the GLSL code again. A binary is identified by a hash of its sources,
+ * GLSL_VERSION, RLG_MAX_LIGHTS_PER_MATERIAL and the OpenGL driver strings, the program is
+ * compiled again if the driver rejects it (e.g. after a driver update).
+ *
+ * @note This function should be called before RLG_CreateContext, the directory must exist.
+ * @note Requires GLSL 330 or higher and a driver supporting program binaries, ignored otherwise.
+ *
+ * @param directory Path of the cache directory, or NULL to disable the cache (default).
+ */
+void RLG_SetShaderCacheDirectory(const char *directory);
+
+/**
+ * @brief Get the counters of the current context.
+ *
+ * The counters accumulate since the creation of the context or the last call to RLG_ResetStats(),
+ * only the work done by the drawing and shadow map functions is counted.
+ *
+ * @return The RLG_Stats of the current context.
+ */
+RLG_Stats RLG_GetStats(void);
+
+/**
+ * @brief Reset the counters of the current context to zero.
+ */
+void RLG_ResetStats(void);
+
+/**
+ * @brief Begin a batch of draws sharing their GL state.
+ *
+ * During a batch, the drawing and casting functions leave their program, textures and vertex array
+ * bound after drawing, the following draws only bind what differs (e.g. 2000 meshes sharing the same
+ * material only bind it once). The material uniforms are only sent if they differ from those the
+ * program already has, in or out of a batch. The state is restored by RLG_EndBatch().
+ *
+ * @note No raylib drawing must be done during a batch, call RLG_EndBatch() before, and the textures
+ *       and meshes drawn in the batch must not be unloaded before it ends. The other functions of
+ *       rlights (shadow maps, deferred passes, skyboxes) restore the state themselves.
+ */
+void RLG_BeginBatch(void);
+
+/**
+ * @brief End the current batch of draws, unbinding the state left bound by its draws.
+ */
+void RLG_EndBatch(void);
+
+/**
+ * @brief Check if a batch of draws is in progress.
+ *
+ * @return true if RLG_BeginBatch() was called without RLG_EndBatch(), false otherwise.
+ */
+bool RLG_IsBatchActive(void);
+
+/**
+ * @brief Enable or disable the use of model shader permutations.
+ *
+ * When enabled (default), each draw uses a permutation of the model shader compiled for the
+ * features it needs (see RLG_ShaderFlag) instead of testing them for each fragment. Permutations
+ * are compiled the first time they are needed and kept until the context is destroyed.
+ *
+ * @note With NO_EMBEDDED_SHADERS the model shader is always used without permutations.
+ *
+ * @param active Boolean value to enable (true) or disable (false) the shader permutations.
+ */
+void RLG_UseShaderPermutations(bool active);
+
+/**
+ * @brief Check if the model shader permutations are used.
+ *
+ * @return true if the shader permutations are used, false otherwise.
+ */
+bool RLG_IsShaderPermutationsUsed(void);
+
+/**
+ * @brief Get the permutation of the model shader for a combination of flags, loading it if needed.
+ *
+ * Can be used to compile the permutations in advance (e.g. during a loading screen).
+ * If the permutation cannot be loaded, or if RLG_MAX_SHADER_PERMUTATIONS is reached,
+ * the model shader with runtime branches is returned.
+ *
+ * @param flags Combination of RLG_ShaderFlag values.
+ *
+ * @return A pointer to the shader of the permutation.
+ */
+const Shader* RLG_GetShaderPermutation(unsigned int flags);
+
 /**
  * @brief Set the view position, corresponds to the position of your camera.
  * 
@@ -268,6 +496,27 @@ void RLG_SetAmbientColor(Color color);
  */
 Color RLG_GetAmbientColor(void);
 
+/**
+ * @brief Set the spherical harmonics of the ambient light.
+ *
+ * When set, the model shader evaluates these L2 spherical harmonics with the normal
+ * of the fragment for the ambient light, instead of sampling the irradiance map of the
+ * material or using the ambient color, which saves a texture fetch per fragment.
+ *
+ * The coefficients are the ones of RLG_Skybox.irradianceSH, they are evaluated as
+ * `sh[0] + sh[1]*y + sh[2]*z + sh[3]*x + sh[4]*x*y + sh[5]*y*z + sh[6]*(3*z*z - 1) + sh[7]*x*z + sh[8]*(x*x - y*y)`.
+ *
+ * @param sh Array of RLG_SH_COEFFICIENTS coefficients, or NULL to stop using them.
+ */
+void RLG_SetAmbientSH(const Vector3 *sh);
+
+/**
+ * @brief Check if the ambient light is given by spherical harmonics.
+ *
+ * @return True if spherical harmonics set with RLG_SetAmbientSH() are used, false otherwise.
+ */
+bool RLG_IsAmbientSHUsed(void);
+
 /**
  * @brief Set the minimum and maximum layers for parallax mapping.
  * 
@@ -529,18 +778,71 @@ void RLG_SetLightTargetV(unsigned int light, Vector3 targetPosition);
  */
 Vector3 RLG_GetLightTarget(unsigned int light);
 
+/**
+ * @brief Enable or disable clustered shading.
+ *
+ * When enabled, the view frustum is divided into a grid of clusters and each enabled light
+ * without shadows (except directional lights) is binned into the clusters it reaches.
+ * Each fragment then only evaluates the lights of its own cluster, which allows thousands
+ * of lights per context. Directional lights and shadow casting lights still go through
+ * the `RLG_MAX_LIGHTS_PER_MATERIAL` light slots of the shader.
+ *
+ * @note The clusters are rebuilt automatically at draw time when the camera or the lights change.
+ * @warning Only available with GLSL 330 or higher (texture buffers are required).
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) clustered shading.
+ */
+void RLG_UseClusteredShading(bool active);
+
+/**
+ * @brief Check if clustered shading is enabled.
+ *
+ * @return True if clustered shading is enabled, false otherwise.
+ */
+bool RLG_IsClusteredShadingUsed(void);
+
+/**
+ * @brief Enable or disable the linear depth of the omnilight shadow maps.
+ *
+ * By default, the omnilight shadow maps store the distance to the light scaled by the far plane,
+ * written through `gl_FragDepth` by the RLG_SHADER_DEPTH_CUBEMAP shaders. The precision is spread
+ * evenly over the whole distance, but the early depth test is disabled for these passes.
+ *
+ * When disabled, they store the hardware depth of the projection of each face instead, from
+ * RLG_SHADOW_NEAR_PLANE to the distance of the light, and the lighting shaders convert the
+ * distance of the fragments to that depth. The faces are then rendered with the RLG_SHADER_DEPTH
+ * shaders, which leave the depth untouched and keep the early depth test of the GPU enabled.
+ *
+ * @note The shadow maps of the omnilights are rendered again at their next update.
+ * @note A custom RLG_SHADER_DEPTH_CUBEMAP code is not used while the linear depth is disabled.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the linear depth.
+ */
+void RLG_UseLinearOmniShadows(bool active);
+
+/**
+ * @brief Check if the omnilight shadow maps store linear depth.
+ *
+ * @return True if the linear depth is enabled, false otherwise.
+ */
+bool RLG_IsLinearOmniShadowsUsed(void);
+
 /**
  * @brief Enable shadow casting for a light.
  *
- * @warning Shadow casting is not fully functional for omnilights yet. Please specify the light direction.
+ * The shadow map is allocated in the shadow atlas, a depth texture of RLG_SHADOW_ATLAS_SIZE pixels
+ * shared by all the lights, so that the shadows of a draw only bind one texture. The areas of the
+ * lights are packed again each time one is allocated, the moved shadow maps must then be updated.
+ *
+ * The six faces of an omnilight are rendered into 3x2 tiles of its area, they store the distance
+ * to the light, or the hardware depth of each face when the linear depth is disabled
+ * (see RLG_UseLinearOmniShadows).
+ *
+ * @note Shadows are not enabled if the shadow map does not fit in the atlas (an omnilight needs
+ *       3x2 tiles of `shadowMapResolution`, a directional light one tile per cascade).
  * 
  * @param light The index of the light to enable shadow casting for.
  * @param shadowMapResolution The resolution of the shadow map.
- * 
- * @todo Implement shadow casting feature for omnilights using cubemaps.
- *       Previous attempts have been made, but it might be optimal to
- *       directly call OpenGL functions bypassing RLGL, though this
- *       approach could pose issues for some users...
  */
 void RLG_EnableShadow(unsigned int light, int shadowMapResolution);
 
@@ -575,25 +877,135 @@ void RLG_SetShadowBias(unsigned int light, float value);
  */
 float RLG_GetShadowBias(unsigned int light);
 
+/**
+ * @brief Set the number of shadow cascades of a directional light.
+ *
+ * With several cascades, the shadow map of the light is made of one tile per cascade in the shadow atlas,
+ * each one covering a slice of the camera frustum set by RLG_SetShadowCamera(), up to `distance`.
+ * The slices are distributed by blending a logarithmic and a uniform split (RLG_SHADOW_CASCADE_LAMBDA),
+ * so that the cascades near the camera receive more texels. `RLG_EnableShadow()` gives the resolution
+ * of each tile.
+ *
+ * @note The fragments beyond `distance` receive no shadow. With one cascade, the light uses a single
+ *       shadow map centered on its position, as the spotlights do.
+ * @warning Only available with GLSL 330 or higher (the cascades are read from the light uniform block).
+ *
+ * @param light The index of the light.
+ * @param count The number of cascades, between 1 and 4.
+ * @param distance The view depth up to which the cascades cast shadows.
+ */
+void RLG_SetShadowCascades(unsigned int light, int count, float distance);
+
+/**
+ * @brief Get the number of shadow cascades of a directional light.
+ *
+ * @param light The index of the light.
+ * @return The number of cascades set with RLG_SetShadowCascades(), 1 by default.
+ */
+int RLG_GetShadowCascades(unsigned int light);
+
+/**
+ * @brief Set the camera the shadow cascades of the directional lights are fit to.
+ *
+ * Must be called before RLG_UpdateShadowMap() each time the camera changes, the aspect
+ * ratio is the one of the framebuffer bound when RLG_UpdateShadowMap() is called.
+ *
+ * @param camera The camera used to draw the scene.
+ */
+void RLG_SetShadowCamera(Camera3D camera);
+
 /**
  * @brief Updates the shadow map for a given light source.
  * 
  * This function updates the shadow map for the specified light by calling the provided draw function.
  * It sets the active shadow map for the light and uses the draw function to render the scene.
  * 
+ * @note With GLSL 330 or higher, the draw function is called once for an omnilight, the six faces
+ *       being rendered in a single pass by a geometry shader, it is called once per face otherwise.
+ * 
  * @param light The identifier of the light source for which to update the shadow map.
  * @param drawFunc The function to draw the scene for shadow rendering.
  */
 void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc);
 
+/**
+ * @brief Updates the shadow map of a light, rendering its static casters only when needed.
+ *
+ * The static casters are rendered into a shadow cache (a second depth atlas allocated at the first
+ * call) when the position, direction, distance, type or shadow map of the light changed, or after
+ * RLG_InvalidateShadowMap(). Otherwise their depth is copied from the cache and only the dynamic
+ * casters are drawn over it. Without dynamic casters and without changes, the shadow map of the
+ * previous update is kept as is.
+ *
+ * @note The cascaded shadow maps follow the camera, their static casters are drawn at each update.
+ * @note With GLSL 100, there is no shadow cache, the static and dynamic casters are drawn together
+ *       unless the shadow map of the previous update can be kept.
+ *
+ * @param light The identifier of the light source for which to update the shadow map.
+ * @param staticDrawFunc The function drawing the casters that do not move.
+ * @param dynamicDrawFunc The function drawing the moving casters, can be NULL.
+ */
+void RLG_UpdateShadowMapCached(unsigned int light, RLG_DrawFunc staticDrawFunc, RLG_DrawFunc dynamicDrawFunc);
+
+/**
+ * @brief Updates the shadow maps of all the enabled shadow casting lights within a budget of passes.
+ *
+ * The tiles of the lights (cube faces, cascades, or the whole light for a single pass omnilight)
+ * are ranked by the screen influence of their light, estimated from its distance to the camera
+ * (the one of RLG_SetShadowCamera(), or the view position) and its radius, multiplied by the number
+ * of calls since they were rendered. Tiles whose light moved are ranked as if RLG_SHADOW_MAX_AGE
+ * calls older. The best ranked tiles are rendered, one pass each, until the budget is spent.
+ *
+ * @note A tile is rendered at the latest every RLG_SHADOW_MAX_AGE calls, even beyond the budget.
+ *       The tiles that were never rendered or whose area moved in the atlas are always rendered.
+ *
+ * @param drawFunc The function to draw the scene for shadow rendering.
+ * @param budget The number of passes (tiles) that can be rendered by this call.
+ */
+void RLG_UpdateShadowMaps(RLG_DrawFunc drawFunc, int budget);
+
+/**
+ * @brief Get the decision of the last RLG_UpdateShadowMaps() for a light.
+ *
+ * @param light The identifier of the light source.
+ * @return The tiles rendered, their age and the priority of the light.
+ */
+RLG_ShadowUpdateInfo RLG_GetShadowUpdateInfo(unsigned int light);
+
+/**
+ * @brief Forces the static casters of a light to be rendered again at its next RLG_UpdateShadowMapCached().
+ *
+ * Must be called when a static caster lit by the light moves, is added or removed.
+ *
+ * @param light The identifier of the light source.
+ */
+void RLG_InvalidateShadowMap(unsigned int light);
+
 /**
  * @brief Retrieves the shadow map texture for a given light source.
  * 
+ * @note The shadow maps of all the lights are stored in a single depth texture, the shadow atlas,
+ *       the area of the light in this texture is given by RLG_GetShadowMapRect().
+ * @note With GLSL 330 or higher, the atlas is set up for depth comparison (GL_TEXTURE_COMPARE_MODE),
+ *       it must be read through a `sampler2DShadow`.
+ * 
  * @param light The identifier of the light source for which to retrieve the shadow map.
- * @return The shadow map texture for the specified light source.
+ * @return The shadow atlas if the light casts shadows, an empty texture otherwise.
  */
 Texture RLG_GetShadowMap(unsigned int light);
 
+/**
+ * @brief Retrieves the area of the shadow map of a light in the shadow atlas.
+ * 
+ * The area is made of square tiles of the resolution given to RLG_EnableShadow(): one for
+ * spotlights, one per cascade on a row for directional lights, and the 6 faces of the cube on
+ * 3 columns and 2 rows for omnilights (+X, -X, +Y on the first row, -Y, +Z, -Z on the second).
+ * 
+ * @param light The identifier of the light source.
+ * @return The area in pixels, with its origin at the bottom left of the atlas.
+ */
+Rectangle RLG_GetShadowMapRect(unsigned int light);
+
 /**
  * @brief Casts a mesh for shadow rendering.
  * 
@@ -603,6 +1015,20 @@ Texture RLG_GetShadowMap(unsigned int light);
  */
 void RLG_CastMesh(Shader shader, Mesh mesh, Matrix transform);
 
+/**
+ * @brief Casts several instances of a mesh for shadow rendering in a single draw call.
+ * 
+ * The depth shaders of the context are replaced by their variant reading the instance matrices.
+ * Other shaders must declare the `mat4 instanceTransform` attribute (raylib matrices, row-major),
+ * otherwise, like below GLSL 330, each instance is cast with RLG_CastMesh().
+ * 
+ * @param shader The shader to use for rendering the mesh.
+ * @param mesh The mesh to cast.
+ * @param transforms The transformation matrices of the instances.
+ * @param count The number of instances.
+ */
+void RLG_CastMeshInstanced(Shader shader, Mesh mesh, const Matrix *transforms, int count);
+
 /**
  * @brief Casts a model for shadow rendering.
  * 
@@ -625,6 +1051,36 @@ void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale);
  */
 void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale);
 
+/**
+ * @brief Enable or disable the frustum culling of the meshes of a model.
+ *
+ * When enabled (default), RLG_DrawModelEx() and RLG_CastModelEx() skip the meshes whose bounding
+ * box is outside of the frustum of the current modelview and projection matrices (the camera, or
+ * the light during RLG_UpdateShadowMap()). The culled meshes are counted by RLG_GetStats().
+ *
+ * @note The local bounding box of each mesh is computed from its vertices the first time it is seen,
+ *       call RLG_UpdateMeshBounds() after modifying the vertices of a mesh.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) frustum culling.
+ */
+void RLG_UseFrustumCulling(bool active);
+
+/**
+ * @brief Check if the frustum culling of the meshes is enabled.
+ *
+ * @return True if frustum culling is enabled, false otherwise.
+ */
+bool RLG_IsFrustumCullingUsed(void);
+
+/**
+ * @brief Recompute the cached bounding box of a mesh from its vertices.
+ *
+ * The bounding boxes are used for the frustum culling and the light selection.
+ *
+ * @param mesh The mesh whose vertices were modified.
+ */
+void RLG_UpdateMeshBounds(Mesh mesh);
+
 /**
  * @brief Draw a mesh with a specified material and transformation.
  * 
@@ -636,6 +1092,23 @@ void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotat
  */
 void RLG_DrawMesh(Mesh mesh, Material material, Matrix transform);
 
+/**
+ * @brief Draw several instances of a mesh with a specified material in a single draw call.
+ * 
+ * The instance matrices are streamed into a vertex buffer and read by a permutation of the model
+ * shader (GLSL 330 or higher). The material and the lights are uploaded once for all the instances,
+ * the lights are selected for the box enclosing them all.
+ * 
+ * NOTE: Below GLSL 330, in deferred mode or when the shader permutations are disabled,
+ *       each instance is drawn with RLG_DrawMesh().
+ * 
+ * @param mesh The mesh to draw.
+ * @param material The material to apply to the mesh.
+ * @param transforms The transformation matrices of the instances.
+ * @param count The number of instances.
+ */
+void RLG_DrawMeshInstanced(Mesh mesh, Material material, const Matrix *transforms, int count);
+
 /**
  * @brief Draw a model at a specified position with a specified scale and tint.
  * 
@@ -663,69 +1136,293 @@ void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint);
 void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint);
 
 /**
- * @brief Loads a skybox from a file.
+ * @brief Begin recording the draws submitted with RLG_Submit() into the draw queue.
  *
- * This function loads a skybox texture from the specified file and returns
- * a RLG_Skybox structure containing the cubemap texture.
+ * The draws of the queue are issued by RLG_FlushQueue() in an order that minimizes the state
+ * changes: grouped by shader permutation, then by material textures and by mesh, and front-to-back
+ * within each group so that the depth test rejects the hidden fragments early.
  *
- * @param skyboxFileName The path to the skybox texture file.
- * @return RLG_Skybox The loaded skybox.
+ * @note Calling it again before RLG_FlushQueue() discards the draws submitted since the last call.
  */
-RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName);
+void RLG_BeginQueue(void);
 
 /**
- * @brief Loads a HDR skybox from a file with specified size and format.
- *
- * This function loads a high dynamic range (HDR) skybox texture from the
- * specified file. It creates a cubemap texture with the given size and format.
+ * @brief Submit a mesh to the draw queue.
  *
- * @note On some Android devices with WebGL, framebuffer objects (FBO)
- * do not properly support a FLOAT-based attachment, so the function uses
- * PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 instead of PIXELFORMAT_UNCOMPRESSED_R32G32B32A32.
+ * The mesh, the material (including its maps) and the textures must stay valid until
+ * RLG_FlushQueue(). Outside of a queue, the mesh is drawn immediately with RLG_DrawMesh().
  *
- * @param skyboxFileName The path to the skybox texture file.
- * @param size The size of the cubemap texture.
- * @param format The pixel format of the cubemap texture.
- * @return RLG_Skybox The loaded HDR skybox.
+ * @param mesh The mesh to draw.
+ * @param material The material to apply to the mesh.
+ * @param transform The transformation matrix to apply to the mesh.
  */
-RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format);
+void RLG_Submit(Mesh mesh, Material material, Matrix transform);
 
 /**
- * @brief Unloads a skybox.
+ * @brief Sort and draw the meshes submitted since RLG_BeginQueue(), then end the queue.
  *
- * This function unloads the specified skybox, freeing the associated
- * resources.
+ * The draws are issued in a batch (see RLG_BeginBatch()), with the camera, lights and
+ * maps that are current at the time of this call.
  *
- * @param skybox The skybox to be unloaded.
+ * @note The sort does not preserve the submission order, only opaque meshes should be submitted,
+ *       transparent ones should be drawn after with RLG_DrawMesh() from back to front.
  */
-void RLG_UnloadSkybox(RLG_Skybox skybox);
+void RLG_FlushQueue(void);
 
 /**
- * @brief Draws a skybox.
+ * @brief Begin deferred shading mode.
  *
- * This function renders the specified skybox.
+ * The meshes drawn until RLG_EndDeferred() only write their surface (albedo, normal,
+ * occlusion/roughness/metalness and emission) into a G-buffer, the lights are then
+ * applied once per visible pixel by RLG_EndDeferred(). The cost of lighting thus depends
+ * on the screen area covered by each light rather than on the drawn geometry.
  *
- * @param skybox The skybox to be drawn.
+ * @note Must be called between BeginMode3D() and EndMode3D(), the G-buffer has the size of the current viewport.
+ * @warning Only available with GLSL 330 or higher (multiple render targets are required), and with
+ *          the embedded shaders (the G-buffer shader is derived from the embedded model shader).
  */
-void RLG_DrawSkybox(RLG_Skybox skybox);
+void RLG_BeginDeferred(void);
 
+/**
+ * @brief End deferred shading mode and apply the lighting.
+ *
+ * Writes the emission, ambient and depth of the G-buffer into the render target that was
+ * bound when calling RLG_BeginDeferred(), then adds the contribution of each enabled light,
+ * restricted to the screen rectangle covered by its range for omnilights and spotlights.
+ * Since the depth is written, forward rendering (e.g. skybox, transparent objects) can follow.
+ */
+void RLG_EndDeferred(void);
 
-/* Misc Helper Functions */
-
-unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vsCount, int fsCount);
+/**
+ * @brief Enable or disable the spherical harmonics irradiance of the skyboxes.
+ *
+ * When enabled, RLG_LoadSkybox() and RLG_LoadSkyboxHDR() read the cubemap back and project it
+ * into L2 spherical harmonics on the CPU (split across RLG_MAX_WORKER_THREADS threads), stored
+ * in RLG_Skybox.irradianceSH, instead of rendering the irradiance cubemap with the convolution
+ * shader, which is very slow on software renderers and low-end GPUs.
+ * The irradiance texture of the skybox is then left empty, the coefficients are given
+ * to the model shader with RLG_SetAmbientSH().
+ *
+ * @note The convolution shader is still used if the cubemap cannot be read back.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the spherical harmonics.
+ */
+void RLG_UseSkyboxIrradianceSH(bool active);
 
+/**
+ * @brief Check if the skybox irradiance is projected into spherical harmonics.
+ *
+ * @return True if the spherical harmonics irradiance is enabled, false otherwise.
+ */
+bool RLG_IsSkyboxIrradianceSHUsed(void);
 
-#if defined(__cplusplus)
-}
-#endif
+/**
+ * @brief Enable or disable the conversion of the HDR panoramas on the CPU.
+ *
+ * When enabled, RLG_LoadSkyboxHDR() decodes the panorama and resamples it into the cubemap faces
+ * with RLG_GenSkyboxFaces(), then uploads the faces with RLG_LoadSkyboxFaces(), instead of
+ * uploading the full panorama to convert it with a shader.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the CPU conversion.
+ */
+void RLG_UseSkyboxCPUConversion(bool active);
 
-#ifdef RLIGHTS_IMPLEMENTATION
+/**
+ * @brief Check if the HDR panoramas are converted on the CPU.
+ *
+ * @return True if the CPU conversion is enabled, false otherwise.
+ */
+bool RLG_IsSkyboxCPUConversionUsed(void);
+
+/**
+ * @brief Enable or disable the drawing of the skyboxes after the opaque geometry.
+ *
+ * When enabled, RLG_DrawSkybox() draws a single triangle covering the screen at depth 1.0,
+ * tested with GL_LEQUAL against the depth of the scene, the view ray of each pixel being
+ * unprojected with the inverse view-projection. Only the pixels where nothing was drawn are
+ * shaded, instead of every pixel of the screen with the cube drawn first (default).
+ *
+ * @note The skybox must then be drawn after the opaque geometry and before the transparent one,
+ *       with the depth test enabled (e.g. within BeginMode3D) and the depth cleared to 1.0.
+ *
+ * @param active Boolean value indicating whether to enable (true) or disable (false) the depth tested skybox.
+ */
+void RLG_UseSkyboxDepthTest(bool active);
+
+/**
+ * @brief Check if the skyboxes are drawn after the opaque geometry.
+ *
+ * @return True if the depth tested skybox is enabled, false otherwise.
+ */
+bool RLG_IsSkyboxDepthTestUsed(void);
+
+/**
+ * @brief Loads a skybox from a file.
+ *
+ * This function loads a skybox texture from the specified file and returns
+ * a RLG_Skybox structure containing the cubemap texture.
+ *
+ * @param skyboxFileName The path to the skybox texture file.
+ * @return RLG_Skybox The loaded skybox.
+ */
+RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName);
+
+/**
+ * @brief Loads a HDR skybox from a file with specified size and format.
+ *
+ * This function loads a high dynamic range (HDR) skybox texture from the
+ * specified file. It creates a cubemap texture with the given size and format.
+ *
+ * @note On some Android devices with WebGL, framebuffer objects (FBO)
+ * do not properly support a FLOAT-based attachment, so the function uses
+ * PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 instead of PIXELFORMAT_UNCOMPRESSED_R32G32B32A32.
+ *
+ * @param skyboxFileName The path to the skybox texture file.
+ * @param size The size of the cubemap texture.
+ * @param format The pixel format of the cubemap texture.
+ * @return RLG_Skybox The loaded HDR skybox.
+ */
+RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format);
+
+/**
+ * @brief Resamples an equirectangular panorama into the six faces of a cubemap on the CPU.
+ *
+ * The faces are filtered bilinearly, their rows being split into bands shared by
+ * RLG_MAX_WORKER_THREADS threads. This function requires neither an OpenGL context nor
+ * a rlights context, it can be called from a loading thread.
+ *
+ * @param panorama The panorama image, read as 32-bit float RGB (other formats are converted on a copy).
+ * @param size The size of the cubemap faces.
+ * @return Image The faces (+X, -X, +Y, -Y, +Z, -Z) stacked vertically in 32-bit float RGB, to unload with UnloadImage().
+ */
+Image RLG_GenSkyboxFaces(Image panorama, int size);
+
+/**
+ * @brief Loads a skybox from the six faces of a cubemap stacked vertically.
+ *
+ * The faces are uploaded in their format, then the irradiance and the reflection terms
+ * are generated like with the other skybox loaders.
+ *
+ * @param faces The faces (+X, -X, +Y, -Y, +Z, -Z), as returned by RLG_GenSkyboxFaces().
+ * @return RLG_Skybox The loaded skybox, HDR if the faces use a floating point format.
+ */
+RLG_Skybox RLG_LoadSkyboxFaces(Image faces);
+
+/**
+ * @brief Saves the textures generated for a skybox into a bake file.
+ *
+ * The cubemap, the irradiance cubemap, the mip levels of the prefiltered cubemap and the
+ * spherical harmonics are read back and stored as half floats, in the layout expected
+ * by the GPU, so that RLG_LoadSkyboxBake() uploads them without any conversion.
+ *
+ * @note Requires GLSL 330 or higher, below it the textures could only be read back with
+ *       8 bits per channel, which would clamp the HDR skyboxes.
+ *
+ * @param skybox The skybox to save, as returned by one of the skybox loaders.
+ * @param fileName The path of the bake file to write.
+ * @return True if the bake file was written, false otherwise.
+ */
+bool RLG_SaveSkyboxBake(RLG_Skybox skybox, const char* fileName);
+
+/**
+ * @brief Loads a skybox from a bake file written by RLG_SaveSkyboxBake().
+ *
+ * The faces of each texture are uploaded as stored, without decoding the panorama
+ * or running the convolution shaders again. The BRDF lookup texture is the one of the context.
+ *
+ * @note Below GLSL 330, the half float textures require an extension (OES_texture_half_float),
+ *       the bake is not loaded without it.
+ *
+ * @param fileName The path of the bake file.
+ * @return RLG_Skybox The loaded skybox, with empty textures if the file is invalid.
+ */
+RLG_Skybox RLG_LoadSkyboxBake(const char* fileName);
+
+/**
+ * @brief Regenerates the textures of a skybox from a source cubemap, spread over several calls.
+ *
+ * Meant to be called once per frame for dynamic skies (e.g. time of day), instead of loading
+ * the skybox again in a single frame. The passes are rendered into a back set of textures owned
+ * by the context: a copy of each face of the source, the mip levels of the cubemap, each face of
+ * the irradiance (read back and projected into spherical harmonics if the skybox has no irradiance
+ * cubemap), then each face of each level of the prefiltered cubemap. Once they are all rendered,
+ * the back set replaces the cubemap, irradiance, prefilter and irradianceSH of the skybox at once,
+ * and its previous textures are kept as the back set of the next update.
+ *
+ * @note An update continues as long as the same skybox pointer is given, another skybox restarts it.
+ *       The source is read by every call, it must not be unloaded before the end of the update.
+ * @note The texture IDs of the skybox change with each swap, the materials using them must be set again.
+ * @warning Only available with GLSL 330 or higher.
+ *
+ * @param skybox The skybox to update, loaded by one of the skybox loaders.
+ * @param source The cubemap to copy into the skybox, of any size, resampled to the size of the skybox.
+ * @param budget The number of passes (cube faces or levels) that can be rendered by this call.
+ * @return True if this call completed the update and swapped the textures of the skybox, false otherwise.
+ */
+bool RLG_UpdateSkybox(RLG_Skybox *skybox, TextureCubemap source, int budget);
+
+/**
+ * @brief Unloads a skybox.
+ *
+ * This function unloads the specified skybox, freeing the associated
+ * resources.
+ *
+ * @param skybox The skybox to be unloaded.
+ */
+void RLG_UnloadSkybox(RLG_Skybox skybox);
+
+/**
+ * @brief Draws a skybox.
+ *
+ * This function renders the specified skybox.
+ *
+ * @note By default the skybox is drawn first, see RLG_UseSkyboxDepthTest() to draw it after the opaque geometry.
+ *
+ * @param skybox The skybox to be drawn.
+ */
+void RLG_DrawSkybox(RLG_Skybox skybox);
+
+
+/* Misc Helper Functions */
+
+unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vsCount, int fsCount);
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#ifdef RLIGHTS_IMPLEMENTATION
 
 #include <raymath.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <float.h>
 #include <rlgl.h>
 
+#if RLG_MAX_WORKER_THREADS > 1
+#   if defined(_WIN32)
+#       include <process.h>                 // Required for: _beginthreadex()
+#       define RLG_THREADS_WIN32
+#   elif (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#       include <pthread.h>                 // Required for: pthread_create(), pthread_join()
+#       define RLG_THREADS_POSIX
+#   endif
+#endif
+
+#if defined(RLG_THREADS_WIN32)
+    // NOTE: Declared here rather than including <windows.h>, whose names conflict with raylib
+#   if defined(__cplusplus)
+    extern "C" {
+#   endif
+    __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *handle, unsigned long milliseconds);
+    __declspec(dllimport) int __stdcall CloseHandle(void *handle);
+#   if defined(__cplusplus)
+    }
+#   endif
+#endif
+
 /* Helper macros */
 
 #define STRINGIFY(x) #x             ///< NOTE: Undefined at the end of the header
@@ -746,7 +1443,67 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 /* Helper defintions */
 
 #define RLG_COUNT_MATERIAL_MAPS 12  ///< Same as MAX_MATERIAL_MAPS defined in raylib/config.h
-#define RLG_COUNT_SHADERS 6         ///< Total shader used by rlights.h internally
+#define RLG_COUNT_SHADERS 18        ///< Total shader used by rlights.h internally
+
+#define RLG_COUNT_CLUSTERS (RLG_CLUSTER_GRID_X*RLG_CLUSTER_GRID_Y*RLG_CLUSTER_GRID_Z)
+#define RLG_SHADOW_ATLAS_TEXTURE_SLOT 11  ///< Texture unit of the shadow atlas, after the material maps
+#define RLG_CLUSTER_TEXTURE_SLOT 12       ///< Texture unit of the light records, the cluster items use the next one
+
+#define RLG_LIGHT_BLOCK_BINDING 0       ///< Uniform buffer binding point of the light slots (GLSL 330 or higher)
+#define RLG_MATERIAL_BLOCK_BINDING 1    ///< Uniform buffer binding point of the material parameters (GLSL 330 or higher)
+
+#define RLG_INSTANCE_ATTRIB_LOCATION 8  ///< First of the four attribute locations of the instance matrices (GLSL 330 or higher)
+
+#define RLG_MAX_SHADOW_CASCADES 4       ///< NOTE: The split distances of the cascades of a light are stored in a vec4
+#define RLG_MAX_SHADOW_TILES 6          ///< Tiles of the area of a light in the shadow atlas (cube faces or cascades)
+#define RLG_SHADOW_TILES_ALL ((1 << RLG_MAX_SHADOW_TILES) - 1)
+#define RLG_SHADOW_NEAR_PLANE 0.01      ///< Near plane of the spotlight and omnilight shadow projections (also written in the shaders)
+
+#define RLG_COUNT_TEXTURE_UNITS (RLG_CLUSTER_TEXTURE_SLOT + 2)  ///< Texture units bound by the drawing functions
+
+// Fields of a light, a light slot only uploads those modified since the light was last uploaded in it
+#define RLG_LIGHT_DIRTY_MATRIX          (1 << 0)
+#define RLG_LIGHT_DIRTY_POSITION        (1 << 1)
+#define RLG_LIGHT_DIRTY_DIRECTION       (1 << 2)
+#define RLG_LIGHT_DIRTY_COLOR           (1 << 3)
+#define RLG_LIGHT_DIRTY_ENERGY          (1 << 4)
+#define RLG_LIGHT_DIRTY_SPECULAR        (1 << 5)
+#define RLG_LIGHT_DIRTY_SIZE            (1 << 6)
+#define RLG_LIGHT_DIRTY_INNER_CUTOFF    (1 << 7)
+#define RLG_LIGHT_DIRTY_OUTER_CUTOFF    (1 << 8)
+#define RLG_LIGHT_DIRTY_DISTANCE        (1 << 9)
+#define RLG_LIGHT_DIRTY_ATTENUATION     (1 << 10)
+#define RLG_LIGHT_DIRTY_SHADOW_TEXEL    (1 << 11)
+#define RLG_LIGHT_DIRTY_DEPTH_BIAS      (1 << 12)
+#define RLG_LIGHT_DIRTY_TYPE            (1 << 13)
+#define RLG_LIGHT_DIRTY_SHADOW          (1 << 14)
+#define RLG_LIGHT_DIRTY_ENABLED         (1 << 15)
+#define RLG_LIGHT_DIRTY_CASCADES        (1 << 16)
+#define RLG_LIGHT_DIRTY_SHADOW_RECT     (1 << 17)
+#define RLG_COUNT_LIGHT_FIELDS 18
+#define RLG_LIGHT_DIRTY_ALL ((1 << RLG_COUNT_LIGHT_FIELDS) - 1)
+
+// Fields of a light whose modification invalidates the static casters of its shadow cache
+#define RLG_LIGHT_SHADOW_FIELDS \
+    (RLG_LIGHT_DIRTY_POSITION | RLG_LIGHT_DIRTY_DIRECTION | RLG_LIGHT_DIRTY_DISTANCE | \
+     RLG_LIGHT_DIRTY_TYPE | RLG_LIGHT_DIRTY_SHADOW | RLG_LIGHT_DIRTY_SHADOW_RECT)
+
+// Values of the context uploaded into the model shader at the next draw
+#define RLG_DIRTY_VIEW_POSITION         (1 << 0)
+#define RLG_DIRTY_AMBIENT_COLOR         (1 << 1)
+#define RLG_DIRTY_FAR_PLANE             (1 << 2)
+#define RLG_DIRTY_PARALLAX_LAYERS       (1 << 3)
+#define RLG_DIRTY_CLUSTERS              (1 << 4)
+#define RLG_DIRTY_SHADOW_ATLAS          (1 << 5)
+#define RLG_DIRTY_AMBIENT_SH            (1 << 6)
+#define RLG_DIRTY_MAP(i)                (1 << (7 + (i)))    ///< One flag for each of the RLG_COUNT_MATERIAL_MAPS maps
+#define RLG_DIRTY_ALL (RLG_DIRTY_MAP(RLG_COUNT_MATERIAL_MAPS) - 1)
+
+#define RLG_COUNT_SHADER_FLAGS 13   ///< Number of RLG_ShaderFlag values
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#   define GL_COMPLETION_STATUS_KHR 0x91B1  ///< From KHR_parallel_shader_compile, not defined by the desktop Glad header
+#endif
 
 /* Uniform names definitions */
 
@@ -756,6 +1513,7 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 #define RLG_SHADER_ATTRIB_NORMAL                "vertexNormal"
 #define RLG_SHADER_ATTRIB_TANGENT               "vertexTangent"
 #define RLG_SHADER_ATTRIB_COLOR                 "vertexColor"
+#define RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM    "instanceTransform"
 
 #define RLG_SHADER_UNIFORM_MATRIX_MVP           "mvp"
 #define RLG_SHADER_UNIFORM_MATRIX_VIEW          "matView"
@@ -764,6 +1522,8 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 #define RLG_SHADER_UNIFORM_MATRIX_NORMAL        "matNormal"
 
 #define RLG_SHADER_UNIFORM_COLOR_AMBIENT        "colAmbient"
+#define RLG_SHADER_UNIFORM_AMBIENT_SH           "ambientSH"
+#define RLG_SHADER_UNIFORM_USE_AMBIENT_SH       "useAmbientSH"
 #define RLG_SHADER_UNIFORM_VIEW_POSITION        "viewPos"
 
 /* Embedded shaders definition */
@@ -776,10 +1536,15 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 #define GLSL_NUM_LIGHTS \
     "#define NUM_LIGHTS " TOSTRING(RLG_MAX_LIGHTS_PER_MATERIAL) "\n"
 
+#define GLSL_DEFERRED_DEF \
+    "#define NUM_LIGHTS 1\n" \
+    "#define DEFERRED\n"
+
 #if GLSL_VERSION < 330
 
 #   define GLSL_TEXTURE_DEF         "#define TEX texture2D\n"
-#   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE textureCube\n"
+#   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE textureCube\n" \
+                                    "#define TEXCUBELOD textureCube\n"   // NOTE: The level is used as a bias, no explicit LOD in fragment shaders
 
 #   define GLSL_FS_OUT_DEF          ""
 
@@ -790,10 +1555,14 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 #   define GLSL_FS_IN(x)            "varying " x ";"
 #   define GLSL_VS_OUT(x)           "varying " x ";"
 
+#   define GLSL_SHADOW_SAMPLER_DEF  "uniform sampler2D shadowAtlas;"
+#   define GLSL_SHADOW_COMPARE(uv, depth) "step(" depth ", texture2D(shadowAtlas, " uv ").r)"
+
 #else
 
 #   define GLSL_TEXTURE_DEF         "#define TEX texture\n"
-#   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE texture\n"
+#   define GLSL_TEXTURE_CUBE_DEF    "#define TEXCUBE texture\n" \
+                                    "#define TEXCUBELOD textureLod\n"
 
 #   define GLSL_FS_OUT_DEF          "out vec4 _;"
 
@@ -804,13 +1573,260 @@ unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vs
 #   define GLSL_FS_IN(x)            "in " x ";"
 #   define GLSL_VS_OUT(x)           "out " x ";"
 
+    // NOTE: The shadow atlas is sampled with depth comparison, the hardware filters the results bilinearly
+#   define GLSL_SHADOW_SAMPLER_DEF  "uniform sampler2DShadow shadowAtlas;"
+#   define GLSL_SHADOW_COMPARE(uv, depth) "texture(shadowAtlas, vec3(" uv ", " depth "))"
+
 #endif
 
+// Lighting functions shared by the model and deferred lighting shaders
+// NOTE: `fragPosition`, `PI` and the light type definitions must be declared before
+#define GLSL_LIGHTING_FUNCTIONS \
+    "float DistributionGGX(float cosTheta, float alpha)" \
+    "{" \
+        "float a = cosTheta*alpha;" \
+        "float k = alpha/(1.0 - cosTheta*cosTheta + a*a);" \
+        "return k*k*(1.0/PI);" \
+    "}" \
+    \
+    /* From Earl Hammon, Jr. "PBR Diffuse Lighting for GGX+Smith Microsurfaces" */ \
+    /* SEE: https://www.gdcvault.com/play/1024478/PBR-Diffuse-Lighting-for-GGX */ \
+    "float GeometrySmith(float NdotL, float NdotV, float alpha)" \
+    "{" \
+        "return 0.5/mix(2.0*NdotL*NdotV, NdotL + NdotV, alpha);" \
+    "}" \
+    \
+    "float SchlickFresnel(float u)" \
+    "{" \
+        "float m = 1.0 - u;" \
+        "float m2 = m*m;" \
+        "return m2*m2*m;"  /* pow(m,5) */ \
+    "}" \
+    \
+    "vec3 ComputeF0(float metallic, float specular, vec3 albedo)" \
+    "{" \
+        "float dielectric = 0.16*specular*specular;" \
+        /* use albedo*metallic as colored specular reflectance at 0 angle for metallic materials */ \
+        /* SEE: https://google.github.io/filament/Filament.md.html */ \
+        "return mix(vec3(dielectric), albedo, vec3(metallic));" \
+    "}" \
+    \
+    "struct LightData {"  /* Light parameters shared by the forward, clustered and deferred light loops */ \
+        "vec3 position;" \
+        "vec3 direction;" \
+        "vec3 color;"  /* Diffuse color of the light already multiplied by its energy */ \
+        "float specular;" \
+        "float size;" \
+        "float innerCutOff;" \
+        "float outerCutOff;" \
+        "float distance;" \
+        "float attenuation;" \
+        "lowp int type;" \
+    "};" \
+    \
+    /* Computes the diffuse and specular contributions of a light without its shadow, */ \
+    /* returns the distance attenuation and spotlight factor to apply to them */ \
+    "float ComputeLight(LightData light, vec3 N, vec3 V, float cNdotV, vec3 F0, float metalness, float roughness," \
+        "out vec3 diffLight, out vec3 specLight, out float cNdotL)" \
+    "{" \
+        "float size_A = 0.0;" \
+        "vec3 L = vec3(0.0);" \
+    \
+        /* Compute the light direction vector */ \
+        "if (light.type != DIRLIGHT)" \
+        "{" \
+            "vec3 LV = light.position - fragPosition;" \
+            "L = normalize(LV);" \
+    \
+            /* If the light has a size, compute the attenuation factor based on the distance */ \
+            "if (light.size > 0.0)" \
+            "{" \
+                "float t = light.size/max(0.001, length(LV));" \
+                "size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));" \
+            "}" \
+        "}" \
+        "else" \
+        "{" \
+            /* For directional lights, use the negative direction as the light direction */ \
+            "L = normalize(-light.direction);" \
+        "}" \
+    \
+        /* Compute the dot product of the normal and light direction, adjusted by size_A */ \
+        "float NdotL = min(size_A + dot(N, L), 1.0);" \
+        "cNdotL = max(NdotL, 0.0);"  /* clamped NdotL */ \
+    \
+        /* Compute the halfway vector between the view and light directions */ \
+        "vec3 H = normalize(V + L);" \
+        "float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);" \
+        "float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);" \
+    \
+        /* Compute diffuse lighting (Burley model) if the material is not fully metallic */ \
+        "diffLight = vec3(0.0);" \
+        "if (metalness < 1.0)" \
+        "{" \
+            "float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;" \
+            "float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);" \
+            "float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);" \
+    \
+            "float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;" \
+            "diffLight = diffBRDF*light.color;" \
+        "}" \
+    \
+        /* Compute specular lighting using the Schlick-GGX model */ \
+        /* NOTE: When roughness is 0, specular light should not be entirely disabled. */ \
+        /* TODO: Handle perfect mirror reflection when roughness is 0. */ \
+        "specLight = vec3(0.0);" \
+        "if (roughness > 0.0)" \
+        "{" \
+            "float alphaGGX = roughness*roughness;" \
+            "float D = DistributionGGX(cNdotH, alphaGGX);" \
+            "float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);" \
+    \
+            "float cLdotH5 = SchlickFresnel(cLdotH);" \
+            "float F90 = clamp(50.0*F0.g, 0.0, 1.0);" \
+            "vec3 F = F0 + (F90 - F0)*cLdotH5;" \
+    \
+            "vec3 specBRDF = cNdotL*D*F*G;" \
+            "specLight = specBRDF*light.color*light.specular;" \
+        "}" \
+    \
+        "float factor = 1.0;" \
+    \
+        /* Apply attenuation based on the distance from the light */ \
+        "if (light.type != DIRLIGHT)" \
+        "{" \
+            "float distance = length(light.position - fragPosition);" \
+            "float atten = 1.0 - clamp(distance/light.distance, 0.0, 1.0);" \
+            "factor *= atten*light.attenuation;" \
+        "}" \
+    \
+        /* Apply spotlight effect if the light is a spotlight */ \
+        "if (light.type == SPOTLIGHT)" \
+        "{" \
+            "float theta = dot(L, normalize(-light.direction));" \
+            "float epsilon = (light.innerCutOff - light.outerCutOff);" \
+            "factor *= smoothstep(0.0, 1.0, (theta - light.outerCutOff)/epsilon);" \
+        "}" \
+    \
+        "return factor;" \
+    "}"
+
+// NOTE: Requires the 'shadowAtlas' sampler (GLSL_SHADOW_SAMPLER_DEF), the area of a light in the atlas
+//       is made of square tiles (cube faces or cascades), given by the offset of its first tile
+//       and the size of one tile in UV coordinates ('rect'), and the 'farPlane' and 'linearOmniShadows'
+//       uniforms for the omnilights
+#define GLSL_SHADOW_FUNCTIONS \
+    /* Returns the coordinates of a direction in its cube face and the index of the face, */ \
+    /* following the cubemap conventions used to render the faces (+X, -X, +Y, -Y, +Z, -Z) */ \
+    "vec3 CubeFace(vec3 v)" \
+    "{" \
+        "vec3 a = abs(v);" \
+    \
+        "if (a.x >= a.y && a.x >= a.z)" \
+        "{" \
+            "return (v.x > 0.0) ? vec3(vec2(-v.z, -v.y)/a.x*0.5 + 0.5, 0.0) : vec3(vec2(v.z, -v.y)/a.x*0.5 + 0.5, 1.0);" \
+        "}" \
+    \
+        "if (a.y >= a.z)" \
+        "{" \
+            "return (v.y > 0.0) ? vec3(vec2(v.x, v.z)/a.y*0.5 + 0.5, 2.0) : vec3(vec2(v.x, -v.z)/a.y*0.5 + 0.5, 3.0);" \
+        "}" \
+    \
+        "return (v.z > 0.0) ? vec3(vec2(v.x, -v.y)/a.z*0.5 + 0.5, 4.0) : vec3(vec2(-v.x, -v.y)/a.z*0.5 + 0.5, 5.0);" \
+    "}" \
+    \
+    /* Returns the depth stored in the shadow map of an omnilight for a fragment at 'v' from the light, */ \
+    /* 'bias' being subtracted in world units: the distance to the light scaled by the far plane, */ \
+    /* or the hardware depth of the projection of the face, from the near plane to 'distance' */ \
+    "float OmniDepth(vec3 v, float bias, float distance)" \
+    "{" \
+        "if (linearOmniShadows) return (length(v) - bias)/farPlane;" \
+    \
+        "vec3 a = abs(v);" \
+        "float n = " TOSTRING(RLG_SHADOW_NEAR_PLANE) ";" \
+        "float z = max(max(max(a.x, a.y), a.z) - bias, n);" \
+        "return (distance + n - 2.0*distance*n/z)/(distance - n)*0.5 + 0.5;" \
+    "}" \
+    \
+    /* Compares 'depth' with the depth stored at 'uv' in a tile of the area of a light, returns 1.0 if lit, */ \
+    /* the coordinates are clamped to the tile so that the filtering never reads the shadow map of another light */ \
+    "float ShadowCompare(vec4 rect, float texel, vec2 tile, vec2 uv, float depth)" \
+    "{" \
+        "uv = clamp(uv, vec2(0.5*texel), vec2(1.0 - 0.5*texel));" \
+        "return " GLSL_SHADOW_COMPARE("rect.xy + (tile + uv)*rect.zw", "depth") ";" \
+    "}" \
+    \
+    /* Percentage closer filtering over 3x3 texels, with GLSL 330 each tap is filtered bilinearly */ \
+    /* by the hardware, 4 taps placed between the texels then cover the same area as 9 fetches */ \
+    "float ShadowPCF(vec4 rect, float texel, vec2 tile, vec2 uv, float depth)" \
+    "{" \
+        "float shadow = 0.0;" \
+        "\n#if __VERSION__ >= 330\n" \
+        "for (int i = 0; i < 4; i++)" \
+        "{" \
+            "vec2 offset = vec2(float(i%2), float(i/2)) - 0.5;" \
+            "shadow += ShadowCompare(rect, texel, tile, uv + offset*texel, depth);" \
+        "}" \
+        "return shadow/4.0;" \
+        "\n#else\n" \
+        "for (int x = -1; x <= 1; x++)" \
+        "{" \
+            "for (int y = -1; y <= 1; y++)" \
+            "{" \
+                "shadow += ShadowCompare(rect, texel, tile, uv + vec2(x, y)*texel, depth);" \
+            "}" \
+        "}" \
+        "return shadow/9.0;" \
+        "\n#endif\n" \
+    "}"
+
+// NOTE: The members are ordered to match the std140 layout of the light uniform block
+#define GLSL_LIGHT_DEF \
+    "struct Light {" \
+        "vec3 position;"                /* Position of the light in world coordinates */ \
+        "float energy;"                 /* Energy factor of the diffuse light color */ \
+        "vec3 direction;"               /* Direction vector of the light (for directional and spotlights) */ \
+        "float specular;"               /* Specular amount of the light */ \
+        "vec3 color;"                   /* Diffuse color of the light */ \
+        "float size;"                   /* Light size (spotlight, omnilight only) */ \
+        "float innerCutOff;"            /* Inner cutoff angle for spotlights (cosine of the angle) */ \
+        "float outerCutOff;"            /* Outer cutoff angle for spotlights (cosine of the angle) */ \
+        "float distance;"               /* Indicates the distance up to which the spotlights and omnilights shine */ \
+        "float attenuation;"            /* Light attenuation factor along the illumination distance of spotlights and omnilights */ \
+        "float shadowMapTxlSz;"         /* Texel size of the shadow map */ \
+        "float depthBias;"              /* Bias value to avoid self-shadowing artifacts */ \
+        "lowp int type;"                /* Type of the light (e.g., point, directional, spotlight) */ \
+        "lowp int shadow;"              /* Indicates if the light casts shadows (1 for true, 0 for false) */ \
+        "lowp int enabled;"             /* Indicates if the light is active (1 for true, 0 for false) */ \
+        "lowp int cascades;"            /* Number of shadow cascades of directional lights, 1 without cascades (GLSL 330 or higher) */ \
+        "vec4 shadowRect;"              /* Area of the light in the shadow atlas (offset and size of one tile in UV) */ \
+    "};"
+
+// NOTE: Shared by the vertex and fragment shaders of the model, uploaded in one buffer update
+#define GLSL_LIGHT_BLOCK \
+    "layout(std140) uniform LightBlock {" \
+        "Light lights[NUM_LIGHTS];" \
+        "mat4 matLights[NUM_LIGHTS];" \
+        "mat4 matCascades[NUM_LIGHTS*" TOSTRING(RLG_MAX_SHADOW_CASCADES) "];" \
+        "vec4 cascadeSplits[NUM_LIGHTS];" /* View depth at which each cascade ends */ \
+    "};"
+
 /* Shader */
 
 static const char G_VS_Model[] =
 {
-#   if GLSL_VERSION > 100
+#   if GLSL_VERSION >= 330
+    GLSL_LIGHT_DEF
+    GLSL_LIGHT_BLOCK
+    GLSL_VS_OUT("vec4 fragPosLightSpace[NUM_LIGHTS]")
+
+    // NOTE: Only the permutations compiled for RLG_DrawMeshInstanced() read the instance matrices
+    "\n#ifndef PERMUTATION\n"
+    "#define USE_INSTANCING"            " false\n"
+    "#endif\n"
+
+    GLSL_VS_IN("mat4 " RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM)
+#   elif GLSL_VERSION > 100
     "uniform mat4 matLights[NUM_LIGHTS];"
     GLSL_VS_OUT("vec4 fragPosLightSpace[NUM_LIGHTS]")
 #   endif
@@ -834,15 +1850,26 @@ static const char G_VS_Model[] =
 
     "void main()"
     "{"
-        "fragPosition = vec3(" RLG_SHADER_UNIFORM_MATRIX_MODEL "*vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0));"
+#       if GLSL_VERSION >= 330
+        // The instance matrices are streamed as raylib stores them (row-major), hence the transposition
+        "mat4 modelMatrix = (USE_INSTANCING) ? transpose(" RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM ") : " RLG_SHADER_UNIFORM_MATRIX_MODEL ";"
+        "mat3 normalMatrix = (USE_INSTANCING) ? transpose(inverse(mat3(modelMatrix))) : mat3(" RLG_SHADER_UNIFORM_MATRIX_NORMAL ");"
+
+        "fragPosition = vec3(modelMatrix*vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0));"
+        "fragNormal = normalMatrix*" RLG_SHADER_ATTRIB_NORMAL ";"
+#       else
+        "mat4 modelMatrix = " RLG_SHADER_UNIFORM_MATRIX_MODEL ";"
+
+        "fragPosition = vec3(modelMatrix*vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0));"
         "fragNormal = (" RLG_SHADER_UNIFORM_MATRIX_NORMAL "*vec4(" RLG_SHADER_ATTRIB_NORMAL ", 0.0)).xyz;"
+#       endif
 
         "fragTexCoord = " RLG_SHADER_ATTRIB_TEXCOORD ";"
         "fragColor = " RLG_SHADER_ATTRIB_COLOR ";"
 
         // The TBN matrix is used to transform vectors from tangent space to world space
         // It is currently used to transform normals from a normal map to world space normals
-        "vec3 T = normalize(vec3(" RLG_SHADER_UNIFORM_MATRIX_MODEL "*vec4(" RLG_SHADER_ATTRIB_TANGENT ".xyz, 0.0)));"
+        "vec3 T = normalize(vec3(modelMatrix*vec4(" RLG_SHADER_ATTRIB_TANGENT ".xyz, 0.0)));"
         "vec3 B = cross(fragNormal, T)*" RLG_SHADER_ATTRIB_TANGENT ".w;"
         "TBN = mat3(T, B, fragNormal);"
 
@@ -853,7 +1880,12 @@ static const char G_VS_Model[] =
         "}"
 #       endif
 
+#       if GLSL_VERSION >= 330
+        // NOTE: The MVP of an instanced draw does not contain the model matrix
+        "gl_Position = " RLG_SHADER_UNIFORM_MATRIX_MVP "*((USE_INSTANCING) ? modelMatrix*vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0) : vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0));"
+#       else
         "gl_Position = " RLG_SHADER_UNIFORM_MATRIX_MVP "*vec4(" RLG_SHADER_ATTRIB_POSITION ", 1.0);"
+#       endif
     "}"
 };
 
@@ -862,8 +1894,8 @@ static const char G_FS_Model[] =
     GLSL_TEXTURE_DEF
     GLSL_TEXTURE_CUBE_DEF
 
-    "#define NUM_MATERIAL_MAPS"         " 7\n"
-    "#define NUM_MATERIAL_CUBEMAPS"     " 2\n"
+    "#define NUM_MATERIAL_MAPS"         " 8\n"
+    "#define NUM_MATERIAL_CUBEMAPS"     " 3\n"
 
     "#define DIRLIGHT"                  " 0\n"
     "#define OMNILIGHT"                 " 1\n"
@@ -876,9 +1908,13 @@ static const char G_FS_Model[] =
     "#define OCCLUSION"                 " 4\n"
     "#define EMISSION"                  " 5\n"
     "#define HEIGHT"                    " 6\n"
+    "#define BRDF"                      " 7\n"
 
     "#define CUBEMAP"                   " 0\n"
     "#define IRRADIANCE"                " 1\n"
+    "#define PREFILTER"                 " 2\n"
+
+    "#define PREFILTER_MAX_LOD"         " (float(" TOSTRING(RLG_PREFILTER_MIP_LEVELS) ") - 1.0)\n"
 
     "#define PI 3.1415926535897932384626433832795028\n"
 
@@ -896,86 +1932,114 @@ static const char G_FS_Model[] =
     GLSL_FS_IN("vec4 fragColor")
     GLSL_FS_IN("mat3 TBN")
 
+#   if GLSL_VERSION >= 330
+    "\n#ifdef DEFERRED\n"
+    "layout(location = 0) out vec4 gAlbedo;"
+    "layout(location = 1) out vec4 gNormal;"
+    "layout(location = 2) out vec4 gORM;"       ///< Direct light occlusion, roughness, metalness, specular light factor
+    "layout(location = 3) out vec4 gEmission;"  ///< Emission, ambient and skybox reflection
+    "\n#else\n"
     GLSL_FS_OUT_DEF
+    "\n#endif\n"
+#   else
+    GLSL_FS_OUT_DEF
+#   endif
 
     "struct MaterialMap {"
-        "sampler2D texture;"
         "mediump vec4 color;"
         "mediump float value;"
-        "lowp int active;"
+        "lowp int enabled;"
     "};"
 
     "struct MaterialCubemap {"
-        "samplerCube texture;"
         "mediump vec4 color;"
         "mediump float value;"
-        "lowp int active;"
+        "lowp int enabled;"
     "};"
 
-    "struct Light {"
-        "samplerCube shadowCubemap;"    ///< Sampler for the shadow map texture
-        "sampler2D shadowMap;"          ///< Sampler for the shadow map texture
-        "vec3 position;"                ///< Position of the light in world coordinates
-        "vec3 direction;"               ///< Direction vector of the light (for directional and spotlights)
-        "vec3 color;"                   ///< Diffuse color of the light
-        "float energy;"                 ///< Energy factor of the diffuse light color
-        "float specular;"               ///< Specular amount of the light
-        "float size;"                   ///< Light size (spotlight, omnilight only)
-        "float innerCutOff;"            ///< Inner cutoff angle for spotlights (cosine of the angle)
-        "float outerCutOff;"            ///< Outer cutoff angle for spotlights (cosine of the angle)
-        "float distance;"               ///< Indicates the distance up to which the spotlights and omnilights shine
-        "float attenuation;"            ///< Light attenuation factor along the illumination distance of spotlights and omnilights
-        "float shadowMapTxlSz;"         ///< Texel size of the shadow map
-        "float depthBias;"              ///< Bias value to avoid self-shadowing artifacts
-        "lowp int type;"                ///< Type of the light (e.g., point, directional, spotlight)
-        "lowp int shadow;"              ///< Indicates if the light casts shadows (1 for true, 0 for false)
-        "lowp int enabled;"             ///< Indicates if the light is active (1 for true, 0 for false)
-    "};"
+    GLSL_LIGHT_DEF
+
+#   if GLSL_VERSION >= 330
+    GLSL_LIGHT_BLOCK
 
+    "layout(std140) uniform MaterialBlock {"
+        "MaterialMap maps[NUM_MATERIAL_MAPS];"
+        "MaterialCubemap cubemaps[NUM_MATERIAL_CUBEMAPS];"
+        "lowp int parallaxMinLayers;"
+        "lowp int parallaxMaxLayers;"
+    "};"
+#   else
     "uniform MaterialCubemap cubemaps[NUM_MATERIAL_CUBEMAPS];"
     "uniform MaterialMap maps[NUM_MATERIAL_MAPS];"
     "uniform Light lights[NUM_LIGHTS];"
 
     "uniform lowp int parallaxMinLayers;"
     "uniform lowp int parallaxMaxLayers;"
+#   endif
+
+    // NOTE: Samplers are kept out of the structs, they cannot be stored in uniform blocks
+    "uniform sampler2D mapTextures[NUM_MATERIAL_MAPS];"
+    "uniform samplerCube cubemapTextures[NUM_MATERIAL_CUBEMAPS];"
+    GLSL_SHADOW_SAMPLER_DEF             ///< Shadow maps of all the lights, each one reads its area of the atlas
+
+#   if GLSL_VERSION >= 330
+    "uniform samplerBuffer clusterLights;"  ///< Light records of the clustered lights (4 texels per light)
+    "uniform usamplerBuffer clusterItems;"  ///< Offset and count of each cluster, followed by the light indices
+    "uniform ivec3 clusterGrid;"            ///< Number of clusters along X, Y and Z
+    "uniform vec3 clusterDepth;"            ///< Depth slice scale, bias and logarithmic distribution flag
+    "uniform lowp int useClusters;"
+
+    "uniform mat4 matView;"
+    "uniform mat4 matProjection;"
+#   endif
 
     "uniform float farPlane;"   ///< Used to scale depth values ​​when reading the depth cubemap (point shadows)
+    "uniform bool linearOmniShadows;"   ///< The omnilight shadow maps store the distance to the light (see RLG_UseLinearOmniShadows)
 
     "uniform vec3 " RLG_SHADER_UNIFORM_COLOR_AMBIENT ";"
     "uniform vec3 " RLG_SHADER_UNIFORM_VIEW_POSITION ";"
 
-    "float DistributionGGX(float cosTheta, float alpha)"
-    "{"
-        "float a = cosTheta*alpha;"
-        "float k = alpha/(1.0 - cosTheta*cosTheta + a*a);"
-        "return k*k*(1.0/PI);"
-    "}"
+    "uniform vec3 " RLG_SHADER_UNIFORM_AMBIENT_SH "[9];"     ///< L2 spherical harmonics of the ambient light (see RLG_SetAmbientSH)
+    "uniform bool " RLG_SHADER_UNIFORM_USE_AMBIENT_SH ";"
+
+    // Features of the material, defined as constants by the prefix of the permutations
+    // NOTE: The branches on these constants are removed by the compiler (see RLG_ShaderFlag)
+    "\n#ifndef PERMUTATION\n"
+    "#define USE_ALBEDO_MAP"            " (maps[ALBEDO].enabled != 0)\n"
+    "#define USE_METALNESS_MAP"         " (maps[METALNESS].enabled != 0)\n"
+    "#define USE_NORMAL_MAP"            " (maps[NORMAL].enabled != 0)\n"
+    "#define USE_ROUGHNESS_MAP"         " (maps[ROUGHNESS].enabled != 0)\n"
+    "#define USE_OCCLUSION_MAP"         " (maps[OCCLUSION].enabled != 0)\n"
+    "#define USE_EMISSION_MAP"          " (maps[EMISSION].enabled != 0)\n"
+    "#define USE_HEIGHT_MAP"            " (maps[HEIGHT].enabled != 0)\n"
+    "#define USE_CUBEMAP"               " (cubemaps[CUBEMAP].enabled != 0)\n"
+    "#define USE_IRRADIANCE_MAP"        " (cubemaps[IRRADIANCE].enabled != 0)\n"
+    "#define USE_DEEP_PARALLAX"         " (parallaxMinLayers > 0 && parallaxMaxLayers > 1)\n"
+    "#define RECEIVE_SHADOW"            " true\n"
+#   if GLSL_VERSION >= 330
+    "#define USE_CLUSTERS"              " (useClusters != 0)\n"
+#   endif
+    "#endif\n"
 
-    // From Earl Hammon, Jr. "PBR Diffuse Lighting for GGX+Smith Microsurfaces"
-    // SEE: https://www.gdcvault.com/play/1024478/PBR-Diffuse-Lighting-for-GGX
-    "float GeometrySmith(float NdotL, float NdotV, float alpha)"
-    "{"
-        "return 0.5/mix(2.0*NdotL*NdotV, NdotL + NdotV, alpha);"
-    "}"
+    // The split-sum reflection needs both the prefiltered cubemap and the BRDF LUT of the skybox
+    "#define USE_PREFILTER_MAP"         " (USE_CUBEMAP && cubemaps[PREFILTER].enabled != 0 && maps[BRDF].enabled != 0)\n"
 
-    "float SchlickFresnel(float u)"
-    "{"
-        "float m = 1.0 - u;"
-        "float m2 = m*m;"
-        "return m2*m2*m;" // pow(m,5)
-    "}"
+    GLSL_LIGHTING_FUNCTIONS
+    GLSL_SHADOW_FUNCTIONS
 
-    "vec3 ComputeF0(float metallic, float specular, vec3 albedo)"
+    // Irradiance in the direction 'n' given by the spherical harmonics of the ambient light
+    "vec3 IrradianceSH(vec3 n)"
     "{"
-        "float dielectric = 0.16*specular*specular;"
-        // use albedo*metallic as colored specular reflectance at 0 angle for metallic materials
-        // SEE: https://google.github.io/filament/Filament.md.html
-        "return mix(vec3(dielectric), albedo, vec3(metallic));"
+        "return " RLG_SHADER_UNIFORM_AMBIENT_SH "[0]"
+            " + " RLG_SHADER_UNIFORM_AMBIENT_SH "[1]*n.y + " RLG_SHADER_UNIFORM_AMBIENT_SH "[2]*n.z + " RLG_SHADER_UNIFORM_AMBIENT_SH "[3]*n.x"
+            " + " RLG_SHADER_UNIFORM_AMBIENT_SH "[4]*n.x*n.y + " RLG_SHADER_UNIFORM_AMBIENT_SH "[5]*n.y*n.z"
+            " + " RLG_SHADER_UNIFORM_AMBIENT_SH "[6]*(3.0*n.z*n.z - 1.0)"
+            " + " RLG_SHADER_UNIFORM_AMBIENT_SH "[7]*n.x*n.z + " RLG_SHADER_UNIFORM_AMBIENT_SH "[8]*(n.x*n.x - n.y*n.y);"
     "}"
 
     "vec2 Parallax(vec2 uv, vec3 V)"
     "{"
-        "float height = 1.0 - TEX(maps[HEIGHT].texture, uv).r;"
+        "float height = 1.0 - TEX(mapTextures[HEIGHT], uv).r;"
         "return uv - vec2(V.xy/V.z)*height*maps[HEIGHT].value;"
     "}"
 
@@ -993,18 +2057,18 @@ static const char G_FS_Model[] =
         "vec2 deltaTexCoord = P/numLayers;"
     
         "vec2 currentUV = uv;"
-        "float currentDepthMapValue = 1.0 - TEX(maps[HEIGHT].texture, currentUV).y;"
+        "float currentDepthMapValue = 1.0 - TEX(mapTextures[HEIGHT], currentUV).y;"
         
         "while(currentLayerDepth < currentDepthMapValue)"
         "{"
             "currentUV += deltaTexCoord;"
             "currentLayerDepth += layerDepth;"
-            "currentDepthMapValue = 1.0 - TEX(maps[HEIGHT].texture, currentUV).y;"
+            "currentDepthMapValue = 1.0 - TEX(mapTextures[HEIGHT], currentUV).y;"
         "}"
 
         "vec2 prevTexCoord = currentUV - deltaTexCoord;"
         "float afterDepth  = currentDepthMapValue + currentLayerDepth;"
-        "float beforeDepth = 1.0 - TEX(maps[HEIGHT].texture,"
+        "float beforeDepth = 1.0 - TEX(mapTextures[HEIGHT],"
             "prevTexCoord).y - currentLayerDepth - layerDepth;"
 
         "float weight = afterDepth/(afterDepth - beforeDepth);"
@@ -1014,11 +2078,11 @@ static const char G_FS_Model[] =
     "float ShadowOmni(int i, float cNdotL)"
     "{"
         "vec3 fragToLight = fragPosition - lights[i].position;"
-        "float closestDepth = TEXCUBE(lights[i].shadowCubemap, fragToLight).r;"
-        "closestDepth *= farPlane;" // Rescale depth
-        "float currentDepth = length(fragToLight);"
+        "vec3 face = CubeFace(fragToLight);"  // The faces are stored on 3 columns and 2 rows
+        "vec2 tile = vec2(mod(face.z, 3.0), floor(face.z/3.0));"
         "float bias = lights[i].depthBias*max(1.0 - cNdotL, 0.05);"
-        "return currentDepth - bias > closestDepth ? 0.0 : 1.0;"
+        "float depth = OmniDepth(fragToLight, bias, lights[i].distance);"
+        "return ShadowCompare(lights[i].shadowRect, lights[i].shadowMapTxlSz, tile, face.xy, depth);"
     "}"
 
     "float Shadow(int i, float cNdotL)"
@@ -1029,31 +2093,35 @@ static const char G_FS_Model[] =
         "vec4 p = matLights[i]*vec4(fragPosition, 1.0);"
 #       endif
 
+        "vec2 tile = vec2(0.0);"
+
+#       if GLSL_VERSION >= 330
+        // Select the first cascade that ends beyond the view depth of the fragment, the cascades are stored on one row
+        "if (lights[i].cascades > 1)"
+        "{"
+            "float viewZ = -(matView*vec4(fragPosition, 1.0)).z;"
+            "if (viewZ > cascadeSplits[i][lights[i].cascades - 1]) return 1.0;"
+
+            "int cascade = 0;"
+            "while (viewZ > cascadeSplits[i][cascade]) cascade++;"
+
+            "p = matCascades[i*" TOSTRING(RLG_MAX_SHADOW_CASCADES) " + cascade]*vec4(fragPosition, 1.0);"
+            "tile.x = float(cascade);"
+        "}"
+#       endif
+
         "vec3 projCoords = p.xyz/p.w;"
         "projCoords = projCoords*0.5 + 0.5;"
 
         "float bias = max(lights[i].depthBias*(1.0 - cNdotL), 0.00002) + 0.00001;"
         "projCoords.z -= bias;"
 
-        "if (projCoords.z > 1.0 || projCoords.x > 1.0 || projCoords.y > 1.0)"
+        "if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.y < 0.0 || projCoords.x > 1.0 || projCoords.y > 1.0)"
         "{"
             "return 1.0;"
         "}"
 
-        "float depth = projCoords.z;"
-        "float shadow = 0.0;"
-
-        // NOTE: You can increase iterations to improve PCF quality
-        "for (int x = -1; x <= 1; x++)"
-        "{"
-            "for (int y = -1; y <= 1; y++)"
-            "{"
-                "float pcfDepth = TEX(lights[i].shadowMap, projCoords.xy + vec2(x, y)*lights[i].shadowMapTxlSz).r;"
-                "shadow += step(depth, pcfDepth);"
-            "}"
-        "}"
-
-        "return shadow/9.0;"
+        "return ShadowPCF(lights[i].shadowRect, lights[i].shadowMapTxlSz, tile, projCoords.xy, projCoords.z);"
     "}"
 
     "void main()"
@@ -1063,10 +2131,9 @@ static const char G_FS_Model[] =
 
         // Compute fragTexCoord (UV), apply parallax if height map is enabled
         "vec2 uv = fragTexCoord;"
-        "if (maps[HEIGHT].active != 0)"
+        "if (USE_HEIGHT_MAP)"
         "{"
-            "uv = (parallaxMinLayers > 0 && parallaxMaxLayers > 1)"
-                "? DeepParallax(uv, V) : Parallax(uv, V);"
+            "uv = (USE_DEEP_PARALLAX) ? DeepParallax(uv, V) : Parallax(uv, V);"
 
             "if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0)"
             "{"
@@ -1076,25 +2143,25 @@ static const char G_FS_Model[] =
 
         // Compute albedo (base color) by sampling the texture and multiplying by the diffuse color
         "vec3 albedo = maps[ALBEDO].color.rgb*fragColor.rgb;"
-        "if (maps[ALBEDO].active != 0)"
-            "albedo *= TEX(maps[ALBEDO].texture, uv).rgb;"
+        "if (USE_ALBEDO_MAP)"
+            "albedo *= TEX(mapTextures[ALBEDO], uv).rgb;"
 
         // Compute metallic factor; if a metalness map is used, sample it
         "float metalness = maps[METALNESS].value;"
-        "if (maps[METALNESS].active != 0)"
-            "metalness *= TEX(maps[METALNESS].texture, uv).b;"
+        "if (USE_METALNESS_MAP)"
+            "metalness *= TEX(mapTextures[METALNESS], uv).b;"
 
         // Compute roughness factor; if a roughness map is used, sample it
         "float roughness = maps[ROUGHNESS].value;"
-        "if (maps[ROUGHNESS].active != 0)"
-            "roughness *= TEX(maps[ROUGHNESS].texture, uv).g;"
+        "if (USE_ROUGHNESS_MAP)"
+            "roughness *= TEX(mapTextures[ROUGHNESS], uv).g;"
 
         // Compute F0 (reflectance at normal incidence) based on the metallic factor
         "vec3 F0 = ComputeF0(metalness, 0.5, albedo);"
 
         // Compute the normal vector; if a normal map is used, transform it to tangent space
-        "vec3 N = (maps[NORMAL].active == 0) ? normalize(fragNormal)"
-            ": normalize(TBN*(TEX(maps[NORMAL].texture, uv).rgb*2.0 - 1.0));"
+        "vec3 N = (USE_NORMAL_MAP) ? normalize(TBN*(TEX(mapTextures[NORMAL], uv).rgb*2.0 - 1.0))"
+            ": normalize(fragNormal);"
 
         // Compute the dot product of the normal and view direction
         "float NdotV = dot(N, V);"
@@ -1104,222 +2171,458 @@ static const char G_FS_Model[] =
         "vec3 diffLighting = vec3(0.0);"
         "vec3 specLighting = vec3(0.0);"
 
-        // Loop through all lights
+        // Loop through all lights (done by the lighting passes when rendering the G-buffer)
+        "\n#ifndef DEFERRED\n"
         "for (int i = 0; i < NUM_LIGHTS; i++)"
         "{"
             "if (lights[i].enabled != 0)"
             "{"
-                "float size_A = 0.0;"
-                "vec3 L = vec3(0.0);"
+                "LightData light = LightData("
+                    "lights[i].position, lights[i].direction, lights[i].color*lights[i].energy,"
+                    "lights[i].specular, lights[i].size, lights[i].innerCutOff, lights[i].outerCutOff,"
+                    "lights[i].distance, lights[i].attenuation, lights[i].type);"
 
-                // Compute the light direction vector
-                "if (lights[i].type != DIRLIGHT)"
-                "{"
-                    "vec3 LV = lights[i].position - fragPosition;"
-                    "L = normalize(LV);"
-
-                    // If the light has a size, compute the attenuation factor based on the distance
-                    "if (lights[i].size > 0.0)"
-                    "{"
-                        "float t = lights[i].size/max(0.001, length(LV));"
-                        "size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));"
-                    "}"
-                "}"
-                "else"
+                "vec3 diffLight, specLight; float cNdotL;"
+                "float factor = ComputeLight(light, N, V, cNdotV, F0, metalness, roughness, diffLight, specLight, cNdotL);"
+
+                // Apply shadow factor if the light casts shadows
+                "if (RECEIVE_SHADOW && lights[i].shadow != 0)"
                 "{"
-                    // For directional lights, use the negative direction as the light direction
-                    "L = normalize(-lights[i].direction);"
+                    "factor *= (lights[i].type == OMNILIGHT)"
+                        "? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);"
                 "}"
 
-                // Compute the dot product of the normal and light direction, adjusted by size_A
-                "float NdotL = min(size_A + dot(N, L), 1.0);"
-                "float cNdotL = max(NdotL, 0.0);" // clamped NdotL
-
-                // Compute the halfway vector between the view and light directions
-                "vec3 H = normalize(V + L);"
-                "float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);"
-                "float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);"
-
-                // Compute light color energy
-                "vec3 lightColE = lights[i].color*lights[i].energy;"
+                // Accumulate the diffuse and specular lighting contributions
+                "diffLighting += diffLight*factor;"
+                "specLighting += specLight*factor;"
+            "}"
+        "}"
 
-                // Compute diffuse lighting (Burley model) if the material is not fully metallic
-                "vec3 diffLight = vec3(0.0);"
-                "if (metalness < 1.0)"
-                "{"
-                    "float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;"
-                    "float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);"
-                    "float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);"
+#   if GLSL_VERSION >= 330
+        // Loop through the lights binned in the cluster of this fragment
+        "if (USE_CLUSTERS)"
+        "{"
+            "vec4 viewPosition = matView*vec4(fragPosition, 1.0);"
+            "vec4 clipPosition = matProjection*viewPosition;"
+            "vec2 ndc = clamp(clipPosition.xy/clipPosition.w*0.5 + 0.5, 0.0, 0.999);"
 
-                    "float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;"
-                    "diffLight = diffBRDF*lightColE;"
-                "}"
+            "float viewZ = max(-viewPosition.z, 1e-4);"
+            "float slice = ((clusterDepth.z != 0.0) ? log(viewZ) : viewZ)*clusterDepth.x + clusterDepth.y;"
 
-                // Compute specular lighting using the Schlick-GGX model
-                // NOTE: When roughness is 0, specular light should not be entirely disabled.
-                // TODO: Handle perfect mirror reflection when roughness is 0.
-                "vec3 specLight = vec3(0.0);"
-                "if (roughness > 0.0)"
-                "{"
-                    "float alphaGGX = roughness*roughness;"
-                    "float D = DistributionGGX(cNdotH, alphaGGX);"
-                    "float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);"
+            "ivec3 cell = ivec3(ivec2(ndc*vec2(clusterGrid.xy)), clamp(int(slice), 0, clusterGrid.z - 1));"
+            "int cluster = cell.x + clusterGrid.x*(cell.y + clusterGrid.y*cell.z);"
 
-                    "float cLdotH5 = SchlickFresnel(cLdotH);"
-                    "float F90 = clamp(50.0*F0.g, 0.0, 1.0);"
-                    "vec3 F = F0 + (F90 - F0)*cLdotH5;"
+            "int offset = int(texelFetch(clusterItems, 2*cluster).r);"
+            "int count = int(texelFetch(clusterItems, 2*cluster + 1).r);"
 
-                    "vec3 specBRDF = cNdotL*D*F*G;"
-                    "specLight = specBRDF*lightColE*lights[i].specular;"
-                "}"
+            "for (int k = 0; k < count; k++)"
+            "{"
+                "int index = 4*int(texelFetch(clusterItems, offset + k).r);"
 
-                // Apply shadow factor if the light casts shadows
-                "float shadow = 1.0;"
-                "if (lights[i].shadow != 0)"
-                "{"
-                    "shadow = (lights[i].type == OMNILIGHT)"
-                        "? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);"
-                "}"
+                "vec4 t0 = texelFetch(clusterLights, index);"       // position, distance
+                "vec4 t1 = texelFetch(clusterLights, index + 1);"   // direction, type
+                "vec4 t2 = texelFetch(clusterLights, index + 2);"   // color*energy, specular
+                "vec4 t3 = texelFetch(clusterLights, index + 3);"   // size, innerCutOff, outerCutOff, attenuation
 
-                // Apply attenuation based on the distance from the light
-                "if (lights[i].type != DIRLIGHT) {"
-                    "float distance = length(lights[i].position - fragPosition);"
-                    "float atten = 1.0 - clamp(distance / lights[i].distance, 0.0, 1.0);"
-                    "shadow *= atten*lights[i].attenuation;"
-                "}"
+                "LightData light = LightData(t0.xyz, t1.xyz, t2.xyz, t2.w, t3.x, t3.y, t3.z, t0.w, t3.w, int(t1.w));"
 
-                // Apply spotlight effect if the light is a spotlight
-                "if (lights[i].type == SPOTLIGHT)"
-                "{"
-                    "float theta = dot(L, normalize(-lights[i].direction));"
-                    "float epsilon = (lights[i].innerCutOff - lights[i].outerCutOff);"
-                    "shadow *= smoothstep(0.0, 1.0, (theta - lights[i].outerCutOff)/epsilon);"
-                "}"
+                "vec3 diffLight, specLight; float cNdotL;"
+                "float factor = ComputeLight(light, N, V, cNdotV, F0, metalness, roughness, diffLight, specLight, cNdotL);"
 
-                // Accumulate the diffuse and specular lighting contributions
-                "diffLighting += diffLight*shadow;"
-                "specLighting += specLight*shadow;"
+                "diffLighting += diffLight*factor;"
+                "specLighting += specLight*factor;"
             "}"
         "}"
+#   endif
+        "\n#endif\n"
 
         // Compute ambient
         "vec3 ambient = " RLG_SHADER_UNIFORM_COLOR_AMBIENT ";"
-        "if (cubemaps[IRRADIANCE].active != 0)"
+        "if (" RLG_SHADER_UNIFORM_USE_AMBIENT_SH " || USE_IRRADIANCE_MAP)"
         "{"
             "vec3 kS = F0 + (1.0 - F0)*SchlickFresnel(cNdotV);"
             "vec3 kD = (1.0 - kS)*(1.0 - metalness);"
-            "ambient = kD*TEXCUBE(cubemaps[IRRADIANCE].texture, N).rgb;"
+            "ambient = kD*(" RLG_SHADER_UNIFORM_USE_AMBIENT_SH " ? IrradianceSH(N) : TEXCUBE(cubemapTextures[IRRADIANCE], N).rgb);"
         "}"
 
-        // Compute ambient occlusion
-        "if (maps[OCCLUSION].active != 0)"
+        // Compute ambient occlusion, also affects direct lighting according to the map value
+        "float lightAffect = 1.0;"
+        "if (USE_OCCLUSION_MAP)"
         "{"
-            "float ao = TEX(maps[OCCLUSION].texture, uv).r;"
+            "float ao = TEX(mapTextures[OCCLUSION], uv).r;"
             "ambient *= ao;"
 
-            "float lightAffect = mix(1.0, ao, maps[OCCLUSION].value);"
-            "diffLighting *= lightAffect;"
-            "specLighting *= lightAffect;"
+            "lightAffect = mix(1.0, ao, maps[OCCLUSION].value);"
         "}"
 
-        // Skybox reflection
-        "if (cubemaps[CUBEMAP].active != 0)"
+        // Skybox reflection, the prefiltered radiance of the roughness is scaled by the BRDF LUT (split-sum),
+        // otherwise the specular lighting is blended with the mirror reflection according to the roughness
+        "vec3 reflection = vec3(0.0);"
+        "float specAffect = lightAffect;"
+        "if (USE_PREFILTER_MAP)"
         "{"
-            "vec3 reflectCol = TEXCUBE(cubemaps[CUBEMAP].texture, reflect(-V, N)).rgb;"
-            "specLighting = mix(specLighting, reflectCol, 1.0 - roughness);"
+            "vec3 prefiltered = TEXCUBELOD(cubemapTextures[PREFILTER], reflect(-V, N), roughness*PREFILTER_MAX_LOD).rgb;"
+            "vec2 brdf = TEX(mapTextures[BRDF], vec2(cNdotV, roughness)).rg;"
+            "reflection = prefiltered*(F0*brdf.x + brdf.y);"
+        "}"
+        "else if (USE_CUBEMAP)"
+        "{"
+            "vec3 reflectCol = TEXCUBE(cubemapTextures[CUBEMAP], reflect(-V, N)).rgb;"
+            "reflection = reflectCol*(1.0 - roughness);"
+            "specAffect *= roughness;"
         "}"
-
-        // Compute the final diffuse color, including ambient and diffuse lighting contributions
-        "vec3 diffuse = albedo*(ambient + diffLighting);"
 
         // Compute emission color; if an emissive map is used, sample it
         "vec3 emission = maps[EMISSION].color.rgb;"
-        "if (maps[EMISSION].active != 0)"
+        "if (USE_EMISSION_MAP)"
         "{"
-            "emission *= TEX(maps[EMISSION].texture, uv).rgb;"
+            "emission *= TEX(mapTextures[EMISSION], uv).rgb;"
         "}"
 
-        // Compute the final fragment color by combining diffuse, specular, and emission contributions
-        GLSL_FINAL_COLOR("vec4(diffuse + specLighting + emission, 1.0)")
-    "}"
-};
-
-static const char G_VS_Depth[] =
-{
-    GLSL_VERSION_DEF
-    GLSL_VS_IN("vec3 vertexPosition")
-    "uniform mat4 mvp;"
-    "void main()"
-    "{"
-        "gl_Position = mvp*vec4(vertexPosition, 1.0);"
-    "}"
-};
+        "\n#ifdef DEFERRED\n"
 
-static const char G_FS_Depth[] =
-{
-    GLSL_VERSION_DEF
-    GLSL_PRECISION("mediump float")
-    "void main(){}"
-};
+        // Write the surface to the G-buffer, the lighting passes will add the lights contributions
+        "gAlbedo = vec4(albedo, 1.0);"
+        "gNormal = vec4(N, 1.0);"
+        "gORM = vec4(lightAffect, roughness, metalness, specAffect);"
+        "gEmission = vec4(albedo*ambient + reflection + emission, 1.0);"
 
-static const char G_VS_DepthCubemap[] =
-{
-    GLSL_VERSION_DEF
+        "\n#else\n"
 
-    GLSL_VS_IN("vec3 vertexPosition")
-    GLSL_VS_OUT("vec3 fragPosition")
+        // Compute the final diffuse color, including ambient and diffuse lighting contributions
+        "vec3 diffuse = albedo*(ambient + diffLighting*lightAffect);"
+        "vec3 specular = specLighting*specAffect + reflection;"
 
-    "uniform mat4 matModel;"
-    "uniform mat4 mvp;"
+        // Compute the final fragment color by combining diffuse, specular, and emission contributions
+        GLSL_FINAL_COLOR("vec4(diffuse + specular + emission, 1.0)")
 
-    "void main()"
-    "{"
-        "fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));"
-        "gl_Position = mvp*vec4(vertexPosition, 1.0);"
+        "\n#endif\n"
     "}"
 };
 
-static const char G_FS_DepthCubemap[] =
+static const char G_VS_Screen[] =
 {
     GLSL_VERSION_DEF
+    GLSL_VS_OUT("vec2 fragTexCoord")
 
-    GLSL_PRECISION("mediump float")
-    GLSL_FS_IN("vec3 fragPosition")
-
-    "uniform vec3 lightPos;"
-    "uniform float farPlane;"
-
+    // Fullscreen triangle generated from the vertex index, no vertex buffer is needed
     "void main()"
     "{"
-        "float lightDistance = length(fragPosition - lightPos);"
-        "lightDistance = lightDistance/farPlane;"
-        "gl_FragDepth = lightDistance;"
+        "vec2 position = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;"
+        "fragTexCoord = position*0.5 + 0.5;"
+        "gl_Position = vec4(position, 0.0, 1.0);"
     "}"
 };
 
-// NOTE: This shader is no longer used currently, I keep it just in case
-static const char G_FS_DEBUG_DepthMapDrawing[] =
+static const char G_FS_DeferredAmbient[] =
 {
     GLSL_VERSION_DEF
-
-    GLSL_PRECISION("mediump float")
     GLSL_FS_IN("vec2 fragTexCoord")
-
-    "uniform sampler2D texture0;"
-    "uniform float near;"
-    "uniform float far;"
-
     GLSL_FS_OUT_DEF
 
+    "uniform sampler2D gEmission;"
+    "uniform sampler2D gDepth;"
+
+    // Copy the emission/ambient term and the depth of the G-buffer into the target
     "void main()"
     "{"
-        "float depth = TEX(texture0, vec2(fragTexCoord.x, 1.0 - fragTexCoord.y)).r;"
-        "depth = (2.0*near*far)/(far + near - (depth*2.0 - 1.0)*(far - near));"
-        GLSL_FINAL_COLOR("vec4(vec3(depth/far), 1.0)")
+        "float depth = texture(gDepth, fragTexCoord).r;"
+        "if (depth == 1.0) discard;"
+
+        "gl_FragDepth = depth;"
+        GLSL_FINAL_COLOR("vec4(texture(gEmission, fragTexCoord).rgb, 1.0)")
     "}"
 };
 
-static const char G_VS_Cubemap[] =
+static const char G_FS_DeferredLighting[] =
+{
+    GLSL_VERSION_DEF
+    GLSL_TEXTURE_DEF
+
+    "#define DIRLIGHT"                  " 0\n"
+    "#define OMNILIGHT"                 " 1\n"
+    "#define SPOTLIGHT"                 " 2\n"
+
+    "#define PI 3.1415926535897932384626433832795028\n"
+
+    GLSL_FS_IN("vec2 fragTexCoord")
+    GLSL_FS_OUT_DEF
+
+    "struct Light {"
+        "vec3 position;"
+        "vec3 direction;"
+        "vec3 color;"
+        "float energy;"
+        "float specular;"
+        "float size;"
+        "float innerCutOff;"
+        "float outerCutOff;"
+        "float distance;"
+        "float attenuation;"
+        "float shadowMapTxlSz;"
+        "float depthBias;"
+        "lowp int type;"
+        "lowp int shadow;"
+        "lowp int enabled;"
+        "lowp int cascades;"
+        "vec4 shadowRect;"
+    "};"
+
+    "uniform sampler2D gAlbedo;"
+    "uniform sampler2D gNormal;"
+    "uniform sampler2D gORM;"
+    "uniform sampler2D gDepth;"
+    GLSL_SHADOW_SAMPLER_DEF
+
+    "uniform Light light;"
+    "uniform mat4 matLight;"
+    "uniform mat4 matCascades[" TOSTRING(RLG_MAX_SHADOW_CASCADES) "];"
+    "uniform vec4 cascadeSplits;"
+    "uniform mat4 matView;"
+    "uniform mat4 matInvViewProj;"  ///< Used to reconstruct the world position from the depth
+
+    "uniform float farPlane;"
+    "uniform bool linearOmniShadows;"
+    "uniform vec3 " RLG_SHADER_UNIFORM_VIEW_POSITION ";"
+
+    "vec3 fragPosition;"
+
+    GLSL_LIGHTING_FUNCTIONS
+    GLSL_SHADOW_FUNCTIONS
+
+    "float ShadowOmni(float cNdotL)"
+    "{"
+        "vec3 fragToLight = fragPosition - light.position;"
+        "vec3 face = CubeFace(fragToLight);"
+        "vec2 tile = vec2(mod(face.z, 3.0), floor(face.z/3.0));"
+        "float bias = light.depthBias*max(1.0 - cNdotL, 0.05);"
+        "return ShadowCompare(light.shadowRect, light.shadowMapTxlSz, tile, face.xy, OmniDepth(fragToLight, bias, light.distance));"
+    "}"
+
+    "float Shadow(float cNdotL)"
+    "{"
+        "vec4 p = matLight*vec4(fragPosition, 1.0);"
+
+        "vec2 tile = vec2(0.0);"
+        "if (light.cascades > 1)"
+        "{"
+            "float viewZ = -(matView*vec4(fragPosition, 1.0)).z;"
+            "if (viewZ > cascadeSplits[light.cascades - 1]) return 1.0;"
+
+            "int cascade = 0;"
+            "while (viewZ > cascadeSplits[cascade]) cascade++;"
+
+            "p = matCascades[cascade]*vec4(fragPosition, 1.0);"
+            "tile.x = float(cascade);"
+        "}"
+
+        "vec3 projCoords = p.xyz/p.w*0.5 + 0.5;"
+        "projCoords.z -= max(light.depthBias*(1.0 - cNdotL), 0.00002) + 0.00001;"
+
+        "if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.y < 0.0 || projCoords.x > 1.0 || projCoords.y > 1.0)"
+        "{"
+            "return 1.0;"
+        "}"
+
+        "return ShadowPCF(light.shadowRect, light.shadowMapTxlSz, tile, projCoords.xy, projCoords.z);"
+    "}"
+
+    "void main()"
+    "{"
+        "float depth = texture(gDepth, fragTexCoord).r;"
+        "if (depth == 1.0) discard;"
+
+        // Reconstruct the world position of the surface
+        "vec4 p = matInvViewProj*vec4(vec3(fragTexCoord, depth)*2.0 - 1.0, 1.0);"
+        "fragPosition = p.xyz/p.w;"
+
+        "vec3 albedo = texture(gAlbedo, fragTexCoord).rgb;"
+        "vec3 N = normalize(texture(gNormal, fragTexCoord).xyz);"
+        "vec4 orm = texture(gORM, fragTexCoord);"
+
+        "vec3 V = normalize(" RLG_SHADER_UNIFORM_VIEW_POSITION " - fragPosition);"
+        "float cNdotV = max(dot(N, V), 1e-4);"
+        "vec3 F0 = ComputeF0(orm.b, 0.5, albedo);"
+
+        "LightData data = LightData("
+            "light.position, light.direction, light.color*light.energy,"
+            "light.specular, light.size, light.innerCutOff, light.outerCutOff,"
+            "light.distance, light.attenuation, light.type);"
+
+        "vec3 diffLight, specLight; float cNdotL;"
+        "float factor = ComputeLight(data, N, V, cNdotV, F0, orm.b, orm.g, diffLight, specLight, cNdotL);"
+
+        "if (light.shadow != 0)"
+        "{"
+            "factor *= (light.type == OMNILIGHT) ? ShadowOmni(cNdotL) : Shadow(cNdotL);"
+        "}"
+
+        // NOTE: Added to the target with additive blending
+        GLSL_FINAL_COLOR("vec4((albedo*diffLight*orm.r + specLight*orm.a)*factor, 1.0)")
+    "}"
+};
+
+static const char G_VS_Depth[] =
+{
+    GLSL_VERSION_DEF
+    GLSL_VS_IN("vec3 vertexPosition")
+    "uniform mat4 mvp;"
+    "void main()"
+    "{"
+        "gl_Position = mvp*vec4(vertexPosition, 1.0);"
+    "}"
+};
+
+static const char G_FS_Depth[] =
+{
+    GLSL_VERSION_DEF
+    GLSL_PRECISION("mediump float")
+    "void main(){}"
+};
+
+static const char G_VS_DepthCubemap[] =
+{
+    GLSL_VERSION_DEF
+
+    GLSL_VS_IN("vec3 vertexPosition")
+    GLSL_VS_OUT("vec3 fragPosition")
+
+    "uniform mat4 matModel;"
+    "uniform mat4 mvp;"
+
+    "void main()"
+    "{"
+        "fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));"
+        "gl_Position = mvp*vec4(vertexPosition, 1.0);"
+    "}"
+};
+
+static const char G_VS_DepthInstanced[] =
+{
+    GLSL_VERSION_DEF
+    GLSL_VS_IN("vec3 vertexPosition")
+    GLSL_VS_IN("mat4 " RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM)
+    "uniform mat4 mvp;"
+    "void main()"
+    "{"
+        "gl_Position = mvp*transpose(" RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM ")*vec4(vertexPosition, 1.0);"
+    "}"
+};
+
+static const char G_VS_DepthCubemapInstanced[] =
+{
+    GLSL_VERSION_DEF
+
+    GLSL_VS_IN("vec3 vertexPosition")
+    GLSL_VS_IN("mat4 " RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM)
+    GLSL_VS_OUT("vec3 fragPosition")
+
+    "uniform mat4 mvp;"
+
+    "void main()"
+    "{"
+        "vec4 worldPosition = transpose(" RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM ")*vec4(vertexPosition, 1.0);"
+        "fragPosition = worldPosition.xyz;"
+        "gl_Position = mvp*worldPosition;"
+    "}"
+};
+
+static const char G_FS_DepthCubemap[] =
+{
+    GLSL_VERSION_DEF
+
+    GLSL_PRECISION("mediump float")
+    GLSL_FS_IN("vec3 fragPosition")
+
+    "uniform vec3 lightPos;"
+    "uniform float farPlane;"
+
+    "void main()"
+    "{"
+        "float lightDistance = length(fragPosition - lightPos);"
+        "lightDistance = lightDistance/farPlane;"
+        "gl_FragDepth = lightDistance;"
+    "}"
+};
+
+#if GLSL_VERSION >= 330
+// NOTE: Renders the six faces of an omnilight in a single pass (GLSL 330 or higher), the vertex shader
+//       outputs world positions and each triangle is emitted once per face it covers, remapped into
+//       the tile of the face (3x2 tiles, same layout as the passes of RLG_UpdateShadowMap())
+static const char G_GS_DepthCubemapLayered[] =
+{
+    GLSL_VERSION_DEF
+
+    "layout(triangles) in;"
+    "layout(triangle_strip, max_vertices = 18) out;"
+
+    "out vec3 fragPosition;"
+
+    "uniform mat4 matFaces[6];"
+
+    "void main()"
+    "{"
+        "for (int face = 0; face < 6; face++)"
+        "{"
+            "vec4 p0 = matFaces[face]*gl_in[0].gl_Position;"
+            "vec4 p1 = matFaces[face]*gl_in[1].gl_Position;"
+            "vec4 p2 = matFaces[face]*gl_in[2].gl_Position;"
+
+            // Skip the faces the triangle is entirely outside of
+            "vec3 x = vec3(p0.x, p1.x, p2.x), y = vec3(p0.y, p1.y, p2.y);"
+            "vec3 z = vec3(p0.z, p1.z, p2.z), w = vec3(p0.w, p1.w, p2.w);"
+
+            "if (all(greaterThan(x, w)) || all(lessThan(x, -w)) ||"
+                "all(greaterThan(y, w)) || all(lessThan(y, -w)) ||"
+                "all(greaterThan(z, w)) || all(lessThan(z, -w))) continue;"
+
+            // Offset of the tile of the face in the clip space of the whole area of the light
+            "vec2 offset = vec2(float(face%3)*2.0 - 2.0, float(face/3)*2.0 - 1.0);"
+
+            "for (int i = 0; i < 3; i++)"
+            "{"
+                "vec4 p = (i == 0) ? p0 : ((i == 1) ? p1 : p2);"
+
+                // The clip distances restrict the triangle to the tile of the face
+                "gl_Position = vec4((p.x + p.w*offset.x)/3.0, (p.y + p.w*offset.y)/2.0, p.z, p.w);"
+                "gl_ClipDistance[0] = p.w - p.x;"
+                "gl_ClipDistance[1] = p.w + p.x;"
+                "gl_ClipDistance[2] = p.w - p.y;"
+                "gl_ClipDistance[3] = p.w + p.y;"
+
+                "fragPosition = gl_in[i].gl_Position.xyz;"
+                "EmitVertex();"
+            "}"
+
+            "EndPrimitive();"
+        "}"
+    "}"
+};
+#endif
+
+// NOTE: This shader is no longer used currently, I keep it just in case
+static const char G_FS_DEBUG_DepthMapDrawing[] =
+{
+    GLSL_VERSION_DEF
+
+    GLSL_PRECISION("mediump float")
+    GLSL_FS_IN("vec2 fragTexCoord")
+
+    "uniform sampler2D texture0;"
+    "uniform float near;"
+    "uniform float far;"
+
+    GLSL_FS_OUT_DEF
+
+    "void main()"
+    "{"
+        "float depth = TEX(texture0, vec2(fragTexCoord.x, 1.0 - fragTexCoord.y)).r;"
+        "depth = (2.0*near*far)/(far + near - (depth*2.0 - 1.0)*(far - near));"
+        GLSL_FINAL_COLOR("vec4(vec3(depth/far), 1.0)")
+    "}"
+};
+
+static const char G_VS_Cubemap[] =
 {
     GLSL_VERSION_DEF
 
@@ -1415,6 +2718,145 @@ static const char G_FS_IrradianceConvolution[] =
     "}"
 };
 
+// NOTE: The radical inverse is computed with floats, integer bit operations are missing below GLSL 130
+#define GLSL_IMPORTANCE_SAMPLING_FUNCTIONS \
+    "float RadicalInverse(float i)" \
+    "{" \
+        "float result = 0.0;" \
+        "float base = 0.5;" \
+        "for (int bit = 0; bit < 10; bit++)" \
+        "{" \
+            "result += mod(i, 2.0)*base;" \
+            "i = floor(i*0.5);" \
+            "base *= 0.5;" \
+        "}" \
+        "return result;" \
+    "}" \
+    \
+    "vec3 ImportanceSampleGGX(vec2 Xi, vec3 N, float a)" \
+    "{" \
+        "float phi = 2.0*PI*Xi.x;" \
+        "float cosTheta = sqrt((1.0 - Xi.y)/(1.0 + (a*a - 1.0)*Xi.y));" \
+        "float sinTheta = sqrt(1.0 - cosTheta*cosTheta);" \
+        \
+        "vec3 up = (abs(N.z) < 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);" \
+        "vec3 tangent = normalize(cross(up, N));" \
+        "vec3 bitangent = cross(N, tangent);" \
+        \
+        "return normalize(tangent*(cos(phi)*sinTheta) + bitangent*(sin(phi)*sinTheta) + N*cosTheta);" \
+    "}"
+
+static const char G_FS_PrefilterConvolution[] =
+{
+    GLSL_VERSION_DEF
+    GLSL_TEXTURE_CUBE_DEF
+
+    "#define PI 3.14159265359\n"
+    "#define SAMPLE_COUNT 64\n"
+
+    GLSL_PRECISION("highp float")
+    GLSL_FS_IN("vec3 fragPosition")
+    GLSL_FS_OUT_DEF
+
+    "uniform samplerCube environmentMap;"
+    "uniform float roughness;"      ///< Roughness of the mip level being rendered
+    "uniform float resolution;"     ///< Size of the faces of the environment map
+
+    GLSL_IMPORTANCE_SAMPLING_FUNCTIONS
+
+    "void main()"
+    "{"
+        // The view and reflection directions are assumed equal to the normal (isotropic lobe)
+        "vec3 N = normalize(fragPosition);"
+        "float a = roughness*roughness;"
+
+        // Solid angle covered by a texel of the environment map
+        "float saTexel = 4.0*PI/(6.0*resolution*resolution);"
+
+        "vec3 color = vec3(0.0);"
+        "float weight = 0.0;"
+
+        "for (int i = 0; i < SAMPLE_COUNT; i++)"
+        "{"
+            "vec2 Xi = vec2(float(i)/float(SAMPLE_COUNT), RadicalInverse(float(i)));"
+            "vec3 H = ImportanceSampleGGX(Xi, N, a);"
+            "vec3 L = normalize(2.0*dot(N, H)*H - N);"
+
+            "float NdotL = dot(N, L);"
+            "if (NdotL > 0.0)"
+            "{"
+                // Sample the mip whose texels cover the solid angle of the sample,
+                // few samples are then enough to avoid bright dots on the rough levels
+                "float NdotH = max(dot(N, H), 0.0);"
+                "float d = NdotH*NdotH*(a*a - 1.0) + 1.0;"
+                "float pdf = a*a/(4.0*PI*d*d) + 0.0001;"
+                "float saSample = 1.0/(float(SAMPLE_COUNT)*pdf);"
+                "float lod = (roughness > 0.0) ? max(0.5*log2(saSample/saTexel) + 1.0, 0.0) : 0.0;"
+
+                "color += TEXCUBELOD(environmentMap, L, lod).rgb*NdotL;"
+                "weight += NdotL;"
+            "}"
+        "}"
+
+        GLSL_FINAL_COLOR("vec4(color/weight, 1.0)")
+    "}"
+};
+
+static const char G_FS_BRDFIntegration[] =
+{
+    GLSL_VERSION_DEF
+
+    "#define PI 3.14159265359\n"
+    "#define SAMPLE_COUNT 256\n"
+
+    GLSL_PRECISION("highp float")
+    GLSL_FS_IN("vec2 fragTexCoord")
+    GLSL_FS_OUT_DEF
+
+    GLSL_IMPORTANCE_SAMPLING_FUNCTIONS
+
+    "float GeometrySchlickGGX(float NdotV, float k)"
+    "{"
+        "return NdotV/(NdotV*(1.0 - k) + k);"
+    "}"
+
+    // Scale and bias applied to F0 by the split-sum approximation, for a NdotV (X) and a roughness (Y)
+    "void main()"
+    "{"
+        "float NdotV = max(fragTexCoord.x, 1e-4);"
+        "float roughness = fragTexCoord.y;"
+        "float a = roughness*roughness;"
+        "float k = a*0.5;"  // Remapping of the geometry term for image based lighting
+
+        "vec3 N = vec3(0.0, 0.0, 1.0);"
+        "vec3 V = vec3(sqrt(1.0 - NdotV*NdotV), 0.0, NdotV);"
+
+        "vec2 scaleBias = vec2(0.0);"
+
+        "for (int i = 0; i < SAMPLE_COUNT; i++)"
+        "{"
+            "vec2 Xi = vec2(float(i)/float(SAMPLE_COUNT), RadicalInverse(float(i)));"
+            "vec3 H = ImportanceSampleGGX(Xi, N, a);"
+            "vec3 L = normalize(2.0*dot(V, H)*H - V);"
+
+            "float NdotL = L.z;"
+            "if (NdotL > 0.0)"
+            "{"
+                "float NdotH = max(H.z, 1e-4);"
+                "float VdotH = max(dot(V, H), 0.0);"
+
+                "float G = GeometrySchlickGGX(NdotV, k)*GeometrySchlickGGX(NdotL, k);"
+                "float Gvis = G*VdotH/(NdotH*NdotV);"
+                "float Fc = pow(1.0 - VdotH, 5.0);"
+
+                "scaleBias += vec2((1.0 - Fc)*Gvis, Fc*Gvis);"
+            "}"
+        "}"
+
+        GLSL_FINAL_COLOR("vec4(scaleBias/float(SAMPLE_COUNT), 0.0, 1.0)")
+    "}"
+};
+
 static const char G_VS_Skybox[] =
 {
     GLSL_VERSION_DEF
@@ -1434,6 +2876,24 @@ static const char G_VS_Skybox[] =
     "}"
 };
 
+static const char G_VS_SkyboxFullscreen[] =
+{
+    GLSL_VERSION_DEF
+
+    GLSL_VS_IN("vec3 vertexPosition")
+    GLSL_VS_OUT("vec3 fragPosition")
+
+    "uniform mat4 matInvViewProj;"
+
+    // Triangle covering the screen on the far plane, the view ray of each corner is unprojected
+    "void main()"
+    "{"
+        "vec4 ray = matInvViewProj*vec4(vertexPosition.xy, 1.0, 1.0);"
+        "fragPosition = ray.xyz/ray.w;"
+        "gl_Position = vec4(vertexPosition.xy, 1.0, 1.0);"
+    "}"
+};
+
 static const char G_FS_Skybox[] =
 {
     GLSL_VERSION_DEF
@@ -1464,11 +2924,31 @@ static const char G_FS_Skybox[] =
 
 /* Types definitions */
 
-struct RLG_ShadowMap
+struct RLG_ShadowMap ///< NOTE: Area of a light in the shadow atlas, made of square tiles (cube faces or cascades)
 {
-    Texture2D depth;
-    unsigned int id;
-    int width, height;
+    int x, y;           ///< Position of the area in the atlas, in pixels
+    int resolution;     ///< Resolution of one tile, zero if the light has no shadow map
+    int columns, rows;  ///< Number of tiles along X and Y
+};
+
+struct RLG_ShadowAtlas
+{
+    Texture2D depth;    ///< Depth texture shared by the shadow maps of all the lights
+    unsigned int id;    ///< Framebuffer, created at the first call to RLG_EnableShadow()
+};
+
+struct RLG_ShadowSchedule ///< NOTE: Update state of the tiles of a light, see RLG_UpdateShadowMaps()
+{
+    unsigned int frames[RLG_MAX_SHADOW_TILES];      ///< Value of the update counter when each tile was last rendered, zero if never
+    unsigned int versions[RLG_MAX_SHADOW_TILES];    ///< Version of the light when each tile was last rendered
+    RLG_ShadowUpdateInfo info;                      ///< Decision of the last RLG_UpdateShadowMaps()
+};
+
+struct RLG_ShadowCache ///< NOTE: State of the static casters of a light, see RLG_UpdateShadowMapCached()
+{
+    unsigned int version;   ///< Version of the light when its static casters were rendered
+    bool cached;            ///< The shadow cache holds the static casters of the light (GLSL 330 or higher)
+    bool current;           ///< The area of the light in the shadow atlas only holds its static casters
 };
 
 struct RLG_Material ///< NOTE: This struct is used to handle data that cannot be stored in the MaterialMap struct of raylib.
@@ -1479,24 +2959,51 @@ struct RLG_Material ///< NOTE: This struct is used to handle data that cannot be
         int parallaxMinLayers;
         int parallaxMaxLayers;
     }
-    locs;
+    data;
+};
 
+struct RLG_Light ///< NOTE: Light of the context, uploaded into a shader slot at draw time if it illuminates the mesh
+{
     struct
     {
-        int useMaps[RLG_COUNT_MATERIAL_MAPS];
-        int parallaxMinLayers;
-        int parallaxMaxLayers;
+        struct RLG_ShadowMap shadowMap;
+        Matrix vpMatrix;    ///< NOTE: Not present in the Light shader struct but in a separate uniform
+        Matrix cascadeMatrices[RLG_MAX_SHADOW_CASCADES];    ///< View-projection matrix of each cascade (separate uniforms too)
+        float cascadeSplits[RLG_MAX_SHADOW_CASCADES];       ///< View depth at which each cascade ends
+        float cascadeDistance;  ///< View depth covered by the cascades, set by RLG_SetShadowCascades()
+        int cascadeCount;       ///< Number of cascades set by RLG_SetShadowCascades(), used when the shadow map is created
+        Vector3 position;
+        Vector3 direction;
+        Vector3 color;
+        float energy;
+        float specular;
+        float size;
+        float innerCutOff;
+        float outerCutOff;
+        float distance;
+        float attenuation;
+        float shadowMapTxlSz;
+        float depthBias;
+        int type;
+        int shadow;
+        int enabled;
+        int cascades;       ///< Number of tiles of the shadow map, 1 if it is not a cascaded shadow map
+        Vector4 shadowRect; ///< Offset of the area of the light in the shadow atlas and size of one tile (UV)
     }
     data;
+
+    unsigned int version;   ///< Incremented on each modification, tells the slots when the light must be re-uploaded
+    unsigned int fieldVersions[RLG_COUNT_LIGHT_FIELDS]; ///< Version of the light at the last modification of each field
+
+    struct RLG_ShadowCache shadowCache;
+    struct RLG_ShadowSchedule shadowSchedule;
 };
 
-struct RLG_Light
+struct RLG_LightSlot ///< NOTE: Corresponds to an entry of the `lights` uniform array of the lighting shader
 {
     struct
     {
         int vpMatrix;       ///< NOTE: Not present in the Light shader struct but in a separate uniform
-        int shadowCubemap;
-        int shadowMap;
         int position;
         int direction;
         int color;
@@ -1512,29 +3019,72 @@ struct RLG_Light
         int type;
         int shadow;
         int enabled;
+        int cascades;
+        int shadowRect;
+        int matCascades;    ///< NOTE: Not present in the Light shader struct but in separate uniforms
+        int cascadeSplits;
     }
     locs;
 
+    int light;              ///< Index of the light currently uploaded in this slot, -1 if the slot is disabled
+    unsigned int version;   ///< Version of the light when it was uploaded in this slot
+};
+
+struct RLG_SlotAssignment ///< NOTE: Light assigned to a slot, each program receives it when it is used for drawing
+{
+    int light;              ///< Index of the light assigned to the slot, -1 if the slot is disabled
+    unsigned int version;   ///< Version of the light when it was assigned (written in the light uniform block with GLSL 330)
+};
+
+struct RLG_PendingProgram ///< NOTE: Program submitted to the driver, its statuses are checked once it is completed
+{
+    unsigned int program;
+    unsigned int vs, fs;            ///< Zero when the program was loaded from the binary cache
+    unsigned int gs;                ///< Zero when the program has no geometry shader (GLSL 330 or higher)
+    unsigned long long cacheKey;    ///< Key of the program in the binary cache (GLSL 330 or higher)
+    bool saveBinary;                ///< The binary is saved in the cache once linked
+    bool pending;
+};
+
+struct RLG_MaterialUniforms ///< NOTE: Material values sent as uniforms, stored in the material uniform block with GLSL 330
+{
+    float colDiffuse[4];
+    float colSpecular[4];
+    float colEmission[4];
+    float metalness;
+    float roughness;
+    float aoLightAffect;
+    float heightScale;
+};
+
+struct RLG_ModelProgram ///< NOTE: Permutation of the model shader, with the uniform state of its program
+{
+    Shader shader;
+    unsigned int flags;     ///< RLG_ShaderFlag combination the program was compiled for (unused by the default program)
+
+    struct RLG_LightSlot slots[RLG_MAX_LIGHTS_PER_MATERIAL];
+
     struct
     {
-        struct RLG_ShadowMap shadowMap;
-        Vector3 position;
-        Vector3 direction;
-        Vector3 color;
-        float energy;
-        float specular;
-        float size;
-        float innerCutOff;
-        float outerCutOff;
-        float distance;
-        float attenuation;
-        float shadowMapTxlSz;
-        float depthBias;
-        int type;
-        int shadow;
-        int enabled;
+        int useMaps[RLG_COUNT_MATERIAL_MAPS];
+        int parallaxMinLayers;
+        int parallaxMaxLayers;
+        int farPlane;
+        int linearOmniShadows;
+        int shadowAtlas;
+        int useClusters;
+        int clusterLights;
+        int clusterItems;
+        int clusterGrid;
+        int clusterDepth;
+        int instanceTransform;  ///< First attribute location of the instance matrices, -1 if the program does not read them
     }
-    data;
+    locs;
+
+    unsigned int dirty;     ///< RLG_DIRTY_* flags of the context values to upload into this program at its next use
+
+    struct RLG_MaterialUniforms material;   ///< Material values last uploaded into the program (below GLSL 330)
+    unsigned int samplers;                  ///< Bits of the material maps whose texture unit was uploaded into the program
 };
 
 struct RLG_SkyboxHandler
@@ -1546,6 +3096,186 @@ struct RLG_SkyboxHandler
     unsigned int previousCubemapID;  /*< Indicates whether to update the data sent to the skybox
                                          shader if different from the ID of the skybox to render */
     int locDoGamma;
+
+    int locDoGammaFullscreen;       ///< Same as locDoGamma, for the fullscreen skybox shader
+    int locInvViewProj;             ///< Inverse view-projection (without translation) of the fullscreen skybox shader
+
+    int locPrefilterRoughness;      ///< Roughness of the mip level rendered by the prefilter shader
+    int locPrefilterResolution;     ///< Size of the faces of the cubemap read by the prefilter shader
+
+    Texture2D brdfLUT;              ///< Split-sum BRDF lookup texture, generated with the first skybox and shared by all of them
+};
+
+struct RLG_SkyboxUpdate ///< NOTE: Regeneration of a skybox spread over several frames, see RLG_UpdateSkybox()
+{
+    RLG_Skybox *target;             ///< Skybox receiving the back set once all the passes are rendered, NULL between two updates
+    RLG_Skybox back;                ///< Textures rendered pass by pass, swapped with the ones of the target at the end
+    struct RLG_SHProjection *sh;    ///< Irradiance projected face by face, if the target has no irradiance cubemap
+    float *pixels;                  ///< RGBA texels of the face read back for the spherical harmonics
+    unsigned int fbo[2];            ///< Framebuffers to draw into the back set, and to read the faces of the source
+    int pass;                       ///< Next pass to render
+    int passCount;
+};
+
+struct RLG_LightBlock ///< NOTE: std140 layout of the 'LightBlock' uniform block of the model shader
+{
+    struct
+    {
+        Vector3 position;   float energy;
+        Vector3 direction;  float specular;
+        Vector3 color;      float size;
+        float innerCutOff, outerCutOff;
+        float distance, attenuation;
+        float shadowMapTxlSz, depthBias;
+        int type, shadow;
+        int enabled, cascades;
+        int padding[2];
+        Vector4 shadowRect;
+    }
+    lights[RLG_MAX_LIGHTS_PER_MATERIAL];
+
+    float matLights[RLG_MAX_LIGHTS_PER_MATERIAL][16];   ///< Column-major, as given by MatrixToFloatV()
+    float matCascades[RLG_MAX_LIGHTS_PER_MATERIAL*RLG_MAX_SHADOW_CASCADES][16];
+    float cascadeSplits[RLG_MAX_LIGHTS_PER_MATERIAL][4];
+};
+
+struct RLG_MaterialBlock ///< NOTE: std140 layout of the 'MaterialBlock' uniform block of the model shader
+{
+    struct
+    {
+        float color[4];
+        float value;
+        int enabled;
+        int padding[2];
+    }
+    maps[8], cubemaps[3];   ///< Same sizes as NUM_MATERIAL_MAPS and NUM_MATERIAL_CUBEMAPS in the shader
+
+    int parallaxMinLayers;
+    int parallaxMaxLayers;
+    int padding[2];
+};
+
+struct RLG_UniformBlocks ///< NOTE: Only used with GLSL 330 or higher
+{
+    struct RLG_LightBlock lights;
+    struct RLG_MaterialBlock material;
+
+    unsigned int lightsBuffer;
+    unsigned int materialBuffer;
+
+    bool lightsDirty;       ///< The light slots changed since the last upload
+    bool materialDirty;     ///< The material parameters changed since the last upload
+};
+
+struct RLG_ClusterHandler ///< NOTE: Only used with GLSL 330 or higher
+{
+    unsigned int lightsBuffer;      ///< Texture buffer of the clustered light records (4 RGBA32F texels per light)
+    unsigned int lightsTexture;
+    unsigned int itemsBuffer;       ///< Texture buffer of the offset/count of each cluster followed by the light indices (R32UI)
+    unsigned int itemsTexture;
+
+    float *lights;                  ///< CPU copy of the light records
+    unsigned int *items;            ///< CPU copy of the cluster items
+    unsigned int *pairs;            ///< (cluster, light record) pairs produced by the binning
+    BoundingBox *froxels;           ///< View space bounds of each cluster
+
+    int lightsCapacity;             ///< Number of light records that can be stored in `lights`
+    int itemsCapacity;              ///< Number of items that can be stored in `items`
+    int pairsCapacity;              ///< Number of pairs that can be stored in `pairs`
+    int lightsBufferSize;           ///< Size in bytes of the data store of `lightsBuffer`
+    int itemsBufferSize;            ///< Size in bytes of the data store of `itemsBuffer`
+
+    Matrix matView;                 ///< View matrix used by the last binning
+    Matrix matProjection;           ///< Projection matrix used to build the froxels
+    unsigned int versions[RLG_MAX_LIGHTS];  ///< Versions of the lights at the last binning
+    bool binned[RLG_MAX_LIGHTS];            ///< Indicates if the light was binned in the clusters at the last binning
+
+    float zNear;                    ///< Near and far planes of the projection used to build the froxels
+    float zFar;
+    float depthScale;               ///< Scale and bias giving the depth slice of a view depth (or of its log)
+    float depthBias;
+    bool depthLog;                  ///< Logarithmic slice distribution (perspective), linear for orthographic projections
+
+    bool enabled;
+    bool dirty;                     ///< Forces the froxels to be rebuilt and the lights to be binned on the next draw
+};
+
+struct RLG_DeferredHandler ///< NOTE: Only used with GLSL 330 or higher
+{
+    unsigned int framebuffer;       ///< G-buffer framebuffer
+    unsigned int albedo;            ///< RGBA8: Albedo
+    unsigned int normal;            ///< RGBA16F: World space normal
+    unsigned int orm;               ///< RGBA8: Direct light occlusion, roughness, metalness, specular light factor
+    unsigned int emission;          ///< RGBA16F: Emission, ambient and skybox reflection
+    unsigned int depth;
+    int width, height;
+
+    unsigned int vao;               ///< Empty vertex array used to draw the fullscreen triangles
+
+    int target;                     ///< Framebuffer bound by RLG_BeginDeferred(), receives the lighting
+    int viewport[4];                ///< Viewport of the target
+
+    Vector3 colAmbient;             ///< Last uploaded ambient color of the G-buffer shader
+    Vector3 viewPos;                ///< Last uploaded view position of the G-buffer shader
+    bool ambientSHDirty;            ///< The spherical harmonics of the ambient light changed since the last upload
+
+    struct RLG_LightSlot light;     ///< Light uniforms of the lighting pass shader
+    int locInvViewProj;
+    int locView;
+    int locViewPos;
+    int locFarPlane;
+    int locLinearOmniShadows;
+
+    bool active;
+};
+
+struct RLG_StateTracker ///< NOTE: GL state bound by the drawing functions, kept bound between the draws of a batch
+{
+    unsigned int program;                               ///< Program currently bound, 0 if none
+    unsigned int vertexArray;                           ///< Vertex array currently bound, 0 if none
+    unsigned int textures[RLG_COUNT_TEXTURE_UNITS];     ///< Texture bound to each unit, 0 if none
+    unsigned int targets[RLG_COUNT_TEXTURE_UNITS];      ///< Target of the texture bound to each unit (2D, cubemap or buffer)
+    bool blocks;                                        ///< The uniform blocks are bound to their binding points (GLSL 330 or higher)
+    bool batch;                                         ///< Between RLG_BeginBatch() and RLG_EndBatch()
+};
+
+struct RLG_MeshBounds ///< NOTE: Local bounding box of a mesh, computed from its vertices the first time it is seen
+{
+    unsigned int vboId;             ///< Position buffer of the mesh, 0 for an empty entry
+    const float *vertices;          ///< Vertices the box was computed from, a different pointer means that the buffer ID was reused
+    int vertexCount;
+    BoundingBox aabb;
+};
+
+struct RLG_BoundsCache
+{
+    struct RLG_MeshBounds *entries; ///< Open addressing hash table indexed by the position buffer of the meshes
+    int count;
+    int capacity;                   ///< Number of entries, always a power of two
+};
+
+struct RLG_QueueEntry ///< NOTE: Draw submitted by RLG_Submit(), issued by RLG_FlushQueue()
+{
+    Mesh mesh;
+    Material material;
+    Matrix transform;
+};
+
+struct RLG_QueueKey
+{
+    unsigned long long key;         ///< Flags (13 bits) | textures (19 bits) | vertex array (16 bits) | view depth (16 bits)
+    unsigned int entry;             ///< Index of the entry in the `entries` of the queue
+};
+
+struct RLG_DrawQueue
+{
+    struct RLG_QueueEntry *entries; ///< Draws submitted since RLG_BeginQueue(), in submission order
+    struct RLG_QueueKey *keys;      ///< Sort keys of the entries
+    struct RLG_QueueKey *scratch;   ///< Second buffer of the radix sort of `keys`
+
+    int count;
+    int capacity;                   ///< Number of entries that can be stored in each array
+    bool active;                    ///< Between RLG_BeginQueue() and RLG_FlushQueue()
 };
 
 static struct RLG_Core
@@ -1558,27 +3288,96 @@ static struct RLG_Core
     /* Shaders */
 
     Shader shaders[RLG_COUNT_SHADERS];
+    struct RLG_PendingProgram pending[RLG_COUNT_SHADERS];   ///< Programs submitted at the context creation, not set up yet
+    bool parallelCompile;                                   ///< KHR_parallel_shader_compile is supported
+    bool ready;                                             ///< All the shaders of the context are set up
 
     /* Skybox handling data */
 
     struct RLG_SkyboxHandler skybox;
+    struct RLG_SkyboxUpdate skyboxUpdate;
 
     /* Lighting shader data*/
 
-    struct RLG_Light lights[RLG_MAX_LIGHTS_PER_MATERIAL];
+    struct RLG_Light lights[RLG_MAX_LIGHTS];
+    struct RLG_SlotAssignment slots[RLG_MAX_LIGHTS_PER_MATERIAL];
     struct RLG_Material material;
+    struct RLG_UniformBlocks blocks;
+
+    /* Shadow mapping data */
+
+    struct RLG_ShadowAtlas shadowAtlas;
+    struct RLG_ShadowAtlas shadowCache;     ///< Static casters of the cached shadow maps, at the same place as in the atlas
+    unsigned int shadowFrame;               ///< Update counter of the shadow tiles, incremented by RLG_UpdateShadowMaps()
+
+    /* Clustered shading data */
+
+    struct RLG_ClusterHandler clusters;
+
+    /* Deferred shading data */
+
+    struct RLG_DeferredHandler deferred;
 
     Vector3 colAmbient;
     Vector3 viewPos;
 
+    Vector3 ambientSH[RLG_SH_COEFFICIENTS];     ///< Spherical harmonics of the ambient light, set by RLG_SetAmbientSH()
+    bool useAmbientSH;
+    bool useSkyboxSH;                           ///< The skybox loaders project the irradiance into spherical harmonics
+    bool useSkyboxCPU;                          ///< RLG_LoadSkyboxHDR() converts the panorama into cubemap faces on the CPU
+    bool useSkyboxDepthTest;                    ///< RLG_DrawSkybox() draws a fullscreen triangle tested against the depth of the scene
+
     /* Special values ​​and uniforms */
 
     float zNear;
     float zFar;
 
+    Camera3D shadowCamera;      ///< Camera the shadow cascades are fit to, set by RLG_SetShadowCamera()
+    bool useShadowCamera;
+
     int locDepthCubemapLightPos;
     int locDepthCubemapFar;
-    int locLightingFar;
+    int locDepthCubemapInstancedLightPos;
+    int locDepthCubemapInstancedFar;
+    int locDepthCubemapLayeredLightPos;
+    int locDepthCubemapLayeredFar;
+    int locDepthCubemapLayeredFaces;
+    int locDepthCubemapLayeredInstancedLightPos;
+    int locDepthCubemapLayeredInstancedFar;
+    int locDepthCubemapLayeredInstancedFaces;
+    int locDepthLayeredFaces;
+    int locDepthLayeredInstancedFaces;
+
+    bool linearOmniShadows;     ///< The omnilight shadow maps store the distance to the light instead of hardware depth
+
+    bool useCullingBounds;      ///< The casts are culled against `matCullingBounds` instead of the rlgl matrices
+    Matrix matCullingBounds;    ///< Maps the cube reached by an omnilight to the clip volume during its single pass update
+
+    /* Model shader permutations */
+
+    struct RLG_ModelProgram programs[RLG_MAX_SHADER_PERMUTATIONS];  ///< NOTE: The first one is the default program (runtime branches)
+    int programCount;
+    bool usePermutations;
+
+    /* GL state tracking */
+
+    struct RLG_StateTracker state;
+
+    /* Sorted draw queue */
+
+    struct RLG_DrawQueue queue;
+
+    /* Frustum culling data */
+
+    struct RLG_BoundsCache bounds;
+    bool useCulling;
+
+    /* Instanced drawing data */
+
+    unsigned int instanceBuffer;    ///< Vertex buffer of the instance matrices (GLSL 330 or higher)
+    int instanceBufferSize;         ///< Size in bytes of the data store of `instanceBuffer`
+
+    RLG_Stats stats;
 }
 *rlgCtx = NULL;
 
@@ -1592,15 +3391,40 @@ static struct RLG_Core
     static const char
         *G_VS_CACHE_DepthCubemap = G_VS_DepthCubemap,
         *G_FS_CACHE_DepthCubemap = G_FS_DepthCubemap;
+    static const char
+        *G_VS_CACHE_DepthInstanced = G_VS_DepthInstanced,
+        *G_FS_CACHE_DepthInstanced = G_FS_Depth;
+    static const char
+        *G_VS_CACHE_DepthCubemapInstanced = G_VS_DepthCubemapInstanced,
+        *G_FS_CACHE_DepthCubemapInstanced = G_FS_DepthCubemap;
+#if GLSL_VERSION >= 330
+    static const char
+        *G_GS_CACHE_DepthCubemapLayered = G_GS_DepthCubemapLayered;
+#endif
     static const char
         *G_VS_CACHE_IrradianceConvolution = G_VS_Cubemap,
         *G_FS_CACHE_IrradianceConvolution = G_FS_IrradianceConvolution;
     static const char
         *G_VS_CACHE_EquirectangularToCubemap = G_VS_Cubemap,
         *G_FS_CACHE_EquirectangularToCubemap = G_FS_EquirectangularToCubemap;
+    static const char
+        *G_VS_CACHE_PrefilterConvolution = G_VS_Cubemap,
+        *G_FS_CACHE_PrefilterConvolution = G_FS_PrefilterConvolution;
+    static const char
+        *G_VS_CACHE_BRDFIntegration = G_VS_Screen,
+        *G_FS_CACHE_BRDFIntegration = G_FS_BRDFIntegration;
     static const char
         *G_VS_CACHE_Skybox = G_VS_Skybox,
         *G_FS_CACHE_Skybox = G_FS_Skybox;
+    static const char
+        *G_VS_CACHE_SkyboxFullscreen = G_VS_SkyboxFullscreen,
+        *G_FS_CACHE_SkyboxFullscreen = G_FS_Skybox;
+    static const char
+        *G_VS_CACHE_DeferredAmbient = G_VS_Screen,
+        *G_FS_CACHE_DeferredAmbient = G_FS_DeferredAmbient;
+    static const char
+        *G_VS_CACHE_DeferredLighting = G_VS_Screen,
+        *G_FS_CACHE_DeferredLighting = G_FS_DeferredLighting;
 #else
     static const char
         *G_FS_CACHE_Model                       = NULL,
@@ -1609,2186 +3433,6648 @@ static struct RLG_Core
         *G_FS_CACHE_Depth                       = NULL,
         *G_VS_CACHE_DepthCubemap                = NULL,
         *G_FS_CACHE_DepthCubemap                = NULL,
+        *G_VS_CACHE_DepthInstanced              = NULL,
+        *G_FS_CACHE_DepthInstanced              = NULL,
+        *G_VS_CACHE_DepthCubemapInstanced       = NULL,
+        *G_FS_CACHE_DepthCubemapInstanced       = NULL,
         *G_VS_CACHE_IrradianceConvolution       = NULL,
         *G_FS_CACHE_IrradianceConvolution       = NULL,
         *G_VS_CACHE_EquirectangularToCubemap    = NULL,
         *G_FS_CACHE_EquirectangularToCubemap    = NULL,
+        *G_VS_CACHE_PrefilterConvolution        = NULL,
+        *G_FS_CACHE_PrefilterConvolution        = NULL,
+        *G_VS_CACHE_BRDFIntegration             = NULL,
+        *G_FS_CACHE_BRDFIntegration             = NULL,
         *G_VS_CACHE_Skybox                      = NULL,
-        *G_FS_CACHE_Skybox                      = NULL;
+        *G_FS_CACHE_Skybox                      = NULL,
+        *G_VS_CACHE_SkyboxFullscreen            = NULL,
+        *G_FS_CACHE_SkyboxFullscreen            = NULL,
+        *G_VS_CACHE_DeferredAmbient             = NULL,
+        *G_FS_CACHE_DeferredAmbient             = NULL,
+        *G_VS_CACHE_DeferredLighting            = NULL,
+        *G_FS_CACHE_DeferredLighting            = NULL;
+#if GLSL_VERSION >= 330
+    static const char
+        *G_GS_CACHE_DepthCubemapLayered         = NULL;
+#endif
 #endif //NO_EMBEDDED_SHADERS
 
-/* Public API */
+static char G_ShaderCacheDirectory[512] = { 0 };    ///< Empty when the program binary cache is disabled
 
-RLG_Context RLG_CreateContext(void)
+/* Internal functions */
+
+static BoundingBox RLG_TransformAABB(BoundingBox aabb, Matrix transform)
 {
-    // On-heap allocation for the context's core structure, initializing it with zeros
-    struct RLG_Core *rlgCtx = (struct RLG_Core*)calloc(1, sizeof(struct RLG_Core));
+    Vector3 center = Vector3Scale(Vector3Add(aabb.min, aabb.max), 0.5f);
+    Vector3 extents = Vector3Scale(Vector3Subtract(aabb.max, aabb.min), 0.5f);
+
+    // Transform the center and compute the new extents from the absolute values of the rotation/scale part
+    Vector3 newCenter = Vector3Transform(center, transform);
+    Vector3 newExtents = {
+        fabsf(transform.m0)*extents.x + fabsf(transform.m4)*extents.y + fabsf(transform.m8)*extents.z,
+        fabsf(transform.m1)*extents.x + fabsf(transform.m5)*extents.y + fabsf(transform.m9)*extents.z,
+        fabsf(transform.m2)*extents.x + fabsf(transform.m6)*extents.y + fabsf(transform.m10)*extents.z
+    };
 
-    if (!rlgCtx)
+    BoundingBox result = { 0 };
+    result.min = Vector3Subtract(newCenter, newExtents);
+    result.max = Vector3Add(newCenter, newExtents);
+
+    return result;
+}
+
+static struct RLG_MeshBounds* RLG_FindMeshBounds(struct RLG_BoundsCache *cache, unsigned int vboId)
+{
+    // NOTE: Knuth multiplicative hash, linear probing until the buffer or an empty entry is found
+    unsigned int mask = (unsigned int)cache->capacity - 1;
+    unsigned int index = (vboId*2654435761u) & mask;
+
+    while (cache->entries[index].vboId != 0 && cache->entries[index].vboId != vboId)
     {
-        TraceLog(LOG_FATAL, "Heap allocation for RLG context failed!");
-        return NULL;
+        index = (index + 1) & mask;
     }
 
-    // We check if all the shader codes are well defined
-    if (G_FS_CACHE_Model == NULL) TraceLog(LOG_WARNING, "The lighting vertex shader has not been defined.");
-    if (G_VS_CACHE_Model == NULL) TraceLog(LOG_WARNING, "The lighting fragment shader has not been defined.");
-    if (G_VS_CACHE_Depth == NULL) TraceLog(LOG_WARNING, "The depth vertex shader has not been defined.");
-    if (G_FS_CACHE_Depth == NULL) TraceLog(LOG_WARNING, "The depth fragment shader has not been defined.");
+    return &cache->entries[index];
+}
 
-    // Setup model shader code arrays
-#   ifndef NO_EMBEDDED_SHADERS
+static bool RLG_GetMeshBounds(Mesh mesh, bool update, BoundingBox *aabb)
+{
+    if (mesh.vertices == NULL) return false;
 
-    const int vsModelCount = 3;
-    const int fsModelCount = 3;
-    const char *vsModel[3] = { 0 };
-    const char *fsModel[3] = { 0 };
+    // Meshes that are not uploaded have no buffer to identify them, their box is not cached
+    if (mesh.vboId == NULL || mesh.vboId[0] == 0)
+    {
+        *aabb = GetMeshBoundingBox(mesh);
+        return true;
+    }
 
-    vsModel[0] = GLSL_VERSION_DEF;
-    vsModel[1] = GLSL_NUM_LIGHTS;
-    vsModel[2] = G_VS_CACHE_Model;
+    struct RLG_BoundsCache *cache = &rlgCtx->bounds;
 
-    fsModel[0] = GLSL_VERSION_DEF;
-    fsModel[1] = GLSL_NUM_LIGHTS;
-    fsModel[2] = G_FS_CACHE_Model;
+    // Grow the table before it is three quarters full
+    if (4*(cache->count + 1) > 3*cache->capacity)
+    {
+        struct RLG_BoundsCache grown = { 0 };
+        grown.capacity = (cache->capacity > 0) ? 2*cache->capacity : 64;
+        grown.entries = (struct RLG_MeshBounds*)calloc(grown.capacity, sizeof(struct RLG_MeshBounds));
+        grown.count = cache->count;
 
-#   else
-    const int vsModelCount = 1;
-    const int fsModelCount = 1;
-    const char *vsModel[1] = { G_VS_CACHE_Model };
-    const char *fsModel[1] = { G_FS_CACHE_Model };
-#   endif //NO_EMBEDDED_SHADERS
+        for (int i = 0; i < cache->capacity; i++)
+        {
+            if (cache->entries[i].vboId != 0) *RLG_FindMeshBounds(&grown, cache->entries[i].vboId) = cache->entries[i];
+        }
 
-    // Load shader and get locations
-    Shader lightShader = { 0 };
-    lightShader.id = EXT_LoadShaderEx(vsModel, fsModel, vsModelCount, fsModelCount);
+        free(cache->entries);
+        *cache = grown;
+    }
 
-    // After shader loading, we TRY to set default location names
-    if (lightShader.id > 0)
+    struct RLG_MeshBounds *entry = RLG_FindMeshBounds(cache, mesh.vboId[0]);
+
+    if (entry->vboId == 0) cache->count++;
+    else if (!update && entry->vertices == mesh.vertices && entry->vertexCount == mesh.vertexCount)
     {
-        // NOTE: Locations that cannot be retrieved are set to -1 by 'rlGetLocationAttrib'
-        lightShader.locs = (int*)malloc(RLG_COUNT_LOCS*sizeof(int));
+        *aabb = entry->aabb;
+        return true;
+    }
 
-        // Get handles to GLSL input attribute locations
-        lightShader.locs[RLG_LOC_VERTEX_POSITION]    = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_POSITION);
-        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD01]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TEXCOORD);
-        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD02]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TEXCOORD2);
-        lightShader.locs[RLG_LOC_VERTEX_NORMAL]      = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_NORMAL);
-        lightShader.locs[RLG_LOC_VERTEX_TANGENT]     = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TANGENT);
-        lightShader.locs[RLG_LOC_VERTEX_COLOR]       = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_COLOR);
+    entry->vboId = mesh.vboId[0];
+    entry->vertices = mesh.vertices;
+    entry->vertexCount = mesh.vertexCount;
+    entry->aabb = GetMeshBoundingBox(mesh);
 
-        // Get handles to GLSL uniform locations (vertex shader)
-        lightShader.locs[RLG_LOC_MATRIX_MVP]         = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_MVP);
-        lightShader.locs[RLG_LOC_MATRIX_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_VIEW);
-        lightShader.locs[RLG_LOC_MATRIX_PROJECTION]  = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_PROJECTION);
-        lightShader.locs[RLG_LOC_MATRIX_MODEL]       = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_MODEL);
-        lightShader.locs[RLG_LOC_MATRIX_NORMAL]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_NORMAL);
+    *aabb = entry->aabb;
+    return true;
+}
 
-        // Get handles to GLSL uniform locations (fragment shader)
-        lightShader.locs[RLG_LOC_COLOR_AMBIENT]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_COLOR_AMBIENT);
-        lightShader.locs[RLG_LOC_VECTOR_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_VIEW_POSITION);
+static void RLG_GetFrustumPlanes(Matrix matViewProjection, Vector4 *planes)
+{
+    // NOTE: Planes of the clip space (Gribb/Hartmann), a point is inside if dot(plane.xyz, p) + plane.w >= 0
+    const Matrix m = matViewProjection;
+    const Vector4 rows[4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 },
+        { m.m3, m.m7, m.m11, m.m15 }
+    };
 
-        lightShader.locs[RLG_LOC_COLOR_DIFFUSE]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_ALBEDO));
-        lightShader.locs[RLG_LOC_COLOR_SPECULAR]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_COLOR_EMISSION]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_EMISSION));
+    for (int i = 0; i < 3; i++)
+    {
+        planes[2*i] = INIT_STRUCT(Vector4, rows[3].x + rows[i].x, rows[3].y + rows[i].y, rows[3].z + rows[i].z, rows[3].w + rows[i].w);
+        planes[2*i + 1] = INIT_STRUCT(Vector4, rows[3].x - rows[i].x, rows[3].y - rows[i].y, rows[3].z - rows[i].z, rows[3].w - rows[i].w);
+    }
+}
 
-        lightShader.locs[RLG_LOC_MAP_ALBEDO]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_ALBEDO));
-        lightShader.locs[RLG_LOC_MAP_METALNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_MAP_NORMAL]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_NORMAL));
-        lightShader.locs[RLG_LOC_MAP_ROUGHNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_ROUGHNESS));
-        lightShader.locs[RLG_LOC_MAP_OCCLUSION]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_OCCLUSION));
-        lightShader.locs[RLG_LOC_MAP_EMISSION]       = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_EMISSION));
-        lightShader.locs[RLG_LOC_MAP_HEIGHT]         = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT));
-        lightShader.locs[RLG_LOC_MAP_BRDF]           = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].texture", MATERIAL_MAP_HEIGHT + 1));
+static bool RLG_IsAABBInFrustum(const Vector4 *planes, BoundingBox aabb)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        // The box is outside if its corner furthest along the normal is behind the plane
+        Vector3 p = {
+            (planes[i].x >= 0.0f) ? aabb.max.x : aabb.min.x,
+            (planes[i].y >= 0.0f) ? aabb.max.y : aabb.min.y,
+            (planes[i].z >= 0.0f) ? aabb.max.z : aabb.min.z
+        };
 
-        lightShader.locs[RLG_LOC_MAP_CUBEMAP]        = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 0));
-        lightShader.locs[RLG_LOC_MAP_IRRADIANCE]     = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 1));
-        lightShader.locs[RLG_LOC_MAP_PREFILTER]      = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].texture", 2));
+        if (planes[i].x*p.x + planes[i].y*p.y + planes[i].z*p.z + planes[i].w < 0.0f) return false;
+    }
 
-        lightShader.locs[RLG_LOC_METALNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_METALNESS));
-        lightShader.locs[RLG_LOC_ROUGHNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_ROUGHNESS));
-        lightShader.locs[RLG_LOC_AO_LIGHT_AFFECT]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_OCCLUSION));
-        lightShader.locs[RLG_LOC_HEIGHT_SCALE]       = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_HEIGHT));
+    return true;
+}
 
-        // Definition of the lighting shader once initialization is successful
-        rlgCtx->shaders[RLG_SHADER_MODEL] = lightShader;
-    }
+static bool RLG_GetCullingPlanes(Vector4 *planes)
+{
+    if (!rlgCtx->useCulling) return false;
 
-    // Init default view position and ambient color
-    rlgCtx->colAmbient = INIT_STRUCT(Vector3, 0.1f, 0.1f, 0.1f);
-    rlgCtx->viewPos = INIT_STRUCT_ZERO(Vector3);
+    // During the single pass update of an omnilight, the rlgl matrices are identities, the casts
+    // are then tested against the cube reached by the light
+    Matrix matViewProjection = rlgCtx->useCullingBounds ? rlgCtx->matCullingBounds
+        : MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
 
-    SetShaderValue(lightShader,
-        lightShader.locs[RLG_LOC_COLOR_AMBIENT],
-        &rlgCtx->colAmbient, RL_SHADER_UNIFORM_VEC3);
+    // NOTE: The rlgl transform matrix is included so that the meshes are tested with their model matrix only
+    RLG_GetFrustumPlanes(MatrixMultiply(rlGetMatrixTransform(), matViewProjection), planes);
 
-    // Retrieving lighting shader uniforms indicating which textures we should sample
-    for (int i = 0, mapID = 0, cubemapID = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
-    {
-        if (i == MATERIAL_MAP_CUBEMAP || i == MATERIAL_MAP_IRRADIANCE || i == MATERIAL_MAP_PREFILTER)
-        {
-            rlgCtx->material.locs.useMaps[i] = rlGetLocationUniform(lightShader.id, TextFormat("cubemaps[%i].active", cubemapID));
-            cubemapID++;
-        }
-        else
-        {
-            rlgCtx->material.locs.useMaps[i] = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].active", mapID));
-            mapID++;
-        }
-    }
+    return true;
+}
 
-    // Default activation of diffuse texture sampling
-    rlgCtx->material.data.useMaps[MATERIAL_MAP_ALBEDO] = true;
-    SetShaderValue(lightShader, rlgCtx->material.locs.useMaps[MATERIAL_MAP_ALBEDO],
-        &rlgCtx->material.data.useMaps[MATERIAL_MAP_ALBEDO], SHADER_UNIFORM_INT);
+static bool RLG_IsMeshCulled(const Vector4 *planes, Mesh mesh, Matrix transform)
+{
+    BoundingBox aabb = { 0 };
 
-    // Recovery of “special” lighting shader uniforms
-    rlgCtx->material.locs.parallaxMinLayers = rlGetLocationUniform(lightShader.id, "parallaxMinLayers");
-    rlgCtx->material.locs.parallaxMaxLayers = rlGetLocationUniform(lightShader.id, "parallaxMaxLayers");
-    rlgCtx->locLightingFar = rlGetLocationUniform(lightShader.id, "farPlane");
+    // The meshes without vertices on the CPU side are always drawn
+    if (!RLG_GetMeshBounds(mesh, false, &aabb)) return false;
 
-    // Allocation and initialization of the desired number of lights
-    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
+    if (RLG_IsAABBInFrustum(planes, RLG_TransformAABB(aabb, transform))) return false;
+
+    rlgCtx->stats.culledMeshes++;
+    return true;
+}
+
+static float RLG_GetLightInfluence(const struct RLG_Light *l, BoundingBox aabb)
+{
+    // Directional lights illuminate everything, they are always selected first
+    if (l->data.type == RLG_DIRLIGHT) return FLT_MAX;
+
+    // Closest point of the box to the light position
+    Vector3 closest = Vector3Min(Vector3Max(l->data.position, aabb.min), aabb.max);
+    float distance = Vector3Distance(closest, l->data.position);
+
+    if (distance >= l->data.distance) return -1.0f;
+
+    // For spotlights, reject the box if its bounding sphere is entirely outside the cone
+    if (l->data.type == RLG_SPOTLIGHT && l->data.outerCutOff < 90.0f)
     {
-        struct RLG_Light *light = &rlgCtx->lights[i];
+        Vector3 center = Vector3Scale(Vector3Add(aabb.min, aabb.max), 0.5f);
+        float radius = 0.5f*Vector3Distance(aabb.min, aabb.max);
 
-        light->data.shadowMap      = INIT_STRUCT_ZERO(struct RLG_ShadowMap);
-        light->data.position       = INIT_STRUCT_ZERO(Vector3);
-        light->data.direction      = INIT_STRUCT_ZERO(Vector3);
-        light->data.color          = INIT_STRUCT(Vector3, 1.0f, 1.0f, 1.0f);
-        light->data.energy         = 1.0f;
-        light->data.specular       = 1.0f;
-        light->data.size           = 0.0f;
-        light->data.innerCutOff    = 180;
-        light->data.outerCutOff    = 180;
-        light->data.distance       = 8.0f;
-        light->data.attenuation    = 1.0f;
-        light->data.shadowMapTxlSz = 0.0f;
-        light->data.depthBias      = 0.0f;
-        light->data.type           = RLG_DIRLIGHT;
-        light->data.shadow         = 0;
-        light->data.enabled        = 0;
+        Vector3 v = Vector3Subtract(center, l->data.position);
+        float along = Vector3DotProduct(v, Vector3Normalize(l->data.direction));
+        float perp = sqrtf(fmaxf(Vector3LengthSqr(v) - along*along, 0.0f));
 
-        light->locs.vpMatrix       = rlGetLocationUniform(lightShader.id, TextFormat("matLights[%i]", i));
-        light->locs.shadowCubemap  = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowCubemap", i));
-        light->locs.shadowMap      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowMap", i));
-        light->locs.position       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].position", i));
-        light->locs.direction      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].direction", i));
-        light->locs.color          = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].color", i));
-        light->locs.energy         = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].energy", i));
-        light->locs.specular       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].specular", i));
-        light->locs.size           = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].size", i));
-        light->locs.innerCutOff    = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].innerCutOff", i));
-        light->locs.outerCutOff    = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].outerCutOff", i));
-        light->locs.distance       = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].distance", i));
-        light->locs.attenuation    = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].attenuation", i));
-        light->locs.shadowMapTxlSz = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadowMapTxlSz", i));
-        light->locs.depthBias      = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].depthBias", i));
-        light->locs.type           = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].type", i));
-        light->locs.shadow         = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].shadow", i));
-        light->locs.enabled        = rlGetLocationUniform(lightShader.id, TextFormat("lights[%i].enabled", i));
-
-        SetShaderValue(lightShader, light->locs.color, &light->data.color, SHADER_UNIFORM_VEC3);
-        SetShaderValue(lightShader, light->locs.energy, &light->data.energy, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lightShader, light->locs.specular, &light->data.specular, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lightShader, light->locs.innerCutOff, (float[1]) { -1 }, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lightShader, light->locs.outerCutOff, (float[1]) { -1 }, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lightShader, light->locs.distance, &light->data.distance, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lightShader, light->locs.attenuation, &light->data.attenuation, SHADER_UNIFORM_FLOAT);
+        float angle = l->data.outerCutOff*DEG2RAD;
+        if (along < -radius || perp*cosf(angle) - along*sinf(angle) > radius) return -1.0f;
     }
 
-    // Init default material maps
-    Texture defaultTexture  = INIT_STRUCT_ZERO(Texture);
-    defaultTexture.id       = rlGetTextureIdDefault();
-    defaultTexture.width    = 1;
-    defaultTexture.height   = 1;
-    defaultTexture.mipmaps  = 1;
-    defaultTexture.format   = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
-
-    rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color = WHITE;
-    rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].value = 0.5f;
-    rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].value = 0.5f;
-    rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].value = 0.0f;
-    rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color = BLACK;
-    rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].texture = defaultTexture;
-    rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].value = 0.05f;
-
-    // Load depth shader (used for shadow casting)
-    rlgCtx->shaders[RLG_SHADER_DEPTH] = LoadShaderFromMemory(G_VS_CACHE_Depth, G_FS_CACHE_Depth);
+    // Estimation of the light received by the closest point of the box (same attenuation as the shader)
+    float brightness = fmaxf(l->data.color.x, fmaxf(l->data.color.y, l->data.color.z));
+    return (1.0f - distance/l->data.distance)*l->data.attenuation*l->data.energy*brightness;
+}
 
-    // Load depth cubemap shader (used for omnilight shadow casting)
-    rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP] = LoadShaderFromMemory(G_VS_CACHE_DepthCubemap, G_FS_CACHE_DepthCubemap);
-    rlgCtx->locDepthCubemapLightPos = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP].id, "lightPos");
-    rlgCtx->locDepthCubemapFar = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP].id, "farPlane");
+#if GLSL_VERSION >= 330
 
-    // Get Near/Far render values
-    rlgCtx->zNear = 0.01f;  // TODO: replace with rlGetCullDistanceNear()
-    rlgCtx->zFar = 1000.0f; // TODO: replace with rlGetCullDistanceFar()
+static unsigned long long RLG_HashString(unsigned long long hash, const char *str)
+{
+    // 64-bit FNV-1a, the terminating null character is hashed to separate the strings
+    if (str == NULL) str = "";
 
-    // Send Near/Far to shaders who need it
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP],
-        rlgCtx->locDepthCubemapFar, &rlgCtx->zFar, SHADER_UNIFORM_FLOAT);
+    do {
+        hash ^= (unsigned char)*str;
+        hash *= 0x100000001B3ULL;
+    } while (*str++ != '\0');
 
-    // Load equirectangular to cubemap shader (used for skybox cubemap generation)
-    rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP] = LoadShaderFromMemory(
-        G_VS_CACHE_EquirectangularToCubemap, G_FS_CACHE_EquirectangularToCubemap);
+    return hash;
+}
 
-    // Load irradiance convolution shader (used to generate irradiance map of the skybox cubemap)
-    rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION] = LoadShaderFromMemory(
-        G_VS_CACHE_IrradianceConvolution, G_FS_CACHE_IrradianceConvolution);
+static unsigned long long RLG_GetProgramKey(const char **vsCodes, const char **fsCodes, const char *gsCode, int vsCount, int fsCount)
+{
+    unsigned long long key = 0xCBF29CE484222325ULL;
 
-    // Load skybox shader
-    rlgCtx->shaders[RLG_SHADER_SKYBOX] = LoadShaderFromMemory(G_VS_CACHE_Skybox, G_FS_CACHE_Skybox);
-    rlgCtx->skybox.locDoGamma = rlGetLocationUniform(rlgCtx->shaders[RLG_SHADER_SKYBOX].id, "doGamma");
+    key = RLG_HashString(key, TextFormat("%i %i %i %i", vsCount, fsCount, GLSL_VERSION, RLG_MAX_LIGHTS_PER_MATERIAL));
 
-    // Load skybox vertex array
-    // Define the positions of the vertices for a cube
-    static const float skyboxPositions[] =
-    {
-        // Front face
-        -0.5f, -0.5f,  0.5f,    // Vertex 0
-         0.5f, -0.5f,  0.5f,    // Vertex 1
-         0.5f,  0.5f,  0.5f,    // Vertex 2
-        -0.5f,  0.5f,  0.5f,    // Vertex 3
+    for (int i = 0; i < vsCount; i++) key = RLG_HashString(key, vsCodes[i]);
+    for (int i = 0; i < fsCount; i++) key = RLG_HashString(key, fsCodes[i]);
+    key = RLG_HashString(key, gsCode);
 
-        // Back face
-        -0.5f, -0.5f, -0.5f,    // Vertex 4
-         0.5f, -0.5f, -0.5f,    // Vertex 5
-         0.5f,  0.5f, -0.5f,    // Vertex 6
-        -0.5f,  0.5f, -0.5f     // Vertex 7
-    };
+    // A binary is only valid for the driver that produced it
+    key = RLG_HashString(key, (const char*)glGetString(GL_VENDOR));
+    key = RLG_HashString(key, (const char*)glGetString(GL_RENDERER));
+    key = RLG_HashString(key, (const char*)glGetString(GL_VERSION));
 
-    // Define the indices for drawing the cube faces
-    const unsigned short skyboxIndices[] =
-    {
-        // Front face
-        0, 1, 2,
-        2, 3, 0,
+    return key;
+}
 
-        // Right face
-        1, 5, 6,
-        6, 2, 1,
+static unsigned int RLG_LoadProgramBinary(unsigned long long key)
+{
+    char fileName[sizeof(G_ShaderCacheDirectory) + 32] = { 0 };
+    snprintf(fileName, sizeof(fileName), "%s/%016llx.bin", G_ShaderCacheDirectory, key);
 
-        // Back face
-        5, 4, 7,
-        7, 6, 5,
+    if (!FileExists(fileName)) return 0;
 
-        // Left face
-        4, 0, 3,
-        3, 7, 4,
+    int size = 0;
+    unsigned char *data = LoadFileData(fileName, &size);
+    unsigned int program = 0;
 
-        // Top face
-        3, 2, 6,
-        6, 7, 3,
+    // NOTE: File layout: "RLGB", binary format (GLenum), program binary
+    if (data != NULL && size > 8 && memcmp(data, "RLGB", 4) == 0)
+    {
+        GLenum format = 0;
+        memcpy(&format, data + 4, sizeof(GLenum));
 
-        // Bottom face
-        4, 5, 1,
-        1, 0, 4
-    };
+        program = glCreateProgram();
+        glProgramBinary(program, format, data + 8, size - 8);
 
-    // Load vertex array object (VAO) and bind it
-    rlgCtx->skybox.vao = rlLoadVertexArray();
-    rlEnableVertexArray(rlgCtx->skybox.vao);
-    {
-        // Load vertex buffer object (VBO) for positions and bind it
-        rlgCtx->skybox.vbo = rlLoadVertexBuffer(skyboxPositions, sizeof(skyboxPositions), false);
-        rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(0);
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
 
-        // Load element buffer object (EBO) for indices and bind it
-        rlgCtx->skybox.ebo = rlLoadVertexBufferElement(skyboxIndices, sizeof(skyboxIndices), false);
+        if (!success)
+        {
+            TraceLog(LOG_INFO, "Program binary [%s] rejected by the driver, the program will be compiled", fileName);
+            glDeleteProgram(program);
+            program = 0;
+        }
     }
-    rlDisableVertexArray();
 
-    return (RLG_Context)rlgCtx;
+    UnloadFileData(data);
+
+    return program;
 }
 
-void RLG_DestroyContext(RLG_Context ctx)
+static void RLG_SaveProgramBinary(unsigned int program, unsigned long long key)
 {
-    struct RLG_Core *pCtx = (struct RLG_Core*)ctx;
+    char fileName[sizeof(G_ShaderCacheDirectory) + 32] = { 0 };
+    snprintf(fileName, sizeof(fileName), "%s/%016llx.bin", G_ShaderCacheDirectory, key);
 
-    rlUnloadVertexBuffer(rlgCtx->skybox.ebo);
-    rlUnloadVertexBuffer(rlgCtx->skybox.vbo);
-    rlUnloadVertexArray(rlgCtx->skybox.vao);
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
 
-    for (int i = 0; i < RLG_COUNT_SHADERS; i++)
-    {
-        if (IsShaderReady(pCtx->shaders[i]))
-        {
-            UnloadShader(pCtx->shaders[i]);
-            pCtx->shaders[i] = INIT_STRUCT_ZERO(Shader);
-        }
-    }
+    if (length <= 0) return;
 
-    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
-    {
-        struct RLG_Light *light = &pCtx->lights[i];
+    unsigned char *data = (unsigned char*)malloc(8 + length);
+    GLenum format = 0;
 
-        if (light->data.shadowMap.id != 0)
-        {
-            rlUnloadTexture(light->data.shadowMap.depth.id);
-            rlUnloadFramebuffer(light->data.shadowMap.id);
-        }
-    }
-}
+    glGetProgramBinary(program, length, &length, &format, data + 8);
 
-void RLG_SetContext(RLG_Context ctx)
-{
-    rlgCtx = (struct RLG_Core*)ctx;
-}
+    memcpy(data, "RLGB", 4);
+    memcpy(data + 4, &format, sizeof(GLenum));
 
-RLG_Context RLG_GetContext(void)
-{
-    return (RLG_Context)rlgCtx;
+    SaveFileData(fileName, data, 8 + length);
+    free(data);
 }
 
-void RLG_SetCustomShaderCode(RLG_Shader shader, const char *vsCode, const char *fsCode)
-{
-    switch (shader)
-    {
-        case RLG_SHADER_MODEL:
-            G_FS_CACHE_Model = vsCode;
-            G_VS_CACHE_Model = fsCode;
-            break;
+#endif //GLSL_VERSION
 
-        case RLG_SHADER_DEPTH:
-            G_VS_CACHE_Depth = vsCode;
-            G_FS_CACHE_Depth = fsCode;
-            break;
+static void RLG_CompileProgram(struct RLG_PendingProgram *pending, const char **vsCodes, const char **fsCodes, const char *gsCode, int vsCount, int fsCount)
+{
+    // NOTE: The statuses are only checked by RLG_FinishProgram(), so that the
+    //       driver can compile the submitted programs in the background
 
-        case RLG_SHADER_DEPTH_CUBEMAP:
-            G_VS_CACHE_DepthCubemap = vsCode;
-            G_FS_CACHE_DepthCubemap = fsCode;
-            break;
+    /* Compile Vertex Shader */
 
-        case RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP:
-            G_VS_CACHE_EquirectangularToCubemap = vsCode;
-            G_FS_CACHE_EquirectangularToCubemap = fsCode;
-            break;
+    pending->vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pending->vs, vsCount, vsCodes, 0);
+    glCompileShader(pending->vs);
 
-        case RLG_SHADER_IRRADIANCE_CONVOLUTION:
-            G_VS_CACHE_IrradianceConvolution = vsCode;
-            G_FS_CACHE_IrradianceConvolution = fsCode;
-            break;
+    /* Compile Fragment Shader */
 
-        case RLG_SHADER_SKYBOX:
-            G_VS_CACHE_Skybox = vsCode;
-            G_FS_CACHE_Skybox = fsCode;
-            break;
+    pending->fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pending->fs, fsCount, fsCodes, 0);
+    glCompileShader(pending->fs);
 
-        default:
-            TraceLog(LOG_WARNING, "Unsupported 'shader' passed to 'RLG_SetCustomShader'");
-            break;
-    }
-}
+#if GLSL_VERSION >= 330
+    /* Compile Geometry Shader (optional) */
 
-const Shader* RLG_GetShader(RLG_Shader shader)
-{
-    if (shader < 0 || shader >= RLG_COUNT_SHADERS)
+    if (gsCode != NULL)
     {
-        return NULL;
+        pending->gs = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(pending->gs, 1, &gsCode, 0);
+        glCompileShader(pending->gs);
     }
+#else
+    (void)gsCode;
+#endif
 
-    return &rlgCtx->shaders[shader];
-}
+    /* Link Shaders */
 
-void RLG_SetViewPosition(float x, float y, float z)
-{
-    RLG_SetViewPositionV(INIT_STRUCT(Vector3, x, y, z));
-}
+    pending->program = glCreateProgram();
+    pending->pending = true;
 
-void RLG_SetViewPositionV(Vector3 position)
-{
-    int loc = rlgCtx->shaders[RLG_SHADER_MODEL].locs[RLG_LOC_VECTOR_VIEW];
+    if (pending->program == 0) return;
 
-    if (loc != -1)
-    {
-        rlgCtx->viewPos = position;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            loc, &rlgCtx->viewPos, SHADER_UNIFORM_VEC3);
-    }
+    glAttachShader(pending->program, pending->vs);
+    glAttachShader(pending->program, pending->fs);
+    if (pending->gs != 0) glAttachShader(pending->program, pending->gs);
 
-}
+    glBindAttribLocation(pending->program, 0, RLG_SHADER_ATTRIB_POSITION);
+    glBindAttribLocation(pending->program, 1, RLG_SHADER_ATTRIB_TEXCOORD);
+    glBindAttribLocation(pending->program, 2, RLG_SHADER_ATTRIB_NORMAL);
+    glBindAttribLocation(pending->program, 3, RLG_SHADER_ATTRIB_COLOR);
+    glBindAttribLocation(pending->program, 4, RLG_SHADER_ATTRIB_TANGENT);
+    glBindAttribLocation(pending->program, 5, RLG_SHADER_ATTRIB_TEXCOORD2);
 
-Vector3 RLG_GetViewPosition(void)
-{
-    return rlgCtx->viewPos;
+#if GLSL_VERSION >= 330
+    // NOTE: Fixed location so that the instance matrices do not replace an attribute of the mesh vertex arrays
+    glBindAttribLocation(pending->program, RLG_INSTANCE_ATTRIB_LOCATION, RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM);
+#endif
+
+#if GLSL_VERSION >= 330
+    // Allows the driver to keep what is needed to retrieve the program binary
+    if (pending->saveBinary) glProgramParameteri(pending->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+
+    glLinkProgram(pending->program);
 }
 
-void RLG_SetAmbientColor(Color color)
+static void RLG_SubmitProgram(struct RLG_PendingProgram *pending, const char **vsCodes, const char **fsCodes, const char *gsCode, int vsCount, int fsCount)
 {
-    int loc = rlgCtx->shaders[RLG_SHADER_MODEL].locs[RLG_LOC_COLOR_AMBIENT];
+    *pending = INIT_STRUCT_ZERO(struct RLG_PendingProgram);
+
+#if GLSL_VERSION >= 330
+    GLint formatCount = 0;
 
-    if (loc != -1)
+    // The cache is only used if the driver supports at least one program binary format
+    if (G_ShaderCacheDirectory[0] != '\0') glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    if (formatCount > 0)
     {
-        rlgCtx->colAmbient.x = (float)color.r/255.0f;
-        rlgCtx->colAmbient.y = (float)color.g/255.0f;
-        rlgCtx->colAmbient.z = (float)color.b/255.0f;
+        pending->cacheKey = RLG_GetProgramKey(vsCodes, fsCodes, gsCode, vsCount, fsCount);
+        pending->program = RLG_LoadProgramBinary(pending->cacheKey);
+
+        // NOTE: A program loaded from the cache is already linked, it has no shader objects
+        if (pending->program > 0)
+        {
+            pending->pending = true;
+            return;
+        }
 
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            loc, &rlgCtx->colAmbient, SHADER_UNIFORM_VEC3);
+        pending->saveBinary = true;
     }
+#endif
+
+    RLG_CompileProgram(pending, vsCodes, fsCodes, gsCode, vsCount, fsCount);
 }
-Color RLG_GetAmbientColor(void)
+
+static bool RLG_IsProgramCompleted(const struct RLG_PendingProgram *pending)
 {
-    Color color = { 0 };
+    // NOTE: Requires KHR_parallel_shader_compile, otherwise the status queries wait for the driver
+    if (pending->vs == 0 || pending->program == 0) return true;
 
-    color.r = rlgCtx->colAmbient.x*255.0f;
-    color.g = rlgCtx->colAmbient.y*255.0f;
-    color.b = rlgCtx->colAmbient.z*255.0f;
-    color.a = 255;
+    GLint completed = GL_FALSE;
+    glGetProgramiv(pending->program, GL_COMPLETION_STATUS_KHR, &completed);
 
-    return color;
+    return (completed == GL_TRUE);
 }
 
-void RLG_SetParallaxLayers(int min, int max)
+static unsigned int RLG_FinishProgram(struct RLG_PendingProgram *pending)
 {
-    if (rlgCtx->material.locs.parallaxMinLayers != -1 &&
-        min != rlgCtx->material.data.parallaxMinLayers)
-    {
-        rlgCtx->material.data.parallaxMinLayers = min;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            rlgCtx->material.locs.parallaxMinLayers,
-            &min, RL_SHADER_UNIFORM_INT);
+    unsigned int program = pending->program;
+    pending->pending = false;
+
+    if (pending->vs == 0) return program;
+
+    GLint success = GL_FALSE;
+    GLchar infoLog[512];
+
+    glGetShaderiv(pending->vs, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(pending->vs, sizeof(infoLog), 0, infoLog);
+        TraceLog(LOG_ERROR, "Failed to compile vertex shader: %s\n", infoLog);
     }
 
-    if (rlgCtx->material.locs.parallaxMaxLayers != -1 &&
-        max != rlgCtx->material.data.parallaxMaxLayers)
-    {
-        rlgCtx->material.data.parallaxMaxLayers = max;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            rlgCtx->material.locs.parallaxMaxLayers,
-            &max, RL_SHADER_UNIFORM_INT);
+    if (success) {
+        glGetShaderiv(pending->fs, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(pending->fs, sizeof(infoLog), 0, infoLog);
+            TraceLog(LOG_ERROR, "Failed to compile fragment shader: %s\n", infoLog);
+        }
     }
-}
 
-void RLG_GetParallaxLayers(int* min, int* max)
-{
-    if (min != NULL) *min = rlgCtx->material.data.parallaxMinLayers;
-    if (max != NULL) *max = rlgCtx->material.data.parallaxMaxLayers;
-}
+    if (success && pending->gs != 0) {
+        glGetShaderiv(pending->gs, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(pending->gs, sizeof(infoLog), 0, infoLog);
+            TraceLog(LOG_ERROR, "Failed to compile geometry shader: %s\n", infoLog);
+        }
+    }
 
-void RLG_UseMap(MaterialMapIndex mapIndex, bool active)
-{
-    if (mapIndex >= 0 && mapIndex < RLG_COUNT_MATERIAL_MAPS)
-    {
-        if (rlgCtx->material.locs.useMaps[mapIndex] != -1 &&
-            active != rlgCtx->material.data.useMaps[mapIndex])
-        {
-            int v = (int)active;
-            rlgCtx->material.data.useMaps[mapIndex] = active;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], rlgCtx->material.locs.useMaps[mapIndex], &v, SHADER_UNIFORM_INT);
+    if (success && program == 0) {
+        TraceLog(LOG_ERROR, "Failed to create shader program\n");
+        success = GL_FALSE;
+    }
+
+    if (success) {
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(program, sizeof(infoLog), 0, infoLog);
+            TraceLog(LOG_ERROR, "Failed to link program shader: %s\n", infoLog);
         }
     }
-}
 
-bool RLG_IsMapUsed(MaterialMapIndex mapIndex)
-{
-    bool result = false;
+    glDeleteShader(pending->vs);
+    glDeleteShader(pending->fs);
+    if (pending->gs != 0) glDeleteShader(pending->gs);
 
-    if (mapIndex >= 0 && mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    if (!success)
     {
-        result = rlgCtx->material.data.useMaps[mapIndex];
+        if (program != 0) glDeleteProgram(program);
+        return 0;
     }
 
-    return result;
+#if GLSL_VERSION >= 330
+    if (pending->saveBinary) RLG_SaveProgramBinary(program, pending->cacheKey);
+#endif
+
+    return program;
 }
 
-void RLG_UseDefaultMap(MaterialMapIndex mapIndex, bool active)
+#if GLSL_VERSION >= 330 && !defined(NO_EMBEDDED_SHADERS)
+static unsigned int RLG_LoadProgram(const char **vsCodes, const char **fsCodes, int vsCount, int fsCount)
 {
-    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
-    {
-        rlgCtx->usedDefaultMaps[mapIndex] = active;
-    }
+    struct RLG_PendingProgram pending;
+    RLG_SubmitProgram(&pending, vsCodes, fsCodes, NULL, vsCount, fsCount);
+
+    return RLG_FinishProgram(&pending);
 }
+#endif
 
-void RLG_SetDefaultMap(MaterialMapIndex mapIndex, MaterialMap map)
+static Shader RLG_InitShader(unsigned int id)
 {
-    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    Shader shader = { 0 };
+    shader.id = id;
+
+    // Same default locations as those set by LoadShaderFromMemory()
+    if (shader.id > 0)
     {
-        rlgCtx->defaultMaps[mapIndex] = map;
+        shader.locs = (int*)malloc(RL_MAX_SHADER_LOCATIONS*sizeof(int));
+        for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) shader.locs[i] = -1;
+
+        shader.locs[SHADER_LOC_VERTEX_POSITION]    = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+        shader.locs[SHADER_LOC_VERTEX_TEXCOORD01]  = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+        shader.locs[SHADER_LOC_VERTEX_TEXCOORD02]  = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+        shader.locs[SHADER_LOC_VERTEX_NORMAL]      = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+        shader.locs[SHADER_LOC_VERTEX_TANGENT]     = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+        shader.locs[SHADER_LOC_VERTEX_COLOR]       = rlGetLocationAttrib(shader.id, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+
+        shader.locs[SHADER_LOC_MATRIX_MVP]         = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_MVP);
+        shader.locs[SHADER_LOC_MATRIX_VIEW]        = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_VIEW);
+        shader.locs[SHADER_LOC_MATRIX_PROJECTION]  = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_PROJECTION);
+        shader.locs[SHADER_LOC_MATRIX_MODEL]       = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_MODEL);
+        shader.locs[SHADER_LOC_MATRIX_NORMAL]      = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_NORMAL);
+
+        shader.locs[SHADER_LOC_COLOR_DIFFUSE]      = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_UNIFORM_NAME_COLOR);
+        shader.locs[SHADER_LOC_MAP_DIFFUSE]        = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE0);
+        shader.locs[SHADER_LOC_MAP_SPECULAR]       = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE1);
+        shader.locs[SHADER_LOC_MAP_NORMAL]         = rlGetLocationUniform(shader.id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE2);
     }
+
+    return shader;
 }
 
-MaterialMap RLG_GetDefaultMap(MaterialMapIndex mapIndex)
+#if GLSL_VERSION >= 330 && !defined(NO_EMBEDDED_SHADERS)
+static Shader RLG_LoadShader(const char *vsCode, const char *fsCode)
 {
-    MaterialMap map = { 0 };
+    // Without code, raylib provides its default shader
+    if (vsCode == NULL || fsCode == NULL) return LoadShaderFromMemory(vsCode, fsCode);
 
-    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
-    {
-        map = rlgCtx->defaultMaps[mapIndex];
+    return RLG_InitShader(RLG_LoadProgram(&vsCode, &fsCode, 1, 1));
+}
+#endif
+
+static Shader RLG_InitModelShader(unsigned int id)
+{
+    Shader lightShader = { 0 };
+    lightShader.id = id;
+
+    // After shader loading, we TRY to set default location names
+    if (lightShader.id > 0)
+    {
+        // NOTE: Locations that cannot be retrieved are set to -1 by 'rlGetLocationAttrib'
+        lightShader.locs = (int*)malloc(RLG_COUNT_LOCS*sizeof(int));
+
+        // Get handles to GLSL input attribute locations
+        lightShader.locs[RLG_LOC_VERTEX_POSITION]    = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_POSITION);
+        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD01]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TEXCOORD);
+        lightShader.locs[RLG_LOC_VERTEX_TEXCOORD02]  = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TEXCOORD2);
+        lightShader.locs[RLG_LOC_VERTEX_NORMAL]      = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_NORMAL);
+        lightShader.locs[RLG_LOC_VERTEX_TANGENT]     = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_TANGENT);
+        lightShader.locs[RLG_LOC_VERTEX_COLOR]       = rlGetLocationAttrib(lightShader.id, RLG_SHADER_ATTRIB_COLOR);
+
+        // Get handles to GLSL uniform locations (vertex shader)
+        lightShader.locs[RLG_LOC_MATRIX_MVP]         = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_MVP);
+        lightShader.locs[RLG_LOC_MATRIX_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_VIEW);
+        lightShader.locs[RLG_LOC_MATRIX_PROJECTION]  = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_PROJECTION);
+        lightShader.locs[RLG_LOC_MATRIX_MODEL]       = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_MODEL);
+        lightShader.locs[RLG_LOC_MATRIX_NORMAL]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_MATRIX_NORMAL);
+
+        // Get handles to GLSL uniform locations (fragment shader)
+        lightShader.locs[RLG_LOC_COLOR_AMBIENT]      = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_COLOR_AMBIENT);
+        lightShader.locs[RLG_LOC_VECTOR_VIEW]        = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_VIEW_POSITION);
+
+        lightShader.locs[RLG_LOC_COLOR_DIFFUSE]      = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_ALBEDO));
+        lightShader.locs[RLG_LOC_COLOR_SPECULAR]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_METALNESS));
+        lightShader.locs[RLG_LOC_COLOR_EMISSION]     = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].color", MATERIAL_MAP_EMISSION));
+
+        lightShader.locs[RLG_LOC_MAP_ALBEDO]         = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_ALBEDO));
+        lightShader.locs[RLG_LOC_MAP_METALNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_METALNESS));
+        lightShader.locs[RLG_LOC_MAP_NORMAL]         = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_NORMAL));
+        lightShader.locs[RLG_LOC_MAP_ROUGHNESS]      = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_ROUGHNESS));
+        lightShader.locs[RLG_LOC_MAP_OCCLUSION]      = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_OCCLUSION));
+        lightShader.locs[RLG_LOC_MAP_EMISSION]       = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_EMISSION));
+        lightShader.locs[RLG_LOC_MAP_HEIGHT]         = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_HEIGHT));
+        lightShader.locs[RLG_LOC_MAP_BRDF]           = rlGetLocationUniform(lightShader.id, TextFormat("mapTextures[%i]", MATERIAL_MAP_HEIGHT + 1));
+
+        lightShader.locs[RLG_LOC_MAP_CUBEMAP]        = rlGetLocationUniform(lightShader.id, TextFormat("cubemapTextures[%i]", 0));
+        lightShader.locs[RLG_LOC_MAP_IRRADIANCE]     = rlGetLocationUniform(lightShader.id, TextFormat("cubemapTextures[%i]", 1));
+        lightShader.locs[RLG_LOC_MAP_PREFILTER]      = rlGetLocationUniform(lightShader.id, TextFormat("cubemapTextures[%i]", 2));
+
+        lightShader.locs[RLG_LOC_METALNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_METALNESS));
+        lightShader.locs[RLG_LOC_ROUGHNESS_SCALE]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_ROUGHNESS));
+        lightShader.locs[RLG_LOC_AO_LIGHT_AFFECT]    = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_OCCLUSION));
+        lightShader.locs[RLG_LOC_HEIGHT_SCALE]       = rlGetLocationUniform(lightShader.id, TextFormat("maps[%i].value", MATERIAL_MAP_HEIGHT));
+
+        lightShader.locs[RLG_LOC_AMBIENT_SH]         = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_AMBIENT_SH);
+        lightShader.locs[RLG_LOC_USE_AMBIENT_SH]     = rlGetLocationUniform(lightShader.id, RLG_SHADER_UNIFORM_USE_AMBIENT_SH);
+
+        // Assign each sampler to its texture unit, those of the maps that are never bound would otherwise
+        // all stay on unit 0, where drivers reject the draws mixing 2D and cube samplers (G-buffer shader,
+        // model shader without permutations)
+        // NOTE: The bound program is restored, the state tracker of the context is left valid
+        int units[3] = { RLG_SHADOW_ATLAS_TEXTURE_SLOT, RLG_CLUSTER_TEXTURE_SLOT, RLG_CLUSTER_TEXTURE_SLOT + 1 };
+        int program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        rlEnableShader(lightShader.id);
+
+        for (int i = 0; i <= RLG_LOC_MAP_BRDF - RLG_LOC_MAP_ALBEDO; i++)
+        {
+            rlSetUniform(lightShader.locs[RLG_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+        }
+
+        rlSetUniform(rlGetLocationUniform(lightShader.id, "shadowAtlas"), &units[0], SHADER_UNIFORM_INT, 1);
+        rlSetUniform(rlGetLocationUniform(lightShader.id, "clusterLights"), &units[1], SHADER_UNIFORM_INT, 1);
+        rlSetUniform(rlGetLocationUniform(lightShader.id, "clusterItems"), &units[2], SHADER_UNIFORM_INT, 1);
+        rlEnableShader((unsigned int)program);
+
+#   if GLSL_VERSION >= 330
+        // Assign the uniform blocks to their binding points, the buffers are shared by all the model shaders
+        unsigned int lightBlock = glGetUniformBlockIndex(lightShader.id, "LightBlock");
+        unsigned int materialBlock = glGetUniformBlockIndex(lightShader.id, "MaterialBlock");
+
+        if (lightBlock != GL_INVALID_INDEX) glUniformBlockBinding(lightShader.id, lightBlock, RLG_LIGHT_BLOCK_BINDING);
+        if (materialBlock != GL_INVALID_INDEX) glUniformBlockBinding(lightShader.id, materialBlock, RLG_MATERIAL_BLOCK_BINDING);
+#   endif
     }
 
-    return map;
+    return lightShader;
 }
 
-bool RLG_IsDefaultMapUsed(MaterialMapIndex mapIndex)
+#if GLSL_VERSION >= 330 && !defined(NO_EMBEDDED_SHADERS)
+static Shader RLG_LoadModelShader(const char **vsCodes, const char **fsCodes, int vsCount, int fsCount)
 {
-    return rlgCtx->usedDefaultMaps[mapIndex];
+    return RLG_InitModelShader(RLG_LoadProgram(vsCodes, fsCodes, vsCount, fsCount));
 }
+#endif
 
-void RLG_UseLight(unsigned int light, bool active)
+static bool RLG_IsSlotLight(const struct RLG_Light *l)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_UseLight' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
-    }
+    if (!l->data.enabled) return false;
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    // With clustered shading, only directional and shadow casting lights go through the shader slots
+    return !rlgCtx->clusters.enabled || l->data.shadow || l->data.type == RLG_DIRLIGHT;
+}
 
-    if (active != l->data.enabled)
-    {
-        l->data.enabled = (int)active;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            l->locs.enabled, &l->data.enabled, SHADER_UNIFORM_INT);
-    }
+#if GLSL_VERSION >= 330
+static bool RLG_IsClusterLight(const struct RLG_Light *l)
+{
+    return rlgCtx->clusters.enabled && l->data.enabled && !RLG_IsSlotLight(l);
 }
+#endif
 
-bool RLG_IsLightUsed(unsigned int light)
+static int RLG_SelectLights(Mesh mesh, const Matrix *transforms, int count, int *selected)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    int enabledCount = 0;
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_IsLightUsed' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return false;
+        if (RLG_IsSlotLight(&rlgCtx->lights[i])) enabledCount++;
     }
 
-    return (bool)rlgCtx->lights[light].data.enabled;
-}
-
-void RLG_ToggleLight(unsigned int light)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    // If all the enabled lights fit in the shader slots, we don't need to pay the AABB test
+    // NOTE: The lights are then given in their index order, which avoids unnecessary slot changes
+    if (enabledCount <= RLG_MAX_LIGHTS_PER_MATERIAL || mesh.vertices == NULL)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_ToggleLight' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        int count = 0;
+
+        for (int i = 0; i < RLG_MAX_LIGHTS && count < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
+        {
+            if (RLG_IsSlotLight(&rlgCtx->lights[i])) selected[count++] = i;
+        }
+
+        return count;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    // NOTE: The instances of a draw share the same lights, they are selected for the box enclosing them all
+    BoundingBox meshAABB = { 0 };
+    RLG_GetMeshBounds(mesh, false, &meshAABB);
 
-    l->data.enabled = !l->data.enabled;
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.enabled,
-        &l->data.enabled, SHADER_UNIFORM_INT);
-}
+    Matrix matTransform = rlGetMatrixTransform();
 
-void RLG_SetLightType(unsigned int light, RLG_LightType type)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    BoundingBox aabb = RLG_TransformAABB(meshAABB, MatrixMultiply(transforms[0], matTransform));
+
+    for (int i = 1; i < count; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightType' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        BoundingBox instanceAABB = RLG_TransformAABB(meshAABB, MatrixMultiply(transforms[i], matTransform));
+        aabb.min = Vector3Min(aabb.min, instanceAABB.min);
+        aabb.max = Vector3Max(aabb.max, instanceAABB.max);
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    // Keep the most influential lights, sorted by decreasing influence
+    float influences[RLG_MAX_LIGHTS_PER_MATERIAL];
+    count = 0;
 
-    if (l->data.type != type)
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
     {
-        if (l->data.shadow)
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+        if (!RLG_IsSlotLight(l)) continue;
+
+        float influence = RLG_GetLightInfluence(l, aabb);
+        if (influence < 0.0f) continue;
+
+        if (count == RLG_MAX_LIGHTS_PER_MATERIAL)
         {
-            int shadowMapResolution = l->data.shadowMap.width;
+            if (influence <= influences[count - 1]) continue;
+            count--; // The least influential light is replaced
+        }
 
-            RLG_DisableShadow(light);
-            RLG_EnableShadow(light, shadowMapResolution);
+        int j = count++;
+        for (; j > 0 && influences[j - 1] < influence; j--)
+        {
+            influences[j] = influences[j - 1];
+            selected[j] = selected[j - 1];
         }
 
-        l->data.type = (int)type;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.type,
-            &l->data.type, SHADER_UNIFORM_INT);
+        influences[j] = influence;
+        selected[j] = i;
     }
+
+    return count;
 }
 
-RLG_LightType RLG_GetLightType(unsigned int light)
+static void RLG_SetUniform(int locIndex, const void *value, int uniformType, int count)
+{
+    if (locIndex < 0) return;
+
+    rlSetUniform(locIndex, value, uniformType, count);
+    rlgCtx->stats.uniformUploads++;
+}
+
+static void RLG_SetUniformMatrix(int locIndex, Matrix mat)
+{
+    if (locIndex < 0) return;
+
+    rlSetUniformMatrix(locIndex, mat);
+    rlgCtx->stats.uniformUploads++;
+}
+
+static void RLG_SetUniformCached(int locIndex, const void *value, void *uploaded, int size, int uniformType)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (locIndex < 0) return;
+
+    // NOTE: Without copy of the uploaded value (G-buffer shader), the value is always sent
+    if (uploaded != NULL && memcmp(uploaded, value, size) == 0)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightType' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return (RLG_LightType)0;
+        rlgCtx->stats.skippedUniformUploads++;
+        return;
     }
 
-    return (RLG_LightType)rlgCtx->lights[light].data.type;
+    RLG_SetUniform(locIndex, value, uniformType, 1);
+    if (uploaded != NULL) memcpy(uploaded, value, size);
 }
 
-void RLG_SetLightValue(unsigned int light, RLG_LightProperty property, float value)
+static void RLG_EnableShader(unsigned int id)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (rlgCtx->state.program == id)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightValue' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
+        rlgCtx->stats.skippedShaderBinds++;
         return;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    rlEnableShader(id);
+    rlgCtx->state.program = id;
+    rlgCtx->stats.shaderBinds++;
+}
 
-    switch (property)
+static void RLG_DisableShader(void)
+{
+    rlDisableShader();
+    rlgCtx->state.program = 0;
+}
+
+static bool RLG_EnableVertexArray(unsigned int id)
+{
+    if (id != 0 && rlgCtx->state.vertexArray == id)
     {
-        case RLG_LIGHT_COLOR:
-            l->data.color = INIT_STRUCT(Vector3, value, value, value);
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.color,
-                &l->data.color, SHADER_UNIFORM_VEC3);
-            break;
+        rlgCtx->stats.skippedVertexArrayBinds++;
+        return true;
+    }
 
-        case RLG_LIGHT_ENERGY:
-            if (value != l->data.energy)
-            {
-                l->data.energy = value;
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.energy,
-                    &l->data.energy, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    bool enabled = rlEnableVertexArray(id);
+    rlgCtx->state.vertexArray = enabled ? id : 0;
+    if (enabled) rlgCtx->stats.vertexArrayBinds++;
 
-        case RLG_LIGHT_SPECULAR:
-            if (value != l->data.specular)
-            {
-                l->data.specular = value;
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.specular,
-                    &l->data.specular, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    return enabled;
+}
 
-        case RLG_LIGHT_SIZE:
-            if (value != l->data.size)
-            {
-                l->data.size = value;
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.size,
-                    &l->data.size, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+static void RLG_BindTexture(int unit, unsigned int target, unsigned int id)
+{
+    struct RLG_StateTracker *state = &rlgCtx->state;
 
-        case RLG_LIGHT_INNER_CUTOFF:
-            if (value != l->data.innerCutOff)
-            {
-                l->data.innerCutOff = value;
-                float c = cosf(value*DEG2RAD);
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.innerCutOff,
-                    &c, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    if (state->textures[unit] == id && state->targets[unit] == target)
+    {
+        rlgCtx->stats.skippedTextureBinds++;
+        return;
+    }
 
-        case RLG_LIGHT_OUTER_CUTOFF:
-            if (value != l->data.outerCutOff)
-            {
-                l->data.outerCutOff = value;
-                float c = cosf(value*DEG2RAD);
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.outerCutOff,
-                    &c, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    glActiveTexture(GL_TEXTURE0 + unit);
 
-        case RLG_LIGHT_DISTANCE:
-            if (value != l->data.distance)
-            {
-                l->data.distance = value;
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.distance, &value, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    // NOTE: A texture of another type would stay bound to the unit
+    if (state->textures[unit] != 0 && state->targets[unit] != target)
+    {
+        glBindTexture(state->targets[unit], 0);
+    }
 
-        case RLG_LIGHT_ATTENUATION:
-            if (value != l->data.attenuation)
-            {
-                l->data.attenuation = value;
-                SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.attenuation, &value, SHADER_UNIFORM_FLOAT);
-            }
-            break;
+    glBindTexture(target, id);
 
-        default:
-            break;
-    }
+    state->textures[unit] = id;
+    state->targets[unit] = target;
+    rlgCtx->stats.textureBinds++;
 }
 
-void RLG_SetLightXYZ(unsigned int light, RLG_LightProperty property, float x, float y, float z)
+static void RLG_RestoreState(void)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    struct RLG_StateTracker *state = &rlgCtx->state;
+
+    for (int i = 0; i < RLG_COUNT_TEXTURE_UNITS; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightXYZ' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        if (state->textures[i] == 0) continue;
+
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(state->targets[i], 0);
+        state->textures[i] = 0;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    Vector3 value = { x, y, z };
+    // NOTE: raylib expects the first texture unit to be the active one
+    glActiveTexture(GL_TEXTURE0);
 
-    switch (property)
+    if (state->vertexArray != 0)
     {
-        case RLG_LIGHT_POSITION:
-            l->data.position = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.position,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
+        rlDisableVertexArray();
+        state->vertexArray = 0;
+    }
 
-        case RLG_LIGHT_DIRECTION:
-            l->data.direction = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
 
-        case RLG_LIGHT_COLOR:
-            l->data.color = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.color,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
+    if (state->program != 0) RLG_DisableShader();
 
-        default:
-            break;
-    }
+    state->blocks = false;
 }
 
-void RLG_SetLightVec3(unsigned int light, RLG_LightProperty property, Vector3 value)
+static void RLG_ReleaseDrawState(void)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    const struct RLG_StateTracker *state = &rlgCtx->state;
+
+    if (!state->batch)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightVec3' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
+        RLG_RestoreState();
         return;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    // During a batch the state stays bound for the next draw, it is restored by RLG_EndBatch()
+    rlgCtx->stats.skippedUnbinds += (state->program != 0) + (state->vertexArray != 0);
 
-    switch (property)
+    for (int i = 0; i < RLG_COUNT_TEXTURE_UNITS; i++)
     {
-        case RLG_LIGHT_POSITION:
-            l->data.position = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.position,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
-
-        case RLG_LIGHT_DIRECTION:
-            l->data.direction = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
+        rlgCtx->stats.skippedUnbinds += (state->textures[i] != 0);
+    }
+}
 
-        case RLG_LIGHT_COLOR:
-            l->data.color = value;
-            SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.color,
-                &value, SHADER_UNIFORM_VEC3);
-            break;
+static void RLG_TouchLight(struct RLG_Light *l, unsigned int fields)
+{
+    l->version++;
 
-        default:
-            break;
+    for (int i = 0; i < RLG_COUNT_LIGHT_FIELDS; i++)
+    {
+        if (fields & (1 << i)) l->fieldVersions[i] = l->version;
     }
 }
 
-void RLG_SetLightColor(unsigned int light, Color color)
+static unsigned int RLG_GetLightChanges(const struct RLG_Light *l, unsigned int sinceVersion)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    unsigned int fields = 0;
+
+    for (int i = 0; i < RLG_COUNT_LIGHT_FIELDS; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightColor' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        if (l->fieldVersions[i] > sinceVersion) fields |= (1 << i);
     }
 
-    Vector3 nCol = { 0 };
-    nCol.x = color.r/255.0f;
-    nCol.y = color.g/255.0f;
-    nCol.z = color.b/255.0f;
+    return fields;
+}
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
+static int RLG_GetLightFieldLocation(unsigned int shaderId, const char *light, const char *field)
+{
+    // NOTE: A local buffer is used because the caller can pass a string given by TextFormat()
+    char name[64] = { 0 };
+    snprintf(name, sizeof(name), "%s.%s", light, field);
 
-    l->data.color = nCol;
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.color,
-        &nCol, SHADER_UNIFORM_VEC3);
+    return rlGetLocationUniform(shaderId, name);
 }
 
-float RLG_GetLightValue(unsigned int light, RLG_LightProperty property)
+static void RLG_GetLightSlotLocations(struct RLG_LightSlot *slot, unsigned int shaderId, const char *light, const char *matrix)
 {
-    float result = 0;
+    slot->locs.vpMatrix       = rlGetLocationUniform(shaderId, matrix);
+    slot->locs.position       = RLG_GetLightFieldLocation(shaderId, light, "position");
+    slot->locs.direction      = RLG_GetLightFieldLocation(shaderId, light, "direction");
+    slot->locs.color          = RLG_GetLightFieldLocation(shaderId, light, "color");
+    slot->locs.energy         = RLG_GetLightFieldLocation(shaderId, light, "energy");
+    slot->locs.specular       = RLG_GetLightFieldLocation(shaderId, light, "specular");
+    slot->locs.size           = RLG_GetLightFieldLocation(shaderId, light, "size");
+    slot->locs.innerCutOff    = RLG_GetLightFieldLocation(shaderId, light, "innerCutOff");
+    slot->locs.outerCutOff    = RLG_GetLightFieldLocation(shaderId, light, "outerCutOff");
+    slot->locs.distance       = RLG_GetLightFieldLocation(shaderId, light, "distance");
+    slot->locs.attenuation    = RLG_GetLightFieldLocation(shaderId, light, "attenuation");
+    slot->locs.shadowMapTxlSz = RLG_GetLightFieldLocation(shaderId, light, "shadowMapTxlSz");
+    slot->locs.depthBias      = RLG_GetLightFieldLocation(shaderId, light, "depthBias");
+    slot->locs.type           = RLG_GetLightFieldLocation(shaderId, light, "type");
+    slot->locs.shadow         = RLG_GetLightFieldLocation(shaderId, light, "shadow");
+    slot->locs.enabled        = RLG_GetLightFieldLocation(shaderId, light, "enabled");
+    slot->locs.cascades       = RLG_GetLightFieldLocation(shaderId, light, "cascades");
+    slot->locs.shadowRect     = RLG_GetLightFieldLocation(shaderId, light, "shadowRect");
+
+    // NOTE: Only the lighting pass shader of the deferred mode has these uniforms, the model
+    //       shader reads the cascades of its lights in the light uniform block (GLSL 330 or higher)
+    slot->locs.matCascades    = -1;
+    slot->locs.cascadeSplits  = -1;
+
+    // NOTE: Slots are disabled by default in the shader (uniforms initialized to zero)
+    slot->light = -1;
+    slot->version = 0;
+}
 
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightValue' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return result;
-    }
+#ifndef NO_EMBEDDED_SHADERS
 
-    const struct RLG_Light *l = &rlgCtx->lights[light];
+static void RLG_GetPermutationDefines(unsigned int flags, char *defines, int size)
+{
+    static const char *names[RLG_COUNT_SHADER_FLAGS] = {
+        "USE_ALBEDO_MAP", "USE_METALNESS_MAP", "USE_NORMAL_MAP", "USE_ROUGHNESS_MAP",
+        "USE_OCCLUSION_MAP", "USE_EMISSION_MAP", "USE_HEIGHT_MAP", "USE_CUBEMAP",
+        "USE_IRRADIANCE_MAP", "USE_DEEP_PARALLAX", "RECEIVE_SHADOW", "USE_CLUSTERS",
+        "USE_INSTANCING"
+    };
 
-    switch (property)
+    int length = snprintf(defines, size, "#define PERMUTATION\n");
+
+    for (int i = 0; i < RLG_COUNT_SHADER_FLAGS && length < size; i++)
     {
-        case RLG_LIGHT_ENERGY:
-            result = l->data.energy;
-            break;
+        length += snprintf(defines + length, size - length, "#define %s %s\n",
+            names[i], (flags & (1 << i)) ? "true" : "false");
+    }
+}
 
-        case RLG_LIGHT_SPECULAR:
-            result = l->data.specular;
-            break;
+#endif //NO_EMBEDDED_SHADERS
 
-        case RLG_LIGHT_SIZE:
-            result = l->data.size;
-            break;
+static void RLG_SubmitModelProgram(struct RLG_PendingProgram *pending, unsigned int flags, bool permutation)
+{
+#ifndef NO_EMBEDDED_SHADERS
+    // NOTE: The default program is compiled without defines, the features are then tested at runtime
+    char defines[512] = { 0 };
+    if (permutation) RLG_GetPermutationDefines(flags, defines, sizeof(defines));
 
-        case RLG_LIGHT_INNER_CUTOFF:
-            result = l->data.innerCutOff;
-            break;
-
-        case RLG_LIGHT_OUTER_CUTOFF:
-            result = l->data.outerCutOff;
-            break;
-
-        case RLG_LIGHT_DISTANCE:
-            result = l->data.distance;
-            break;
-
-        case RLG_LIGHT_ATTENUATION:
-            result = l->data.attenuation;
-            break;
-
-        default:
-            break;
-    }
+    const char *vsCodes[4] = { GLSL_VERSION_DEF, GLSL_NUM_LIGHTS, defines, G_VS_CACHE_Model };
+    const char *fsCodes[4] = { GLSL_VERSION_DEF, GLSL_NUM_LIGHTS, defines, G_FS_CACHE_Model };
 
-    return result;
+    RLG_SubmitProgram(pending, vsCodes, fsCodes, NULL, 4, 4);
+#else
+    (void)flags; (void)permutation;
+    RLG_SubmitProgram(pending, &G_VS_CACHE_Model, &G_FS_CACHE_Model, NULL, 1, 1);
+#endif
 }
 
-Vector3 RLG_GetLightVec3(unsigned int light, RLG_LightProperty property)
+static bool RLG_InitModelProgram(struct RLG_ModelProgram *program, unsigned int id, unsigned int flags)
 {
-    Vector3 result = { 0 };
+    Shader shader = RLG_InitModelShader(id);
+
+    program->shader = shader;
+    program->flags = flags;
 
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    // Retrieving the uniforms indicating which textures we should sample
+    for (int i = 0, mapID = 0, cubemapID = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightVec3' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return result;
+        if (i == MATERIAL_MAP_CUBEMAP || i == MATERIAL_MAP_IRRADIANCE || i == MATERIAL_MAP_PREFILTER)
+        {
+            program->locs.useMaps[i] = rlGetLocationUniform(shader.id, TextFormat("cubemaps[%i].enabled", cubemapID));
+            cubemapID++;
+        }
+        else
+        {
+            program->locs.useMaps[i] = rlGetLocationUniform(shader.id, TextFormat("maps[%i].enabled", mapID));
+            mapID++;
+        }
     }
 
-    const struct RLG_Light *l = &rlgCtx->lights[light];
-
-    switch (property)
+    // Recovery of “special” lighting shader uniforms
+    program->locs.parallaxMinLayers = rlGetLocationUniform(shader.id, "parallaxMinLayers");
+    program->locs.parallaxMaxLayers = rlGetLocationUniform(shader.id, "parallaxMaxLayers");
+    program->locs.farPlane = rlGetLocationUniform(shader.id, "farPlane");
+    program->locs.linearOmniShadows = rlGetLocationUniform(shader.id, "linearOmniShadows");
+    program->locs.shadowAtlas = rlGetLocationUniform(shader.id, "shadowAtlas");
+
+    // Retrieving the clustered shading uniforms (absent below GLSL 330)
+    program->locs.useClusters = rlGetLocationUniform(shader.id, "useClusters");
+    program->locs.clusterLights = rlGetLocationUniform(shader.id, "clusterLights");
+    program->locs.clusterItems = rlGetLocationUniform(shader.id, "clusterItems");
+    program->locs.clusterGrid = rlGetLocationUniform(shader.id, "clusterGrid");
+    program->locs.clusterDepth = rlGetLocationUniform(shader.id, "clusterDepth");
+
+    // NOTE: The attribute is removed by the compiler from the programs not compiled for instancing
+    program->locs.instanceTransform = rlGetLocationAttrib(shader.id, RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM);
+
+    // Retrieving the uniform locations of each light slot
+    // NOTE: With GLSL 330 or higher the lights are stored in a uniform block, the locations are then -1
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
     {
-        case RLG_LIGHT_POSITION:
-            result = l->data.position;
-            break;
-
-        case RLG_LIGHT_DIRECTION:
-            result = l->data.direction;
-            break;
+        RLG_GetLightSlotLocations(&program->slots[i], shader.id,
+            TextFormat("lights[%i]", i), TextFormat("matLights[%i]", i));
+    }
 
-        case RLG_LIGHT_COLOR:
-            result = l->data.color;
-            break;
+    // All the values of the context are uploaded at the first use of the program
+    program->dirty = RLG_DIRTY_ALL;
 
-        default:
-            break;
-    }
+    // NOTE: NaN bit patterns never compare equal to the material values, they are sent at the first draw
+    memset(&program->material, 0xFF, sizeof(program->material));
+    program->samplers = 0;
 
-    return result;
+    return (shader.id > 0);
 }
 
-Color RLG_GetLightColor(unsigned int light)
+#ifndef NO_EMBEDDED_SHADERS
+static bool RLG_LoadModelProgram(struct RLG_ModelProgram *program, unsigned int flags, bool permutation)
 {
-    Color result = BLACK;
+    struct RLG_PendingProgram pending;
+    RLG_SubmitModelProgram(&pending, flags, permutation);
 
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightColor' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return result;
-    }
+    return RLG_InitModelProgram(program, RLG_FinishProgram(&pending), flags);
+}
+#endif //NO_EMBEDDED_SHADERS
 
+static void RLG_UploadLightSlot(struct RLG_LightSlot *slot, int light)
+{
     const struct RLG_Light *l = &rlgCtx->lights[light];
 
-    result.r = 255*l->data.color.x;
-    result.g = 255*l->data.color.y;
-    result.b = 255*l->data.color.z;
+    // NOTE: If the slot already holds this light, only the fields modified since its upload are sent
+    unsigned int fields = (slot->light == light)
+        ? RLG_GetLightChanges(l, slot->version)
+        : RLG_LIGHT_DIRTY_ALL;
 
-    return result;
-}
+    if (fields & RLG_LIGHT_DIRTY_MATRIX) RLG_SetUniformMatrix(slot->locs.vpMatrix, l->data.vpMatrix);
+    if (fields & RLG_LIGHT_DIRTY_POSITION) RLG_SetUniform(slot->locs.position, &l->data.position, SHADER_UNIFORM_VEC3, 1);
+    if (fields & RLG_LIGHT_DIRTY_DIRECTION) RLG_SetUniform(slot->locs.direction, &l->data.direction, SHADER_UNIFORM_VEC3, 1);
+    if (fields & RLG_LIGHT_DIRTY_COLOR) RLG_SetUniform(slot->locs.color, &l->data.color, SHADER_UNIFORM_VEC3, 1);
+    if (fields & RLG_LIGHT_DIRTY_ENERGY) RLG_SetUniform(slot->locs.energy, &l->data.energy, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_SPECULAR) RLG_SetUniform(slot->locs.specular, &l->data.specular, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_SIZE) RLG_SetUniform(slot->locs.size, &l->data.size, SHADER_UNIFORM_FLOAT, 1);
 
-void RLG_LightTranslate(unsigned int light, float x, float y, float z)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (fields & RLG_LIGHT_DIRTY_INNER_CUTOFF)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightTranslate' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        float innerCutOff = cosf(l->data.innerCutOff*DEG2RAD);
+        RLG_SetUniform(slot->locs.innerCutOff, &innerCutOff, SHADER_UNIFORM_FLOAT, 1);
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-
-    l->data.position.x += x;
-    l->data.position.y += y;
-    l->data.position.z += z;
+    if (fields & RLG_LIGHT_DIRTY_OUTER_CUTOFF)
+    {
+        float outerCutOff = cosf(l->data.outerCutOff*DEG2RAD);
+        RLG_SetUniform(slot->locs.outerCutOff, &outerCutOff, SHADER_UNIFORM_FLOAT, 1);
+    }
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.position,
-        &l->data.position, SHADER_UNIFORM_VEC3);
-}
+    if (fields & RLG_LIGHT_DIRTY_DISTANCE) RLG_SetUniform(slot->locs.distance, &l->data.distance, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_ATTENUATION) RLG_SetUniform(slot->locs.attenuation, &l->data.attenuation, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_SHADOW_TEXEL) RLG_SetUniform(slot->locs.shadowMapTxlSz, &l->data.shadowMapTxlSz, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_DEPTH_BIAS) RLG_SetUniform(slot->locs.depthBias, &l->data.depthBias, SHADER_UNIFORM_FLOAT, 1);
+    if (fields & RLG_LIGHT_DIRTY_TYPE) RLG_SetUniform(slot->locs.type, &l->data.type, SHADER_UNIFORM_INT, 1);
+    if (fields & RLG_LIGHT_DIRTY_SHADOW) RLG_SetUniform(slot->locs.shadow, &l->data.shadow, SHADER_UNIFORM_INT, 1);
+    if (fields & RLG_LIGHT_DIRTY_ENABLED) RLG_SetUniform(slot->locs.enabled, &l->data.enabled, SHADER_UNIFORM_INT, 1);
+    if (fields & RLG_LIGHT_DIRTY_SHADOW_RECT) RLG_SetUniform(slot->locs.shadowRect, &l->data.shadowRect, SHADER_UNIFORM_VEC4, 1);
 
-void RLG_LightTranslateV(unsigned int light, Vector3 v)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (fields & RLG_LIGHT_DIRTY_CASCADES)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightTranslateV' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
-    }
+        RLG_SetUniform(slot->locs.cascades, &l->data.cascades, SHADER_UNIFORM_INT, 1);
+        RLG_SetUniform(slot->locs.cascadeSplits, l->data.cascadeSplits, SHADER_UNIFORM_VEC4, 1);
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    l->data.position.x += v.x;
-    l->data.position.y += v.y;
-    l->data.position.z += v.z;
+        // NOTE: The elements of a uniform array have consecutive locations
+        for (int i = 0; i < l->data.cascades && slot->locs.matCascades >= 0; i++)
+        {
+            RLG_SetUniformMatrix(slot->locs.matCascades + i, l->data.cascadeMatrices[i]);
+        }
+    }
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.position,
-        &l->data.position, SHADER_UNIFORM_VEC3);
+    slot->light = light;
+    slot->version = l->version;
+    rlgCtx->stats.lightUploads++;
 }
 
-void RLG_LightRotateX(unsigned int light, float degrees)
+static void RLG_SetLightSlot(int index, int light)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateX' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
-    }
-
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    float radians = DEG2RAD*degrees;
-    float c = cosf(radians);
-    float s = sinf(radians);
+    struct RLG_SlotAssignment *slot = &rlgCtx->slots[index];
 
-    l->data.direction.y = l->data.direction.y*c + l->data.direction.z*s;
-    l->data.direction.z = -l->data.direction.y*s + l->data.direction.z*c;
+    slot->light = light;
+    slot->version = (light >= 0) ? rlgCtx->lights[light].version : 0;
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-        &l->data.direction, SHADER_UNIFORM_VEC3);
-}
+#if GLSL_VERSION >= 330
+    // NOTE: The slot is written into the uniform block copy, uploaded once before drawing
+    struct RLG_UniformBlocks *b = &rlgCtx->blocks;
 
-void RLG_LightRotateY(unsigned int light, float degrees)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (light >= 0)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateY' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        const struct RLG_Light *l = &rlgCtx->lights[light];
+
+        b->lights.lights[index].position       = l->data.position;
+        b->lights.lights[index].energy         = l->data.energy;
+        b->lights.lights[index].direction      = l->data.direction;
+        b->lights.lights[index].specular       = l->data.specular;
+        b->lights.lights[index].color          = l->data.color;
+        b->lights.lights[index].size           = l->data.size;
+        b->lights.lights[index].innerCutOff    = cosf(l->data.innerCutOff*DEG2RAD);
+        b->lights.lights[index].outerCutOff    = cosf(l->data.outerCutOff*DEG2RAD);
+        b->lights.lights[index].distance       = l->data.distance;
+        b->lights.lights[index].attenuation    = l->data.attenuation;
+        b->lights.lights[index].shadowMapTxlSz = l->data.shadowMapTxlSz;
+        b->lights.lights[index].depthBias      = l->data.depthBias;
+        b->lights.lights[index].type           = l->data.type;
+        b->lights.lights[index].shadow         = l->data.shadow;
+        b->lights.lights[index].enabled        = l->data.enabled;
+        b->lights.lights[index].cascades       = l->data.cascades;
+        b->lights.lights[index].shadowRect     = l->data.shadowRect;
+
+        memcpy(b->lights.matLights[index], MatrixToFloatV(l->data.vpMatrix).v, 16*sizeof(float));
+        memcpy(b->lights.cascadeSplits[index], l->data.cascadeSplits, sizeof(l->data.cascadeSplits));
+
+        for (int i = 0; i < l->data.cascades; i++)
+        {
+            int cascade = index*RLG_MAX_SHADOW_CASCADES + i;
+            memcpy(b->lights.matCascades[cascade], MatrixToFloatV(l->data.cascadeMatrices[i]).v, 16*sizeof(float));
+        }
+    }
+    else
+    {
+        b->lights.lights[index].enabled = 0;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    float radians = DEG2RAD*degrees;
-    float c = cosf(radians);
-    float s = sinf(radians);
+    b->lightsDirty = true;
+#endif
+}
 
-    l->data.direction.x = l->data.direction.x*c - l->data.direction.z*s;
-    l->data.direction.z = l->data.direction.x*s + l->data.direction.z*c;
+#if GLSL_VERSION < 330
+
+static void RLG_UploadProgramSlots(struct RLG_ModelProgram *program)
+{
+    // NOTE: Each program has its own uniforms, it receives the lights assigned
+    //       to the slots that changed since the last time it was used
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
+    {
+        const struct RLG_SlotAssignment *assigned = &rlgCtx->slots[i];
+        struct RLG_LightSlot *slot = &program->slots[i];
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-        &l->data.direction, SHADER_UNIFORM_VEC3);
+        if (assigned->light >= 0)
+        {
+            if (slot->light != assigned->light || slot->version != rlgCtx->lights[assigned->light].version)
+            {
+                RLG_UploadLightSlot(slot, assigned->light);
+            }
+        }
+        else if (slot->light >= 0)
+        {
+            // Slot no longer used, we disable it in the shader
+            int enabled = 0;
+            RLG_SetUniform(slot->locs.enabled, &enabled, SHADER_UNIFORM_INT, 1);
+            slot->light = -1;
+        }
+    }
 }
 
-void RLG_LightRotateZ(unsigned int light, float degrees)
+#endif //GLSL_VERSION
+
+static void RLG_MarkProgramsDirty(unsigned int dirty)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    for (int i = 0; i < rlgCtx->programCount; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateZ' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        rlgCtx->programs[i].dirty |= dirty;
     }
+}
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    float radians = DEG2RAD*degrees;
-    float c = cosf(radians);
-    float s = sinf(radians);
+static void RLG_UploadModelState(struct RLG_ModelProgram *program)
+{
+    // NOTE: The setters only flag the values they modify, the program being bound here
+    //       they are all uploaded at once rather than binding it for each of them
+    unsigned int dirty = program->dirty;
+    if (dirty == 0) return;
 
-    l->data.direction.x = l->data.direction.x*c + l->data.direction.y*s;
-    l->data.direction.y = -l->data.direction.x*s + l->data.direction.y*c;
+    const Shader *shader = &program->shader;
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-        &l->data.direction, SHADER_UNIFORM_VEC3);
-}
+    if (dirty & RLG_DIRTY_VIEW_POSITION)
+    {
+        RLG_SetUniform(shader->locs[RLG_LOC_VECTOR_VIEW], &rlgCtx->viewPos, SHADER_UNIFORM_VEC3, 1);
+    }
 
-void RLG_LightRotate(unsigned int light, Vector3 axis, float degrees)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    if (dirty & RLG_DIRTY_AMBIENT_COLOR)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotate' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        RLG_SetUniform(shader->locs[RLG_LOC_COLOR_AMBIENT], &rlgCtx->colAmbient, SHADER_UNIFORM_VEC3, 1);
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    float radians = -DEG2RAD*degrees;
-    float halfTheta = radians*0.5f;
+    if (dirty & RLG_DIRTY_AMBIENT_SH)
+    {
+        int useAmbientSH = rlgCtx->useAmbientSH;
+        RLG_SetUniform(shader->locs[RLG_LOC_AMBIENT_SH], rlgCtx->ambientSH, SHADER_UNIFORM_VEC3, RLG_SH_COEFFICIENTS);
+        RLG_SetUniform(shader->locs[RLG_LOC_USE_AMBIENT_SH], &useAmbientSH, SHADER_UNIFORM_INT, 1);
+    }
 
-    float sinHalfTheta = sinf(halfTheta);
-    Quaternion rotationQuat = {
-        axis.x * sinHalfTheta,
-        axis.y * sinHalfTheta,
-        axis.z * sinHalfTheta,
-        cosf(halfTheta)
-    };
+    if (dirty & RLG_DIRTY_FAR_PLANE)
+    {
+        int linear = rlgCtx->linearOmniShadows;
+        RLG_SetUniform(program->locs.farPlane, &rlgCtx->zFar, SHADER_UNIFORM_FLOAT, 1);
+        RLG_SetUniform(program->locs.linearOmniShadows, &linear, SHADER_UNIFORM_INT, 1);
+    }
 
-    // Convert the current direction vector to a quaternion
-    Quaternion directionQuat = {
-        l->data.direction.x,
-        l->data.direction.y,
-        l->data.direction.z,
-        0.0f
-    };
+    if (dirty & RLG_DIRTY_SHADOW_ATLAS)
+    {
+        int unit = RLG_SHADOW_ATLAS_TEXTURE_SLOT;
+        RLG_SetUniform(program->locs.shadowAtlas, &unit, SHADER_UNIFORM_INT, 1);
+    }
 
-    // Calculate the rotated direction quaternion
-    Quaternion rotatedQuat = QuaternionMultiply(
-        QuaternionMultiply(rotationQuat, directionQuat),
-        QuaternionInvert(rotationQuat));
+#if GLSL_VERSION >= 330
+    if (dirty & RLG_DIRTY_CLUSTERS)
+    {
+        const struct RLG_ClusterHandler *c = &rlgCtx->clusters;
+
+        int grid[3] = { RLG_CLUSTER_GRID_X, RLG_CLUSTER_GRID_Y, RLG_CLUSTER_GRID_Z };
+        int lightsSlot = RLG_CLUSTER_TEXTURE_SLOT, itemsSlot = RLG_CLUSTER_TEXTURE_SLOT + 1;
+        float depth[3] = { c->depthScale, c->depthBias, (float)c->depthLog };
+        int useClusters = (int)c->enabled;
+
+        RLG_SetUniform(program->locs.clusterGrid, grid, SHADER_UNIFORM_IVEC3, 1);
+        RLG_SetUniform(program->locs.clusterLights, &lightsSlot, SHADER_UNIFORM_INT, 1);
+        RLG_SetUniform(program->locs.clusterItems, &itemsSlot, SHADER_UNIFORM_INT, 1);
+        RLG_SetUniform(program->locs.clusterDepth, depth, SHADER_UNIFORM_VEC3, 1);
+        RLG_SetUniform(program->locs.useClusters, &useClusters, SHADER_UNIFORM_INT, 1);
+    }
+#else
+    // NOTE: With GLSL 330 or higher these values are stored in the material uniform block
+    if (dirty & RLG_DIRTY_PARALLAX_LAYERS)
+    {
+        RLG_SetUniform(program->locs.parallaxMinLayers, &rlgCtx->material.data.parallaxMinLayers, SHADER_UNIFORM_INT, 1);
+        RLG_SetUniform(program->locs.parallaxMaxLayers, &rlgCtx->material.data.parallaxMaxLayers, SHADER_UNIFORM_INT, 1);
+    }
 
-    // Update the light direction with the rotated direction
-    l->data.direction = Vector3Normalize(INIT_STRUCT(Vector3,
-        rotatedQuat.x, rotatedQuat.y, rotatedQuat.z
-    ));
+    for (int i = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
+    {
+        if (dirty & RLG_DIRTY_MAP(i))
+        {
+            RLG_SetUniform(program->locs.useMaps[i], &rlgCtx->material.data.useMaps[i], SHADER_UNIFORM_INT, 1);
+        }
+    }
+#endif
 
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-        &l->data.direction, SHADER_UNIFORM_VEC3);
+    program->dirty = 0;
 }
 
-void RLG_SetLightTarget(unsigned int light, float x, float y, float z)
+static void RLG_GetMaterialUniforms(Material material, struct RLG_MaterialUniforms *values)
 {
-    RLG_SetLightTargetV(light, INIT_STRUCT(Vector3, x, y, z));
-}
+    const MaterialMap *maps[RLG_COUNT_MATERIAL_MAPS];
 
-void RLG_SetLightTargetV(unsigned int light, Vector3 targetPosition)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    for (int i = 0; i < RLG_COUNT_MATERIAL_MAPS; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightTarget' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        maps[i] = (rlgCtx->usedDefaultMaps[i]) ? &rlgCtx->defaultMaps[i] : &material.maps[i];
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-
-    l->data.direction = Vector3Normalize(Vector3Subtract(
-        targetPosition, l->data.position));
-
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.direction,
-        &l->data.direction, SHADER_UNIFORM_VEC3);
-}
+    const Color colors[3] = {
+        maps[MATERIAL_MAP_ALBEDO]->color,
+        maps[MATERIAL_MAP_METALNESS]->color,
+        maps[MATERIAL_MAP_EMISSION]->color
+    };
 
-Vector3 RLG_GetLightTarget(unsigned int light)
-{
-    Vector3 result = INIT_STRUCT_ZERO(Vector3);
+    float *targets[3] = { values->colDiffuse, values->colSpecular, values->colEmission };
 
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    for (int i = 0; i < 3; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightTarget' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return result;
+        targets[i][0] = (float)colors[i].r/255.0f;
+        targets[i][1] = (float)colors[i].g/255.0f;
+        targets[i][2] = (float)colors[i].b/255.0f;
+        targets[i][3] = (float)colors[i].a/255.0f;
     }
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    result = Vector3Add(l->data.position, l->data.direction);
-
-    return result;
+    values->metalness = maps[MATERIAL_MAP_METALNESS]->value;
+    values->roughness = maps[MATERIAL_MAP_ROUGHNESS]->value;
+    values->aoLightAffect = maps[MATERIAL_MAP_OCCLUSION]->value;
+    values->heightScale = maps[MATERIAL_MAP_HEIGHT]->value;
 }
 
-void RLG_EnableShadow(unsigned int light, int shadowMapResolution)
+static unsigned int RLG_GetShaderFlags(void)
 {
-    // Check if the specified light ID is within the valid range
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    unsigned int flags = 0;
+
+    // NOTE: The flags of the maps use the same bits as their MaterialMapIndex
+    for (int i = 0; i <= MATERIAL_MAP_IRRADIANCE; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_EnableShadow' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        if (rlgCtx->material.data.useMaps[i]) flags |= (1 << i);
     }
 
-    // Get a pointer to the specified light structure
-    struct RLG_Light *l = &rlgCtx->lights[light];
+    if ((flags & RLG_USE_HEIGHT_MAP) &&
+        rlgCtx->material.data.parallaxMinLayers > 0 &&
+        rlgCtx->material.data.parallaxMaxLayers > 1)
+    {
+        flags |= RLG_USE_DEEP_PARALLAX;
+    }
 
-    // Check if the current shadow map resolution is different from the desired resolution
-    if (l->data.shadowMap.width != shadowMapResolution)
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
     {
-        // If the shadow map is already initialized, unload the existing texture and framebuffer
-        if (l->data.shadowMap.id != 0)
+        int light = rlgCtx->slots[i].light;
+
+        if (light >= 0 && rlgCtx->lights[light].data.shadow)
         {
-            rlUnloadTexture(l->data.shadowMap.depth.id);
-            rlUnloadFramebuffer(l->data.shadowMap.id);
+            flags |= RLG_RECEIVE_SHADOW;
+            break;
         }
+    }
 
-        // Get a pointer to the shadow map structure of the light
-        struct RLG_ShadowMap *sm = &l->data.shadowMap;
-
-        // If the light is an omnidirectional light, set up a cube map for shadows
-        if (l->data.type == RLG_OMNILIGHT)
-        {
-            glGenTextures(1, &sm->depth.id);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, sm->depth.id);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-            for (int i = 0; i < 6; ++i)
-            {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-                    shadowMapResolution, shadowMapResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-            }
-            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-            glGenFramebuffers(1, &sm->id);
-            glBindFramebuffer(GL_FRAMEBUFFER, sm->id);
-            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, sm->depth.id, 0);
-            glDrawBuffer(GL_NONE);
-            glReadBuffer(GL_NONE);
+    if (rlgCtx->clusters.enabled) flags |= RLG_USE_CLUSTERS;
 
-            // Check if the framebuffer is complete
-            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            {
-                // Log an error if the framebuffer is not complete
-                TraceLog(LOG_ERROR, "Framebuffer is not complete for omnidirectional shadow map");
-            }
+    return flags;
+}
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+static struct RLG_ModelProgram* RLG_GetModelProgram(unsigned int flags)
+{
+#ifndef NO_EMBEDDED_SHADERS
+    for (int i = 1; i < rlgCtx->programCount; i++)
+    {
+        struct RLG_ModelProgram *program = &rlgCtx->programs[i];
 
-            // Configure the shadow map parameters
-            sm->depth.width = sm->depth.height = shadowMapResolution;
-            sm->width = sm->height = shadowMapResolution;
-            sm->depth.format = 19, sm->depth.mipmaps = 1;
-        }
-        else
+        if (program->flags == flags)
         {
-            // Set up a 2D texture for shadow map for other light types
-            sm->id = rlLoadFramebuffer(shadowMapResolution, shadowMapResolution);
-            sm->width = sm->height = shadowMapResolution;
-            rlEnableFramebuffer(sm->id);
+            // NOTE: A permutation that failed to load is kept to not be compiled again
+            return (program->shader.id > 0) ? program : &rlgCtx->programs[0];
+        }
+    }
 
-            sm->depth.id = rlLoadTextureDepth(shadowMapResolution, shadowMapResolution, false);
-            sm->depth.width = sm->depth.height = shadowMapResolution;
-            sm->depth.format = 19, sm->depth.mipmaps = 1;
+    if (rlgCtx->programCount < RLG_MAX_SHADER_PERMUTATIONS)
+    {
+        struct RLG_ModelProgram *program = &rlgCtx->programs[rlgCtx->programCount++];
 
-            rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_S, RL_TEXTURE_WRAP_CLAMP);
-            rlTextureParameters(sm->depth.id, RL_TEXTURE_WRAP_T, RL_TEXTURE_WRAP_CLAMP);
-            rlFramebufferAttach(sm->id, sm->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+        if (rlgCtx->programCount == RLG_MAX_SHADER_PERMUTATIONS)
+        {
+            TraceLog(LOG_WARNING, "Maximum number of shader permutations reached [MAX %i], the other combinations will use the default model shader", RLG_MAX_SHADER_PERMUTATIONS);
         }
 
-        // REVIEW: Should this value be modifiable by the user?
-        float texelSize = 1.0f/shadowMapResolution;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.shadowMapTxlSz,
-            &texelSize, SHADER_UNIFORM_FLOAT);
+        if (RLG_LoadModelProgram(program, flags, true))
+        {
+            return program;
+        }
 
-        // Set the depth bias value based on the light type
-        l->data.depthBias = (l->data.type == RLG_OMNILIGHT) ? 0.05f : 0.0002f;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.depthBias,
-            &l->data.depthBias, SHADER_UNIFORM_FLOAT);
+        TraceLog(LOG_WARNING, "Failed to load the model shader permutation [FLAGS 0x%03x], the default model shader will be used", flags);
     }
+#else
+    (void)flags;
+#endif
 
-    // Enable shadows for the light and send the information to the shader
-    l->data.shadow = true;
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.shadow,
-        &l->data.shadow, SHADER_UNIFORM_INT);
+    return &rlgCtx->programs[0];
 }
 
-void RLG_DisableShadow(unsigned int light)
+static void RLG_AssignLightSlots(const int *selected, int count)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
-    {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_DisableShadow' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
-    }
+    bool placed[RLG_MAX_LIGHTS_PER_MATERIAL] = { 0 };
+    bool kept[RLG_MAX_LIGHTS_PER_MATERIAL] = { 0 };
 
-    struct RLG_Light *l = &rlgCtx->lights[light];
-
-    if (l->data.shadow)
+    // Lights already present in a slot stay in it, they only need to be re-uploaded if they changed
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
     {
-        // Unload depth texture and framebuffer
-        rlUnloadTexture(l->data.shadowMap.depth.id);
-        rlUnloadFramebuffer(l->data.shadowMap.id);
+        struct RLG_SlotAssignment *slot = &rlgCtx->slots[i];
+        if (slot->light < 0) continue;
 
-        // Fill shadow map struct with zeroes
-        l->data.shadowMap = INIT_STRUCT_ZERO(struct RLG_ShadowMap);
+        for (int j = 0; j < count; j++)
+        {
+            if (!placed[j] && selected[j] == slot->light)
+            {
+                if (slot->version != rlgCtx->lights[slot->light].version)
+                {
+                    RLG_SetLightSlot(i, slot->light);
+                }
 
-        // Send info to the shader
-        l->data.shadow = false;
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.shadow,
-            &l->data.shadow, SHADER_UNIFORM_INT);
+                placed[j] = kept[i] = true;
+                break;
+            }
+        }
     }
-}
 
-bool RLG_IsShadowEnabled(unsigned int light)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    // The other selected lights take the place of the lights that are no longer needed
+    for (int i = 0, j = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_IsShadowEnabled' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return false;
-    }
+        if (kept[i]) continue;
 
-    return rlgCtx->lights[light].data.shadow;
+        struct RLG_SlotAssignment *slot = &rlgCtx->slots[i];
+
+        while (j < count && placed[j]) j++;
+
+        if (j < count)
+        {
+            RLG_SetLightSlot(i, selected[j]);
+            placed[j] = true;
+        }
+        else if (slot->light >= 0)
+        {
+            // Slot no longer used, we disable it in the shader
+            RLG_SetLightSlot(i, -1);
+        }
+    }
 }
 
-void RLG_SetShadowBias(unsigned int light, float value)
+static void RLG_GetProjectionPlanes(Matrix matProjection, float *zNear, float *zFar)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    // NOTE: Orthographic projections have m15 = 1, perspective projections have m15 = 0
+    if (matProjection.m15 == 1.0f)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowBias' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        *zNear = (matProjection.m14 + 1.0f)/matProjection.m10;
+        *zFar = (matProjection.m14 - 1.0f)/matProjection.m10;
+    }
+    else
+    {
+        *zNear = matProjection.m14/(matProjection.m10 - 1.0f);
+        *zFar = matProjection.m14/(matProjection.m10 + 1.0f);
     }
-
-    struct RLG_Light *l = &rlgCtx->lights[light];
-
-    l->data.depthBias = value;
-    SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.depthBias,
-        &value, SHADER_UNIFORM_FLOAT);
 }
 
-float RLG_GetShadowBias(unsigned int light)
+#if GLSL_VERSION >= 330
+
+static void RLG_UploadBuffer(GLenum target, unsigned int buffer, const void *data, int size, int *bufferSize)
 {
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    glBindBuffer(target, buffer);
+
+    // The data store is only reallocated when it becomes too small
+    if (size > *bufferSize)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowBias' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return 0;
+        *bufferSize = (size > 2*(*bufferSize)) ? size : 2*(*bufferSize);
+        glBufferData(target, *bufferSize, NULL, GL_DYNAMIC_DRAW);
     }
 
-    return rlgCtx->lights[light].data.depthBias;
+    if (size > 0) glBufferSubData(target, 0, size, data);
+    glBindBuffer(target, 0);
 }
 
-void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc)
+static void RLG_EnableInstanceTransforms(int location, const Matrix *transforms, int count)
 {
-    // Directions and up vectors for the 6 faces of the cubemap
-    static const Vector3 dirs[6] = {
-        {  1.0,  0.0,  0.0 }, // +X
-        { -1.0,  0.0,  0.0 }, // -X
-        {  0.0,  1.0,  0.0 }, // +Y
-        {  0.0, -1.0,  0.0 }, // -Y
-        {  0.0,  0.0,  1.0 }, // +Z
-        {  0.0,  0.0, -1.0 }  // -Z
-    };
+    if (rlgCtx->instanceBuffer == 0) glGenBuffers(1, &rlgCtx->instanceBuffer);
 
-    static const Vector3 ups[6] = {
-        {  0.0, -1.0,  0.0 }, // +X
-        {  0.0, -1.0,  0.0 }, // -X
-        {  0.0,  0.0,  1.0 }, // +Y
-        {  0.0,  0.0, -1.0 }, // -Y
-        {  0.0, -1.0,  0.0 }, // +Z
-        {  0.0, -1.0,  0.0 }  // -Z
-    };
+    RLG_UploadBuffer(GL_ARRAY_BUFFER, rlgCtx->instanceBuffer, transforms, count*sizeof(Matrix), &rlgCtx->instanceBufferSize);
 
-    // Safety checks
-    if (!drawFunc)
-    {
-        // Log an error if the draw function pointer is NULL
-        TraceLog(LOG_ERROR, "The drawing function pointer specified to 'RLG_UpdateShadowMap' is NULL");
-        return;  
-    }
+    // Each matrix takes four consecutive attribute locations, advanced once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, rlgCtx->instanceBuffer);
 
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    for (int i = 0; i < 4; i++)
     {
-        // Log an error if the light ID exceeds the number of allocated lights
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_UpdateShadowMap' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return;
+        glEnableVertexAttribArray(location + i);
+        glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix), (const void*)(i*4*sizeof(float)));
+        glVertexAttribDivisor(location + i, 1);
     }
 
-    // Get a pointer to the specified light structure
-    struct RLG_Light *l = &rlgCtx->lights[light];
-    if (!l->data.shadow)
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void RLG_DisableInstanceTransforms(int location)
+{
+    // NOTE: The attributes are stored in the vertex array of the mesh, they must not stay enabled for the other draws
+    for (int i = 0; i < 4; i++)
     {
-        TraceLog(LOG_ERROR, "Light [ID %i] does not support shadow casting", light);
-        return;
+        glVertexAttribDivisor(location + i, 0);
+        glDisableVertexAttribArray(location + i);
     }
+}
 
-    // Flush the rendering batch and enable the shadow map framebuffer
-    rlDrawRenderBatchActive();
-    rlEnableFramebuffer(l->data.shadowMap.id);
-
-    // Configure the projection for the shadow map
-    rlViewport(0, 0, l->data.shadowMap.width, l->data.shadowMap.height);
-    rlMatrixMode(RL_PROJECTION);
-    rlPushMatrix();
-    rlLoadIdentity();
+static void RLG_WriteMaterialBlock(Material material)
+{
+    struct RLG_UniformBlocks *b = &rlgCtx->blocks;
 
-    // Near and far clipping planes for shadow map rendering
-    rlgCtx->zNear = 0.01f;      // TODO: replace with rlGetCullDistanceNear()
-    rlgCtx->zFar = 1000.0f;     // TODO: replace with rlGetCullDistanceFar()
+    // NOTE: Built in a copy, the buffer is only updated if the parameters changed since the last draw
+    struct RLG_MaterialBlock block = b->material;
 
-    // Set up projection matrix based on the light type
-    switch (l->data.type)
+    for (int i = 0; i < 7; i++)
     {
-        case RLG_DIRLIGHT:
-            // Orthographic projection for directional
-            rlOrtho(-10.0, 10.0, -10.0, 10.0, rlgCtx->zNear, rlgCtx->zFar);
-            break;
-        case RLG_SPOTLIGHT:
-            // Perspective projection for spotlight
-            rlMultMatrixf(MatrixToFloat(MatrixPerspective(90*DEG2RAD, 1.0, 0.01, l->data.distance)));
-            break;
-        case RLG_OMNILIGHT:
-            // Perspective projection for omnidirectional light
-            rlMultMatrixf(MatrixToFloat(MatrixPerspective(90*DEG2RAD, 1.0, 0.01, l->data.distance)));
-            break;
+        const MaterialMap *map = (rlgCtx->usedDefaultMaps[i])
+            ? &rlgCtx->defaultMaps[i] : &material.maps[i];
+
+        block.maps[i].color[0] = (float)map->color.r/255.0f;
+        block.maps[i].color[1] = (float)map->color.g/255.0f;
+        block.maps[i].color[2] = (float)map->color.b/255.0f;
+        block.maps[i].color[3] = (float)map->color.a/255.0f;
+        block.maps[i].value = map->value;
+        block.maps[i].enabled = rlgCtx->material.data.useMaps[i];
     }
 
-    // Switch to modelview matrix mode
-    rlMatrixMode(RL_MODELVIEW);
+    block.maps[7].enabled = rlgCtx->material.data.useMaps[MATERIAL_MAP_BRDF];
 
-    // Enable depth test and disable color blending
-    rlEnableDepthTest();
-    rlDisableColorBlend();
+    block.cubemaps[0].enabled = rlgCtx->material.data.useMaps[MATERIAL_MAP_CUBEMAP];
+    block.cubemaps[1].enabled = rlgCtx->material.data.useMaps[MATERIAL_MAP_IRRADIANCE];
+    block.cubemaps[2].enabled = rlgCtx->material.data.useMaps[MATERIAL_MAP_PREFILTER];
 
-    // Select the appropriate depth shader
-    Shader shader = { 0 };
-    if (l->data.type == RLG_OMNILIGHT)
-    {
-        shader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP];
+    block.parallaxMinLayers = rlgCtx->material.data.parallaxMinLayers;
+    block.parallaxMaxLayers = rlgCtx->material.data.parallaxMaxLayers;
 
-        // Send the light position to the depth shader
-        SetShaderValue(shader, rlgCtx->locDepthCubemapLightPos,
-            &l->data.position, SHADER_UNIFORM_VEC3);
+    if (memcmp(&block, &b->material, sizeof(struct RLG_MaterialBlock)) != 0)
+    {
+        b->material = block;
+        b->materialDirty = true;
+    }
+}
 
-        // Send zFar to the depth shader to scale depth from [0..zFar] to [0..1]
-        SetShaderValue(shader, rlgCtx->locDepthCubemapFar,
-            &rlgCtx->zFar, SHADER_UNIFORM_FLOAT);
+static void RLG_UploadUniformBlocks(void)
+{
+    struct RLG_UniformBlocks *b = &rlgCtx->blocks;
 
-        // Send zFar to the lighting shader to scale depth from [0..1] to [0..zFar]
-        SetShaderValue(rlgCtx->shaders[RLG_SHADER_MODEL],
-            rlgCtx->locLightingFar, &rlgCtx->zFar,
-            SHADER_UNIFORM_FLOAT);
+    // NOTE: The buffers are bound at the first draw of a batch (at each draw otherwise),
+    // several contexts can exist and share the binding points
+    if (!rlgCtx->state.blocks)
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, RLG_LIGHT_BLOCK_BINDING, b->lightsBuffer);
+        glBindBufferBase(GL_UNIFORM_BUFFER, RLG_MATERIAL_BLOCK_BINDING, b->materialBuffer);
+        rlgCtx->state.blocks = true;
     }
     else
     {
-        shader = rlgCtx->shaders[RLG_SHADER_DEPTH];
+        rlgCtx->stats.skippedBufferBinds += 2;
     }
 
-    // Determine the number of iterations for omnidirectional light
-    int iterationCount = (l->data.type == RLG_OMNILIGHT) ? 6 : 1;
-    for (int i = 0; i < iterationCount; i++)
+    if (b->lightsDirty)
     {
-        // Configure the ModelView matrix
-        Matrix matView = { 0 };
-        if (l->data.type == RLG_OMNILIGHT)
-        {
-            // Attach the depth texture of the i-th face
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                l->data.shadowMap.depth.id, 0);
-
-            // Calculate the view matrix
-            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, dirs[i]), ups[i]);
-        }
-        else
-        {
-            // Calculate the view matrix for directional and spotlight
-            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, l->data.direction), INIT_STRUCT(Vector3, 0, 1, 0));
+        glBindBuffer(GL_UNIFORM_BUFFER, b->lightsBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(struct RLG_LightBlock), &b->lights);
+        b->lightsDirty = false;
+        rlgCtx->stats.bufferUploads++;
+    }
 
-            // Calculate and send the view-projection matrix to the lighting shader for later rendering
-            Matrix viewProj = MatrixMultiply(matView, rlGetMatrixProjection());
-            SetShaderValueMatrix(rlgCtx->shaders[RLG_SHADER_MODEL], l->locs.vpMatrix, viewProj);
-        }
+    if (b->materialDirty)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, b->materialBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(struct RLG_MaterialBlock), &b->material);
+        b->materialDirty = false;
+        rlgCtx->stats.bufferUploads++;
+    }
 
-        // Apply the view matrix for rendering into the depth texture
-        rlLoadIdentity();
-        rlMultMatrixf(MatrixToFloat(matView));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-        // Clear the previous state of the depth texture
-        rlClearScreenBuffers();
+static bool RLG_GetSphereBoundsNDC(Vector3 center, float radius, Matrix matProjection, float zNear, float *bounds)
+{
+    bool ortho = (matProjection.m15 == 1.0f);
 
-        // Render objects in the light's context
-        drawFunc(shader);
+    float dMin = -center.z - radius;
+    float dMax = -center.z + radius;
 
-        // Flush the rendering batch
-        rlDrawRenderBatchActive();
-    }
+    bounds[0] = bounds[1] = -1.0f;
+    bounds[2] = bounds[3] = 1.0f;
 
-    // End rendering
-    rlEnableColorBlend();
-    rlDisableFramebuffer();
+    // The sphere covers the whole screen if it crosses the near plane of a perspective projection
+    if (!ortho && dMin <= zNear) return true;
 
-    // Reset the viewport and projection matrix to the screen settings
-    rlViewport(0, 0, GetScreenWidth(), GetScreenHeight());
-    rlMatrixMode(RL_PROJECTION);
-    rlPopMatrix();
-    rlMatrixMode(RL_MODELVIEW);
-    rlLoadIdentity();
-}
+    float nxMin = FLT_MAX, nxMax = -FLT_MAX;
+    float nyMin = FLT_MAX, nyMax = -FLT_MAX;
 
-Texture RLG_GetShadowMap(unsigned int light)
-{
-    if (light >= RLG_MAX_LIGHTS_PER_MATERIAL)
+    // Project the corners of the view space box of the sphere
+    for (int i = 0; i < 8; i++)
     {
-        // Log an error if the light ID exceeds the number of allocated lights
-        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowMap' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS_PER_MATERIAL);
-        return INIT_STRUCT_ZERO(Texture);
+        float x = center.x + ((i & 1) ? radius : -radius);
+        float y = center.y + ((i & 2) ? radius : -radius);
+        float d = (i & 4) ? dMax : dMin;
+
+        float nx = ortho ? matProjection.m0*x + matProjection.m12 : matProjection.m0*x/d - matProjection.m8;
+        float ny = ortho ? matProjection.m5*y + matProjection.m13 : matProjection.m5*y/d - matProjection.m9;
+
+        nxMin = fminf(nxMin, nx), nxMax = fmaxf(nxMax, nx);
+        nyMin = fminf(nyMin, ny), nyMax = fmaxf(nyMax, ny);
     }
 
-    return rlgCtx->lights[light].data.shadowMap.depth;
+    if (nxMax < -1.0f || nxMin > 1.0f || nyMax < -1.0f || nyMin > 1.0f) return false;
+
+    bounds[0] = fmaxf(nxMin, -1.0f), bounds[1] = fmaxf(nyMin, -1.0f);
+    bounds[2] = fminf(nxMax, 1.0f), bounds[3] = fminf(nyMax, 1.0f);
+
+    return true;
 }
 
-void RLG_CastMesh(Shader shader, Mesh mesh, Matrix transform)
+static void RLG_BuildFroxels(Matrix matProjection)
 {
-    // Bind shader program
-    rlEnableShader(shader.id);
-
-    // Get a copy of current matrices to work with,
-    // just in case stereo render is required, and we need to modify them
-    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
-    // That's because BeginMode3D() sets it and there is no model-drawing function
-    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
-    Matrix matModel = MatrixIdentity();
-    Matrix matView = rlGetMatrixModelview();
-    Matrix matModelView = MatrixIdentity();
-    Matrix matProjection = rlGetMatrixProjection();
+    struct RLG_ClusterHandler *c = &rlgCtx->clusters;
 
-    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
-    if (shader.locs[RLG_LOC_MATRIX_MODEL] != -1)
-        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MODEL], transform);
+    bool ortho = (matProjection.m15 == 1.0f);
 
-    // Accumulate several model transformations:
-    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
-    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
-    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+    float zNear, zFar;
+    RLG_GetProjectionPlanes(matProjection, &zNear, &zFar);
 
-    // Get model-view matrix
-    matModelView = MatrixMultiply(matModel, matView);
+    // Perspective projections use a logarithmic distribution of the slices
+    // so that the clusters keep roughly the same proportions along the depth
+    c->zNear = zNear;
+    c->zFar = zFar;
+    c->depthLog = !ortho;
+    c->depthScale = ortho ? RLG_CLUSTER_GRID_Z/(zFar - zNear) : RLG_CLUSTER_GRID_Z/logf(zFar/zNear);
+    c->depthBias = ortho ? -zNear*c->depthScale : -logf(zNear)*c->depthScale;
 
-    // Try binding vertex array objects (VAO) or use VBOs if not possible
-    if (!rlEnableVertexArray(mesh.vaoId))
+    for (int z = 0; z < RLG_CLUSTER_GRID_Z; z++)
     {
-        // Bind mesh VBO data: vertex position (shader-location = 0)
-        rlEnableVertexBuffer(mesh.vboId[0]);
-        rlSetVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION]);
+        float t0 = (float)z/RLG_CLUSTER_GRID_Z, t1 = (float)(z + 1)/RLG_CLUSTER_GRID_Z;
+        float d0 = ortho ? zNear + (zFar - zNear)*t0 : zNear*powf(zFar/zNear, t0);
+        float d1 = ortho ? zNear + (zFar - zNear)*t1 : zNear*powf(zFar/zNear, t1);
 
-        // If vertex indices exist, bine the VBO containing the indices
-        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
-    }
+        for (int y = 0; y < RLG_CLUSTER_GRID_Y; y++)
+        {
+            float ny0 = -1.0f + 2.0f*y/RLG_CLUSTER_GRID_Y, ny1 = -1.0f + 2.0f*(y + 1)/RLG_CLUSTER_GRID_Y;
 
-    int eyeCount = rlIsStereoRenderEnabled() ? 2 : 1;
+            for (int x = 0; x < RLG_CLUSTER_GRID_X; x++)
+            {
+                float nx0 = -1.0f + 2.0f*x/RLG_CLUSTER_GRID_X, nx1 = -1.0f + 2.0f*(x + 1)/RLG_CLUSTER_GRID_X;
 
-    for (int eye = 0; eye < eyeCount; eye++)
-    {
-        // Calculate model-view-projection matrix (MVP)
-        Matrix matModelViewProjection = MatrixIdentity();
-        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
-        else
-        {
-            // Setup current eye viewport (half screen width)
-            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
-            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
-        }
+                BoundingBox froxel = {
+                    INIT_STRUCT(Vector3, FLT_MAX, FLT_MAX, FLT_MAX),
+                    INIT_STRUCT(Vector3, -FLT_MAX, -FLT_MAX, -FLT_MAX)
+                };
 
-        // Send combined model-view-projection matrix to shader
-        rlSetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+                // Unproject the eight corners of the cluster in view space
+                for (int i = 0; i < 8; i++)
+                {
+                    float d = (i & 4) ? d1 : d0;
+                    float nx = (i & 1) ? nx1 : nx0;
+                    float ny = (i & 2) ? ny1 : ny0;
+
+                    Vector3 p = { 0.0f, 0.0f, -d };
+
+                    if (ortho)
+                    {
+                        p.x = (nx - matProjection.m12)/matProjection.m0;
+                        p.y = (ny - matProjection.m13)/matProjection.m5;
+                    }
+                    else
+                    {
+                        p.x = d*(nx + matProjection.m8)/matProjection.m0;
+                        p.y = d*(ny + matProjection.m9)/matProjection.m5;
+                    }
+
+                    froxel.min = Vector3Min(froxel.min, p);
+                    froxel.max = Vector3Max(froxel.max, p);
+                }
 
-        // Draw mesh
-        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
-        else rlDrawVertexArray(0, mesh.vertexCount);
+                c->froxels[x + RLG_CLUSTER_GRID_X*(y + RLG_CLUSTER_GRID_Y*z)] = froxel;
+            }
+        }
     }
 
-    // Disable all possible vertex array objects (or VBOs)
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
+    // The depth slice parameters are uploaded into the programs at their next use
+    RLG_MarkProgramsDirty(RLG_DIRTY_CLUSTERS);
+}
 
-    // Disable shader program
-    rlDisableShader();
+static int RLG_GetClusterSlice(float depth)
+{
+    const struct RLG_ClusterHandler *c = &rlgCtx->clusters;
 
-    // Restore rlgl internal modelview and projection matrices
-    rlSetMatrixModelview(matView);
-    rlSetMatrixProjection(matProjection);
+    float slice = (c->depthLog ? logf(fmaxf(depth, 1e-4f)) : depth)*c->depthScale + c->depthBias;
+    return (int)Clamp(slice, 0.0f, RLG_CLUSTER_GRID_Z - 1);
 }
 
-void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale)
+static int RLG_GetClusterTile(float ndc, int count)
 {
-    Vector3 vScale = { scale, scale, scale };
-    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
-
-    RLG_CastModelEx(shader, model, position, rotationAxis, 0.0f, vScale);
+    return (int)Clamp((ndc*0.5f + 0.5f)*count, 0.0f, count - 1);
 }
 
-void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale)
+static void RLG_UpdateClusters(Matrix matView, Matrix matProjection)
 {
-    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
-    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
-    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+    struct RLG_ClusterHandler *c = &rlgCtx->clusters;
 
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-    model.transform = MatrixMultiply(model.transform, matTransform);
+    bool rebuild = c->dirty || memcmp(&matProjection, &c->matProjection, sizeof(Matrix)) != 0;
+    bool rebin = rebuild || memcmp(&matView, &c->matView, sizeof(Matrix)) != 0;
 
-    for (int i = 0; i < model.meshCount; i++)
+    // Lights that are not and were not in the clusters do not require a new binning
+    for (int i = 0; i < RLG_MAX_LIGHTS && !rebin; i++)
     {
-        RLG_CastMesh(shader, model.meshes[i], model.transform);
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+        rebin = (l->version != c->versions[i]) && (c->binned[i] || RLG_IsClusterLight(l));
     }
-}
 
-void RLG_DrawMesh(Mesh mesh, Material material, Matrix transform)
-{
-    const Shader *shader = &rlgCtx->shaders[RLG_SHADER_MODEL];
+    if (!rebin) return;
 
-    // Bind shader program
-    rlEnableShader(shader->id);
+    if (rebuild) RLG_BuildFroxels(matProjection);
 
-    // Send required data to shader (matrices, values)
-    //-----------------------------------------------------
-    // Upload to shader material.data.colDiffuse
-    if (shader->locs[RLG_LOC_COLOR_DIFFUSE] != -1)
+    c->matView = matView;
+    c->matProjection = matProjection;
+    c->dirty = false;
+
+    int lightCount = 0;
+    int pairCount = 0;
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
     {
-        float values[4] = { };
+        const struct RLG_Light *l = &rlgCtx->lights[i];
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ALBEDO])
-        {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
-        }
-        else
-        {
-            values[0] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_ALBEDO].color.a/255.0f;
-        }
+        c->versions[i] = l->version;
+        c->binned[i] = false;
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
-    }
+        if (!RLG_IsClusterLight(l)) continue;
 
-    // Upload to shader material.data.colSpecular (if location available)
-    if (shader->locs[RLG_LOC_COLOR_SPECULAR] != -1)
-    {
-        float values[4] = { };
+        // Bounds of the sphere of influence of the light in view space
+        Vector3 center = Vector3Transform(l->data.position, matView);
+        float radius = l->data.distance;
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
-        {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].color.a/255.0f;
-        }
-        else
-        {
-            values[0] = (float)material.maps[MATERIAL_MAP_METALNESS].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_METALNESS].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_METALNESS].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_METALNESS].color.a/255.0f;
-        }
+        float dMin = -center.z - radius;
+        float dMax = -center.z + radius;
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_SPECULAR], values, SHADER_UNIFORM_VEC4, 1);
-    }
+        if (dMax < c->zNear || dMin > c->zFar) continue;
 
-    // Upload to shader material.data.colEmission (if location available)
-    if (shader->locs[RLG_LOC_COLOR_EMISSION] != -1)
-    {
-        float values[4] = { };
+        int z0 = RLG_GetClusterSlice(dMin);
+        int z1 = RLG_GetClusterSlice(dMax);
+
+        // Screen tiles covered by the projection of the sphere
+        float bounds[4];
+        if (!RLG_GetSphereBoundsNDC(center, radius, matProjection, c->zNear, bounds)) continue;
 
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_EMISSION])
+        int x0 = RLG_GetClusterTile(bounds[0], RLG_CLUSTER_GRID_X), x1 = RLG_GetClusterTile(bounds[2], RLG_CLUSTER_GRID_X);
+        int y0 = RLG_GetClusterTile(bounds[1], RLG_CLUSTER_GRID_Y), y1 = RLG_GetClusterTile(bounds[3], RLG_CLUSTER_GRID_Y);
+
+        // Write the light record
+        if (lightCount == c->lightsCapacity)
         {
-            values[0] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.r/255.0f;
-            values[1] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.g/255.0f;
-            values[2] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.b/255.0f;
-            values[3] = (float)rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color.a/255.0f;
+            c->lightsCapacity = (c->lightsCapacity > 0) ? 2*c->lightsCapacity : 64;
+            c->lights = (float*)realloc(c->lights, 16*c->lightsCapacity*sizeof(float));
         }
-        else
+
+        float *record = c->lights + 16*lightCount;
+        Vector3 color = Vector3Scale(l->data.color, l->data.energy);
+
+        record[0] = l->data.position.x, record[1] = l->data.position.y, record[2] = l->data.position.z;
+        record[3] = l->data.distance;
+        record[4] = l->data.direction.x, record[5] = l->data.direction.y, record[6] = l->data.direction.z;
+        record[7] = (float)l->data.type;
+        record[8] = color.x, record[9] = color.y, record[10] = color.z;
+        record[11] = l->data.specular;
+        record[12] = l->data.size;
+        record[13] = cosf(l->data.innerCutOff*DEG2RAD);
+        record[14] = cosf(l->data.outerCutOff*DEG2RAD);
+        record[15] = l->data.attenuation;
+
+        // Add the light to each cluster intersecting its sphere of influence
+        for (int z = z0; z <= z1; z++)
+        {
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    int cluster = x + RLG_CLUSTER_GRID_X*(y + RLG_CLUSTER_GRID_Y*z);
+                    const BoundingBox *froxel = &c->froxels[cluster];
+
+                    Vector3 closest = Vector3Min(Vector3Max(center, froxel->min), froxel->max);
+                    if (Vector3DistanceSqr(closest, center) > radius*radius) continue;
+
+                    if (pairCount == c->pairsCapacity)
+                    {
+                        c->pairsCapacity = (c->pairsCapacity > 0) ? 2*c->pairsCapacity : 1024;
+                        c->pairs = (unsigned int*)realloc(c->pairs, 2*c->pairsCapacity*sizeof(unsigned int));
+                    }
+
+                    c->pairs[2*pairCount] = cluster;
+                    c->pairs[2*pairCount + 1] = lightCount;
+                    pairCount++;
+                }
+            }
+        }
+
+        c->binned[i] = true;
+        lightCount++;
+    }
+
+    // Build the cluster items, the offset and count of each cluster followed by the light indices
+    int itemCount = 2*RLG_COUNT_CLUSTERS + pairCount;
+
+    if (itemCount > c->itemsCapacity)
+    {
+        c->itemsCapacity = (itemCount > 2*c->itemsCapacity) ? itemCount : 2*c->itemsCapacity;
+        c->items = (unsigned int*)realloc(c->items, c->itemsCapacity*sizeof(unsigned int));
+    }
+
+    memset(c->items, 0, 2*RLG_COUNT_CLUSTERS*sizeof(unsigned int));
+
+    for (int i = 0; i < pairCount; i++)
+    {
+        c->items[2*c->pairs[2*i] + 1]++;
+    }
+
+    for (int i = 0, offset = 2*RLG_COUNT_CLUSTERS; i < RLG_COUNT_CLUSTERS; i++)
+    {
+        c->items[2*i] = offset;
+        offset += c->items[2*i + 1];
+        c->items[2*i + 1] = 0;
+    }
+
+    // NOTE: The pairs are ordered by light, so are the lights of each cluster
+    for (int i = 0; i < pairCount; i++)
+    {
+        unsigned int cluster = c->pairs[2*i];
+        c->items[c->items[2*cluster] + c->items[2*cluster + 1]++] = c->pairs[2*i + 1];
+    }
+
+    RLG_UploadBuffer(GL_TEXTURE_BUFFER, c->lightsBuffer, c->lights, 16*lightCount*sizeof(float), &c->lightsBufferSize);
+    RLG_UploadBuffer(GL_TEXTURE_BUFFER, c->itemsBuffer, c->items, itemCount*sizeof(unsigned int), &c->itemsBufferSize);
+}
+
+static bool RLG_LoadDeferredShaders(void)
+{
+#ifndef NO_EMBEDDED_SHADERS
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    if (rlgCtx->shaders[RLG_SHADER_GBUFFER].id != 0) return true;
+
+    // The G-buffer shader is the model shader compiled with the DEFERRED define
+    const char *vsCodes[3] = { GLSL_VERSION_DEF, GLSL_DEFERRED_DEF, G_VS_CACHE_Model };
+    const char *fsCodes[3] = { GLSL_VERSION_DEF, GLSL_DEFERRED_DEF, G_FS_CACHE_Model };
+
+    if (G_VS_CACHE_Model == NULL || G_FS_CACHE_Model == NULL ||
+        G_VS_CACHE_DeferredAmbient == NULL || G_FS_CACHE_DeferredAmbient == NULL ||
+        G_VS_CACHE_DeferredLighting == NULL || G_FS_CACHE_DeferredLighting == NULL)
+    {
+        TraceLog(LOG_WARNING, "The deferred shading shaders have not been defined.");
+        return false;
+    }
+
+    Shader gbuffer = RLG_LoadModelShader(vsCodes, fsCodes, 3, 3);
+    Shader ambient = RLG_LoadShader(G_VS_CACHE_DeferredAmbient, G_FS_CACHE_DeferredAmbient);
+    Shader lighting = RLG_LoadShader(G_VS_CACHE_DeferredLighting, G_FS_CACHE_DeferredLighting);
+
+    if (!IsShaderReady(gbuffer) || !IsShaderReady(ambient) || !IsShaderReady(lighting))
+    {
+        if (IsShaderReady(gbuffer)) UnloadShader(gbuffer);
+        if (IsShaderReady(ambient)) UnloadShader(ambient);
+        if (IsShaderReady(lighting)) UnloadShader(lighting);
+
+        TraceLog(LOG_ERROR, "Failed to load the deferred shading shaders.");
+        return false;
+    }
+
+    rlgCtx->shaders[RLG_SHADER_GBUFFER] = gbuffer;
+    rlgCtx->shaders[RLG_SHADER_DEFERRED_AMBIENT] = ambient;
+    rlgCtx->shaders[RLG_SHADER_DEFERRED_LIGHTING] = lighting;
+
+    // NOTE: The material parameters and lights are shared with the model shader through
+    //       the uniform blocks, the ambient color and view position are copied when drawing
+    d->colAmbient = INIT_STRUCT(Vector3, -1.0f, -1.0f, -1.0f);
+    d->viewPos = INIT_STRUCT(Vector3, FLT_MAX, FLT_MAX, FLT_MAX);
+    d->ambientSHDirty = true;
+
+    // Set the texture units of the G-buffer samplers
+    // NOTE: Ambient pass: emission 0, depth 1; Lighting pass: albedo 0, normal 1, ORM 2, depth 3, shadow atlas 4
+    int units[5] = { 0, 1, 2, 3, 4 };
+
+    rlEnableShader(ambient.id);
+    rlSetUniform(rlGetLocationUniform(ambient.id, "gEmission"), &units[0], SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlGetLocationUniform(ambient.id, "gDepth"), &units[1], SHADER_UNIFORM_INT, 1);
+
+    rlEnableShader(lighting.id);
+    rlSetUniform(rlGetLocationUniform(lighting.id, "gAlbedo"), &units[0], SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlGetLocationUniform(lighting.id, "gNormal"), &units[1], SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlGetLocationUniform(lighting.id, "gORM"), &units[2], SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlGetLocationUniform(lighting.id, "gDepth"), &units[3], SHADER_UNIFORM_INT, 1);
+    rlSetUniform(rlGetLocationUniform(lighting.id, "shadowAtlas"), &units[4], SHADER_UNIFORM_INT, 1);
+    rlDisableShader();
+
+    RLG_GetLightSlotLocations(&d->light, lighting.id, "light", "matLight");
+
+    d->light.locs.matCascades = rlGetLocationUniform(lighting.id, "matCascades");
+    d->light.locs.cascadeSplits = rlGetLocationUniform(lighting.id, "cascadeSplits");
+
+    d->locInvViewProj = rlGetLocationUniform(lighting.id, "matInvViewProj");
+    d->locView = rlGetLocationUniform(lighting.id, RLG_SHADER_UNIFORM_MATRIX_VIEW);
+    d->locViewPos = rlGetLocationUniform(lighting.id, RLG_SHADER_UNIFORM_VIEW_POSITION);
+    d->locFarPlane = rlGetLocationUniform(lighting.id, "farPlane");
+    d->locLinearOmniShadows = rlGetLocationUniform(lighting.id, "linearOmniShadows");
+
+    // Empty vertex array, the fullscreen triangle is generated from gl_VertexID
+    d->vao = rlLoadVertexArray();
+
+    return true;
+#else
+    // NOTE: The G-buffer shader is the embedded model shader compiled with the DEFERRED define,
+    //       the model code given without the embedded shaders starts with its own '#version'
+    TraceLog(LOG_WARNING, "Deferred shading requires the embedded shaders");
+    return false;
+#endif
+}
+
+static void RLG_UnloadGBuffer(void)
+{
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    if (d->framebuffer == 0) return;
+
+    rlUnloadTexture(d->albedo);
+    rlUnloadTexture(d->normal);
+    rlUnloadTexture(d->orm);
+    rlUnloadTexture(d->emission);
+    rlUnloadTexture(d->depth);
+    rlUnloadFramebuffer(d->framebuffer);
+
+    d->framebuffer = 0;
+    d->width = d->height = 0;
+}
+
+static bool RLG_LoadGBuffer(int width, int height)
+{
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    RLG_UnloadGBuffer();
+
+    d->framebuffer = rlLoadFramebuffer(width, height);
+    if (d->framebuffer == 0) return false;
+
+    d->albedo = rlLoadTexture(NULL, width, height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    d->normal = rlLoadTexture(NULL, width, height, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16, 1);
+    d->orm = rlLoadTexture(NULL, width, height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    d->emission = rlLoadTexture(NULL, width, height, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16, 1);
+    d->depth = rlLoadTextureDepth(width, height, false);
+
+    rlFramebufferAttach(d->framebuffer, d->albedo, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebuffer, d->normal, RL_ATTACHMENT_COLOR_CHANNEL1, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebuffer, d->orm, RL_ATTACHMENT_COLOR_CHANNEL2, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebuffer, d->emission, RL_ATTACHMENT_COLOR_CHANNEL3, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(d->framebuffer, d->depth, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    // NOTE: rlFramebufferAttach() unbinds the framebuffer, the draw buffers are part of its state
+    rlEnableFramebuffer(d->framebuffer);
+    rlActiveDrawBuffers(4);
+    rlDisableFramebuffer();
+
+    d->width = width, d->height = height;
+
+    if (!rlFramebufferComplete(d->framebuffer))
+    {
+        TraceLog(LOG_ERROR, "Framebuffer is not complete for the G-buffer");
+        RLG_UnloadGBuffer();
+        return false;
+    }
+
+    return true;
+}
+
+static void RLG_UploadGBufferState(const Shader *shader)
+{
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    // NOTE: The dirty flags of the context concern the model shader, the
+    //       values that changed since the last draw are compared here
+    if (memcmp(&d->colAmbient, &rlgCtx->colAmbient, sizeof(Vector3)) != 0)
+    {
+        d->colAmbient = rlgCtx->colAmbient;
+        RLG_SetUniform(shader->locs[RLG_LOC_COLOR_AMBIENT], &d->colAmbient, SHADER_UNIFORM_VEC3, 1);
+    }
+
+    if (memcmp(&d->viewPos, &rlgCtx->viewPos, sizeof(Vector3)) != 0)
+    {
+        d->viewPos = rlgCtx->viewPos;
+        RLG_SetUniform(shader->locs[RLG_LOC_VECTOR_VIEW], &d->viewPos, SHADER_UNIFORM_VEC3, 1);
+    }
+
+    if (d->ambientSHDirty)
+    {
+        int useAmbientSH = rlgCtx->useAmbientSH;
+        RLG_SetUniform(shader->locs[RLG_LOC_AMBIENT_SH], rlgCtx->ambientSH, SHADER_UNIFORM_VEC3, RLG_SH_COEFFICIENTS);
+        RLG_SetUniform(shader->locs[RLG_LOC_USE_AMBIENT_SH], &useAmbientSH, SHADER_UNIFORM_INT, 1);
+        d->ambientSHDirty = false;
+    }
+}
+
+#endif //GLSL_VERSION
+
+static bool RLG_IsParallelCompileSupported(void)
+{
+#if GLSL_VERSION >= 330
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (int i = 0; i < count; i++)
+    {
+        const char *extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+
+        if (extension != NULL && (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 ||
+            strcmp(extension, "GL_ARB_parallel_shader_compile") == 0))
+        {
+            return true;
+        }
+    }
+
+    return false;
+#else
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+    return (extensions != NULL && strstr(extensions, "GL_KHR_parallel_shader_compile") != NULL);
+#endif
+}
+
+static void RLG_SubmitContextShader(struct RLG_Core *ctx, RLG_Shader shader, const char *vsCode, const char *fsCode)
+{
+    // Without code, raylib provides its default shader
+    if (vsCode == NULL || fsCode == NULL)
+    {
+        ctx->shaders[shader] = LoadShaderFromMemory(vsCode, fsCode);
+        return;
+    }
+
+    RLG_SubmitProgram(&ctx->pending[shader], &vsCode, &fsCode, NULL, 1, 1);
+}
+
+static void RLG_FinishContextShader(struct RLG_Core *ctx, RLG_Shader shader)
+{
+    unsigned int id = RLG_FinishProgram(&ctx->pending[shader]);
+
+    switch (shader)
+    {
+        case RLG_SHADER_MODEL:
+            RLG_InitModelProgram(&ctx->programs[0], id, 0);
+            ctx->shaders[RLG_SHADER_MODEL] = ctx->programs[0].shader;
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthCubemapLightPos = rlGetLocationUniform(id, "lightPos");
+            ctx->locDepthCubemapFar = rlGetLocationUniform(id, "farPlane");
+
+            // Send Near/Far to shaders who need it
+            if (id > 0) SetShaderValue(ctx->shaders[shader], ctx->locDepthCubemapFar, &ctx->zFar, SHADER_UNIFORM_FLOAT);
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP_INSTANCED:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthCubemapInstancedLightPos = rlGetLocationUniform(id, "lightPos");
+            ctx->locDepthCubemapInstancedFar = rlGetLocationUniform(id, "farPlane");
+
+            if (id > 0) SetShaderValue(ctx->shaders[shader], ctx->locDepthCubemapInstancedFar, &ctx->zFar, SHADER_UNIFORM_FLOAT);
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP_LAYERED:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthCubemapLayeredLightPos = rlGetLocationUniform(id, "lightPos");
+            ctx->locDepthCubemapLayeredFar = rlGetLocationUniform(id, "farPlane");
+            ctx->locDepthCubemapLayeredFaces = rlGetLocationUniform(id, "matFaces");
+
+            if (id > 0) SetShaderValue(ctx->shaders[shader], ctx->locDepthCubemapLayeredFar, &ctx->zFar, SHADER_UNIFORM_FLOAT);
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP_LAYERED_INSTANCED:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthCubemapLayeredInstancedLightPos = rlGetLocationUniform(id, "lightPos");
+            ctx->locDepthCubemapLayeredInstancedFar = rlGetLocationUniform(id, "farPlane");
+            ctx->locDepthCubemapLayeredInstancedFaces = rlGetLocationUniform(id, "matFaces");
+
+            if (id > 0) SetShaderValue(ctx->shaders[shader], ctx->locDepthCubemapLayeredInstancedFar, &ctx->zFar, SHADER_UNIFORM_FLOAT);
+            break;
+
+        case RLG_SHADER_DEPTH_LAYERED:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthLayeredFaces = rlGetLocationUniform(id, "matFaces");
+            break;
+
+        case RLG_SHADER_DEPTH_LAYERED_INSTANCED:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->locDepthLayeredInstancedFaces = rlGetLocationUniform(id, "matFaces");
+            break;
+
+        case RLG_SHADER_SKYBOX:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->skybox.locDoGamma = rlGetLocationUniform(id, "doGamma");
+            break;
+
+        case RLG_SHADER_SKYBOX_FULLSCREEN:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->skybox.locDoGammaFullscreen = rlGetLocationUniform(id, "doGamma");
+            ctx->skybox.locInvViewProj = rlGetLocationUniform(id, "matInvViewProj");
+            break;
+
+        case RLG_SHADER_PREFILTER_CONVOLUTION:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            ctx->skybox.locPrefilterRoughness = rlGetLocationUniform(id, "roughness");
+            ctx->skybox.locPrefilterResolution = rlGetLocationUniform(id, "resolution");
+            break;
+
+        default:
+            ctx->shaders[shader] = RLG_InitShader(id);
+            break;
+    }
+}
+
+static bool RLG_UpdateContextShaders(struct RLG_Core *ctx, bool wait)
+{
+    bool ready = true;
+    int finished = 0;
+
+    for (int i = 0; i < RLG_COUNT_SHADERS; i++)
+    {
+        if (!ctx->pending[i].pending) continue;
+
+        // Without KHR_parallel_shader_compile the completion cannot be polled,
+        // a single program is then finished per call when we do not wait
+        bool completed = wait || (ctx->parallelCompile
+            ? RLG_IsProgramCompleted(&ctx->pending[i]) : (finished == 0));
+
+        if (!completed)
+        {
+            ready = false;
+            continue;
+        }
+
+        RLG_FinishContextShader(ctx, (RLG_Shader)i);
+        finished++;
+    }
+
+    ctx->ready = ready;
+
+    return ready;
+}
+
+/* Public API */
+
+RLG_Context RLG_CreateContext(void)
+{
+    struct RLG_Core *ctx = (struct RLG_Core*)RLG_CreateContextAsync();
+
+    // Wait for all the programs and retrieve their locations
+    if (ctx != NULL) RLG_UpdateContextShaders(ctx, true);
+
+    return (RLG_Context)ctx;
+}
+
+RLG_Context RLG_CreateContextAsync(void)
+{
+    // On-heap allocation for the context's core structure, initializing it with zeros
+    struct RLG_Core *rlgCtx = (struct RLG_Core*)calloc(1, sizeof(struct RLG_Core));
+
+    if (!rlgCtx)
+    {
+        TraceLog(LOG_FATAL, "Heap allocation for RLG context failed!");
+        return NULL;
+    }
+
+    // We check if all the shader codes are well defined
+    if (G_VS_CACHE_Model == NULL) TraceLog(LOG_WARNING, "The lighting vertex shader has not been defined.");
+    if (G_FS_CACHE_Model == NULL) TraceLog(LOG_WARNING, "The lighting fragment shader has not been defined.");
+    if (G_VS_CACHE_Depth == NULL) TraceLog(LOG_WARNING, "The depth vertex shader has not been defined.");
+    if (G_FS_CACHE_Depth == NULL) TraceLog(LOG_WARNING, "The depth fragment shader has not been defined.");
+
+    // Get Near/Far render values
+    rlgCtx->zNear = 0.01f;  // TODO: replace with rlGetCullDistanceNear()
+    rlgCtx->zFar = 1000.0f; // TODO: replace with rlGetCullDistanceFar()
+
+    // Submit all the programs before checking any of them, so that the driver can compile them
+    // in parallel, their locations are retrieved once linked (see RLG_FinishContextShader)
+    rlgCtx->parallelCompile = RLG_IsParallelCompileSupported();
+
+    // Default model program (features tested at runtime), the permutations are loaded when needed
+    RLG_SubmitModelProgram(&rlgCtx->pending[RLG_SHADER_MODEL], 0, false);
+    rlgCtx->programCount = 1;
+    rlgCtx->usePermutations = true;
+    rlgCtx->useCulling = true;
+    rlgCtx->shadowFrame = 1;
+
+    // The omnilights store the distance to the light by default, so that a custom RLG_SHADER_DEPTH_CUBEMAP is used
+    rlgCtx->linearOmniShadows = true;
+
+    // Depth shaders (used for shadow casting of directional/spot lights and omnilights)
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_DEPTH, G_VS_CACHE_Depth, G_FS_CACHE_Depth);
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_DEPTH_CUBEMAP, G_VS_CACHE_DepthCubemap, G_FS_CACHE_DepthCubemap);
+
+#if GLSL_VERSION >= 330
+    // Depth shaders reading the instance matrices (used by RLG_CastMeshInstanced)
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_DEPTH_INSTANCED, G_VS_CACHE_DepthInstanced, G_FS_CACHE_DepthInstanced);
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_DEPTH_CUBEMAP_INSTANCED,
+        G_VS_CACHE_DepthCubemapInstanced, G_FS_CACHE_DepthCubemapInstanced);
+
+    // Depth shaders rendering the six faces of the omnilights in a single pass, with a geometry shader
+    // NOTE: They reuse the code of the cubemap depth shaders, the omnilights fall back to six passes without them
+    if (G_GS_CACHE_DepthCubemapLayered != NULL && G_VS_CACHE_DepthCubemap != NULL && G_FS_CACHE_DepthCubemap != NULL)
+    {
+        RLG_SubmitProgram(&rlgCtx->pending[RLG_SHADER_DEPTH_CUBEMAP_LAYERED],
+            &G_VS_CACHE_DepthCubemap, &G_FS_CACHE_DepthCubemap, G_GS_CACHE_DepthCubemapLayered, 1, 1);
+    }
+
+    if (G_GS_CACHE_DepthCubemapLayered != NULL && G_VS_CACHE_DepthCubemapInstanced != NULL && G_FS_CACHE_DepthCubemapInstanced != NULL)
+    {
+        RLG_SubmitProgram(&rlgCtx->pending[RLG_SHADER_DEPTH_CUBEMAP_LAYERED_INSTANCED],
+            &G_VS_CACHE_DepthCubemapInstanced, &G_FS_CACHE_DepthCubemapInstanced, G_GS_CACHE_DepthCubemapLayered, 1, 1);
+    }
+
+    // Same, with the fragment shader of the shadow maps, the depth written by the rasterizer is kept
+    if (G_GS_CACHE_DepthCubemapLayered != NULL && G_VS_CACHE_DepthCubemap != NULL && G_FS_CACHE_Depth != NULL)
+    {
+        RLG_SubmitProgram(&rlgCtx->pending[RLG_SHADER_DEPTH_LAYERED],
+            &G_VS_CACHE_DepthCubemap, &G_FS_CACHE_Depth, G_GS_CACHE_DepthCubemapLayered, 1, 1);
+    }
+
+    if (G_GS_CACHE_DepthCubemapLayered != NULL && G_VS_CACHE_DepthCubemapInstanced != NULL && G_FS_CACHE_DepthInstanced != NULL)
+    {
+        RLG_SubmitProgram(&rlgCtx->pending[RLG_SHADER_DEPTH_LAYERED_INSTANCED],
+            &G_VS_CACHE_DepthCubemapInstanced, &G_FS_CACHE_DepthInstanced, G_GS_CACHE_DepthCubemapLayered, 1, 1);
+    }
+#endif
+
+    // Skybox shaders (cubemap generation, irradiance map generation and drawing)
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP,
+        G_VS_CACHE_EquirectangularToCubemap, G_FS_CACHE_EquirectangularToCubemap);
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_IRRADIANCE_CONVOLUTION,
+        G_VS_CACHE_IrradianceConvolution, G_FS_CACHE_IrradianceConvolution);
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_SKYBOX, G_VS_CACHE_Skybox, G_FS_CACHE_Skybox);
+    RLG_SubmitContextShader(rlgCtx, RLG_SHADER_SKYBOX_FULLSCREEN, G_VS_CACHE_SkyboxFullscreen, G_FS_CACHE_SkyboxFullscreen);
+
+#if GLSL_VERSION >= 330
+    // Split-sum shaders (prefiltered specular mips and BRDF lookup texture)
+    // NOTE: Not replaced by the default shader without code, the skyboxes are then loaded without them
+    if (G_VS_CACHE_PrefilterConvolution != NULL && G_FS_CACHE_PrefilterConvolution != NULL)
+    {
+        RLG_SubmitContextShader(rlgCtx, RLG_SHADER_PREFILTER_CONVOLUTION,
+            G_VS_CACHE_PrefilterConvolution, G_FS_CACHE_PrefilterConvolution);
+    }
+
+    if (G_VS_CACHE_BRDFIntegration != NULL && G_FS_CACHE_BRDFIntegration != NULL)
+    {
+        RLG_SubmitContextShader(rlgCtx, RLG_SHADER_BRDF_INTEGRATION,
+            G_VS_CACHE_BRDFIntegration, G_FS_CACHE_BRDFIntegration);
+    }
+#endif
+
+    // Init default view position and ambient color
+    rlgCtx->colAmbient = INIT_STRUCT(Vector3, 0.1f, 0.1f, 0.1f);
+    rlgCtx->viewPos = INIT_STRUCT_ZERO(Vector3);
+
+    // Default activation of diffuse texture sampling
+    rlgCtx->material.data.useMaps[MATERIAL_MAP_ALBEDO] = true;
+
+    // Allocation and initialization of the desired number of lights
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        struct RLG_Light *light = &rlgCtx->lights[i];
+
+        light->data.shadowMap      = INIT_STRUCT_ZERO(struct RLG_ShadowMap);
+        light->data.vpMatrix       = MatrixIdentity();
+        light->data.cascadeDistance = 100.0f;
+        light->data.cascadeCount   = 1;
+        light->data.cascades       = 1;
+        light->data.shadowRect     = INIT_STRUCT_ZERO(Vector4);
+        light->data.position       = INIT_STRUCT_ZERO(Vector3);
+        light->data.direction      = INIT_STRUCT_ZERO(Vector3);
+        light->data.color          = INIT_STRUCT(Vector3, 1.0f, 1.0f, 1.0f);
+        light->data.energy         = 1.0f;
+        light->data.specular       = 1.0f;
+        light->data.size           = 0.0f;
+        light->data.innerCutOff    = 180;
+        light->data.outerCutOff    = 180;
+        light->data.distance       = 8.0f;
+        light->data.attenuation    = 1.0f;
+        light->data.shadowMapTxlSz = 0.0f;
+        light->data.depthBias      = 0.0f;
+        light->data.type           = RLG_DIRLIGHT;
+        light->data.shadow         = 0;
+        light->data.enabled        = 0;
+
+        light->version = 1;
+    }
+
+    // No light is assigned to the slots yet
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
+    {
+        rlgCtx->slots[i].light = -1;
+    }
+
+#if GLSL_VERSION >= 330
+    // Create the uniform buffers of the lights and material parameters
+    // NOTE: Their content is uploaded before the first draw
+    glGenBuffers(1, &rlgCtx->blocks.lightsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, rlgCtx->blocks.lightsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(struct RLG_LightBlock), NULL, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &rlgCtx->blocks.materialBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, rlgCtx->blocks.materialBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(struct RLG_MaterialBlock), NULL, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    rlgCtx->blocks.lightsDirty = true;
+    rlgCtx->blocks.materialDirty = true;
+#endif
+
+    // Init default material maps
+    Texture defaultTexture  = INIT_STRUCT_ZERO(Texture);
+    defaultTexture.id       = rlGetTextureIdDefault();
+    defaultTexture.width    = 1;
+    defaultTexture.height   = 1;
+    defaultTexture.mipmaps  = 1;
+    defaultTexture.format   = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_ALBEDO].color = WHITE;
+    rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].value = 0.5f;
+    rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].value = 0.5f;
+    rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].value = 0.0f;
+    rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_EMISSION].color = BLACK;
+    rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].texture = defaultTexture;
+    rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].value = 0.05f;
+
+    // Load skybox vertex array
+    // Define the positions of the vertices for a cube
+    static const float skyboxPositions[] =
+    {
+        // Front face
+        -0.5f, -0.5f,  0.5f,    // Vertex 0
+         0.5f, -0.5f,  0.5f,    // Vertex 1
+         0.5f,  0.5f,  0.5f,    // Vertex 2
+        -0.5f,  0.5f,  0.5f,    // Vertex 3
+
+        // Back face
+        -0.5f, -0.5f, -0.5f,    // Vertex 4
+         0.5f, -0.5f, -0.5f,    // Vertex 5
+         0.5f,  0.5f, -0.5f,    // Vertex 6
+        -0.5f,  0.5f, -0.5f,    // Vertex 7
+
+        // Fullscreen triangle (see RLG_UseSkyboxDepthTest), not indexed
+        -1.0f, -1.0f,  1.0f,    // Vertex 8
+         3.0f, -1.0f,  1.0f,    // Vertex 9
+        -1.0f,  3.0f,  1.0f     // Vertex 10
+    };
+
+    // Define the indices for drawing the cube faces
+    const unsigned short skyboxIndices[] =
+    {
+        // Front face
+        0, 1, 2,
+        2, 3, 0,
+
+        // Right face
+        1, 5, 6,
+        6, 2, 1,
+
+        // Back face
+        5, 4, 7,
+        7, 6, 5,
+
+        // Left face
+        4, 0, 3,
+        3, 7, 4,
+
+        // Top face
+        3, 2, 6,
+        6, 7, 3,
+
+        // Bottom face
+        4, 5, 1,
+        1, 0, 4
+    };
+
+    // Load vertex array object (VAO) and bind it
+    rlgCtx->skybox.vao = rlLoadVertexArray();
+    rlEnableVertexArray(rlgCtx->skybox.vao);
+    {
+        // Load vertex buffer object (VBO) for positions and bind it
+        rlgCtx->skybox.vbo = rlLoadVertexBuffer(skyboxPositions, sizeof(skyboxPositions), false);
+        rlSetVertexAttribute(0, 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(0);
+
+        // Load element buffer object (EBO) for indices and bind it
+        rlgCtx->skybox.ebo = rlLoadVertexBufferElement(skyboxIndices, sizeof(skyboxIndices), false);
+    }
+    rlDisableVertexArray();
+
+    return (RLG_Context)rlgCtx;
+}
+
+void RLG_DestroyContext(RLG_Context ctx)
+{
+    struct RLG_Core *pCtx = (struct RLG_Core*)ctx;
+
+    // The programs still compiling are finished to be unloaded like the others
+    if (!pCtx->ready) RLG_UpdateContextShaders(pCtx, true);
+
+    rlUnloadVertexBuffer(rlgCtx->skybox.ebo);
+    rlUnloadVertexBuffer(rlgCtx->skybox.vbo);
+    rlUnloadVertexArray(rlgCtx->skybox.vao);
+
+    if (pCtx->skybox.brdfLUT.id != 0)
+    {
+        rlUnloadTexture(pCtx->skybox.brdfLUT.id);
+    }
+
+    if (pCtx->skyboxUpdate.fbo[0] != 0)
+    {
+        RLG_UnloadSkybox(pCtx->skyboxUpdate.back);
+        rlUnloadFramebuffer(pCtx->skyboxUpdate.fbo[0]);
+        rlUnloadFramebuffer(pCtx->skyboxUpdate.fbo[1]);
+    }
+
+    free(pCtx->skyboxUpdate.sh);
+    free(pCtx->skyboxUpdate.pixels);
+
+    for (int i = 0; i < RLG_COUNT_SHADERS; i++)
+    {
+        if (IsShaderReady(pCtx->shaders[i]))
+        {
+            UnloadShader(pCtx->shaders[i]);
+            pCtx->shaders[i] = INIT_STRUCT_ZERO(Shader);
+        }
+    }
+
+    // NOTE: The first program is the model shader unloaded above
+    for (int i = 1; i < pCtx->programCount; i++)
+    {
+        if (IsShaderReady(pCtx->programs[i].shader))
+        {
+            UnloadShader(pCtx->programs[i].shader);
+        }
+    }
+
+    pCtx->programCount = 0;
+
+    if (pCtx->shadowAtlas.id != 0)
+    {
+        rlUnloadTexture(pCtx->shadowAtlas.depth.id);
+        rlUnloadFramebuffer(pCtx->shadowAtlas.id);
+    }
+
+    if (pCtx->shadowCache.id != 0)
+    {
+        rlUnloadTexture(pCtx->shadowCache.depth.id);
+        rlUnloadFramebuffer(pCtx->shadowCache.id);
+    }
+
+    if (pCtx->clusters.lightsBuffer != 0)
+    {
+        rlUnloadTexture(pCtx->clusters.lightsTexture);
+        rlUnloadTexture(pCtx->clusters.itemsTexture);
+        rlUnloadVertexBuffer(pCtx->clusters.lightsBuffer);
+        rlUnloadVertexBuffer(pCtx->clusters.itemsBuffer);
+    }
+
+    free(pCtx->clusters.lights);
+    free(pCtx->clusters.items);
+    free(pCtx->clusters.pairs);
+    free(pCtx->clusters.froxels);
+
+    if (pCtx->blocks.lightsBuffer != 0)
+    {
+        rlUnloadVertexBuffer(pCtx->blocks.lightsBuffer);
+        rlUnloadVertexBuffer(pCtx->blocks.materialBuffer);
+    }
+
+    if (pCtx->instanceBuffer != 0)
+    {
+        rlUnloadVertexBuffer(pCtx->instanceBuffer);
+    }
+
+    free(pCtx->queue.entries);
+    free(pCtx->queue.keys);
+    free(pCtx->queue.scratch);
+    free(pCtx->bounds.entries);
+
+    if (pCtx->deferred.framebuffer != 0)
+    {
+        rlUnloadTexture(pCtx->deferred.albedo);
+        rlUnloadTexture(pCtx->deferred.normal);
+        rlUnloadTexture(pCtx->deferred.orm);
+        rlUnloadTexture(pCtx->deferred.emission);
+        rlUnloadTexture(pCtx->deferred.depth);
+        rlUnloadFramebuffer(pCtx->deferred.framebuffer);
+    }
+
+    if (pCtx->deferred.vao != 0)
+    {
+        rlUnloadVertexArray(pCtx->deferred.vao);
+    }
+}
+
+void RLG_SetContext(RLG_Context ctx)
+{
+    // NOTE: The contexts share the texture units and uniform block bindings, the state of a batch is restored first
+    if (rlgCtx != NULL && rlgCtx != (struct RLG_Core*)ctx && rlgCtx->state.batch) RLG_RestoreState();
+
+    rlgCtx = (struct RLG_Core*)ctx;
+}
+
+RLG_Context RLG_GetContext(void)
+{
+    return (RLG_Context)rlgCtx;
+}
+
+bool RLG_IsContextReady(void)
+{
+    return rlgCtx->ready || RLG_UpdateContextShaders(rlgCtx, false);
+}
+
+void RLG_SetCustomShaderCode(RLG_Shader shader, const char *vsCode, const char *fsCode)
+{
+    switch (shader)
+    {
+        case RLG_SHADER_MODEL:
+            G_VS_CACHE_Model = vsCode;
+            G_FS_CACHE_Model = fsCode;
+            break;
+
+        case RLG_SHADER_DEPTH:
+            G_VS_CACHE_Depth = vsCode;
+            G_FS_CACHE_Depth = fsCode;
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP:
+            G_VS_CACHE_DepthCubemap = vsCode;
+            G_FS_CACHE_DepthCubemap = fsCode;
+            break;
+
+        case RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP:
+            G_VS_CACHE_EquirectangularToCubemap = vsCode;
+            G_FS_CACHE_EquirectangularToCubemap = fsCode;
+            break;
+
+        case RLG_SHADER_IRRADIANCE_CONVOLUTION:
+            G_VS_CACHE_IrradianceConvolution = vsCode;
+            G_FS_CACHE_IrradianceConvolution = fsCode;
+            break;
+
+        case RLG_SHADER_SKYBOX:
+            G_VS_CACHE_Skybox = vsCode;
+            G_FS_CACHE_Skybox = fsCode;
+            break;
+
+        case RLG_SHADER_DEFERRED_AMBIENT:
+            G_VS_CACHE_DeferredAmbient = vsCode;
+            G_FS_CACHE_DeferredAmbient = fsCode;
+            break;
+
+        case RLG_SHADER_DEFERRED_LIGHTING:
+            G_VS_CACHE_DeferredLighting = vsCode;
+            G_FS_CACHE_DeferredLighting = fsCode;
+            break;
+
+        case RLG_SHADER_DEPTH_INSTANCED:
+            G_VS_CACHE_DepthInstanced = vsCode;
+            G_FS_CACHE_DepthInstanced = fsCode;
+            break;
+
+        case RLG_SHADER_DEPTH_CUBEMAP_INSTANCED:
+            G_VS_CACHE_DepthCubemapInstanced = vsCode;
+            G_FS_CACHE_DepthCubemapInstanced = fsCode;
+            break;
+
+        case RLG_SHADER_PREFILTER_CONVOLUTION:
+            G_VS_CACHE_PrefilterConvolution = vsCode;
+            G_FS_CACHE_PrefilterConvolution = fsCode;
+            break;
+
+        case RLG_SHADER_BRDF_INTEGRATION:
+            G_VS_CACHE_BRDFIntegration = vsCode;
+            G_FS_CACHE_BRDFIntegration = fsCode;
+            break;
+
+        case RLG_SHADER_SKYBOX_FULLSCREEN:
+            G_VS_CACHE_SkyboxFullscreen = vsCode;
+            G_FS_CACHE_SkyboxFullscreen = fsCode;
+            break;
+
+        default:
+            TraceLog(LOG_WARNING, "Unsupported 'shader' passed to 'RLG_SetCustomShader'");
+            break;
+    }
+}
+
+const Shader* RLG_GetShader(RLG_Shader shader)
+{
+    if (shader < 0 || shader >= RLG_COUNT_SHADERS)
+    {
+        return NULL;
+    }
+
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    return &rlgCtx->shaders[shader];
+}
+
+void RLG_SetShaderCacheDirectory(const char *directory)
+{
+    if (directory == NULL)
+    {
+        G_ShaderCacheDirectory[0] = '\0';
+        return;
+    }
+
+    if (strlen(directory) >= sizeof(G_ShaderCacheDirectory))
+    {
+        TraceLog(LOG_WARNING, "Shader cache directory path specified to 'RLG_SetShaderCacheDirectory' is too long [MAX %i]",
+            (int)sizeof(G_ShaderCacheDirectory) - 1);
+        return;
+    }
+
+    strcpy(G_ShaderCacheDirectory, directory);
+}
+
+RLG_Stats RLG_GetStats(void)
+{
+    return rlgCtx->stats;
+}
+
+void RLG_ResetStats(void)
+{
+    rlgCtx->stats = INIT_STRUCT_ZERO(RLG_Stats);
+}
+
+void RLG_BeginBatch(void)
+{
+    if (rlgCtx->state.batch) return;
+
+    // The draws of the batch must not be interleaved with those of raylib
+    rlDrawRenderBatchActive();
+
+    rlgCtx->state.batch = true;
+}
+
+void RLG_EndBatch(void)
+{
+    if (!rlgCtx->state.batch) return;
+
+    RLG_RestoreState();
+
+    rlgCtx->state.batch = false;
+}
+
+bool RLG_IsBatchActive(void)
+{
+    return rlgCtx->state.batch;
+}
+
+void RLG_UseShaderPermutations(bool active)
+{
+    rlgCtx->usePermutations = active;
+}
+
+bool RLG_IsShaderPermutationsUsed(void)
+{
+    return rlgCtx->usePermutations;
+}
+
+const Shader* RLG_GetShaderPermutation(unsigned int flags)
+{
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    return &RLG_GetModelProgram(flags)->shader;
+}
+
+void RLG_SetViewPosition(float x, float y, float z)
+{
+    RLG_SetViewPositionV(INIT_STRUCT(Vector3, x, y, z));
+}
+
+void RLG_SetViewPositionV(Vector3 position)
+{
+    // NOTE: Uploaded into the model shader at the next draw
+    rlgCtx->viewPos = position;
+    RLG_MarkProgramsDirty(RLG_DIRTY_VIEW_POSITION);
+}
+
+Vector3 RLG_GetViewPosition(void)
+{
+    return rlgCtx->viewPos;
+}
+
+void RLG_SetAmbientColor(Color color)
+{
+    // NOTE: Uploaded into the model shader at the next draw
+    rlgCtx->colAmbient.x = (float)color.r/255.0f;
+    rlgCtx->colAmbient.y = (float)color.g/255.0f;
+    rlgCtx->colAmbient.z = (float)color.b/255.0f;
+    RLG_MarkProgramsDirty(RLG_DIRTY_AMBIENT_COLOR);
+}
+
+Color RLG_GetAmbientColor(void)
+{
+    Color color = { 0 };
+
+    color.r = rlgCtx->colAmbient.x*255.0f;
+    color.g = rlgCtx->colAmbient.y*255.0f;
+    color.b = rlgCtx->colAmbient.z*255.0f;
+    color.a = 255;
+
+    return color;
+}
+
+void RLG_SetAmbientSH(const Vector3 *sh)
+{
+    // NOTE: Uploaded into the model shader at the next draw
+    rlgCtx->useAmbientSH = (sh != NULL);
+    if (sh != NULL) memcpy(rlgCtx->ambientSH, sh, RLG_SH_COEFFICIENTS*sizeof(Vector3));
+
+    rlgCtx->deferred.ambientSHDirty = true;
+    RLG_MarkProgramsDirty(RLG_DIRTY_AMBIENT_SH);
+}
+
+bool RLG_IsAmbientSHUsed(void)
+{
+    return rlgCtx->useAmbientSH;
+}
+
+void RLG_SetParallaxLayers(int min, int max)
+{
+#if GLSL_VERSION >= 330
+    // NOTE: Written into the material uniform block at the next draw
+    rlgCtx->material.data.parallaxMinLayers = min;
+    rlgCtx->material.data.parallaxMaxLayers = max;
+#else
+    // NOTE: Uploaded into the model shader at the next draw
+    if (min != rlgCtx->material.data.parallaxMinLayers ||
+        max != rlgCtx->material.data.parallaxMaxLayers)
+    {
+        rlgCtx->material.data.parallaxMinLayers = min;
+        rlgCtx->material.data.parallaxMaxLayers = max;
+        RLG_MarkProgramsDirty(RLG_DIRTY_PARALLAX_LAYERS);
+    }
+#endif
+}
+
+void RLG_GetParallaxLayers(int* min, int* max)
+{
+    if (min != NULL) *min = rlgCtx->material.data.parallaxMinLayers;
+    if (max != NULL) *max = rlgCtx->material.data.parallaxMaxLayers;
+}
+
+void RLG_UseMap(MaterialMapIndex mapIndex, bool active)
+{
+    if (mapIndex >= 0 && mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    {
+#   if GLSL_VERSION >= 330
+        // NOTE: Written into the material uniform block at the next draw
+        rlgCtx->material.data.useMaps[mapIndex] = active;
+#   else
+        // NOTE: Uploaded into the model shader at the next draw
+        if (active != rlgCtx->material.data.useMaps[mapIndex])
+        {
+            rlgCtx->material.data.useMaps[mapIndex] = active;
+            RLG_MarkProgramsDirty(RLG_DIRTY_MAP(mapIndex));
+        }
+#   endif
+    }
+}
+
+bool RLG_IsMapUsed(MaterialMapIndex mapIndex)
+{
+    bool result = false;
+
+    if (mapIndex >= 0 && mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    {
+        result = rlgCtx->material.data.useMaps[mapIndex];
+    }
+
+    return result;
+}
+
+void RLG_UseDefaultMap(MaterialMapIndex mapIndex, bool active)
+{
+    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    {
+        rlgCtx->usedDefaultMaps[mapIndex] = active;
+    }
+}
+
+void RLG_SetDefaultMap(MaterialMapIndex mapIndex, MaterialMap map)
+{
+    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    {
+        rlgCtx->defaultMaps[mapIndex] = map;
+    }
+}
+
+MaterialMap RLG_GetDefaultMap(MaterialMapIndex mapIndex)
+{
+    MaterialMap map = { 0 };
+
+    if (mapIndex >= 0 || mapIndex < RLG_COUNT_MATERIAL_MAPS)
+    {
+        map = rlgCtx->defaultMaps[mapIndex];
+    }
+
+    return map;
+}
+
+bool RLG_IsDefaultMapUsed(MaterialMapIndex mapIndex)
+{
+    return rlgCtx->usedDefaultMaps[mapIndex];
+}
+
+void RLG_UseLight(unsigned int light, bool active)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_UseLight' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    if (active != l->data.enabled)
+    {
+        l->data.enabled = (int)active;
+        RLG_TouchLight(l, RLG_LIGHT_DIRTY_ENABLED);
+    }
+}
+
+bool RLG_IsLightUsed(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_IsLightUsed' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return false;
+    }
+
+    return (bool)rlgCtx->lights[light].data.enabled;
+}
+
+void RLG_ToggleLight(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_ToggleLight' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    l->data.enabled = !l->data.enabled;
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_ENABLED);
+}
+
+void RLG_SetLightType(unsigned int light, RLG_LightType type)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightType' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    if (l->data.type != (int)type)
+    {
+        l->data.type = (int)type;
+        RLG_TouchLight(l, RLG_LIGHT_DIRTY_TYPE);
+
+        // NOTE: The area of the shadow map is allocated again for the new type (cube faces, cascades or single map)
+        if (l->data.shadow)
+        {
+            int shadowMapResolution = l->data.shadowMap.resolution;
+
+            RLG_DisableShadow(light);
+            RLG_EnableShadow(light, shadowMapResolution);
+        }
+    }
+}
+
+RLG_LightType RLG_GetLightType(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightType' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return (RLG_LightType)0;
+    }
+
+    return (RLG_LightType)rlgCtx->lights[light].data.type;
+}
+
+void RLG_SetLightValue(unsigned int light, RLG_LightProperty property, float value)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightValue' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    switch (property)
+    {
+        case RLG_LIGHT_COLOR:
+            l->data.color = INIT_STRUCT(Vector3, value, value, value);
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_COLOR);
+            break;
+
+        case RLG_LIGHT_ENERGY:
+            if (value != l->data.energy)
+            {
+                l->data.energy = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_ENERGY);
+            }
+            break;
+
+        case RLG_LIGHT_SPECULAR:
+            if (value != l->data.specular)
+            {
+                l->data.specular = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_SPECULAR);
+            }
+            break;
+
+        case RLG_LIGHT_SIZE:
+            if (value != l->data.size)
+            {
+                l->data.size = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_SIZE);
+            }
+            break;
+
+        case RLG_LIGHT_INNER_CUTOFF:
+            if (value != l->data.innerCutOff)
+            {
+                l->data.innerCutOff = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_INNER_CUTOFF);
+            }
+            break;
+
+        case RLG_LIGHT_OUTER_CUTOFF:
+            if (value != l->data.outerCutOff)
+            {
+                l->data.outerCutOff = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_OUTER_CUTOFF);
+            }
+            break;
+
+        case RLG_LIGHT_DISTANCE:
+            if (value != l->data.distance)
+            {
+                l->data.distance = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_DISTANCE);
+            }
+            break;
+
+        case RLG_LIGHT_ATTENUATION:
+            if (value != l->data.attenuation)
+            {
+                l->data.attenuation = value;
+                RLG_TouchLight(l, RLG_LIGHT_DIRTY_ATTENUATION);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void RLG_SetLightXYZ(unsigned int light, RLG_LightProperty property, float x, float y, float z)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightXYZ' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    Vector3 value = { x, y, z };
+
+    switch (property)
+    {
+        case RLG_LIGHT_POSITION:
+            l->data.position = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_POSITION);
+            break;
+
+        case RLG_LIGHT_DIRECTION:
+            l->data.direction = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+            break;
+
+        case RLG_LIGHT_COLOR:
+            l->data.color = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_COLOR);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void RLG_SetLightVec3(unsigned int light, RLG_LightProperty property, Vector3 value)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightVec3' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    switch (property)
+    {
+        case RLG_LIGHT_POSITION:
+            l->data.position = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_POSITION);
+            break;
+
+        case RLG_LIGHT_DIRECTION:
+            l->data.direction = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+            break;
+
+        case RLG_LIGHT_COLOR:
+            l->data.color = value;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_COLOR);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void RLG_SetLightColor(unsigned int light, Color color)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightColor' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    Vector3 nCol = { 0 };
+    nCol.x = color.r/255.0f;
+    nCol.y = color.g/255.0f;
+    nCol.z = color.b/255.0f;
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    l->data.color = nCol;
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_COLOR);
+}
+
+float RLG_GetLightValue(unsigned int light, RLG_LightProperty property)
+{
+    float result = 0;
+
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightValue' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return result;
+    }
+
+    const struct RLG_Light *l = &rlgCtx->lights[light];
+
+    switch (property)
+    {
+        case RLG_LIGHT_ENERGY:
+            result = l->data.energy;
+            break;
+
+        case RLG_LIGHT_SPECULAR:
+            result = l->data.specular;
+            break;
+
+        case RLG_LIGHT_SIZE:
+            result = l->data.size;
+            break;
+
+        case RLG_LIGHT_INNER_CUTOFF:
+            result = l->data.innerCutOff;
+            break;
+
+        case RLG_LIGHT_OUTER_CUTOFF:
+            result = l->data.outerCutOff;
+            break;
+
+        case RLG_LIGHT_DISTANCE:
+            result = l->data.distance;
+            break;
+
+        case RLG_LIGHT_ATTENUATION:
+            result = l->data.attenuation;
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
+
+Vector3 RLG_GetLightVec3(unsigned int light, RLG_LightProperty property)
+{
+    Vector3 result = { 0 };
+
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightVec3' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return result;
+    }
+
+    const struct RLG_Light *l = &rlgCtx->lights[light];
+
+    switch (property)
+    {
+        case RLG_LIGHT_POSITION:
+            result = l->data.position;
+            break;
+
+        case RLG_LIGHT_DIRECTION:
+            result = l->data.direction;
+            break;
+
+        case RLG_LIGHT_COLOR:
+            result = l->data.color;
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
+
+Color RLG_GetLightColor(unsigned int light)
+{
+    Color result = BLACK;
+
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightColor' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return result;
+    }
+
+    const struct RLG_Light *l = &rlgCtx->lights[light];
+
+    result.r = 255*l->data.color.x;
+    result.g = 255*l->data.color.y;
+    result.b = 255*l->data.color.z;
+
+    return result;
+}
+
+void RLG_LightTranslate(unsigned int light, float x, float y, float z)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightTranslate' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    l->data.position.x += x;
+    l->data.position.y += y;
+    l->data.position.z += z;
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_POSITION);
+}
+
+void RLG_LightTranslateV(unsigned int light, Vector3 v)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightTranslateV' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    l->data.position.x += v.x;
+    l->data.position.y += v.y;
+    l->data.position.z += v.z;
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_POSITION);
+}
+
+void RLG_LightRotateX(unsigned int light, float degrees)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateX' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    float radians = DEG2RAD*degrees;
+    float c = cosf(radians);
+    float s = sinf(radians);
+
+    l->data.direction.y = l->data.direction.y*c + l->data.direction.z*s;
+    l->data.direction.z = -l->data.direction.y*s + l->data.direction.z*c;
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+}
+
+void RLG_LightRotateY(unsigned int light, float degrees)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateY' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    float radians = DEG2RAD*degrees;
+    float c = cosf(radians);
+    float s = sinf(radians);
+
+    l->data.direction.x = l->data.direction.x*c - l->data.direction.z*s;
+    l->data.direction.z = l->data.direction.x*s + l->data.direction.z*c;
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+}
+
+void RLG_LightRotateZ(unsigned int light, float degrees)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotateZ' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    float radians = DEG2RAD*degrees;
+    float c = cosf(radians);
+    float s = sinf(radians);
+
+    l->data.direction.x = l->data.direction.x*c + l->data.direction.y*s;
+    l->data.direction.y = -l->data.direction.x*s + l->data.direction.y*c;
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+}
+
+void RLG_LightRotate(unsigned int light, Vector3 axis, float degrees)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_LightRotate' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    float radians = -DEG2RAD*degrees;
+    float halfTheta = radians*0.5f;
+
+    float sinHalfTheta = sinf(halfTheta);
+    Quaternion rotationQuat = {
+        axis.x * sinHalfTheta,
+        axis.y * sinHalfTheta,
+        axis.z * sinHalfTheta,
+        cosf(halfTheta)
+    };
+
+    // Convert the current direction vector to a quaternion
+    Quaternion directionQuat = {
+        l->data.direction.x,
+        l->data.direction.y,
+        l->data.direction.z,
+        0.0f
+    };
+
+    // Calculate the rotated direction quaternion
+    Quaternion rotatedQuat = QuaternionMultiply(
+        QuaternionMultiply(rotationQuat, directionQuat),
+        QuaternionInvert(rotationQuat));
+
+    // Update the light direction with the rotated direction
+    l->data.direction = Vector3Normalize(INIT_STRUCT(Vector3,
+        rotatedQuat.x, rotatedQuat.y, rotatedQuat.z
+    ));
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+}
+
+void RLG_SetLightTarget(unsigned int light, float x, float y, float z)
+{
+    RLG_SetLightTargetV(light, INIT_STRUCT(Vector3, x, y, z));
+}
+
+void RLG_SetLightTargetV(unsigned int light, Vector3 targetPosition)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetLightTarget' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    l->data.direction = Vector3Normalize(Vector3Subtract(
+        targetPosition, l->data.position));
+
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DIRECTION);
+}
+
+Vector3 RLG_GetLightTarget(unsigned int light)
+{
+    Vector3 result = INIT_STRUCT_ZERO(Vector3);
+
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetLightTarget' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return result;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    result = Vector3Add(l->data.position, l->data.direction);
+
+    return result;
+}
+
+void RLG_UseClusteredShading(bool active)
+{
+#if GLSL_VERSION >= 330
+    struct RLG_ClusterHandler *c = &rlgCtx->clusters;
+
+    if (active == c->enabled) return;
+
+    // Create the texture buffers on first activation
+    if (active && c->lightsBuffer == 0)
+    {
+        // NOTE: Creating textures changes the bindings of the active unit
+        RLG_RestoreState();
+
+        c->froxels = (BoundingBox*)malloc(RLG_COUNT_CLUSTERS*sizeof(BoundingBox));
+
+        glGenBuffers(1, &c->lightsBuffer);
+        glGenBuffers(1, &c->itemsBuffer);
+        glGenTextures(1, &c->lightsTexture);
+        glGenTextures(1, &c->itemsTexture);
+
+        // NOTE: The data stores are allocated during the first binning
+        RLG_UploadBuffer(GL_TEXTURE_BUFFER, c->lightsBuffer, NULL, 0, &c->lightsBufferSize);
+        RLG_UploadBuffer(GL_TEXTURE_BUFFER, c->itemsBuffer, NULL, 0, &c->itemsBufferSize);
+
+        glBindTexture(GL_TEXTURE_BUFFER, c->lightsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, c->lightsBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, c->itemsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, c->itemsBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    c->enabled = active;
+    c->dirty = true;
+
+    RLG_MarkProgramsDirty(RLG_DIRTY_CLUSTERS);
+#else
+    (void)active;
+    TraceLog(LOG_WARNING, "Clustered shading requires GLSL 330 or higher");
+#endif
+}
+
+bool RLG_IsClusteredShadingUsed(void)
+{
+    return rlgCtx->clusters.enabled;
+}
+
+void RLG_UseLinearOmniShadows(bool active)
+{
+    if (active == rlgCtx->linearOmniShadows) return;
+
+    rlgCtx->linearOmniShadows = active;
+
+    // The depth stored by the shadow maps of the omnilights changes, they must be rendered again
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[i];
+        if (l->data.type != RLG_OMNILIGHT || !l->data.shadow) continue;
+
+        l->shadowCache.cached = false;
+        l->shadowCache.current = false;
+        RLG_TouchLight(l, RLG_LIGHT_DIRTY_SHADOW);
+    }
+
+    RLG_MarkProgramsDirty(RLG_DIRTY_FAR_PLANE);
+}
+
+bool RLG_IsLinearOmniShadowsUsed(void)
+{
+    return rlgCtx->linearOmniShadows;
+}
+
+static bool RLG_LoadShadowAtlas(struct RLG_ShadowAtlas *atlas)
+{
+    // NOTE: Creating textures changes the bindings of the active unit
+    RLG_RestoreState();
+
+    atlas->id = rlLoadFramebuffer(RLG_SHADOW_ATLAS_SIZE, RLG_SHADOW_ATLAS_SIZE);
+    rlEnableFramebuffer(atlas->id);
+
+    atlas->depth.id = rlLoadTextureDepth(RLG_SHADOW_ATLAS_SIZE, RLG_SHADOW_ATLAS_SIZE, false);
+    atlas->depth.width = atlas->depth.height = RLG_SHADOW_ATLAS_SIZE;
+    atlas->depth.format = 19, atlas->depth.mipmaps = 1;
+
+    rlTextureParameters(atlas->depth.id, RL_TEXTURE_WRAP_S, RL_TEXTURE_WRAP_CLAMP);
+    rlTextureParameters(atlas->depth.id, RL_TEXTURE_WRAP_T, RL_TEXTURE_WRAP_CLAMP);
+
+#if GLSL_VERSION >= 330
+    // Sampled by the shaders with depth comparison, the results of the 4 nearest texels being filtered (hardware PCF)
+    rlTextureParameters(atlas->depth.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    rlTextureParameters(atlas->depth.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, atlas->depth.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+#endif
+    rlFramebufferAttach(atlas->id, atlas->depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    bool complete = rlFramebufferComplete(atlas->id);
+    rlDisableFramebuffer();
+
+    if (!complete)
+    {
+        TraceLog(LOG_ERROR, "Framebuffer is not complete for the shadow atlas");
+
+        rlUnloadTexture(atlas->depth.id);
+        rlUnloadFramebuffer(atlas->id);
+        *atlas = INIT_STRUCT_ZERO(struct RLG_ShadowAtlas);
+    }
+
+    return complete;
+}
+
+static bool RLG_PackShadowAtlas(void)
+{
+    // Sort the shadow casting lights by decreasing height of their area (insertion sort, few lights cast shadows)
+    int order[RLG_MAX_LIGHTS];
+    int count = 0;
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        const struct RLG_ShadowMap *sm = &rlgCtx->lights[i].data.shadowMap;
+        if (!rlgCtx->lights[i].data.shadow) continue;
+
+        int j = count++;
+        for (; j > 0; j--)
+        {
+            const struct RLG_ShadowMap *prev = &rlgCtx->lights[order[j - 1]].data.shadowMap;
+            if (prev->rows*prev->resolution >= sm->rows*sm->resolution) break;
+            order[j] = order[j - 1];
+        }
+
+        order[j] = i;
+    }
+
+    // Place the areas from left to right on shelves, the first area of a shelf giving its height
+    int positions[RLG_MAX_LIGHTS][2];
+    int x = 0, y = 0, shelfHeight = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const struct RLG_ShadowMap *sm = &rlgCtx->lights[order[i]].data.shadowMap;
+        int width = sm->columns*sm->resolution;
+        int height = sm->rows*sm->resolution;
+
+        if (x + width > RLG_SHADOW_ATLAS_SIZE)
+        {
+            y += shelfHeight;
+            x = shelfHeight = 0;
+        }
+
+        if (width > RLG_SHADOW_ATLAS_SIZE || y + height > RLG_SHADOW_ATLAS_SIZE)
+        {
+            return false;
+        }
+
+        positions[i][0] = x, positions[i][1] = y;
+        if (shelfHeight == 0) shelfHeight = height;
+        x += width;
+    }
+
+    // NOTE: The content of a moved shadow map is only valid after its next RLG_UpdateShadowMap()
+    for (int i = 0; i < count; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[order[i]];
+        struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+        sm->x = positions[i][0];
+        sm->y = positions[i][1];
+
+        Vector4 rect = {
+            (float)sm->x/RLG_SHADOW_ATLAS_SIZE, (float)sm->y/RLG_SHADOW_ATLAS_SIZE,
+            (float)sm->resolution/RLG_SHADOW_ATLAS_SIZE, (float)sm->resolution/RLG_SHADOW_ATLAS_SIZE
+        };
+
+        if (memcmp(&rect, &l->data.shadowRect, sizeof(Vector4)) != 0)
+        {
+            l->data.shadowRect = rect;
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_SHADOW_RECT);
+        }
+    }
+
+    return true;
+}
+
+void RLG_EnableShadow(unsigned int light, int shadowMapResolution)
+{
+    // Check if the specified light ID is within the valid range
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_EnableShadow' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    // Get a pointer to the specified light structure
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+    // The omnilights store their 6 faces on 3 columns and 2 rows, the cascades are stored on one row
+    int columns = 1, rows = 1;
+    if (l->data.type == RLG_OMNILIGHT) columns = 3, rows = 2;
+    else if (l->data.type == RLG_DIRLIGHT) columns = l->data.cascadeCount;
+
+    // Check if the area of the light in the shadow atlas must be allocated again
+    if (!l->data.shadow || sm->resolution != shadowMapResolution || sm->columns != columns || sm->rows != rows)
+    {
+        if (rlgCtx->shadowAtlas.id == 0 && !RLG_LoadShadowAtlas(&rlgCtx->shadowAtlas))
+        {
+            return;
+        }
+
+        struct RLG_ShadowMap previous = *sm;
+        int wasEnabled = l->data.shadow;
+
+        sm->resolution = shadowMapResolution;
+        sm->columns = columns, sm->rows = rows;
+        l->data.shadow = true;
+
+        // NOTE: All the areas are packed again, the atlas does not fragment when the lights change
+        if (!RLG_PackShadowAtlas())
+        {
+            TraceLog(LOG_WARNING, "Shadow map of light [ID %i] (%ix%i) does not fit in the shadow atlas [%ix%i]",
+                light, columns*shadowMapResolution, rows*shadowMapResolution, RLG_SHADOW_ATLAS_SIZE, RLG_SHADOW_ATLAS_SIZE);
+
+            // NOTE: The atlas is left unchanged when the packing fails
+            *sm = previous;
+            l->data.shadow = wasEnabled;
+            return;
+        }
+
+        // REVIEW: Should this value be modifiable by the user?
+        l->data.shadowMapTxlSz = 1.0f/shadowMapResolution;
+
+        // Set the depth bias value based on the light type
+        l->data.depthBias = (l->data.type == RLG_OMNILIGHT) ? 0.05f : 0.0002f;
+
+        l->data.cascades = (l->data.type == RLG_DIRLIGHT) ? columns : 1;
+        RLG_TouchLight(l, RLG_LIGHT_DIRTY_SHADOW_TEXEL | RLG_LIGHT_DIRTY_DEPTH_BIAS | RLG_LIGHT_DIRTY_CASCADES);
+    }
+
+    // Enable shadows for the light and send the information to the shader
+    l->data.shadow = true;
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_SHADOW);
+}
+
+void RLG_DisableShadow(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_DisableShadow' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    if (l->data.shadow)
+    {
+        // Fill shadow map struct with zeroes
+        // NOTE: The area of the light in the atlas is reused by the next packing
+        l->data.shadowMap = INIT_STRUCT_ZERO(struct RLG_ShadowMap);
+
+        // Send info to the shader
+        l->data.shadow = false;
+        RLG_TouchLight(l, RLG_LIGHT_DIRTY_SHADOW);
+    }
+}
+
+bool RLG_IsShadowEnabled(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_IsShadowEnabled' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return false;
+    }
+
+    return rlgCtx->lights[light].data.shadow;
+}
+
+void RLG_SetShadowBias(unsigned int light, float value)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowBias' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+
+    l->data.depthBias = value;
+    RLG_TouchLight(l, RLG_LIGHT_DIRTY_DEPTH_BIAS);
+}
+
+float RLG_GetShadowBias(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowBias' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return 0;
+    }
+
+    return rlgCtx->lights[light].data.depthBias;
+}
+
+void RLG_SetShadowCascades(unsigned int light, int count, float distance)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_SetShadowCascades' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    if (count < 1 || count > RLG_MAX_SHADOW_CASCADES)
+    {
+        TraceLog(LOG_WARNING, "Shadow cascades count [%i] specified to 'RLG_SetShadowCascades' is out of range [1..%i]", count, RLG_MAX_SHADOW_CASCADES);
+        count = (count < 1) ? 1 : RLG_MAX_SHADOW_CASCADES;
+    }
+
+#if GLSL_VERSION < 330
+    if (count > 1)
+    {
+        TraceLog(LOG_WARNING, "Cascaded shadow maps require GLSL 330 or higher");
+        count = 1;
+    }
+#endif
+
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    l->data.cascadeDistance = distance;
+
+    if (l->data.cascadeCount != count)
+    {
+        l->data.cascadeCount = count;
+
+        // The area of the shadow map is allocated again with the new number of tiles
+        if (l->data.shadow && l->data.type == RLG_DIRLIGHT)
+        {
+            int shadowMapResolution = l->data.shadowMap.resolution;
+
+            RLG_DisableShadow(light);
+            RLG_EnableShadow(light, shadowMapResolution);
+        }
+    }
+}
+
+int RLG_GetShadowCascades(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowCascades' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return 0;
+    }
+
+    return rlgCtx->lights[light].data.cascadeCount;
+}
+
+void RLG_SetShadowCamera(Camera3D camera)
+{
+    rlgCtx->shadowCamera = camera;
+    rlgCtx->useShadowCamera = true;
+}
+
+static void RLG_UpdateCascadeSplits(struct RLG_Light *l)
+{
+    // Practical split scheme, blend of the logarithmic and uniform distributions of the view depth
+    float zNear = RL_CULL_DISTANCE_NEAR;
+    float zFar = fmaxf(l->data.cascadeDistance, 2.0f*zNear);
+
+    for (int i = 0; i < l->data.cascades; i++)
+    {
+        float t = (float)(i + 1)/l->data.cascades;
+
+        float logSplit = zNear*powf(zFar/zNear, t);
+        float uniformSplit = zNear + (zFar - zNear)*t;
+
+        l->data.cascadeSplits[i] = RLG_SHADOW_CASCADE_LAMBDA*logSplit + (1.0f - RLG_SHADOW_CASCADE_LAMBDA)*uniformSplit;
+    }
+}
+
+#if GLSL_VERSION >= 330
+static void RLG_GetCascadeMatrices(const struct RLG_Light *l, int cascade, float aspect, Matrix *matView, Matrix *matProjection)
+{
+    const Camera3D *camera = &rlgCtx->shadowCamera;
+
+    float zNear = (cascade > 0) ? l->data.cascadeSplits[cascade - 1] : RL_CULL_DISTANCE_NEAR;
+    float zFar = l->data.cascadeSplits[cascade];
+
+    // Projection of the slice of the camera frustum covered by the cascade
+    Matrix matSlice = { 0 };
+
+    if (camera->projection == CAMERA_ORTHOGRAPHIC)
+    {
+        double top = camera->fovy/2.0, right = top*aspect;
+        matSlice = MatrixOrtho(-right, right, -top, top, zNear, zFar);
+    }
+    else
+    {
+        matSlice = MatrixPerspective(camera->fovy*DEG2RAD, aspect, zNear, zFar);
+    }
+
+    Matrix matCamera = MatrixLookAt(camera->position, camera->target, camera->up);
+    Matrix matInvSlice = MatrixInvert(MatrixMultiply(matCamera, matSlice));
+
+    // World space corners of the slice, from the corners of the NDC cube
+    Vector3 corners[8];
+    Vector3 center = { 0 };
+
+    for (int i = 0; i < 8; i++)
+    {
+        const Matrix m = matInvSlice;
+
+        float x = (i & 1) ? 1.0f : -1.0f;
+        float y = (i & 2) ? 1.0f : -1.0f;
+        float z = (i & 4) ? 1.0f : -1.0f;
+        float w = m.m3*x + m.m7*y + m.m11*z + m.m15;
+
+        corners[i] = INIT_STRUCT(Vector3,
+            (m.m0*x + m.m4*y + m.m8*z + m.m12)/w,
+            (m.m1*x + m.m5*y + m.m9*z + m.m13)/w,
+            (m.m2*x + m.m6*y + m.m10*z + m.m14)/w);
+
+        center = Vector3Add(center, corners[i]);
+    }
+
+    center = Vector3Scale(center, 1.0f/8.0f);
+
+    // NOTE: The cascade encloses the bounding sphere of the slice, so its size does not change when the camera rotates
+    float radius = 0.0f;
+
+    for (int i = 0; i < 8; i++)
+    {
+        radius = fmaxf(radius, Vector3Distance(corners[i], center));
+    }
+
+    radius = ceilf(radius*16.0f)/16.0f;
+
+    // The light view is placed at the origin and the center of the cascade is snapped to the
+    // texels of the shadow map, the shadows then do not shimmer when the camera moves
+    Vector3 direction = Vector3Normalize(l->data.direction);
+    Vector3 up = { 0.0f, 1.0f, 0.0f };
+    if (fabsf(direction.y) > 0.99f) up = INIT_STRUCT(Vector3, 0.0f, 0.0f, 1.0f);
+
+    *matView = MatrixLookAt(Vector3Zero(), direction, up);
+
+    Vector3 origin = Vector3Transform(center, *matView);
+    float texelSize = 2.0f*radius/l->data.shadowMap.resolution;
+
+    origin.x = floorf(origin.x/texelSize)*texelSize;
+    origin.y = floorf(origin.y/texelSize)*texelSize;
+
+    // NOTE: The near plane is moved back towards the light by the cascade distance,
+    //       so that the casters located between the light and the slice are rendered
+    *matProjection = MatrixOrtho(origin.x - radius, origin.x + radius, origin.y - radius, origin.y + radius,
+        -origin.z - radius - l->data.cascadeDistance, -origin.z + radius);
+}
+#endif
+
+static void RLG_SetDepthCubemapUniforms(RLG_Shader shader, int locLightPos, int locFar, int locFaces, Vector3 lightPos, const Matrix *matFaces)
+{
+    if (rlgCtx->shaders[shader].id == 0) return;
+
+    // Send the light position to the depth shader, and zFar to scale depth from [0..zFar] to [0..1]
+    RLG_EnableShader(rlgCtx->shaders[shader].id);
+    RLG_SetUniform(locLightPos, &lightPos, SHADER_UNIFORM_VEC3, 1);
+    RLG_SetUniform(locFar, &rlgCtx->zFar, SHADER_UNIFORM_FLOAT, 1);
+
+    // View-projection matrices of the faces, applied by the geometry shader of the single pass variants
+    for (int i = 0; i < 6 && matFaces != NULL && locFaces >= 0; i++)
+    {
+        RLG_SetUniformMatrix(locFaces + i, matFaces[i]);
+    }
+
+    RLG_DisableShader();
+}
+
+static bool RLG_IsShadowLayered(const struct RLG_Light *l)
+{
+    RLG_Shader shader = rlgCtx->linearOmniShadows ? RLG_SHADER_DEPTH_CUBEMAP_LAYERED : RLG_SHADER_DEPTH_LAYERED;
+    return (l->data.type == RLG_OMNILIGHT && rlgCtx->shaders[shader].id > 0);
+}
+
+static void RLG_RenderShadowMap(struct RLG_Light *l, unsigned int framebuffer, bool clear, unsigned int tiles, RLG_DrawFunc drawFunc, RLG_DrawFunc extraDrawFunc)
+{
+    // Directions and up vectors for the 6 faces of the cubemap
+    static const Vector3 dirs[6] = {
+        {  1.0,  0.0,  0.0 }, // +X
+        { -1.0,  0.0,  0.0 }, // -X
+        {  0.0,  1.0,  0.0 }, // +Y
+        {  0.0, -1.0,  0.0 }, // -Y
+        {  0.0,  0.0,  1.0 }, // +Z
+        {  0.0,  0.0, -1.0 }  // -Z
+    };
+
+    static const Vector3 ups[6] = {
+        {  0.0, -1.0,  0.0 }, // +X
+        {  0.0, -1.0,  0.0 }, // -X
+        {  0.0,  0.0,  1.0 }, // +Y
+        {  0.0,  0.0, -1.0 }, // -Y
+        {  0.0, -1.0,  0.0 }, // +Z
+        {  0.0, -1.0,  0.0 }  // -Z
+    };
+
+    // Cascaded shadow maps are fit to the camera given by RLG_SetShadowCamera()
+    bool cascaded = (l->data.type == RLG_DIRLIGHT && l->data.cascades > 1);
+    if (cascaded) RLG_UpdateCascadeSplits(l);
+
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    // Unbind the state left by the draws of a batch, the casts then keep theirs until the end of each face
+    RLG_RestoreState();
+
+    // Flush the rendering batch and enable the shadow atlas framebuffer (or the shadow cache one)
+    // NOTE: The tiles of the light are rendered one by one, the scissor test restricts the clears to them
+    rlDrawRenderBatchActive();
+    rlEnableFramebuffer(framebuffer);
+    rlEnableScissorTest();
+
+    const struct RLG_ShadowMap *sm = &l->data.shadowMap;
+
+    // Configure the projection for the shadow map
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+
+    // Near and far clipping planes for shadow map rendering
+    rlgCtx->zNear = 0.01f;      // TODO: replace with rlGetCullDistanceNear()
+    rlgCtx->zFar = 1000.0f;     // TODO: replace with rlGetCullDistanceFar()
+
+    // Set up projection matrix based on the light type
+    switch (l->data.type)
+    {
+        case RLG_DIRLIGHT:
+            // Orthographic projection for directional
+            rlOrtho(-10.0, 10.0, -10.0, 10.0, rlgCtx->zNear, rlgCtx->zFar);
+            break;
+        case RLG_SPOTLIGHT:
+            // Perspective projection for spotlight
+            rlMultMatrixf(MatrixToFloat(MatrixPerspective(90*DEG2RAD, 1.0, RLG_SHADOW_NEAR_PLANE, l->data.distance)));
+            break;
+        case RLG_OMNILIGHT:
+            // Perspective projection for omnidirectional light
+            rlMultMatrixf(MatrixToFloat(MatrixPerspective(90*DEG2RAD, 1.0, RLG_SHADOW_NEAR_PLANE, l->data.distance)));
+            break;
+    }
+
+    // Switch to modelview matrix mode
+    rlMatrixMode(RL_MODELVIEW);
+
+    // Enable depth test and disable color blending
+    rlEnableDepthTest();
+    rlDisableColorBlend();
+
+    // With GLSL 330, the six faces of an omnilight are rendered in a single pass, the casters are
+    // submitted once and a geometry shader emits their triangles into the tiles of the faces
+    bool layered = RLG_IsShadowLayered(l);
+
+    // By default, the omnilights write the distance to the light through gl_FragDepth,
+    // the hardware depth variant keeps the depth of the faces so that early-Z stays enabled
+    bool linear = rlgCtx->linearOmniShadows;
+
+    // Select the appropriate depth shader
+    Shader shader = { 0 };
+    if (layered)
+    {
+        Matrix matFaces[6];
+        for (int i = 0; i < 6; i++)
+        {
+            Matrix matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, dirs[i]), ups[i]);
+            matFaces[i] = MatrixMultiply(matView, rlGetMatrixProjection());
+        }
+
+        if (linear)
+        {
+            shader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP_LAYERED];
+
+            RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_CUBEMAP_LAYERED, rlgCtx->locDepthCubemapLayeredLightPos,
+                rlgCtx->locDepthCubemapLayeredFar, rlgCtx->locDepthCubemapLayeredFaces, l->data.position, matFaces);
+
+            // Same for the shader used by RLG_CastMeshInstanced()
+            RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_CUBEMAP_LAYERED_INSTANCED, rlgCtx->locDepthCubemapLayeredInstancedLightPos,
+                rlgCtx->locDepthCubemapLayeredInstancedFar, rlgCtx->locDepthCubemapLayeredInstancedFaces, l->data.position, matFaces);
+        }
+        else
+        {
+            shader = rlgCtx->shaders[RLG_SHADER_DEPTH_LAYERED];
+
+            RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_LAYERED, -1, -1, rlgCtx->locDepthLayeredFaces, l->data.position, matFaces);
+            RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_LAYERED_INSTANCED, -1, -1, rlgCtx->locDepthLayeredInstancedFaces, l->data.position, matFaces);
+        }
+
+        // The casts only transform the vertices to world space, they are culled against the cube reached by the light
+        rlMatrixMode(RL_PROJECTION);
+        rlLoadIdentity();
+        rlMatrixMode(RL_MODELVIEW);
+
+        float scale = 1.0f/l->data.distance;
+        rlgCtx->matCullingBounds = MatrixMultiply(MatrixTranslate(-l->data.position.x, -l->data.position.y, -l->data.position.z), MatrixScale(scale, scale, scale));
+        rlgCtx->useCullingBounds = true;
+
+        // zFar is sent to the lighting shader at the next draw to scale depth from [0..1] to [0..zFar]
+        RLG_MarkProgramsDirty(RLG_DIRTY_FAR_PLANE);
+    }
+    else if (l->data.type == RLG_OMNILIGHT && linear)
+    {
+        shader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP];
+
+        RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_CUBEMAP, rlgCtx->locDepthCubemapLightPos,
+            rlgCtx->locDepthCubemapFar, -1, l->data.position, NULL);
+
+        // Same for the shader used by RLG_CastMeshInstanced() (GLSL 330 or higher)
+        RLG_SetDepthCubemapUniforms(RLG_SHADER_DEPTH_CUBEMAP_INSTANCED, rlgCtx->locDepthCubemapInstancedLightPos,
+            rlgCtx->locDepthCubemapInstancedFar, -1, l->data.position, NULL);
+
+        // zFar is sent to the lighting shader at the next draw to scale depth from [0..1] to [0..zFar]
+        RLG_MarkProgramsDirty(RLG_DIRTY_FAR_PLANE);
+    }
+    else
+    {
+        shader = rlgCtx->shaders[RLG_SHADER_DEPTH];
+
+        // The lighting shaders know whether the omnilights store hardware or linear depth
+        if (l->data.type == RLG_OMNILIGHT) RLG_MarkProgramsDirty(RLG_DIRTY_FAR_PLANE);
+    }
+
+#if GLSL_VERSION >= 330
+    // The clip distances written by the geometry shader restrict each triangle to the tile of its face
+    if (layered) for (int i = 0; i < 4; i++) glEnable(GL_CLIP_DISTANCE0 + i);
+#endif
+
+    // Determine the number of iterations for omnidirectional light and cascades
+    int iterationCount = layered ? 1 : ((l->data.type == RLG_OMNILIGHT) ? 6 : (cascaded ? l->data.cascades : 1));
+    for (int i = 0; i < iterationCount; i++)
+    {
+        // NOTE: The single pass renders all the faces, the tiles are only selected with multiple passes
+        if (!layered && !(tiles & (1 << i))) continue;
+
+        // Select the tile of the face or cascade in the area of the light
+        // NOTE: The single pass covers the whole area, the geometry shader selects the tiles
+        int x = sm->x + (i%sm->columns)*sm->resolution;
+        int y = sm->y + (i/sm->columns)*sm->resolution;
+        int width = layered ? sm->columns*sm->resolution : sm->resolution;
+        int height = layered ? sm->rows*sm->resolution : sm->resolution;
+
+        rlViewport(x, y, width, height);
+        rlScissor(x, y, width, height);
+
+        // Configure the ModelView matrix
+        Matrix matView = { 0 };
+        if (layered)
+        {
+            // The view-projection matrices of the faces are applied by the geometry shader
+            matView = MatrixIdentity();
+        }
+        else if (l->data.type == RLG_OMNILIGHT)
+        {
+            // Calculate the view matrix
+            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, dirs[i]), ups[i]);
+        }
+#if GLSL_VERSION >= 330
+        else if (cascaded)
+        {
+            // Fit the projection to the slice of the camera frustum covered by the cascade
+            // NOTE: Aspect ratio of the framebuffer the scene will be drawn into, as BeginMode3D() computes it
+            Matrix matProjection = { 0 };
+            float aspect = (float)rlGetFramebufferWidth()/(float)rlGetFramebufferHeight();
+            RLG_GetCascadeMatrices(l, i, aspect, &matView, &matProjection);
+
+            rlMatrixMode(RL_PROJECTION);
+            rlLoadIdentity();
+            rlMultMatrixf(MatrixToFloat(matProjection));
+            rlMatrixMode(RL_MODELVIEW);
+
+            l->data.cascadeMatrices[i] = MatrixMultiply(matView, matProjection);
+        }
+#endif
+        else
+        {
+            // Calculate the view matrix for directional and spotlight
+            matView = MatrixLookAt(l->data.position, Vector3Add(l->data.position, l->data.direction), INIT_STRUCT(Vector3, 0, 1, 0));
+
+            // Calculate and store the view-projection matrix, it will be sent to the lighting shader for later rendering
+            l->data.vpMatrix = MatrixMultiply(matView, rlGetMatrixProjection());
+            RLG_TouchLight(l, RLG_LIGHT_DIRTY_MATRIX);
+        }
+
+        // Apply the view matrix for rendering into the depth texture
+        rlLoadIdentity();
+        rlMultMatrixf(MatrixToFloat(matView));
+
+        // Clear the previous state of the tile
+        // NOTE: Not cleared when the casters are drawn over the static casters copied from the shadow cache
+        if (clear) rlClearScreenBuffers();
+
+        // Render objects in the light's context
+        if (drawFunc != NULL) drawFunc(shader);
+        if (extraDrawFunc != NULL) extraDrawFunc(shader);
+
+        // Flush the rendering batch
+        RLG_RestoreState();
+        rlDrawRenderBatchActive();
+    }
+
+    // The cascade matrices and splits are sent to the lighting shader at the next draw
+    if (cascaded) RLG_TouchLight(l, RLG_LIGHT_DIRTY_CASCADES);
+
+    // Stamp the rendered tiles for the scheduler of RLG_UpdateShadowMaps()
+    for (int i = 0; i < (layered ? 6 : iterationCount); i++)
+    {
+        if (!layered && !(tiles & (1 << i))) continue;
+
+        l->shadowSchedule.frames[i] = rlgCtx->shadowFrame;
+        l->shadowSchedule.versions[i] = l->version;
+        rlgCtx->stats.shadowTileUpdates++;
+    }
+
+#if GLSL_VERSION >= 330
+    if (layered) for (int i = 0; i < 4; i++) glDisable(GL_CLIP_DISTANCE0 + i);
+#endif
+
+    rlgCtx->useCullingBounds = false;
+
+    // End rendering
+    rlDisableScissorTest();
+    rlEnableColorBlend();
+    rlDisableFramebuffer();
+
+    // Reset the viewport and projection matrix to the screen settings
+    rlViewport(0, 0, GetScreenWidth(), GetScreenHeight());
+    rlMatrixMode(RL_PROJECTION);
+    rlPopMatrix();
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+}
+
+static struct RLG_Light* RLG_GetShadowCastingLight(unsigned int light, const char *funcName)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        // Log an error if the light ID exceeds the number of allocated lights
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to '%s' exceeds allocated number [MAX %i]", light, funcName, RLG_MAX_LIGHTS);
+        return NULL;
+    }
+
+    // Get a pointer to the specified light structure
+    struct RLG_Light *l = &rlgCtx->lights[light];
+    if (!l->data.shadow)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] does not support shadow casting", light);
+        return NULL;
+    }
+
+    // Cascaded shadow maps are fit to the camera given by RLG_SetShadowCamera()
+    if (l->data.type == RLG_DIRLIGHT && l->data.cascades > 1 && !rlgCtx->useShadowCamera)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] has shadow cascades but no camera was given to 'RLG_SetShadowCamera'", light);
+        return NULL;
+    }
+
+    return l;
+}
+
+void RLG_UpdateShadowMap(unsigned int light, RLG_DrawFunc drawFunc)
+{
+    // Safety checks
+    if (!drawFunc)
+    {
+        // Log an error if the draw function pointer is NULL
+        TraceLog(LOG_ERROR, "The drawing function pointer specified to 'RLG_UpdateShadowMap' is NULL");
+        return;  
+    }
+
+    struct RLG_Light *l = RLG_GetShadowCastingLight(light, "RLG_UpdateShadowMap");
+    if (l == NULL) return;
+
+    RLG_RenderShadowMap(l, rlgCtx->shadowAtlas.id, true, RLG_SHADOW_TILES_ALL, drawFunc, NULL);
+
+    // NOTE: The area of the light no longer holds the static casters only (see RLG_UpdateShadowMapCached)
+    l->shadowCache.current = false;
+}
+
+void RLG_UpdateShadowMapCached(unsigned int light, RLG_DrawFunc staticDrawFunc, RLG_DrawFunc dynamicDrawFunc)
+{
+    // Safety checks
+    if (!staticDrawFunc)
+    {
+        // Log an error if the draw function pointer is NULL
+        TraceLog(LOG_ERROR, "The static drawing function pointer specified to 'RLG_UpdateShadowMapCached' is NULL");
+        return;
+    }
+
+    struct RLG_Light *l = RLG_GetShadowCastingLight(light, "RLG_UpdateShadowMapCached");
+    if (l == NULL) return;
+
+    struct RLG_ShadowCache *cache = &l->shadowCache;
+
+    // NOTE: The cascades follow the camera, their static casters must be rendered again at each update
+    bool cascaded = (l->data.type == RLG_DIRLIGHT && l->data.cascades > 1);
+    bool unchanged = !cascaded && (RLG_GetLightChanges(l, cache->version) & RLG_LIGHT_SHADOW_FIELDS) == 0;
+
+    // The depth of the previous update is kept when nothing changed and there are no dynamic casters
+    if (unchanged && cache->current && dynamicDrawFunc == NULL)
+    {
+        rlgCtx->stats.cachedShadowMaps++;
+        return;
+    }
+
+#if GLSL_VERSION >= 330
+    // The static casters are rendered into the same area of the shadow cache, allocated when first needed
+    if (!cascaded && (rlgCtx->shadowCache.id != 0 || RLG_LoadShadowAtlas(&rlgCtx->shadowCache)))
+    {
+        if (!unchanged || !cache->cached)
+        {
+            RLG_RenderShadowMap(l, rlgCtx->shadowCache.id, true, RLG_SHADOW_TILES_ALL, staticDrawFunc, NULL);
+
+            cache->version = l->version;
+            cache->cached = true;
+        }
+        else
+        {
+            rlgCtx->stats.cachedShadowMaps++;
+        }
+
+        // Copy the depth of the static casters into the shadow atlas
+        const struct RLG_ShadowMap *sm = &l->data.shadowMap;
+        int x = sm->x, y = sm->y;
+        int width = sm->columns*sm->resolution, height = sm->rows*sm->resolution;
+
+        rlDrawRenderBatchActive();
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, rlgCtx->shadowCache.id);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rlgCtx->shadowAtlas.id);
+        glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        rlDisableFramebuffer();
+
+        // The dynamic casters are then drawn over them, without clearing the area
+        if (dynamicDrawFunc != NULL) RLG_RenderShadowMap(l, rlgCtx->shadowAtlas.id, false, RLG_SHADOW_TILES_ALL, dynamicDrawFunc, NULL);
+
+        cache->current = (dynamicDrawFunc == NULL);
+        return;
+    }
+#endif
+
+    // Without shadow cache, the static and dynamic casters are drawn together
+    RLG_RenderShadowMap(l, rlgCtx->shadowAtlas.id, true, RLG_SHADOW_TILES_ALL, staticDrawFunc, dynamicDrawFunc);
+
+    cache->version = l->version;
+    cache->cached = false;
+    cache->current = !cascaded && (dynamicDrawFunc == NULL);
+}
+
+static bool RLG_IsShadowScheduled(const struct RLG_Light *l)
+{
+    // NOTE: The cascades cannot be fit without the camera given to RLG_SetShadowCamera()
+    bool cascaded = (l->data.type == RLG_DIRLIGHT && l->data.cascades > 1);
+    return l->data.shadow && l->data.enabled && (!cascaded || rlgCtx->useShadowCamera);
+}
+
+static int RLG_GetShadowTileCount(const struct RLG_Light *l)
+{
+    // NOTE: A single pass omnilight is scheduled as one tile, rendering its six faces
+    if (RLG_IsShadowLayered(l)) return 1;
+
+    return l->data.shadowMap.columns*l->data.shadowMap.rows;
+}
+
+static float RLG_GetShadowInfluence(const struct RLG_Light *l, Vector3 viewPos)
+{
+    // Directional lights cover the whole screen, like the lights whose sphere contains the camera
+    if (l->data.type == RLG_DIRLIGHT) return 10.0f;
+
+    // Approximation of the screen size of the sphere reached by the light, from its radius and distance
+    float distance = Vector3Distance(viewPos, l->data.position) - l->data.distance;
+    return fminf(l->data.distance/fmaxf(distance, 0.001f), 10.0f);
+}
+
+void RLG_UpdateShadowMaps(RLG_DrawFunc drawFunc, int budget)
+{
+    // Safety checks
+    if (!drawFunc)
+    {
+        // Log an error if the draw function pointer is NULL
+        TraceLog(LOG_ERROR, "The drawing function pointer specified to 'RLG_UpdateShadowMaps' is NULL");
+        return;
+    }
+
+    // Wait for the shaders of the context, the single pass omnilights are scheduled as one tile
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    Vector3 viewPos = rlgCtx->useShadowCamera ? rlgCtx->shadowCamera.position : rlgCtx->viewPos;
+    unsigned int frame = rlgCtx->shadowFrame;
+
+    // The tiles never rendered, moved in the atlas or too old are rendered whatever the budget
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[i];
+        struct RLG_ShadowSchedule *schedule = &l->shadowSchedule;
+
+        schedule->info = INIT_STRUCT_ZERO(RLG_ShadowUpdateInfo);
+        if (!RLG_IsShadowScheduled(l)) continue;
+
+        schedule->info.priority = RLG_GetShadowInfluence(l, viewPos);
+
+        for (int j = 0; j < RLG_GetShadowTileCount(l); j++)
+        {
+            unsigned int age = frame - schedule->frames[j];
+            unsigned int changes = RLG_GetLightChanges(l, schedule->versions[j]);
+
+            if (schedule->frames[j] == 0 || age >= RLG_SHADOW_MAX_AGE ||
+                (changes & (RLG_LIGHT_DIRTY_SHADOW | RLG_LIGHT_DIRTY_SHADOW_RECT)))
+            {
+                schedule->info.forcedTiles |= (1 << j);
+                budget--;
+            }
+
+            if (age > schedule->info.age) schedule->info.age = age;
+        }
+
+        schedule->info.updatedTiles = schedule->info.forcedTiles;
+    }
+
+    // The remaining budget goes to the tiles with the best influence*age score, a light
+    // that moved since a tile was rendered counts as RLG_SHADOW_MAX_AGE updates older
+    while (budget > 0)
+    {
+        struct RLG_Light *best = NULL;
+        float bestScore = 0.0f;
+        int bestTile = 0;
+
+        for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+        {
+            struct RLG_Light *l = &rlgCtx->lights[i];
+            const struct RLG_ShadowSchedule *schedule = &l->shadowSchedule;
+
+            if (!RLG_IsShadowScheduled(l)) continue;
+
+            for (int j = 0; j < RLG_GetShadowTileCount(l); j++)
+            {
+                if (schedule->info.updatedTiles & (1 << j)) continue;
+
+                float age = (float)(frame - schedule->frames[j]);
+                if (RLG_GetLightChanges(l, schedule->versions[j]) & RLG_LIGHT_SHADOW_FIELDS) age += RLG_SHADOW_MAX_AGE;
+
+                float score = schedule->info.priority*age;
+
+                if (score > bestScore)
+                {
+                    best = l, bestScore = score, bestTile = j;
+                }
+            }
+        }
+
+        if (best == NULL) break;
+
+        best->shadowSchedule.info.updatedTiles |= (1 << bestTile);
+        budget--;
+    }
+
+    // Render the selected tiles, each light in one call of RLG_RenderShadowMap()
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        struct RLG_Light *l = &rlgCtx->lights[i];
+        const RLG_ShadowUpdateInfo *info = &l->shadowSchedule.info;
+
+        if (!RLG_IsShadowScheduled(l)) continue;
+
+        for (int j = 0; j < RLG_GetShadowTileCount(l); j++)
+        {
+            if (!(info->updatedTiles & (1 << j))) rlgCtx->stats.skippedShadowTileUpdates += RLG_IsShadowLayered(l) ? 6 : 1;
+        }
+
+        if (info->updatedTiles == 0) continue;
+
+        RLG_RenderShadowMap(l, rlgCtx->shadowAtlas.id, true,
+            RLG_IsShadowLayered(l) ? RLG_SHADOW_TILES_ALL : info->updatedTiles, drawFunc, NULL);
+
+        // NOTE: The area of the light no longer holds the static casters only (see RLG_UpdateShadowMapCached)
+        l->shadowCache.current = false;
+    }
+
+    rlgCtx->shadowFrame++;
+}
+
+RLG_ShadowUpdateInfo RLG_GetShadowUpdateInfo(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowUpdateInfo' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return INIT_STRUCT_ZERO(RLG_ShadowUpdateInfo);
+    }
+
+    return rlgCtx->lights[light].shadowSchedule.info;
+}
+
+void RLG_InvalidateShadowMap(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_InvalidateShadowMap' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return;
+    }
+
+    struct RLG_ShadowCache *cache = &rlgCtx->lights[light].shadowCache;
+
+    cache->cached = false;
+    cache->current = false;
+}
+
+Texture RLG_GetShadowMap(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        // Log an error if the light ID exceeds the number of allocated lights
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowMap' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return INIT_STRUCT_ZERO(Texture);
+    }
+
+    // NOTE: All the shadow maps are stored in the shadow atlas
+    if (!rlgCtx->lights[light].data.shadow) return INIT_STRUCT_ZERO(Texture);
+    return rlgCtx->shadowAtlas.depth;
+}
+
+Rectangle RLG_GetShadowMapRect(unsigned int light)
+{
+    if (light >= RLG_MAX_LIGHTS)
+    {
+        TraceLog(LOG_ERROR, "Light [ID %i] specified to 'RLG_GetShadowMapRect' exceeds allocated number [MAX %i]", light, RLG_MAX_LIGHTS);
+        return INIT_STRUCT_ZERO(Rectangle);
+    }
+
+    const struct RLG_ShadowMap *sm = &rlgCtx->lights[light].data.shadowMap;
+
+    return INIT_STRUCT(Rectangle, (float)sm->x, (float)sm->y,
+        (float)(sm->columns*sm->resolution), (float)(sm->rows*sm->resolution));
+}
+
+void RLG_CastMesh(Shader shader, Mesh mesh, Matrix transform)
+{
+    // Bind shader program
+    RLG_EnableShader(shader.id);
+
+    // Get a copy of current matrices to work with,
+    // just in case stereo render is required, and we need to modify them
+    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
+    // That's because BeginMode3D() sets it and there is no model-drawing function
+    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
+    Matrix matModel = MatrixIdentity();
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matModelView = MatrixIdentity();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
+    if (shader.locs[RLG_LOC_MATRIX_MODEL] != -1)
+        RLG_SetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MODEL], transform);
+
+    // Accumulate several model transformations:
+    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
+    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
+    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+
+    // Get model-view matrix
+    matModelView = MatrixMultiply(matModel, matView);
+
+    // Try binding vertex array objects (VAO) or use VBOs if not possible
+    if (!RLG_EnableVertexArray(mesh.vaoId))
+    {
+        // Bind mesh VBO data: vertex position (shader-location = 0)
+        rlEnableVertexBuffer(mesh.vboId[0]);
+        rlSetVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader.locs[RLG_LOC_VERTEX_POSITION]);
+
+        // If vertex indices exist, bine the VBO containing the indices
+        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+    }
+
+    int eyeCount = rlIsStereoRenderEnabled() ? 2 : 1;
+
+    for (int eye = 0; eye < eyeCount; eye++)
+    {
+        // Calculate model-view-projection matrix (MVP)
+        Matrix matModelViewProjection = MatrixIdentity();
+        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
+        else
+        {
+            // Setup current eye viewport (half screen width)
+            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
+            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+        }
+
+        // Send combined model-view-projection matrix to shader
+        RLG_SetUniformMatrix(shader.locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+
+        // Draw mesh
+        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
+        else rlDrawVertexArray(0, mesh.vertexCount);
+    }
+
+    // Unbind the vertex array and program (deferred to RLG_EndBatch() during a batch)
+    RLG_ReleaseDrawState();
+
+    // Restore rlgl internal modelview and projection matrices
+    rlSetMatrixModelview(matView);
+    rlSetMatrixProjection(matProjection);
+}
+
+void RLG_CastMeshInstanced(Shader shader, Mesh mesh, const Matrix *transforms, int count)
+{
+    if (transforms == NULL || count <= 0) return;
+
+#if GLSL_VERSION >= 330
+    // The depth shaders of the context are replaced by their variant reading the instance matrices
+    Shader instancedShader = shader;
+
+    if (shader.id == rlgCtx->shaders[RLG_SHADER_DEPTH].id) instancedShader = rlgCtx->shaders[RLG_SHADER_DEPTH_INSTANCED];
+    else if (shader.id == rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP].id) instancedShader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP_INSTANCED];
+    else if (shader.id == rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP_LAYERED].id) instancedShader = rlgCtx->shaders[RLG_SHADER_DEPTH_CUBEMAP_LAYERED_INSTANCED];
+    else if (shader.id == rlgCtx->shaders[RLG_SHADER_DEPTH_LAYERED].id) instancedShader = rlgCtx->shaders[RLG_SHADER_DEPTH_LAYERED_INSTANCED];
+
+    int location = (instancedShader.id > 0)
+        ? rlGetLocationAttrib(instancedShader.id, RLG_SHADER_ATTRIB_INSTANCE_TRANSFORM) : -1;
+
+    if (location >= 0)
+    {
+        // Bind shader program
+        RLG_EnableShader(instancedShader.id);
+
+        // NOTE: The instances are transformed in the shader, the MVP only contains the rlgl transform, the view and the projection
+        Matrix matView = rlGetMatrixModelview();
+        Matrix matProjection = rlGetMatrixProjection();
+        Matrix matModelView = MatrixMultiply(rlGetMatrixTransform(), matView);
+
+        // Try binding vertex array objects (VAO) or use VBOs if not possible
+        if (!RLG_EnableVertexArray(mesh.vaoId))
+        {
+            // Bind mesh VBO data: vertex position (shader-location = 0)
+            rlEnableVertexBuffer(mesh.vboId[0]);
+            rlSetVertexAttribute(instancedShader.locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(instancedShader.locs[RLG_LOC_VERTEX_POSITION]);
+
+            // If vertex indices exist, bine the VBO containing the indices
+            if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+        }
+
+        RLG_EnableInstanceTransforms(location, transforms, count);
+
+        int eyeCount = rlIsStereoRenderEnabled() ? 2 : 1;
+
+        for (int eye = 0; eye < eyeCount; eye++)
+        {
+            // Calculate model-view-projection matrix (MVP)
+            Matrix matModelViewProjection = MatrixIdentity();
+            if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
+            else
+            {
+                // Setup current eye viewport (half screen width)
+                rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
+                matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+            }
+
+            // Send combined model-view-projection matrix to shader
+            RLG_SetUniformMatrix(instancedShader.locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+
+            // Draw all the instances of the mesh
+            if (mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, count);
+            else rlDrawVertexArrayInstanced(0, mesh.vertexCount, count);
+        }
+
+        RLG_DisableInstanceTransforms(location);
+
+        // Unbind the vertex array and program (deferred to RLG_EndBatch() during a batch)
+        RLG_ReleaseDrawState();
+
+        // Restore rlgl internal modelview and projection matrices
+        rlSetMatrixModelview(matView);
+        rlSetMatrixProjection(matProjection);
+
+        return;
+    }
+#endif
+
+    // Without a shader reading the instance matrices, the instances are cast one by one
+    for (int i = 0; i < count; i++)
+    {
+        RLG_CastMesh(shader, mesh, transforms[i]);
+    }
+}
+
+void RLG_CastModel(Shader shader, Model model, Vector3 position, float scale)
+{
+    Vector3 vScale = { scale, scale, scale };
+    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+
+    RLG_CastModelEx(shader, model, position, rotationAxis, 0.0f, vScale);
+}
+
+void RLG_CastModelEx(Shader shader, Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale)
+{
+    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
+    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
+    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+
+    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+    model.transform = MatrixMultiply(model.transform, matTransform);
+
+    // NOTE: During RLG_UpdateShadowMap() the modelview and projection matrices are those of the light
+    Vector4 planes[6];
+    bool culling = RLG_GetCullingPlanes(planes);
+
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        if (culling && RLG_IsMeshCulled(planes, model.meshes[i], model.transform)) continue;
+
+        RLG_CastMesh(shader, model.meshes[i], model.transform);
+    }
+}
+
+static void RLG_DrawMeshEx(Mesh mesh, Material material, const Matrix *transforms, int count, bool instanced)
+{
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    // NOTE: The instances are transformed in the shader, the model matrix of an instanced draw is the identity
+    Matrix transform = instanced ? MatrixIdentity() : transforms[0];
+
+    // NOTE: In deferred mode the surface is written into the G-buffer, the lights are applied by RLG_EndDeferred()
+    bool deferred = rlgCtx->deferred.active;
+
+    struct RLG_ModelProgram *program = NULL;
+
+    if (!deferred)
+    {
+        // Select the lights illuminating the mesh and assign them to the light slots
+        int selectedLights[RLG_MAX_LIGHTS_PER_MATERIAL];
+        int selectedCount = RLG_SelectLights(mesh, transforms, count, selectedLights);
+        RLG_AssignLightSlots(selectedLights, selectedCount);
+
+#if GLSL_VERSION >= 330
+        // Bin the other lights in the clusters if the camera or the lights changed
+        if (rlgCtx->clusters.enabled) RLG_UpdateClusters(rlGetMatrixModelview(), rlGetMatrixProjection());
+#endif
+
+        // Get the permutation of the model shader compiled for the maps and lights used by this draw
+        unsigned int flags = RLG_GetShaderFlags();
+        if (instanced) flags |= RLG_USE_INSTANCING;
+
+        program = rlgCtx->usePermutations
+            ? RLG_GetModelProgram(flags)
+            : &rlgCtx->programs[0];
+
+        // Without a program reading the instance matrices, the instances are drawn one by one
+        if (instanced && program->locs.instanceTransform < 0)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                RLG_DrawMeshEx(mesh, material, &transforms[i], 1, false);
+            }
+
+            return;
+        }
+    }
+
+    const Shader *shader = deferred
+        ? &rlgCtx->shaders[RLG_SHADER_GBUFFER]
+        : &program->shader;
+
+    // Bind shader program
+    RLG_EnableShader(shader->id);
+
+#if GLSL_VERSION >= 330
+    // Copy into the G-buffer shader the global values set since the last draw
+    if (deferred) RLG_UploadGBufferState(shader);
+#endif
+
+    if (!deferred)
+    {
+        // Upload into the program the values modified since its last use
+        RLG_UploadModelState(program);
+#if GLSL_VERSION < 330
+        RLG_UploadProgramSlots(program);
+#endif
+    }
+
+    // Send required data to shader (matrices, values)
+    //-----------------------------------------------------
+    // Upload the material colors and values that differ from those the program already has
+    // NOTE: With GLSL 330 or higher they are written in the material uniform block instead (no locations)
+    struct RLG_MaterialUniforms values = { 0 };
+    struct RLG_MaterialUniforms *uploaded = deferred ? NULL : &program->material;
+
+    RLG_GetMaterialUniforms(material, &values);
+
+    RLG_SetUniformCached(shader->locs[RLG_LOC_COLOR_DIFFUSE], values.colDiffuse,
+        uploaded ? uploaded->colDiffuse : NULL, sizeof(values.colDiffuse), SHADER_UNIFORM_VEC4);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_COLOR_SPECULAR], values.colSpecular,
+        uploaded ? uploaded->colSpecular : NULL, sizeof(values.colSpecular), SHADER_UNIFORM_VEC4);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_COLOR_EMISSION], values.colEmission,
+        uploaded ? uploaded->colEmission : NULL, sizeof(values.colEmission), SHADER_UNIFORM_VEC4);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_METALNESS_SCALE], &values.metalness,
+        uploaded ? &uploaded->metalness : NULL, sizeof(float), SHADER_UNIFORM_FLOAT);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_ROUGHNESS_SCALE], &values.roughness,
+        uploaded ? &uploaded->roughness : NULL, sizeof(float), SHADER_UNIFORM_FLOAT);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_AO_LIGHT_AFFECT], &values.aoLightAffect,
+        uploaded ? &uploaded->aoLightAffect : NULL, sizeof(float), SHADER_UNIFORM_FLOAT);
+    RLG_SetUniformCached(shader->locs[RLG_LOC_HEIGHT_SCALE], &values.heightScale,
+        uploaded ? &uploaded->heightScale : NULL, sizeof(float), SHADER_UNIFORM_FLOAT);
+
+    // Get a copy of current matrices to work with,
+    // just in case stereo render is required, and we need to modify them
+    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
+    // That's because BeginMode3D() sets it and there is no model-drawing function
+    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
+    Matrix matModel = MatrixIdentity();
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matModelView = MatrixIdentity();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    // Upload view matrix (if location available)
+    if (shader->locs[RLG_LOC_MATRIX_VIEW] != -1)
+        RLG_SetUniformMatrix(shader->locs[RLG_LOC_MATRIX_VIEW], matView);
+
+    // Upload projection matrix (if location available)
+    if (shader->locs[RLG_LOC_MATRIX_PROJECTION] != -1)
+        RLG_SetUniformMatrix(shader->locs[RLG_LOC_MATRIX_PROJECTION], matProjection);
+
+    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
+    if (shader->locs[RLG_LOC_MATRIX_MODEL] != -1)
+        RLG_SetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MODEL], transform);
+
+    // Accumulate several model transformations:
+    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
+    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
+    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+
+    // Get model-view matrix
+    matModelView = MatrixMultiply(matModel, matView);
+
+    // Upload model normal matrix (if locations available)
+    if (shader->locs[RLG_LOC_MATRIX_NORMAL] != -1)
+        RLG_SetUniformMatrix(shader->locs[RLG_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
+
+    //-----------------------------------------------------
+
+    // Bind active texture maps (if available)
+    for (int i = 0; i < 11; i++)
+    {
+        if (rlgCtx->material.data.useMaps[i])
+        {
+            int textureID = (rlgCtx->usedDefaultMaps[i])
+                ? rlgCtx->defaultMaps[i].texture.id
+                : material.maps[i].texture.id;
+
+            if (textureID > 0)
+            {
+                // Bind the texture to the unit of the map, unless it is still bound by the previous draw
+                if (i == MATERIAL_MAP_IRRADIANCE ||
+                    i == MATERIAL_MAP_PREFILTER ||
+                    i == MATERIAL_MAP_CUBEMAP)
+                {
+                    RLG_BindTexture(i, GL_TEXTURE_CUBE_MAP, textureID);
+                }
+                else
+                {
+                    RLG_BindTexture(i, GL_TEXTURE_2D, textureID);
+                }
+
+                // NOTE: The units of the maps never change, they are only sent once to each program
+                if (deferred || !(program->samplers & (1 << i)))
+                {
+                    RLG_SetUniform(shader->locs[RLG_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+                    if (!deferred) program->samplers |= (1 << i);
+                }
+                else
+                {
+                    rlgCtx->stats.skippedUniformUploads++;
+                }
+            }
+        }
+    }
+
+    // Bind the shadow atlas, it contains the shadow maps of all the lights
+    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL && !deferred; i++)
+    {
+        int light = rlgCtx->slots[i].light;
+
+        if (light >= 0 && rlgCtx->lights[light].data.shadow)
+        {
+            RLG_BindTexture(RLG_SHADOW_ATLAS_TEXTURE_SLOT, GL_TEXTURE_2D, rlgCtx->shadowAtlas.depth.id);
+            break;
+        }
+    }
+
+#if GLSL_VERSION >= 330
+    // Upload the light slots and material parameters that changed since the last draw
+    RLG_WriteMaterialBlock(material);
+    RLG_UploadUniformBlocks();
+
+    // Bind the clustered lights texture buffers
+    if (rlgCtx->clusters.enabled && !deferred)
+    {
+        RLG_BindTexture(RLG_CLUSTER_TEXTURE_SLOT, GL_TEXTURE_BUFFER, rlgCtx->clusters.lightsTexture);
+        RLG_BindTexture(RLG_CLUSTER_TEXTURE_SLOT + 1, GL_TEXTURE_BUFFER, rlgCtx->clusters.itemsTexture);
+    }
+#endif
+
+    // Try binding vertex array objects (VAO) or use VBOs if not possible
+    // WARNING: UploadMesh() enables all vertex attributes available in mesh and sets default attribute values
+    // for shader expected vertex attributes that are not provided by the mesh (i.e. colors)
+    // This could be a dangerous approach because different meshes with different shaders can enable/disable some attributes
+    if (!RLG_EnableVertexArray(mesh.vaoId))
+    {
+        // Bind mesh VBO data: vertex position (shader-location = 0)
+        rlEnableVertexBuffer(mesh.vboId[0]);
+        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION]);
+
+        // Bind mesh VBO data: vertex texcoords (shader-location = 1)
+        rlEnableVertexBuffer(mesh.vboId[1]);
+        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01]);
+
+        if (shader->locs[RLG_LOC_VERTEX_NORMAL] != -1)
+        {
+            // Bind mesh VBO data: vertex normals (shader-location = 2)
+            rlEnableVertexBuffer(mesh.vboId[2]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL]);
+        }
+
+        // Bind mesh VBO data: vertex colors (shader-location = 3, if available)
+        if (shader->locs[RLG_LOC_VERTEX_COLOR] != -1)
+        {
+            if (mesh.vboId[3] != 0)
+            {
+                rlEnableVertexBuffer(mesh.vboId[3]);
+                rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
+                rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
+            }
+            else
+            {
+                // Set default value for defined vertex attribute in shader but not provided by mesh
+                // WARNING: It could result in GPU undefined behaviour
+                float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+                rlSetVertexAttributeDefault(shader->locs[RLG_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
+                rlDisableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
+            }
+        }
+
+        // Bind mesh VBO data: vertex tangents (shader-location = 4, if available)
+        if (shader->locs[RLG_LOC_VERTEX_TANGENT] != -1)
+        {
+            rlEnableVertexBuffer(mesh.vboId[4]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT]);
+        }
+
+        // Bind mesh VBO data: vertex texcoords2 (shader-location = 5, if available)
+        if (shader->locs[RLG_LOC_VERTEX_TEXCOORD02] != -1)
+        {
+            rlEnableVertexBuffer(mesh.vboId[5]);
+            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02]);
+        }
+
+        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+    }
+
+#if GLSL_VERSION >= 330
+    // Stream the instance matrices into the attributes of the program
+    if (instanced) RLG_EnableInstanceTransforms(program->locs.instanceTransform, transforms, count);
+#endif
+
+    int eyeCount = 1;
+    if (rlIsStereoRenderEnabled()) eyeCount = 2;
+
+    for (int eye = 0; eye < eyeCount; eye++)
+    {
+        // Calculate model-view-projection matrix (MVP)
+        Matrix matModelViewProjection = MatrixIdentity();
+        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
+        else
+        {
+            // Setup current eye viewport (half screen width)
+            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
+            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+        }
+
+        // Send combined model-view-projection matrix to shader
+        RLG_SetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+
+        // Draw mesh
+        if (instanced)
+        {
+            if (mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, count);
+            else rlDrawVertexArrayInstanced(0, mesh.vertexCount, count);
+        }
+        else
+        {
+            if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
+            else rlDrawVertexArray(0, mesh.vertexCount);
+        }
+    }
+
+#if GLSL_VERSION >= 330
+    if (instanced) RLG_DisableInstanceTransforms(program->locs.instanceTransform);
+#endif
+
+    // Unbind the textures, vertex array and program (deferred to RLG_EndBatch() during a batch)
+    RLG_ReleaseDrawState();
+
+    // Restore rlgl internal modelview and projection matrices
+    rlSetMatrixModelview(matView);
+    rlSetMatrixProjection(matProjection);
+}
+
+void RLG_UseFrustumCulling(bool active)
+{
+    rlgCtx->useCulling = active;
+}
+
+bool RLG_IsFrustumCullingUsed(void)
+{
+    return rlgCtx->useCulling;
+}
+
+void RLG_UpdateMeshBounds(Mesh mesh)
+{
+    BoundingBox aabb = { 0 };
+    RLG_GetMeshBounds(mesh, true, &aabb);
+}
+
+void RLG_DrawMesh(Mesh mesh, Material material, Matrix transform)
+{
+    RLG_DrawMeshEx(mesh, material, &transform, 1, false);
+}
+
+void RLG_DrawMeshInstanced(Mesh mesh, Material material, const Matrix *transforms, int count)
+{
+    if (transforms == NULL || count <= 0) return;
+
+#if GLSL_VERSION >= 330
+    // NOTE: The G-buffer shader does not read the instance matrices
+    if (!rlgCtx->deferred.active)
+    {
+        RLG_DrawMeshEx(mesh, material, transforms, count, true);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; i++)
+    {
+        RLG_DrawMeshEx(mesh, material, &transforms[i], 1, false);
+    }
+}
+
+void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint)
+{
+    Vector3 vScale = { scale, scale, scale };
+    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+
+    RLG_DrawModelEx(model, position, rotationAxis, 0.0f, vScale, tint);
+}
+
+void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint)
+{
+    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
+    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
+    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+
+    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
+    model.transform = MatrixMultiply(model.transform, matTransform);
+
+    Vector4 planes[6];
+    bool culling = RLG_GetCullingPlanes(planes);
+
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        if (culling && RLG_IsMeshCulled(planes, model.meshes[i], model.transform)) continue;
+
+        Color color = model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color;
+
+        Color colorTint = WHITE;
+        colorTint.r = (unsigned char)((color.r*tint.r)/255);
+        colorTint.g = (unsigned char)((color.g*tint.g)/255);
+        colorTint.b = (unsigned char)((color.b*tint.b)/255);
+        colorTint.a = (unsigned char)((color.a*tint.a)/255);
+
+        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = colorTint;
+        RLG_DrawMesh(model.meshes[i], model.materials[model.meshMaterial[i]], model.transform);
+        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = color;
+    }
+}
+
+static unsigned long long RLG_GetQueueKey(const struct RLG_QueueEntry *entry, unsigned int flags, Matrix matModelView, float zNear, float zFar)
+{
+    // Hash of the textures bound by the draw, the draws sharing the same textures get the same bits
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+
+    for (int i = 0; i <= MATERIAL_MAP_BRDF; i++)
+    {
+        if (!rlgCtx->material.data.useMaps[i]) continue;
+
+        unsigned int textureID = (rlgCtx->usedDefaultMaps[i])
+            ? rlgCtx->defaultMaps[i].texture.id
+            : entry->material.maps[i].texture.id;
+
+        hash ^= textureID;
+        hash *= 0x100000001B3ULL;
+    }
+
+    unsigned long long textures = (hash ^ (hash >> 19) ^ (hash >> 38)) & 0x7FFFF;
+
+    // NOTE: Meshes without vertex array are grouped by their position buffer
+    unsigned long long vertexArray = (entry->mesh.vaoId > 0)
+        ? entry->mesh.vaoId : entry->mesh.vboId[0];
+
+    // View depth of the origin of the mesh, quantized between the planes of the projection
+    float depth = -matModelView.m14;
+    float t = (zFar > zNear) ? (depth - zNear)/(zFar - zNear) : 0.0f;
+    unsigned long long quantized = (unsigned long long)(Clamp(t, 0.0f, 1.0f)*65535.0f);
+
+    return ((unsigned long long)flags << 51) | (textures << 32) | ((vertexArray & 0xFFFF) << 16) | quantized;
+}
+
+static struct RLG_QueueKey* RLG_SortQueueKeys(struct RLG_QueueKey *keys, struct RLG_QueueKey *scratch, int count)
+{
+    // Least significant digit radix sort, 8 bits per pass, each pass is stable
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int offsets[256] = { 0 };
+
+        for (int i = 0; i < count; i++)
+        {
+            offsets[(keys[i].key >> shift) & 0xFF]++;
+        }
+
+        // The passes whose digit is the same for all the keys are skipped (e.g. single permutation)
+        if (offsets[(keys[0].key >> shift) & 0xFF] == count) continue;
+
+        for (int i = 0, sum = 0; i < 256; i++)
+        {
+            int digitCount = offsets[i];
+            offsets[i] = sum;
+            sum += digitCount;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            scratch[offsets[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+        }
+
+        struct RLG_QueueKey *sorted = scratch;
+        scratch = keys;
+        keys = sorted;
+    }
+
+    return keys;
+}
+
+void RLG_BeginQueue(void)
+{
+    rlgCtx->queue.count = 0;
+    rlgCtx->queue.active = true;
+}
+
+void RLG_Submit(Mesh mesh, Material material, Matrix transform)
+{
+    struct RLG_DrawQueue *q = &rlgCtx->queue;
+
+    if (!q->active)
+    {
+        RLG_DrawMesh(mesh, material, transform);
+        return;
+    }
+
+    if (q->count == q->capacity)
+    {
+        q->capacity = (q->capacity > 0) ? 2*q->capacity : 256;
+        q->entries = (struct RLG_QueueEntry*)realloc(q->entries, q->capacity*sizeof(struct RLG_QueueEntry));
+        q->keys = (struct RLG_QueueKey*)realloc(q->keys, q->capacity*sizeof(struct RLG_QueueKey));
+        q->scratch = (struct RLG_QueueKey*)realloc(q->scratch, q->capacity*sizeof(struct RLG_QueueKey));
+    }
+
+    struct RLG_QueueEntry *entry = &q->entries[q->count++];
+
+    entry->mesh = mesh;
+    entry->material = material;
+    entry->transform = transform;
+}
+
+void RLG_FlushQueue(void)
+{
+    struct RLG_DrawQueue *q = &rlgCtx->queue;
+
+    if (!q->active) return;
+    q->active = false;
+
+    if (q->count == 0) return;
+
+    // NOTE: The shadows are the only permutation feature that depends on the drawn mesh,
+    // the other flags are given by the maps and options of the context
+    unsigned int flags = RLG_GetShaderFlags() & ~RLG_RECEIVE_SHADOW;
+
+    int shadowLights[RLG_MAX_LIGHTS];
+    int shadowCount = 0, slotCount = 0;
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+        if (!RLG_IsSlotLight(l)) continue;
+
+        slotCount++;
+        if (l->data.shadow) shadowLights[shadowCount++] = i;
+    }
+
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matTransform = rlGetMatrixTransform();
+
+    float zNear = 0.0f, zFar = 0.0f;
+    RLG_GetProjectionPlanes(rlGetMatrixProjection(), &zNear, &zFar);
+
+    for (int i = 0; i < q->count; i++)
+    {
+        const struct RLG_QueueEntry *entry = &q->entries[i];
+
+        Matrix matModel = MatrixMultiply(entry->transform, matTransform);
+        unsigned int entryFlags = flags;
+
+        // Estimate whether the draw will receive shadows, with the same shortcut as RLG_SelectLights()
+        // NOTE: The origin of the mesh is tested instead of its bounding box, the key only has to group the draws
+        if (shadowCount > 0 && slotCount <= RLG_MAX_LIGHTS_PER_MATERIAL)
+        {
+            entryFlags |= RLG_RECEIVE_SHADOW;
+        }
+        else
+        {
+            Vector3 origin = { matModel.m12, matModel.m13, matModel.m14 };
+            BoundingBox point = { origin, origin };
+
+            for (int j = 0; j < shadowCount; j++)
+            {
+                if (RLG_GetLightInfluence(&rlgCtx->lights[shadowLights[j]], point) >= 0.0f)
+                {
+                    entryFlags |= RLG_RECEIVE_SHADOW;
+                    break;
+                }
+            }
+        }
+
+        q->keys[i].key = RLG_GetQueueKey(entry, entryFlags, MatrixMultiply(matModel, matView), zNear, zFar);
+        q->keys[i].entry = i;
+    }
+
+    const struct RLG_QueueKey *sorted = RLG_SortQueueKeys(q->keys, q->scratch, q->count);
+
+    // The consecutive draws of a group only bind what differs from the previous one
+    bool batch = rlgCtx->state.batch;
+    if (!batch) RLG_BeginBatch();
+
+    for (int i = 0; i < q->count; i++)
+    {
+        const struct RLG_QueueEntry *entry = &q->entries[sorted[i].entry];
+        RLG_DrawMesh(entry->mesh, entry->material, entry->transform);
+    }
+
+    if (!batch) RLG_EndBatch();
+
+    q->count = 0;
+}
+
+void RLG_BeginDeferred(void)
+{
+#if GLSL_VERSION >= 330
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    if (d->active) return;
+
+    // Draw the pending geometry into the current target before switching
+    RLG_RestoreState();
+    rlDrawRenderBatchActive();
+
+    if (!RLG_LoadDeferredShaders()) return;
+
+    // Save the current target, the lighting is written into it by RLG_EndDeferred()
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &d->target);
+    glGetIntegerv(GL_VIEWPORT, d->viewport);
+
+    // The G-buffer follows the size of the viewport
+    if (d->viewport[2] != d->width || d->viewport[3] != d->height)
+    {
+        if (!RLG_LoadGBuffer(d->viewport[2], d->viewport[3])) return;
+    }
+
+    rlEnableFramebuffer(d->framebuffer);
+    rlViewport(0, 0, d->width, d->height);
+
+    rlClearColor(0, 0, 0, 0);
+    rlClearScreenBuffers();
+
+    // NOTE: Blending must be disabled, the alpha channels of the G-buffer are not opacities
+    rlDisableColorBlend();
+
+    d->active = true;
+#else
+    TraceLog(LOG_WARNING, "Deferred shading requires GLSL 330 or higher");
+#endif
+}
+
+void RLG_EndDeferred(void)
+{
+#if GLSL_VERSION >= 330
+    struct RLG_DeferredHandler *d = &rlgCtx->deferred;
+
+    if (!d->active) return;
+
+    RLG_RestoreState();
+    rlDrawRenderBatchActive();
+    d->active = false;
+
+    // Restore the target of the lighting
+    rlEnableFramebuffer(d->target);
+    rlViewport(d->viewport[0], d->viewport[1], d->viewport[2], d->viewport[3]);
+
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProjection = rlGetMatrixProjection();
+
+    float zNear = 0.0f, zFar = 0.0f;
+    RLG_GetProjectionPlanes(matProjection, &zNear, &zFar);
+
+    rlEnableVertexArray(d->vao);
+
+    // Ambient pass: emission, ambient, reflections and depth of the G-buffer
+    //-----------------------------------------------------
+    RLG_EnableShader(rlgCtx->shaders[RLG_SHADER_DEFERRED_AMBIENT].id);
+
+    rlActiveTextureSlot(0); rlEnableTexture(d->emission);
+    rlActiveTextureSlot(1); rlEnableTexture(d->depth);
+
+    // NOTE: The depth is copied to allow forward rendering after RLG_EndDeferred()
+    rlDisableColorBlend();
+    rlEnableDepthTest();
+    rlEnableDepthMask();
+    glDepthFunc(GL_ALWAYS);
+
+    rlDrawVertexArray(0, 3);
+
+    glDepthFunc(GL_LEQUAL);
+    //-----------------------------------------------------
+
+    // Lighting pass: one additive fullscreen triangle per light,
+    // scissored to the screen area reached by the light
+    //-----------------------------------------------------
+    RLG_EnableShader(rlgCtx->shaders[RLG_SHADER_DEFERRED_LIGHTING].id);
+
+    Matrix matInvViewProj = MatrixInvert(MatrixMultiply(matView, matProjection));
+    RLG_SetUniformMatrix(d->locInvViewProj, matInvViewProj);
+    RLG_SetUniformMatrix(d->locView, matView);
+    RLG_SetUniform(d->locViewPos, &rlgCtx->viewPos, SHADER_UNIFORM_VEC3, 1);
+    RLG_SetUniform(d->locFarPlane, &rlgCtx->zFar, SHADER_UNIFORM_FLOAT, 1);
+
+    int linear = rlgCtx->linearOmniShadows;
+    RLG_SetUniform(d->locLinearOmniShadows, &linear, SHADER_UNIFORM_INT, 1);
+
+    rlActiveTextureSlot(0); rlEnableTexture(d->albedo);
+    rlActiveTextureSlot(1); rlEnableTexture(d->normal);
+    rlActiveTextureSlot(2); rlEnableTexture(d->orm);
+    rlActiveTextureSlot(3); rlEnableTexture(d->depth);
+    rlActiveTextureSlot(4); rlEnableTexture(rlgCtx->shadowAtlas.depth.id);
+
+    rlDisableDepthTest();
+    rlDisableDepthMask();
+    rlEnableColorBlend();
+    rlSetBlendMode(RL_BLEND_ADDITIVE);    // NOTE: The lighting shader writes an alpha of 1.0
+    rlEnableScissorTest();
+
+    for (int i = 0; i < RLG_MAX_LIGHTS; i++)
+    {
+        const struct RLG_Light *l = &rlgCtx->lights[i];
+        if (!l->data.enabled) continue;
+
+        // Screen rectangle covered by the sphere of influence of the light
+        float bounds[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+
+        if (l->data.type != RLG_DIRLIGHT)
+        {
+            Vector3 center = Vector3Transform(l->data.position, matView);
+            float radius = l->data.distance;
+
+            if (-center.z + radius < zNear || -center.z - radius > zFar) continue;
+            if (!RLG_GetSphereBoundsNDC(center, radius, matProjection, zNear, bounds)) continue;
+        }
+
+        int x0 = (int)floorf((bounds[0]*0.5f + 0.5f)*d->viewport[2]);
+        int y0 = (int)floorf((bounds[1]*0.5f + 0.5f)*d->viewport[3]);
+        int x1 = (int)ceilf((bounds[2]*0.5f + 0.5f)*d->viewport[2]);
+        int y1 = (int)ceilf((bounds[3]*0.5f + 0.5f)*d->viewport[3]);
+
+        if (x1 <= x0 || y1 <= y0) continue;
+
+        rlScissor(d->viewport[0] + x0, d->viewport[1] + y0, x1 - x0, y1 - y0);
+
+        // The light uniforms are only uploaded if another light or a modified one is drawn
+        if (d->light.light != i || d->light.version != l->version)
+        {
+            RLG_UploadLightSlot(&d->light, i);
+        }
+
+        rlDrawVertexArray(0, 3);
+    }
+
+    rlDisableScissorTest();
+    rlSetBlendMode(RL_BLEND_ALPHA);
+    rlEnableDepthMask();
+    rlEnableDepthTest();
+    //-----------------------------------------------------
+
+    // Unbind the G-buffer and shadow textures
+    for (int i = 4; i >= 0; i--)
+    {
+        rlActiveTextureSlot(i);
+        rlDisableTexture();
+    }
+
+    rlDisableVertexArray();
+    RLG_DisableShader();
+#endif
+}
+
+static bool RLG_ReadCubemapFace(unsigned int fbo, unsigned int cubemap, int face, int mip, int size, float *pixels)
+{
+    rlFramebufferAttach(fbo, cubemap, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + face, mip);
+    if (!rlFramebufferComplete(fbo)) return false;
+
+    rlEnableFramebuffer(fbo);
+
+#if GLSL_VERSION >= 330
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_FLOAT, pixels);
+#else
+    // NOTE: OpenGL ES 2.0 only guarantees the reading of 8-bit RGBA texels,
+    //       they are expanded to floats in place, starting from the end
+    unsigned char *bytes = (unsigned char*)pixels;
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+    for (int i = 4*size*size - 1; i >= 0; i--) pixels[i] = bytes[i]/255.0f;
+#endif
+
+    rlDisableFramebuffer();
+
+    return true;
+}
+
+// Major axis of each cubemap face followed by the directions of increasing columns (s) and rows (t)
+static const float G_CubemapAxes[6][3][3] = {
+    { {  1,  0,  0 }, {  0,  0, -1 }, {  0, -1,  0 } },    // +X
+    { { -1,  0,  0 }, {  0,  0,  1 }, {  0, -1,  0 } },    // -X
+    { {  0,  1,  0 }, {  1,  0,  0 }, {  0,  0,  1 } },    // +Y
+    { {  0, -1,  0 }, {  1,  0,  0 }, {  0,  0, -1 } },    // -Y
+    { {  0,  0,  1 }, {  1,  0,  0 }, {  0, -1,  0 } },    // +Z
+    { {  0,  0, -1 }, { -1,  0,  0 }, {  0, -1,  0 } }     // -Z
+};
+
+typedef void (*RLG_JobFunc)(void *data, int job);
+
+struct RLG_Worker
+{
+    RLG_JobFunc func;
+    void *data;
+    int first;      ///< First job run by the worker, followed by every 'step' jobs
+    int step;
+    int count;      ///< Total number of jobs
+};
+
+static void RLG_RunWorker(struct RLG_Worker *worker)
+{
+    for (int job = worker->first; job < worker->count; job += worker->step)
+    {
+        worker->func(worker->data, job);
+    }
+}
+
+#if defined(RLG_THREADS_WIN32)
+static unsigned int __stdcall RLG_WorkerThread(void *arg)
+{
+    RLG_RunWorker((struct RLG_Worker*)arg);
+    return 0;
+}
+#elif defined(RLG_THREADS_POSIX)
+static void* RLG_WorkerThread(void *arg)
+{
+    RLG_RunWorker((struct RLG_Worker*)arg);
+    return NULL;
+}
+#endif
+
+static void RLG_RunJobs(RLG_JobFunc func, void *data, int count)
+{
+    struct RLG_Worker workers[RLG_MAX_WORKER_THREADS];
+    int workerCount = (count < RLG_MAX_WORKER_THREADS) ? count : RLG_MAX_WORKER_THREADS;
+
+    if (count <= 0) return;
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        workers[i].func = func;
+        workers[i].data = data;
+        workers[i].first = i;
+        workers[i].step = workerCount;
+        workers[i].count = count;
+    }
+
+    // The calling thread runs the first worker, the others run on their own thread
+    // NOTE: The jobs of a worker whose thread could not be created are run by the calling thread
+#if defined(RLG_THREADS_WIN32)
+    uintptr_t threads[RLG_MAX_WORKER_THREADS] = { 0 };
+    for (int i = 1; i < workerCount; i++) threads[i] = _beginthreadex(NULL, 0, RLG_WorkerThread, &workers[i], 0, NULL);
+
+    RLG_RunWorker(&workers[0]);
+
+    for (int i = 1; i < workerCount; i++)
+    {
+        if (threads[i] == 0) { RLG_RunWorker(&workers[i]); continue; }
+
+        WaitForSingleObject((void*)threads[i], 0xFFFFFFFF);
+        CloseHandle((void*)threads[i]);
+    }
+#elif defined(RLG_THREADS_POSIX)
+    pthread_t threads[RLG_MAX_WORKER_THREADS];
+    bool started[RLG_MAX_WORKER_THREADS] = { 0 };
+    for (int i = 1; i < workerCount; i++) started[i] = (pthread_create(&threads[i], NULL, RLG_WorkerThread, &workers[i]) == 0);
+
+    RLG_RunWorker(&workers[0]);
+
+    for (int i = 1; i < workerCount; i++)
+    {
+        if (started[i]) pthread_join(threads[i], NULL);
+        else RLG_RunWorker(&workers[i]);
+    }
+#else
+    for (int i = 0; i < workerCount; i++) RLG_RunWorker(&workers[i]);
+#endif
+}
+
+struct RLG_SHProjection
+{
+    const float *pixels;    ///< RGBA texels of the face being projected
+    int size;
+    int face;
+    int bands;              ///< Number of row bands the face is split into, one for each job
+
+    float sums[RLG_MAX_WORKER_THREADS][3*RLG_SH_COEFFICIENTS + 1];  ///< Weighted sums of each band, followed by the total weight
+};
+
+static void RLG_ProjectSHBand(void *data, int job)
+{
+    struct RLG_SHProjection *p = (struct RLG_SHProjection*)data;
+    const float (*axis)[3] = G_CubemapAxes[p->face];
+
+    int y0 = job*p->size/p->bands;
+    int y1 = (job + 1)*p->size/p->bands;
+    float scale = 2.0f/p->size;
+
+    // NOTE: The texels are processed by blocks of 4 lanes, whose independent
+    //       loops are vectorized by the compiler, the lanes are summed at the end
+    float acc[3*RLG_SH_COEFFICIENTS + 1][4] = { 0 };
+
+    for (int y = y0; y < y1; y++)
+    {
+        const float *row = p->pixels + 4*y*p->size;
+        float t = (y + 0.5f)*scale - 1.0f;
+
+        for (int x = 0; x < p->size; x += 4)
+        {
+            float basis[RLG_SH_COEFFICIENTS][4], r[4], g[4], b[4], w[4];
+
+            for (int k = 0; k < 4; k++)
+            {
+                int i = (x + k < p->size) ? x + k : p->size - 1;
+                float s = (x + k + 0.5f)*scale - 1.0f;
+
+                // Direction of the texel, and its solid angle up to a constant factor
+                float invLength = 1.0f/sqrtf(1.0f + s*s + t*t);
+                float dx = (axis[0][0] + s*axis[1][0] + t*axis[2][0])*invLength;
+                float dy = (axis[0][1] + s*axis[1][1] + t*axis[2][1])*invLength;
+                float dz = (axis[0][2] + s*axis[1][2] + t*axis[2][2])*invLength;
+                w[k] = (x + k < p->size) ? invLength*invLength*invLength : 0.0f;
+
+                r[k] = row[4*i]*w[k];
+                g[k] = row[4*i + 1]*w[k];
+                b[k] = row[4*i + 2]*w[k];
+
+                basis[0][k] = 0.282095f;
+                basis[1][k] = 0.488603f*dy;
+                basis[2][k] = 0.488603f*dz;
+                basis[3][k] = 0.488603f*dx;
+                basis[4][k] = 1.092548f*dx*dy;
+                basis[5][k] = 1.092548f*dy*dz;
+                basis[6][k] = 0.315392f*(3.0f*dz*dz - 1.0f);
+                basis[7][k] = 1.092548f*dx*dz;
+                basis[8][k] = 0.546274f*(dx*dx - dy*dy);
+            }
+
+            for (int c = 0; c < RLG_SH_COEFFICIENTS; c++)
+            {
+                for (int k = 0; k < 4; k++) acc[3*c][k] += basis[c][k]*r[k];
+                for (int k = 0; k < 4; k++) acc[3*c + 1][k] += basis[c][k]*g[k];
+                for (int k = 0; k < 4; k++) acc[3*c + 2][k] += basis[c][k]*b[k];
+            }
+
+            for (int k = 0; k < 4; k++) acc[3*RLG_SH_COEFFICIENTS][k] += w[k];
+        }
+    }
+
+    for (int c = 0; c < 3*RLG_SH_COEFFICIENTS + 1; c++)
+    {
+        p->sums[job][c] += acc[c][0] + acc[c][1] + acc[c][2] + acc[c][3];
+    }
+}
+
+static void RLG_GetProjectedSH(const struct RLG_SHProjection *p, Vector3 *sh)
+{
+    // Convolution of each band by the clamped cosine lobe, divided by PI like the irradiance
+    // convolution shader, multiplied by the normalization constant of each basis function
+    static const float factors[RLG_SH_COEFFICIENTS] = {
+        0.282095f,
+        0.488603f*2.0f/3.0f, 0.488603f*2.0f/3.0f, 0.488603f*2.0f/3.0f,
+        1.092548f/4.0f, 1.092548f/4.0f, 0.315392f/4.0f, 1.092548f/4.0f, 0.546274f/4.0f
+    };
+
+    float sums[3*RLG_SH_COEFFICIENTS + 1] = { 0 };
+
+    for (int i = 0; i < p->bands; i++)
+    {
+        for (int c = 0; c < 3*RLG_SH_COEFFICIENTS + 1; c++) sums[c] += p->sums[i][c];
+    }
+
+    // The texel weights are normalized so that they cover the whole sphere
+    float normalize = 4.0f*PI/sums[3*RLG_SH_COEFFICIENTS];
+
+    for (int c = 0; c < RLG_SH_COEFFICIENTS; c++)
+    {
+        sh[c].x = sums[3*c]*normalize*factors[c];
+        sh[c].y = sums[3*c + 1]*normalize*factors[c];
+        sh[c].z = sums[3*c + 2]*normalize*factors[c];
+    }
+}
+
+static bool RLG_ProjectCubemapSH(TextureCubemap cubemap, Vector3 *sh)
+{
+    struct RLG_SHProjection *p = (struct RLG_SHProjection*)calloc(1, sizeof(struct RLG_SHProjection));
+    float *pixels = (float*)malloc(4*cubemap.width*cubemap.width*sizeof(float));
+    unsigned int fbo = rlLoadFramebuffer(cubemap.width, cubemap.width);
+
+    bool success = (p != NULL && pixels != NULL && fbo != 0);
+
+    if (success)
+    {
+        p->pixels = pixels;
+        p->size = cubemap.width;
+        p->bands = (cubemap.width < RLG_MAX_WORKER_THREADS) ? cubemap.width : RLG_MAX_WORKER_THREADS;
+    }
+
+    // The faces are read back one by one, their rows are split across the worker threads
+    for (int i = 0; i < 6 && success; i++)
+    {
+        success = RLG_ReadCubemapFace(fbo, cubemap.id, i, 0, cubemap.width, pixels);
+
+        p->face = i;
+        if (success) RLG_RunJobs(RLG_ProjectSHBand, p, p->bands);
+    }
+
+    if (success)
+    {
+        RLG_GetProjectedSH(p, sh);
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "Failed to read the skybox cubemap back, its irradiance is convolved on the GPU");
+    }
+
+    if (fbo != 0) rlUnloadFramebuffer(fbo);
+    free(pixels);
+    free(p);
+
+    return success;
+}
+
+struct RLG_PanoramaResampling
+{
+    const float *panorama;  ///< RGB texels of the equirectangular panorama
+    int width;
+    int height;
+
+    float *faces;           ///< RGB texels of the six faces, stacked vertically
+    int size;
+    int bands;              ///< Number of row bands each face is split into, one job for each band of each face
+};
+
+static void RLG_ResamplePanoramaBand(void *data, int job)
+{
+    struct RLG_PanoramaResampling *p = (struct RLG_PanoramaResampling*)data;
+
+    int face = job/p->bands;
+    int band = job%p->bands;
+    const float (*axis)[3] = G_CubemapAxes[face];
+
+    int y0 = band*p->size/p->bands;
+    int y1 = (band + 1)*p->size/p->bands;
+    float scale = 2.0f/p->size;
+
+    for (int y = y0; y < y1; y++)
+    {
+        float *row = p->faces + 3*(face*p->size + y)*p->size;
+        float t = (y + 0.5f)*scale - 1.0f;
+
+        for (int x = 0; x < p->size; x += 4)
+        {
+            // NOTE: The texels are processed by blocks of 4 lanes, the loops without
+            //       lookup in the panorama are vectorized by the compiler
+            float u[4], v[4], fx[4], fy[4];
+            int i0[4], i1[4], j0[4], j1[4];
+
+            // Coordinates of the direction of each texel in the panorama, as sampled by the conversion shader
+            for (int k = 0; k < 4; k++)
+            {
+                float s = (x + k + 0.5f)*scale - 1.0f;
+                float dx = axis[0][0] + s*axis[1][0] + t*axis[2][0];
+                float dy = axis[0][1] + s*axis[1][1] + t*axis[2][1];
+                float dz = axis[0][2] + s*axis[1][2] + t*axis[2][2];
+
+                u[k] = atan2f(dz, dx)*(0.5f/PI) + 0.5f;
+                v[k] = 0.5f - atan2f(dy, sqrtf(dx*dx + dz*dz))/PI;
+            }
+
+            // Bilinear filtering, wrapped horizontally and clamped vertically
+            for (int k = 0; k < 4; k++)
+            {
+                float px = u[k]*p->width - 0.5f;
+                float py = v[k]*p->height - 0.5f;
+                float x0 = floorf(px), y0 = floorf(py);
+
+                fx[k] = px - x0;
+                fy[k] = py - y0;
+
+                i0[k] = ((int)x0 + p->width)%p->width;
+                i1[k] = (i0[k] + 1)%p->width;
+                j0[k] = ((int)y0 < 0) ? 0 : (int)y0;
+                j1[k] = ((int)y0 + 1 < p->height) ? (int)y0 + 1 : p->height - 1;
+            }
+
+            for (int k = 0; k < 4 && x + k < p->size; k++)
+            {
+                const float *a = p->panorama + 3*(j0[k]*p->width + i0[k]);
+                const float *b = p->panorama + 3*(j0[k]*p->width + i1[k]);
+                const float *c = p->panorama + 3*(j1[k]*p->width + i0[k]);
+                const float *d = p->panorama + 3*(j1[k]*p->width + i1[k]);
+
+                for (int n = 0; n < 3; n++)
+                {
+                    float top = a[n] + (b[n] - a[n])*fx[k];
+                    float bottom = c[n] + (d[n] - c[n])*fx[k];
+                    row[3*(x + k) + n] = top + (bottom - top)*fy[k];
+                }
+            }
+        }
+    }
+}
+
+static TextureCubemap RLG_GenIrradianceCubemap(TextureCubemap cubemap)
+{
+    TextureCubemap irradiance = { 0 };
+
+    int size = cubemap.width / 16;
+    size = (size < 8) ? 8 : size;
+
+    // Create a renderbuffer for depth attachment
+    unsigned int rbo = rlLoadTextureDepth(size, size, true);
+
+    // Create a cubemap texture to hold the irradiance data
+    irradiance.id = rlLoadTextureCubemap(NULL, size, cubemap.format);
+    rlCubemapParameters(irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    rlCubemapParameters(irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    // Create and configure the framebuffer
+    unsigned int fbo = rlLoadFramebuffer(size, size);
+    rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+    rlFramebufferAttach(fbo, irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+
+    // Validate the framebuffer configuration
+    if (rlFramebufferComplete(fbo))
+    {
+        TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+    }
+
+    // Enable the shader for irradiance convolution
+    rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+
+    // Set the projection matrix for the shader
+    Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+    rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+
+    // Define view matrices for each cubemap face
+    Matrix fboViews[6] = {
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
+    };
+
+    // Set the viewport to match the framebuffer dimensions
+    rlViewport(0, 0, size, size);
+    rlDisableBackfaceCulling();
+
+    // Activate the cubemap texture
+    rlActiveTextureSlot(0);
+    rlEnableTextureCubemap(cubemap.id);
+
+    for (int i = 0; i < 6; i++)
+    {
+        // Set the view matrix for the current cubemap face
+        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
+
+        // Attach the current cubemap face to the framebuffer
+        rlFramebufferAttach(fbo, irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
+        rlEnableFramebuffer(fbo);
+
+        // Clear the framebuffer and draw the cube face
+        rlClearScreenBuffers();
+        rlLoadDrawCube();
+    }
+
+    // Disable the shader and textures
+    rlDisableShader();
+    rlDisableTextureCubemap();
+    rlDisableFramebuffer();
+
+    // Unload the framebuffer and its attachments
+    rlUnloadFramebuffer(fbo);
+
+    // Reset the viewport to default dimensions
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+    rlEnableBackfaceCulling();
+
+    // Set the irradiance cubemap properties
+    irradiance.width = size;
+    irradiance.height = size;
+    irradiance.mipmaps = 1;
+    irradiance.format = cubemap.format;
+
+    return irradiance;
+}
+
+#if GLSL_VERSION >= 330
+static TextureCubemap RLG_LoadPrefilterCubemap(int size, int format)
+{
+    TextureCubemap prefilter = { 0 };
+
+    prefilter.id = rlLoadTextureCubemap(NULL, size, format);
+    rlEnableTextureCubemap(prefilter.id);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, RLG_PREFILTER_MIP_LEVELS - 1);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);  // Only allocates the levels, they are all rendered afterwards
+    rlDisableTextureCubemap();
+
+    rlCubemapParameters(prefilter.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+    rlCubemapParameters(prefilter.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    prefilter.width = size;
+    prefilter.height = size;
+    prefilter.mipmaps = RLG_PREFILTER_MIP_LEVELS;
+    prefilter.format = format;
+
+    return prefilter;
+}
+#endif
+
+static TextureCubemap RLG_GenPrefilterCubemap(TextureCubemap *cubemap)
+{
+    TextureCubemap prefilter = { 0 };
+
+#if GLSL_VERSION >= 330
+    Shader shader = rlgCtx->shaders[RLG_SHADER_PREFILTER_CONVOLUTION];
+    if (shader.id == 0) return prefilter;
+
+    // The rough levels read the mips of the environment, few samples are then needed per texel
+    rlEnableTextureCubemap(cubemap->id);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    rlDisableTextureCubemap();
+
+    rlCubemapParameters(cubemap->id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+    cubemap->mipmaps = 1 + (int)floorf(log2f((float)cubemap->width));
+
+    // NOTE: The last level must keep a few texels per face to hold the fully rough lobe
+    int size = cubemap->width / 4;
+    size = (size < 32) ? 32 : (size > 256) ? 256 : size;
+
+    // Create a cubemap texture with one mip level per roughness
+    prefilter = RLG_LoadPrefilterCubemap(size, cubemap->format);
+
+    // Create the framebuffer, the color attachment changes for each face of each level
+    unsigned int fbo = rlLoadFramebuffer(size, size);
+    rlFramebufferAttach(fbo, prefilter.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+
+    // Validate the framebuffer configuration
+    if (rlFramebufferComplete(fbo))
+    {
+        TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+    }
+
+    // Enable the shader for prefiltered convolution
+    rlEnableShader(shader.id);
+
+    float resolution = (float)cubemap->width;
+    rlSetUniform(rlgCtx->skybox.locPrefilterResolution, &resolution, SHADER_UNIFORM_FLOAT, 1);
+
+    // Set the projection matrix for the shader
+    Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+
+    // Define view matrices for each cubemap face
+    Matrix fboViews[6] = {
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+        MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
+    };
+
+    rlDisableBackfaceCulling();
+    rlDisableDepthTest();
+
+    // Activate the environment cubemap texture
+    rlActiveTextureSlot(0);
+    rlEnableTextureCubemap(cubemap->id);
+
+    for (int mip = 0; mip < RLG_PREFILTER_MIP_LEVELS; mip++)
+    {
+        // Each level is rendered for its roughness, from smooth (0.0) to fully rough (1.0)
+        float roughness = (float)mip/(RLG_PREFILTER_MIP_LEVELS - 1);
+        rlSetUniform(rlgCtx->skybox.locPrefilterRoughness, &roughness, SHADER_UNIFORM_FLOAT, 1);
+
+        int mipSize = size >> mip;
+        rlViewport(0, 0, mipSize, mipSize);
+
+        for (int i = 0; i < 6; i++)
         {
-            values[0] = (float)material.maps[MATERIAL_MAP_EMISSION].color.r/255.0f;
-            values[1] = (float)material.maps[MATERIAL_MAP_EMISSION].color.g/255.0f;
-            values[2] = (float)material.maps[MATERIAL_MAP_EMISSION].color.b/255.0f;
-            values[3] = (float)material.maps[MATERIAL_MAP_EMISSION].color.a/255.0f;
+            // Set the view matrix for the current cubemap face
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
+
+            // Attach the current face of the level to the framebuffer
+            rlFramebufferAttach(fbo, prefilter.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, mip);
+            rlEnableFramebuffer(fbo);
+
+            // Clear the framebuffer and draw the cube face
+            rlClearScreenBuffers();
+            rlLoadDrawCube();
         }
+    }
+
+    // Disable the shader and textures
+    rlDisableShader();
+    rlDisableTextureCubemap();
+    rlDisableFramebuffer();
+
+    // Unload the framebuffer
+    rlUnloadFramebuffer(fbo);
+
+    // Reset the viewport to default dimensions
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+    rlEnableBackfaceCulling();
+#else
+    (void)cubemap;
+#endif
+
+    return prefilter;
+}
+
+static Texture2D RLG_GetBRDFLUT(void)
+{
+#if GLSL_VERSION >= 330
+    Texture2D *lut = &rlgCtx->skybox.brdfLUT;
+
+    // NOTE: Only depends on the BRDF, generated once and shared by all the skyboxes
+    if (lut->id != 0 || rlgCtx->shaders[RLG_SHADER_BRDF_INTEGRATION].id == 0)
+    {
+        return *lut;
+    }
+
+    const int size = 256;
+
+    // NOTE: Half floats keep the precision of the bias term, RGB16F is not always renderable
+    lut->id = rlLoadTexture(NULL, size, size, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16, 1);
+    lut->width = size;
+    lut->height = size;
+    lut->mipmaps = 1;
+    lut->format = PIXELFORMAT_UNCOMPRESSED_R16G16B16A16;
+
+    rlTextureParameters(lut->id, RL_TEXTURE_WRAP_S, RL_TEXTURE_WRAP_CLAMP);
+    rlTextureParameters(lut->id, RL_TEXTURE_WRAP_T, RL_TEXTURE_WRAP_CLAMP);
+    rlTextureParameters(lut->id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    rlTextureParameters(lut->id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+
+    unsigned int fbo = rlLoadFramebuffer(size, size);
+    rlFramebufferAttach(fbo, lut->id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+
+    if (rlFramebufferComplete(fbo))
+    {
+        TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+    }
+
+    // Draw the fullscreen triangle, its vertices are generated by the vertex shader
+    unsigned int vao = rlLoadVertexArray();
+
+    rlEnableFramebuffer(fbo);
+    rlViewport(0, 0, size, size);
+    rlDisableDepthTest();
+
+    rlEnableShader(rlgCtx->shaders[RLG_SHADER_BRDF_INTEGRATION].id);
+    rlEnableVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    rlDisableVertexArray();
+    rlDisableShader();
+
+    rlDisableFramebuffer();
+    rlUnloadFramebuffer(fbo);
+    rlUnloadVertexArray(vao);
+
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+
+    return *lut;
+#else
+    return INIT_STRUCT_ZERO(Texture2D);
+#endif
+}
+
+static void RLG_GenSkyboxLighting(RLG_Skybox *skybox)
+{
+    // Generate the irradiance, projected into spherical harmonics on the CPU when enabled
+    if (!rlgCtx->useSkyboxSH || !RLG_ProjectCubemapSH(skybox->cubemap, skybox->irradianceSH))
+    {
+        skybox->irradiance = RLG_GenIrradianceCubemap(skybox->cubemap);
+    }
+
+    // Generate the terms of the split-sum reflection
+    skybox->prefilter = RLG_GenPrefilterCubemap(&skybox->cubemap);
+    skybox->brdf = RLG_GetBRDFLUT();
+}
+
+void RLG_UseSkyboxIrradianceSH(bool active)
+{
+    rlgCtx->useSkyboxSH = active;
+}
 
-        rlSetUniform(shader->locs[RLG_LOC_COLOR_EMISSION], values, SHADER_UNIFORM_VEC4, 1);
+bool RLG_IsSkyboxIrradianceSHUsed(void)
+{
+    return rlgCtx->useSkyboxSH;
+}
+
+void RLG_UseSkyboxCPUConversion(bool active)
+{
+    rlgCtx->useSkyboxCPU = active;
+}
+
+bool RLG_IsSkyboxCPUConversionUsed(void)
+{
+    return rlgCtx->useSkyboxCPU;
+}
+
+void RLG_UseSkyboxDepthTest(bool active)
+{
+    // NOTE: The gamma flag is cached per cubemap, it must be sent again to the other shader
+    if (active != rlgCtx->useSkyboxDepthTest) rlgCtx->skybox.previousCubemapID = 0;
+    rlgCtx->useSkyboxDepthTest = active;
+}
+
+bool RLG_IsSkyboxDepthTestUsed(void)
+{
+    return rlgCtx->useSkyboxDepthTest;
+}
+
+RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName)
+{
+    RLG_Skybox skybox = { 0 };
+
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
+
+    // Load the cubemap texture from the image file
+    Image img = LoadImage(skyboxFileName);
+    skybox.cubemap = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT);
+    UnloadImage(img);
+
+    // Generate the irradiance and the reflection terms
+    RLG_GenSkyboxLighting(&skybox);
+
+    return skybox;
+}
+
+RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format)
+{
+    RLG_Skybox skybox = { 0 };
+
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
+
+    // Convert the panorama on the CPU when enabled, only the final faces are uploaded
+    if (rlgCtx->useSkyboxCPU)
+    {
+        Image panorama = LoadImage(skyboxFileName);
+        Image faces = RLG_GenSkyboxFaces(panorama, size);
+        UnloadImage(panorama);
+
+        if (faces.format != format) ImageFormat(&faces, format);
+
+        skybox = RLG_LoadSkyboxFaces(faces);
+        skybox.isHDR = true;
+
+        UnloadImage(faces);
+
+        return skybox;
     }
 
-    // Upload to shader material.data.metalness (if location available)
-    if (shader->locs[RLG_LOC_METALNESS_SCALE] != -1)
+    // Create a framebuffer object (FBO) to generate the skybox
+    unsigned int fbo = rlLoadFramebuffer(0, 0);
+
+    // Generate the cubemap for the skybox
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_METALNESS])
+        // Load the HDR panorama texture
+        Texture2D panorama = LoadTexture(skyboxFileName);
+
+        // Create a renderbuffer for depth attachment
+        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+
+        // Create a cubemap texture to hold the HDR data
+        skybox.cubemap.id = rlLoadTextureCubemap(NULL, size, format);
+
+        // Configure the framebuffer with the renderbuffer and cubemap texture
+        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+        rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+
+        // Validate the framebuffer configuration
+        if (rlFramebufferComplete(fbo))
         {
-            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
+            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
         }
-        else
+
+        // Enable the shader to convert the HDR equirectangular map to cubemap faces
+        rlEnableShader(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].id);
+
+        // Set the projection matrix for the shader
+        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+
+        // Define view matrices for each cubemap face
+        Matrix fboViews[6] = {
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
+            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
+        };
+
+        // Set the viewport to match the framebuffer dimensions
+        rlViewport(0, 0, size, size);
+        rlDisableBackfaceCulling();
+
+        // Activate the panorama texture
+        rlActiveTextureSlot(0);
+        rlEnableTexture(panorama.id);
+
+        for (int i = 0; i < 6; i++)
         {
-            rlSetUniform(shader->locs[RLG_LOC_METALNESS_SCALE],
-                &material.maps[MATERIAL_MAP_METALNESS].value, SHADER_UNIFORM_FLOAT, 1);
+            // Set the view matrix for the current cubemap face
+            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
+            
+            // Attach the current cubemap face to the framebuffer
+            rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
+            rlEnableFramebuffer(fbo);
+
+            // Clear the framebuffer and draw the cube
+            rlClearScreenBuffers();
+            rlLoadDrawCube();
         }
+
+        // Disable the shader and textures
+        rlDisableShader();
+        rlDisableTexture();
+        rlDisableFramebuffer();
+
+        // Reset the viewport to default dimensions
+        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+        rlEnableBackfaceCulling();
+
+        // Set the cubemap properties
+        skybox.cubemap.width = size;
+        skybox.cubemap.height = size;
+        skybox.cubemap.mipmaps = 1;
+        skybox.cubemap.format = format;
+
+        // Unload the panorama texture as it's no longer needed
+        UnloadTexture(panorama);
     }
 
-    // Upload to shader material.data.roughness (if location available)
-    if (shader->locs[RLG_LOC_ROUGHNESS_SCALE] != -1)
+    // Unload the framebuffer
+    rlUnloadFramebuffer(fbo);
+
+    // Generate the irradiance and the reflection terms
+    RLG_GenSkyboxLighting(&skybox);
+
+    // Indicate that the texture used is HDR
+    skybox.isHDR = true;
+
+    return skybox;
+}
+
+Image RLG_GenSkyboxFaces(Image panorama, int size)
+{
+    Image faces = { 0 };
+
+    if (panorama.data == NULL || size <= 0) return faces;
+
+    // NOTE: The panorama is read as RGB floats, other formats are converted on a copy
+    Image source = panorama;
+
+    if (panorama.format != PIXELFORMAT_UNCOMPRESSED_R32G32B32)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_ROUGHNESS])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
-        {
-            rlSetUniform(shader->locs[RLG_LOC_ROUGHNESS_SCALE],
-                &material.maps[MATERIAL_MAP_ROUGHNESS].value, SHADER_UNIFORM_FLOAT, 1);
-        }
+        source = ImageCopy(panorama);
+        ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
     }
 
-    // Upload to shader material.data.aoLightAffect (if location available)
-    if (shader->locs[RLG_LOC_AO_LIGHT_AFFECT] != -1)
+    if (source.data != NULL && source.format == PIXELFORMAT_UNCOMPRESSED_R32G32B32)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_OCCLUSION])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
-        {
-            rlSetUniform(shader->locs[RLG_LOC_AO_LIGHT_AFFECT],
-                &material.maps[MATERIAL_MAP_OCCLUSION].value, SHADER_UNIFORM_FLOAT, 1);
-        }
+        faces.data = RL_MALLOC(6*size*size*3*sizeof(float));
     }
 
-    // Upload to shader material.data.heightScale (if location available)
-    if (shader->locs[RLG_LOC_HEIGHT_SCALE] != -1)
+    if (faces.data != NULL)
     {
-        if (rlgCtx->usedDefaultMaps[MATERIAL_MAP_HEIGHT])
-        {
-            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
-                &rlgCtx->defaultMaps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
-        }
-        else
-        {
-            rlSetUniform(shader->locs[RLG_LOC_HEIGHT_SCALE],
-                &material.maps[MATERIAL_MAP_HEIGHT].value, SHADER_UNIFORM_FLOAT, 1);
-        }
+        faces.width = size;
+        faces.height = 6*size;
+        faces.mipmaps = 1;
+        faces.format = PIXELFORMAT_UNCOMPRESSED_R32G32B32;
+
+        struct RLG_PanoramaResampling resampling = { 0 };
+
+        resampling.panorama = (const float*)source.data;
+        resampling.width = source.width;
+        resampling.height = source.height;
+        resampling.faces = (float*)faces.data;
+        resampling.size = size;
+        resampling.bands = (size < RLG_MAX_WORKER_THREADS) ? size : RLG_MAX_WORKER_THREADS;
+
+        // The rows of each face are split into bands, shared by the worker threads
+        RLG_RunJobs(RLG_ResamplePanoramaBand, &resampling, 6*resampling.bands);
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "Failed to convert the panorama into cubemap faces");
     }
 
-    // Get a copy of current matrices to work with,
-    // just in case stereo render is required, and we need to modify them
-    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
-    // That's because BeginMode3D() sets it and there is no model-drawing function
-    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
-    Matrix matModel = MatrixIdentity();
-    Matrix matView = rlGetMatrixModelview();
-    Matrix matModelView = MatrixIdentity();
-    Matrix matProjection = rlGetMatrixProjection();
-
-    // Upload view matrix (if location available)
-    if (shader->locs[RLG_LOC_MATRIX_VIEW] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_VIEW], matView);
-
-    // Upload projection matrix (if location available)
-    if (shader->locs[RLG_LOC_MATRIX_PROJECTION] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_PROJECTION], matProjection);
+    if (source.data != panorama.data) UnloadImage(source);
 
-    // Model transformation matrix is sent to shader uniform location: RLG_LOC_MATRIX_MODEL
-    if (shader->locs[RLG_LOC_MATRIX_MODEL] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MODEL], transform);
+    return faces;
+}
 
-    // Accumulate several model transformations:
-    //    transform: model transformation provided (includes DrawModel() params combined with model.transform)
-    //    rlGetMatrixTransform(): rlgl internal transform matrix due to push/pop matrix stack
-    matModel = MatrixMultiply(transform, rlGetMatrixTransform());
+RLG_Skybox RLG_LoadSkyboxFaces(Image faces)
+{
+    RLG_Skybox skybox = { 0 };
 
-    // Get model-view matrix
-    matModelView = MatrixMultiply(matModel, matView);
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
 
-    // Upload model normal matrix (if locations available)
-    if (shader->locs[RLG_LOC_MATRIX_NORMAL] != -1)
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
-    //-----------------------------------------------------
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
 
-    // Bind active texture maps (if available)
-    for (int i = 0; i < 11; i++)
+    if (faces.data == NULL || faces.height != 6*faces.width)
     {
-        if (rlgCtx->material.data.useMaps[i])
-        {
-            int textureID = (rlgCtx->usedDefaultMaps[i])
-                ? rlgCtx->defaultMaps[i].texture.id
-                : material.maps[i].texture.id;
-
-            if (textureID > 0)
-            {
-                // Select current shader texture slot
-                rlActiveTextureSlot(i);
+        TraceLog(LOG_WARNING, "Skybox faces must be six square images stacked vertically");
+        return skybox;
+    }
 
-                // Enable texture for active slot
-                if (i == MATERIAL_MAP_IRRADIANCE ||
-                    i == MATERIAL_MAP_PREFILTER ||
-                    i == MATERIAL_MAP_CUBEMAP)
-                {
-                    rlEnableTextureCubemap(textureID);
-                }
-                else
-                {
-                    rlEnableTexture(textureID);
-                }
+    // Upload the faces as they are, one after the other
+    skybox.cubemap.id = rlLoadTextureCubemap(faces.data, faces.width, faces.format);
+    skybox.cubemap.width = faces.width;
+    skybox.cubemap.height = faces.width;
+    skybox.cubemap.mipmaps = 1;
+    skybox.cubemap.format = faces.format;
 
-                rlSetUniform(shader->locs[RLG_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
-            }
-        }
-    }
+    // Generate the irradiance and the reflection terms
+    RLG_GenSkyboxLighting(&skybox);
 
-    // Bind depth textures for shadow mapping
-    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
-    {
-        const struct RLG_Light *l = &rlgCtx->lights[i];
+    // Floating point faces are considered HDR
+    skybox.isHDR = (faces.format >= PIXELFORMAT_UNCOMPRESSED_R32 &&
+                    faces.format <= PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
 
-        if (l->data.enabled && l->data.shadow)
-        {
-            int j = 11 + i;
-            rlActiveTextureSlot(j);
+    return skybox;
+}
 
-            if (l->data.type == RLG_OMNILIGHT)
-            {
-                rlEnableTextureCubemap(l->data.shadowMap.depth.id);
-                rlSetUniform(l->locs.shadowCubemap, &j, SHADER_UNIFORM_INT, 1);
-            }
-            else
-            {
-                rlEnableTexture(l->data.shadowMap.depth.id);
-                rlSetUniform(l->locs.shadowMap, &j, SHADER_UNIFORM_INT, 1);
-            }
-        }
-    }
+#define RLG_SKYBOX_BAKE_VERSION 1
 
-    // Try binding vertex array objects (VAO) or use VBOs if not possible
-    // WARNING: UploadMesh() enables all vertex attributes available in mesh and sets default attribute values
-    // for shader expected vertex attributes that are not provided by the mesh (i.e. colors)
-    // This could be a dangerous approach because different meshes with different shaders can enable/disable some attributes
-    if (!rlEnableVertexArray(mesh.vaoId))
-    {
-        // Bind mesh VBO data: vertex position (shader-location = 0)
-        rlEnableVertexBuffer(mesh.vboId[0]);
-        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_POSITION]);
+// NOTE: Layout of the bake files: the header, then the half float RGB texels of the levels of the
+//       cubemap, the irradiance and the prefiltered cubemap, each level storing its six faces in order
+struct RLG_SkyboxBakeHeader
+{
+    char magic[4];                  ///< "RLGS"
+    int version;                    ///< RLG_SKYBOX_BAKE_VERSION
+    int isHDR;
+    int cubemapSize, cubemapMipmaps;    ///< Only the first level is stored, the others are generated at loading
+    int irradianceSize;                 ///< Zero if the irradiance was projected into spherical harmonics
+    int prefilterSize, prefilterMipmaps;
+    float irradianceSH[3*RLG_SH_COEFFICIENTS];
+};
 
-        // Bind mesh VBO data: vertex texcoords (shader-location = 1)
-        rlEnableVertexBuffer(mesh.vboId[1]);
-        rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD01]);
+#if GLSL_VERSION >= 330
+static unsigned short RLG_FloatToHalf(float value)
+{
+    unsigned int bits = 0;
+    memcpy(&bits, &value, sizeof(float));
 
-        if (shader->locs[RLG_LOC_VERTEX_NORMAL] != -1)
-        {
-            // Bind mesh VBO data: vertex normals (shader-location = 2)
-            rlEnableVertexBuffer(mesh.vboId[2]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_NORMAL]);
-        }
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    unsigned int mantissa = bits & 0x7FFFFF;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
 
-        // Bind mesh VBO data: vertex colors (shader-location = 3, if available)
-        if (shader->locs[RLG_LOC_VERTEX_COLOR] != -1)
-        {
-            if (mesh.vboId[3] != 0)
-            {
-                rlEnableVertexBuffer(mesh.vboId[3]);
-                rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
-                rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
-            }
-            else
-            {
-                // Set default value for defined vertex attribute in shader but not provided by mesh
-                // WARNING: It could result in GPU undefined behaviour
-                float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-                rlSetVertexAttributeDefault(shader->locs[RLG_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
-                rlDisableVertexAttribute(shader->locs[RLG_LOC_VERTEX_COLOR]);
-            }
-        }
+    // Values too large for a half float are clamped to the largest one (infinities and NaN included)
+    if (exponent >= 31) return sign | 0x7BFF;
 
-        // Bind mesh VBO data: vertex tangents (shader-location = 4, if available)
-        if (shader->locs[RLG_LOC_VERTEX_TANGENT] != -1)
-        {
-            rlEnableVertexBuffer(mesh.vboId[4]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TANGENT]);
-        }
+    // Values too small for a normal half float are stored as subnormals, or flushed to zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10) return sign;
 
-        // Bind mesh VBO data: vertex texcoords2 (shader-location = 5, if available)
-        if (shader->locs[RLG_LOC_VERTEX_TEXCOORD02] != -1)
-        {
-            rlEnableVertexBuffer(mesh.vboId[5]);
-            rlSetVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(shader->locs[RLG_LOC_VERTEX_TEXCOORD02]);
-        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        unsigned int half = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
 
-        if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
+        return sign | (unsigned short)half;
     }
 
-    int eyeCount = 1;
-    if (rlIsStereoRenderEnabled()) eyeCount = 2;
+    // Rounded to the nearest, a carry into the exponent is still a valid half float
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    half += (mantissa >> 12) & 1;
 
-    for (int eye = 0; eye < eyeCount; eye++)
-    {
-        // Calculate model-view-projection matrix (MVP)
-        Matrix matModelViewProjection = MatrixIdentity();
-        if (eyeCount == 1) matModelViewProjection = MatrixMultiply(matModelView, matProjection);
-        else
-        {
-            // Setup current eye viewport (half screen width)
-            rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
-            matModelViewProjection = MatrixMultiply(MatrixMultiply(matModelView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
-        }
+    return sign | (unsigned short)((half >= 0x7C00) ? 0x7BFF : half);
+}
+#endif
 
-        // Send combined model-view-projection matrix to shader
-        rlSetUniformMatrix(shader->locs[RLG_LOC_MATRIX_MVP], matModelViewProjection);
+static int RLG_GetBakedCubemapSize(int size, int mipmaps)
+{
+    int bytes = 0;
 
-        // Draw mesh
-        if (mesh.indices != NULL) rlDrawVertexArrayElements(0, mesh.triangleCount*3, 0);
-        else rlDrawVertexArray(0, mesh.vertexCount);
+    for (int i = 0; i < mipmaps; i++)
+    {
+        int mipSize = (size >> i) > 0 ? (size >> i) : 1;
+        bytes += 6*mipSize*mipSize*3*(int)sizeof(unsigned short);
     }
 
-    // Unbind all bound texture maps
-    for (int i = 0; i < 11; i++)
+    return bytes;
+}
+
+#if GLSL_VERSION >= 330
+static bool RLG_WriteBakedCubemap(unsigned int fbo, TextureCubemap cubemap, int mipmaps, float *pixels, unsigned char **cursor)
+{
+    for (int i = 0; i < mipmaps; i++)
     {
-        if (rlgCtx->material.data.useMaps[i])
+        int mipSize = (cubemap.width >> i) > 0 ? (cubemap.width >> i) : 1;
+
+        for (int face = 0; face < 6; face++)
         {
-            // Select current shader texture slot
-            rlActiveTextureSlot(i);
+            if (!RLG_ReadCubemapFace(fbo, cubemap.id, face, i, mipSize, pixels)) return false;
 
-            // Disable texture for active slot
-            if (i == MATERIAL_MAP_IRRADIANCE ||
-                i == MATERIAL_MAP_PREFILTER ||
-                i == MATERIAL_MAP_CUBEMAP)
-            {
-                rlDisableTextureCubemap();
-            }
-            else
+            // NOTE: The alpha channel is dropped, the skybox textures are opaque
+            unsigned short *texels = (unsigned short*)*cursor;
+
+            for (int j = 0; j < mipSize*mipSize; j++)
             {
-                rlDisableTexture();
+                texels[3*j + 0] = RLG_FloatToHalf(pixels[4*j + 0]);
+                texels[3*j + 1] = RLG_FloatToHalf(pixels[4*j + 1]);
+                texels[3*j + 2] = RLG_FloatToHalf(pixels[4*j + 2]);
             }
+
+            *cursor += 3*mipSize*mipSize*sizeof(unsigned short);
         }
     }
 
-    // Unbind depth textures
-    for (int i = 0; i < RLG_MAX_LIGHTS_PER_MATERIAL; i++)
+    return true;
+}
+#endif
+
+static TextureCubemap RLG_LoadBakedCubemap(int size, int mipmaps, const unsigned char **cursor)
+{
+    TextureCubemap cubemap = { 0 };
+    if (size <= 0) return cubemap;
+
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    rlGetGlTextureFormats(PIXELFORMAT_UNCOMPRESSED_R16G16B16, &glInternalFormat, &glFormat, &glType);
+
+    glGenTextures(1, &cubemap.id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // The faces are uploaded straight from the file data, in the order they are stored
+    for (int i = 0; i < mipmaps; i++)
     {
-        const struct RLG_Light *l = &rlgCtx->lights[i];
+        int mipSize = (size >> i) > 0 ? (size >> i) : 1;
 
-        if (l->data.enabled && l->data.shadow)
+        for (int face = 0; face < 6; face++)
         {
-            rlActiveTextureSlot(11 + i);
-
-            if (l->data.type == RLG_OMNILIGHT)
-            {
-                rlDisableTextureCubemap();
-            }
-            else
-            {
-                rlDisableTexture();
-            }
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, i, glInternalFormat, mipSize, mipSize, 0, glFormat, glType, *cursor);
+            *cursor += 3*mipSize*mipSize*sizeof(unsigned short);
         }
     }
 
-    // Disable all possible vertex array objects (or VBOs)
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
+#if GLSL_VERSION >= 330
+    if (mipmaps > 1) glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, mipmaps - 1);
+#endif
 
-    // Disable shader program
-    rlDisableShader();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (mipmaps > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#if GLSL_VERSION >= 330
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#endif
 
-    // Restore rlgl internal modelview and projection matrices
-    rlSetMatrixModelview(matView);
-    rlSetMatrixProjection(matProjection);
-}
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-void RLG_DrawModel(Model model, Vector3 position, float scale, Color tint)
-{
-    Vector3 vScale = { scale, scale, scale };
-    Vector3 rotationAxis = { 0.0f, 1.0f, 0.0f };
+    cubemap.width = size;
+    cubemap.height = size;
+    cubemap.mipmaps = mipmaps;
+    cubemap.format = PIXELFORMAT_UNCOMPRESSED_R16G16B16;
 
-    RLG_DrawModelEx(model, position, rotationAxis, 0.0f, vScale, tint);
+    return cubemap;
 }
 
-void RLG_DrawModelEx(Model model, Vector3 position, Vector3 rotationAxis, float rotationAngle, Vector3 scale, Color tint)
+bool RLG_SaveSkyboxBake(RLG_Skybox skybox, const char* fileName)
 {
-    Matrix matScale = MatrixScale(scale.x, scale.y, scale.z);
-    Matrix matRotation = MatrixRotate(rotationAxis, rotationAngle*DEG2RAD);
-    Matrix matTranslation = MatrixTranslate(position.x, position.y, position.z);
+#if GLSL_VERSION >= 330
+    if (skybox.cubemap.id == 0) return false;
 
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-    model.transform = MatrixMultiply(model.transform, matTransform);
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
 
-    for (int i = 0; i < model.meshCount; i++)
-    {
-        Color color = model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color;
+    struct RLG_SkyboxBakeHeader header = { 0 };
 
-        Color colorTint = WHITE;
-        colorTint.r = (unsigned char)((color.r*tint.r)/255);
-        colorTint.g = (unsigned char)((color.g*tint.g)/255);
-        colorTint.b = (unsigned char)((color.b*tint.b)/255);
-        colorTint.a = (unsigned char)((color.a*tint.a)/255);
+    memcpy(header.magic, "RLGS", 4);
+    header.version = RLG_SKYBOX_BAKE_VERSION;
+    header.isHDR = (int)skybox.isHDR;
+    header.cubemapSize = skybox.cubemap.width;
+    header.cubemapMipmaps = skybox.cubemap.mipmaps;
+    header.irradianceSize = (skybox.irradiance.id != 0) ? skybox.irradiance.width : 0;
+    header.prefilterSize = (skybox.prefilter.id != 0) ? skybox.prefilter.width : 0;
+    header.prefilterMipmaps = (skybox.prefilter.id != 0) ? skybox.prefilter.mipmaps : 0;
+    memcpy(header.irradianceSH, skybox.irradianceSH, sizeof(header.irradianceSH));
 
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = colorTint;
-        RLG_DrawMesh(model.meshes[i], model.materials[model.meshMaterial[i]], model.transform);
-        model.materials[model.meshMaterial[i]].maps[MATERIAL_MAP_DIFFUSE].color = color;
-    }
-}
+    int size = (int)sizeof(header)
+        + RLG_GetBakedCubemapSize(header.cubemapSize, 1)
+        + RLG_GetBakedCubemapSize(header.irradianceSize, (header.irradianceSize > 0) ? 1 : 0)
+        + RLG_GetBakedCubemapSize(header.prefilterSize, header.prefilterMipmaps);
 
-RLG_Skybox RLG_LoadSkybox(const char* skyboxFileName)
-{
-    RLG_Skybox skybox = { 0 };
+    // NOTE: The irradiance and prefiltered sizes are clamped to a minimum, they can exceed the cubemap size
+    int maxSize = header.cubemapSize;
+    if (header.irradianceSize > maxSize) maxSize = header.irradianceSize;
+    if (header.prefilterSize > maxSize) maxSize = header.prefilterSize;
 
-    // Load the cubemap texture from the image file
-    Image img = LoadImage(skyboxFileName);
-    skybox.cubemap = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT);
-    UnloadImage(img);
+    unsigned char *data = (unsigned char*)malloc(size);
+    float *pixels = (float*)malloc(4*maxSize*maxSize*sizeof(float));
+    unsigned int fbo = rlLoadFramebuffer(maxSize, maxSize);
 
-    // Generate Irradiance Cubemap
-    {
-        int size = skybox.cubemap.width / 16;
-        size = (size < 8) ? 8 : size;
+    bool success = (data != NULL && pixels != NULL && fbo != 0);
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+    if (success)
+    {
+        unsigned char *cursor = data + sizeof(header);
+        memcpy(data, &header, sizeof(header));
 
-        // Create a cubemap texture to hold the HDR data
-        skybox.irradiance.id = rlLoadTextureCubemap(NULL, size, skybox.cubemap.format);
-        rlCubemapParameters(skybox.irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
-        rlCubemapParameters(skybox.irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+        success = RLG_WriteBakedCubemap(fbo, skybox.cubemap, 1, pixels, &cursor);
 
-        // Create and configure the framebuffer
-        unsigned int fbo = rlLoadFramebuffer(size, size);
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+        if (success && header.irradianceSize > 0)
+        {
+            success = RLG_WriteBakedCubemap(fbo, skybox.irradiance, 1, pixels, &cursor);
+        }
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
+        if (success && header.prefilterSize > 0)
         {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
-        }  
+            success = RLG_WriteBakedCubemap(fbo, skybox.prefilter, header.prefilterMipmaps, pixels, &cursor);
+        }
 
-        // Enable the shader for converting HDR equirectangular environment map to cubemap faces
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+        if (!success) TraceLog(LOG_WARNING, "Failed to read the skybox textures back, [%s] is not saved", fileName);
+    }
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    if (success)
+    {
+        success = SaveFileData(fileName, data, size);
+    }
+
+    if (fbo != 0) rlUnloadFramebuffer(fbo);
+    free(pixels);
+    free(data);
+
+    return success;
+#else
+    // NOTE: The textures could only be read back with 8 bits per channel, which clamps the HDR skyboxes
+    (void)skybox;
+    TraceLog(LOG_WARNING, "Skybox bakes require GLSL 330 or higher, [%s] is not saved", fileName);
+    return false;
+#endif
+}
+
+RLG_Skybox RLG_LoadSkyboxBake(const char* fileName)
+{
+    RLG_Skybox skybox = { 0 };
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
-        };
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
+
+    int size = 0;
+    unsigned char *data = LoadFileData(fileName, &size);
+    if (data == NULL) return skybox;
+
+    struct RLG_SkyboxBakeHeader header = { 0 };
+    if (size >= (int)sizeof(header)) memcpy(&header, data, sizeof(header));
+
+    // The texel data must match the sizes of the header
+    // NOTE: The sizes are bounded first, so that the size of the data cannot overflow
+    bool valid = (memcmp(header.magic, "RLGS", 4) == 0 && header.version == RLG_SKYBOX_BAKE_VERSION &&
+        header.cubemapSize > 0 && header.cubemapSize <= 4096 &&
+        header.cubemapMipmaps >= 0 && header.cubemapMipmaps <= 13 &&
+        (header.cubemapMipmaps <= 1 || (header.cubemapSize >> (header.cubemapMipmaps - 1)) > 0) &&
+        header.irradianceSize >= 0 && header.irradianceSize <= 4096 &&
+        header.prefilterSize >= 0 && header.prefilterSize <= 4096 &&
+        header.prefilterMipmaps >= 0 && header.prefilterMipmaps <= 13 && size == (int)sizeof(header)
+            + RLG_GetBakedCubemapSize(header.cubemapSize, 1)
+            + RLG_GetBakedCubemapSize(header.irradianceSize, (header.irradianceSize > 0) ? 1 : 0)
+            + RLG_GetBakedCubemapSize(header.prefilterSize, header.prefilterMipmaps));
+
+    if (!valid)
+    {
+        TraceLog(LOG_WARNING, "File [%s] is not a valid skybox bake", fileName);
+        UnloadFileData(data);
+        return skybox;
+    }
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, size, size);
-        rlDisableBackfaceCulling();
+    // NOTE: Below GLSL 330, the half float textures need an extension (e.g. OES_texture_half_float)
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    rlGetGlTextureFormats(PIXELFORMAT_UNCOMPRESSED_R16G16B16, &glInternalFormat, &glFormat, &glType);
 
-        // Activate the panorama texture
-        rlActiveTextureSlot(0);
-        rlEnableTextureCubemap(skybox.cubemap.id);
+    if (glInternalFormat == 0)
+    {
+        TraceLog(LOG_WARNING, "Skybox bake [%s] cannot be loaded, half float textures are not supported", fileName);
+        UnloadFileData(data);
+        return skybox;
+    }
 
-        for (int i = 0; i < 6; i++)
-        {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+    if (header.prefilterMipmaps > 0 && header.prefilterMipmaps != RLG_PREFILTER_MIP_LEVELS)
+    {
+        TraceLog(LOG_WARNING, "Skybox bake [%s] has %i prefiltered levels instead of %i, rough reflections will be off",
+            fileName, header.prefilterMipmaps, RLG_PREFILTER_MIP_LEVELS);
+    }
 
-            // Clear the framebuffer and draw the cube face
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
-        }
+    const unsigned char *cursor = data + sizeof(header);
 
-        // Disable the shader and textures
-        rlDisableShader();
+    skybox.cubemap = RLG_LoadBakedCubemap(header.cubemapSize, 1, &cursor);
+    skybox.irradiance = RLG_LoadBakedCubemap(header.irradianceSize, 1, &cursor);
+    skybox.prefilter = RLG_LoadBakedCubemap(header.prefilterSize, header.prefilterMipmaps, &cursor);
+
+    // The other levels of the cubemap are generated on the GPU, as when the skybox was generated
+    if (header.cubemapMipmaps > 1)
+    {
+        rlEnableTextureCubemap(skybox.cubemap.id);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         rlDisableTextureCubemap();
-        rlDisableFramebuffer();
 
-        // Unload the framebuffer and its attachments
-        rlUnloadFramebuffer(fbo);
+        skybox.cubemap.mipmaps = header.cubemapMipmaps;
+    }
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+    memcpy(skybox.irradianceSH, header.irradianceSH, sizeof(header.irradianceSH));
+    skybox.isHDR = (header.isHDR != 0);
 
-        // Set the cubemap properties
-        skybox.cubemap.width = size;
-        skybox.cubemap.height = size;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = skybox.cubemap.format;
-    }
+    if (skybox.prefilter.id != 0) skybox.brdf = RLG_GetBRDFLUT();
+
+    UnloadFileData(data);
 
     return skybox;
 }
 
-RLG_Skybox RLG_LoadSkyboxHDR(const char* skyboxFileName, int size, int format)
+#if GLSL_VERSION >= 330
+static void RLG_BeginSkyboxUpdate(struct RLG_SkyboxUpdate *u, RLG_Skybox *skybox)
 {
-    RLG_Skybox skybox = { 0 };
+    RLG_Skybox *back = &u->back;
 
-    // Create a framebuffer object (FBO) to generate the skybox and irradiance map
-    unsigned int fbo = rlLoadFramebuffer(0, 0);
+    int size = skybox->cubemap.width;
+    int irradianceSize = (skybox->irradiance.id != 0) ? skybox->irradiance.width : 0;
+    int prefilterSize = (skybox->prefilter.id != 0) ? skybox->prefilter.width : 0;
 
-    // Generate the cubemap for the skybox
+    // The back set is kept between the updates, after a swap it holds the previous textures of the skybox
+    bool valid = (back->cubemap.id != 0 && back->cubemap.width == size && back->cubemap.format == skybox->cubemap.format
+        && ((back->irradiance.id != 0) ? back->irradiance.width : 0) == irradianceSize
+        && ((back->prefilter.id != 0) ? back->prefilter.width : 0) == prefilterSize
+        && (prefilterSize == 0 || back->prefilter.mipmaps == RLG_PREFILTER_MIP_LEVELS));
+
+    if (!valid)
     {
-        // Load the HDR panorama texture
-        Texture2D panorama = LoadTexture(skyboxFileName);
+        if (back->cubemap.id != 0) RLG_UnloadSkybox(*back);
+        *back = INIT_STRUCT_ZERO(RLG_Skybox);
+
+        // NOTE: The mip levels of the cubemap are generated by a pass of the update
+        back->cubemap.id = rlLoadTextureCubemap(NULL, size, skybox->cubemap.format);
+        rlCubemapParameters(back->cubemap.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+        rlCubemapParameters(back->cubemap.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+        back->cubemap.width = back->cubemap.height = size;
+        back->cubemap.mipmaps = 1 + (int)floorf(log2f((float)size));
+        back->cubemap.format = skybox->cubemap.format;
+
+        if (irradianceSize > 0)
+        {
+            back->irradiance.id = rlLoadTextureCubemap(NULL, irradianceSize, skybox->irradiance.format);
+            rlCubemapParameters(back->irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
+            rlCubemapParameters(back->irradiance.id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+            back->irradiance.width = back->irradiance.height = irradianceSize;
+            back->irradiance.mipmaps = 1;
+            back->irradiance.format = skybox->irradiance.format;
+        }
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(size, size, true);
+        if (prefilterSize > 0)
+        {
+            back->prefilter = RLG_LoadPrefilterCubemap(prefilterSize, skybox->prefilter.format);
+        }
+    }
 
-        // Create a cubemap texture to hold the HDR data
-        skybox.cubemap.id = rlLoadTextureCubemap(NULL, size, format);
+    if (u->fbo[0] == 0)
+    {
+        u->fbo[0] = rlLoadFramebuffer(size, size);
+        u->fbo[1] = rlLoadFramebuffer(size, size);
+    }
 
-        // Configure the framebuffer with the renderbuffer and cubemap texture
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+    // Without irradiance cubemap, the faces are read back and projected into spherical harmonics
+    if (irradianceSize > 0 || u->sh == NULL || u->sh->size != size)
+    {
+        free(u->sh);
+        free(u->pixels);
+        u->sh = NULL;
+        u->pixels = NULL;
+    }
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
+    if (irradianceSize == 0 && u->sh == NULL)
+    {
+        u->sh = (struct RLG_SHProjection*)calloc(1, sizeof(struct RLG_SHProjection));
+        u->pixels = (float*)malloc(4*size*size*sizeof(float));
+
+        if (u->sh == NULL || u->pixels == NULL)
         {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
+            free(u->sh);
+            free(u->pixels);
+            u->sh = NULL;
+            u->pixels = NULL;
+        }
+        else
+        {
+            u->sh->pixels = u->pixels;
+            u->sh->size = size;
+            u->sh->bands = (size < RLG_MAX_WORKER_THREADS) ? size : RLG_MAX_WORKER_THREADS;
         }
+    }
 
-        // Enable the shader to convert the HDR equirectangular map to cubemap faces
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].id);
+    if (u->sh != NULL) memset(u->sh->sums, 0, sizeof(u->sh->sums));
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    back->brdf = skybox->brdf;
+    back->isHDR = skybox->isHDR;
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
-        };
+    // Passes: 6 face copies, the mip levels of the cubemap, 6 irradiance faces, then each face of each prefiltered level
+    u->target = skybox;
+    u->pass = 0;
+    u->passCount = 13 + ((prefilterSize > 0) ? 6*RLG_PREFILTER_MIP_LEVELS : 0);
+}
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, size, size);
-        rlDisableBackfaceCulling();
+static void RLG_RenderSkyboxUpdatePass(struct RLG_SkyboxUpdate *u, TextureCubemap source, int pass)
+{
+    RLG_Skybox *back = &u->back;
 
-        // Activate the panorama texture
-        rlActiveTextureSlot(0);
-        rlEnableTexture(panorama.id);
+    // Copy a face of the source, scaled to the size of the skybox
+    if (pass < 6)
+    {
+        rlFramebufferAttach(u->fbo[1], source.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + pass, 0);
+        rlFramebufferAttach(u->fbo[0], back->cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + pass, 0);
 
-        for (int i = 0; i < 6; i++)
-        {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_EQUIRECTANGULAR_TO_CUBEMAP].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.cubemap.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, u->fbo[1]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, u->fbo[0]);
+        glBlitFramebuffer(0, 0, source.width, source.height, 0, 0, back->cubemap.width, back->cubemap.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        rlDisableFramebuffer();
+        return;
+    }
 
-            // Clear the framebuffer and draw the cube
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
-        }
+    // Generate the mip levels read by the prefilter convolution
+    if (pass == 6)
+    {
+        rlEnableTextureCubemap(back->cubemap.id);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        rlDisableTextureCubemap();
+        return;
+    }
 
-        // Disable the shader and textures
-        rlDisableShader();
-        rlDisableTexture();
-        rlDisableFramebuffer();
+    int face = (pass - 7)%6;
+    bool irradiance = (pass < 13);
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+    // Read back an irradiance face and add its projection to the sums of the worker threads
+    if (irradiance && u->sh != NULL)
+    {
+        u->sh->face = face;
 
-        // Set the cubemap properties
-        skybox.cubemap.width = size;
-        skybox.cubemap.height = size;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = format;
+        if (RLG_ReadCubemapFace(u->fbo[0], back->cubemap.id, face, 0, back->cubemap.width, u->pixels))
+        {
+            RLG_RunJobs(RLG_ProjectSHBand, u->sh, u->sh->bands);
+        }
 
-        // Unload the panorama texture as it's no longer needed
-        UnloadTexture(panorama);
+        return;
     }
 
-    // Generate the irradiance cubemap
+    // Otherwise convolve a face of the irradiance, or a face of a level of the prefiltered cubemap
+    int mip = irradiance ? 0 : (pass - 13)/6;
+    TextureCubemap target = irradiance ? back->irradiance : back->prefilter;
+    Shader shader = rlgCtx->shaders[irradiance ? RLG_SHADER_IRRADIANCE_CONVOLUTION : RLG_SHADER_PREFILTER_CONVOLUTION];
+
+    rlEnableShader(shader.id);
+
+    if (!irradiance)
     {
-        int irrSize = skybox.cubemap.width / 16;
-        irrSize = (irrSize < 8) ? 8 : irrSize;
+        float roughness = (float)mip/(RLG_PREFILTER_MIP_LEVELS - 1);
+        float resolution = (float)back->cubemap.width;
+        rlSetUniform(rlgCtx->skybox.locPrefilterRoughness, &roughness, SHADER_UNIFORM_FLOAT, 1);
+        rlSetUniform(rlgCtx->skybox.locPrefilterResolution, &resolution, SHADER_UNIFORM_FLOAT, 1);
+    }
 
-        // Create a renderbuffer for depth attachment
-        unsigned int rbo = rlLoadTextureDepth(irrSize, irrSize, true);
+    // Set the projection and the view matrix of the face
+    const float (*axis)[3] = G_CubemapAxes[face];
 
-        // Create a cubemap texture to hold the irradiance data
-        skybox.irradiance.id = rlLoadTextureCubemap(NULL, irrSize, skybox.cubemap.format);
-        rlCubemapParameters(skybox.irradiance.id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_LINEAR);
-        rlCubemapParameters(skybox.irradiance.id, GL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_LINEAR);
+    Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+    Matrix matFboView = MatrixLookAt(INIT_STRUCT_ZERO(Vector3),
+        INIT_STRUCT(Vector3, axis[0][0], axis[0][1], axis[0][2]),
+        INIT_STRUCT(Vector3, axis[2][0], axis[2][1], axis[2][2]));
 
-        // Create and configure the framebuffer
-        unsigned int fbo = rlLoadFramebuffer(irrSize, irrSize);
-        rlFramebufferAttach(fbo, rbo, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
-        rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X, 0);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], matFboView);
 
-        // Validate the framebuffer configuration
-        if (rlFramebufferComplete(fbo))
-        {
-            TraceLog(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", fbo);
-        }
+    rlActiveTextureSlot(0);
+    rlEnableTextureCubemap(back->cubemap.id);
 
-        // Enable the shader for irradiance convolution
-        rlEnableShader(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].id);
+    // Attach the face of the level to the framebuffer, then draw the cube
+    rlFramebufferAttach(u->fbo[0], target.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + face, mip);
+    rlEnableFramebuffer(u->fbo[0]);
+    rlViewport(0, 0, target.width >> mip, target.width >> mip);
 
-        // Set the projection matrix for the shader
-        Matrix matFboProjection = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
-        rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_PROJECTION], matFboProjection);
+    rlClearScreenBuffers();
+    rlLoadDrawCube();
 
-        // Define view matrices for each cubemap face
-        Matrix fboViews[6] = {
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3, -1.0f,  0.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f,  1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f, -1.0f,  0.0f), INIT_STRUCT(Vector3, 0.0f,  0.0f, -1.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f,  1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f)),
-            MatrixLookAt(INIT_STRUCT_ZERO(Vector3), INIT_STRUCT(Vector3,  0.0f,  0.0f, -1.0f), INIT_STRUCT(Vector3, 0.0f, -1.0f,  0.0f))
-        };
+    rlDisableTextureCubemap();
+    rlDisableShader();
+    rlDisableFramebuffer();
+}
+#endif
 
-        // Set the viewport to match the framebuffer dimensions
-        rlViewport(0, 0, irrSize, irrSize);
-        rlDisableBackfaceCulling();
+bool RLG_UpdateSkybox(RLG_Skybox *skybox, TextureCubemap source, int budget)
+{
+#if GLSL_VERSION >= 330
+    struct RLG_SkyboxUpdate *u = &rlgCtx->skyboxUpdate;
 
-        // Activate the cubemap texture
-        rlActiveTextureSlot(0);
-        rlEnableTextureCubemap(skybox.cubemap.id);
+    if (skybox == NULL || skybox->cubemap.id == 0 || source.id == 0)
+    {
+        TraceLog(LOG_ERROR, "The skybox or the source cubemap specified to 'RLG_UpdateSkybox' is invalid");
+        return false;
+    }
 
-        for (int i = 0; i < 6; i++)
-        {
-            // Set the view matrix for the current cubemap face
-            rlSetUniformMatrix(rlgCtx->shaders[RLG_SHADER_IRRADIANCE_CONVOLUTION].locs[SHADER_LOC_MATRIX_VIEW], fboViews[i]);
-            
-            // Attach the current cubemap face to the framebuffer
-            rlFramebufferAttach(fbo, skybox.irradiance.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_CUBEMAP_POSITIVE_X + i, 0);
-            rlEnableFramebuffer(fbo);
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
 
-            // Clear the framebuffer and draw the cube
-            rlClearScreenBuffers();
-            rlLoadDrawCube();
-        }
+    // Render what was batched into the current framebuffer, then unbind the state left by the draws
+    rlDrawRenderBatchActive();
+    RLG_RestoreState();
 
-        // Disable the shader and textures
-        rlDisableShader();
-        rlDisableTextureCubemap();
-        rlDisableFramebuffer();
+    // An update starts once the previous one is swapped, or when another skybox is given
+    if (u->target != skybox)
+    {
+        RLG_BeginSkyboxUpdate(u, skybox);
+    }
 
-        // Reset the viewport to default dimensions
-        rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-        rlEnableBackfaceCulling();
+    if (u->sh == NULL && skybox->irradiance.id == 0)
+    {
+        TraceLog(LOG_WARNING, "Failed to allocate the spherical harmonics projection of the skybox update");
+        u->target = NULL;
+        return false;
+    }
 
-        // Set the cubemap properties
-        skybox.cubemap.width = irrSize;
-        skybox.cubemap.height = irrSize;
-        skybox.cubemap.mipmaps = 1;
-        skybox.cubemap.format = skybox.cubemap.format;
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    rlDisableBackfaceCulling();
+    rlDisableDepthTest();
+
+    for (int i = 0; i < budget && u->pass < u->passCount; i++)
+    {
+        RLG_RenderSkyboxUpdatePass(u, source, u->pass++);
     }
 
-    // Unload the framebuffer
-    rlUnloadFramebuffer(fbo);
+    // Reset the viewport and the state of the current render target
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+    rlEnableBackfaceCulling();
+    if (depthTest) rlEnableDepthTest();
 
-    // Indicate that the texture used is HDR
-    skybox.isHDR = true;
+    if (u->pass < u->passCount) return false;
 
-    return skybox;
+    // All the passes are rendered, the back set replaces the textures of the skybox at once
+    if (u->sh != NULL) RLG_GetProjectedSH(u->sh, u->back.irradianceSH);
+
+    RLG_Skybox front = *skybox;
+
+    skybox->cubemap = u->back.cubemap;
+    skybox->irradiance = u->back.irradiance;
+    skybox->prefilter = u->back.prefilter;
+    memcpy(skybox->irradianceSH, u->back.irradianceSH, sizeof(skybox->irradianceSH));
+
+    // NOTE: The previous textures become the back set of the next update, nothing is reallocated
+    u->back.cubemap = front.cubemap;
+    u->back.irradiance = front.irradiance;
+    u->back.prefilter = front.prefilter;
+    u->target = NULL;
+
+    return true;
+#else
+    (void)skybox; (void)source; (void)budget;
+    TraceLog(LOG_WARNING, "Incremental skybox updates require GLSL 330 or higher");
+    return false;
+#endif
 }
 
 void RLG_UnloadSkybox(RLG_Skybox skybox)
 {
     UnloadTexture(skybox.cubemap);
     UnloadTexture(skybox.irradiance);
+    UnloadTexture(skybox.prefilter);
+
+    // NOTE: The BRDF lookup texture belongs to the context
 }
 
 void RLG_DrawSkybox(RLG_Skybox skybox)
 {
-    Shader *shader = &rlgCtx->shaders[RLG_SHADER_SKYBOX];
+    // Wait for the shaders of the context if they are still compiling
+    if (!rlgCtx->ready) RLG_UpdateContextShaders(rlgCtx, true);
+
+    bool fullscreen = rlgCtx->useSkyboxDepthTest;
+    Shader *shader = &rlgCtx->shaders[fullscreen ? RLG_SHADER_SKYBOX_FULLSCREEN : RLG_SHADER_SKYBOX];
+
+    // Unbind the state left by the draws of a batch
+    RLG_RestoreState();
 
     // Bind shader program
-    rlEnableShader(shader->id);
+    RLG_EnableShader(shader->id);
 
     if (rlgCtx->skybox.previousCubemapID != skybox.cubemap.id)
     {
         int isHDR = (int)skybox.isHDR;
-        rlSetUniform(rlgCtx->skybox.locDoGamma, &isHDR, SHADER_UNIFORM_INT, 1);
+        RLG_SetUniform(fullscreen ? rlgCtx->skybox.locDoGammaFullscreen : rlgCtx->skybox.locDoGamma, &isHDR, SHADER_UNIFORM_INT, 1);
         rlgCtx->skybox.previousCubemapID = skybox.cubemap.id;
     }
 
     rlDisableBackfaceCulling();
     rlDisableDepthMask();
 
+    // The fullscreen triangle is at depth 1.0, only the pixels not covered by the scene pass the test
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    if (fullscreen)
+    {
+        rlEnableDepthTest();
+        glDepthFunc(GL_LEQUAL);
+    }
+
     // Get current view/projection matrices
     Matrix matView = rlGetMatrixModelview();
     Matrix matProjection = rlGetMatrixProjection();
 
     // Upload view and projection matrices (if locations available)
-    if (shader->locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_VIEW], matView);
-    if (shader->locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+    if (shader->locs[SHADER_LOC_MATRIX_VIEW] != -1) RLG_SetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_VIEW], matView);
+    if (shader->locs[SHADER_LOC_MATRIX_PROJECTION] != -1) RLG_SetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
 
     // Bind cubemap texture (if available)
     if (skybox.cubemap.id > 0)
@@ -3818,6 +10104,7 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
     {
         // Calculate model-view-projection matrix (MVP)
         Matrix matModelViewProjection = MatrixIdentity();
+        Matrix matViewEye = matView;
         if (eyeCount == 1)
         {
             matModelViewProjection = MatrixMultiply(matView, matProjection);
@@ -3826,11 +10113,25 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
         {
             // Setup current eye viewport (half screen width)
             rlViewport(eye*rlGetFramebufferWidth()/2, 0, rlGetFramebufferWidth()/2, rlGetFramebufferHeight());
-            matModelViewProjection = MatrixMultiply(MatrixMultiply(matView, rlGetMatrixViewOffsetStereo(eye)), rlGetMatrixProjectionStereo(eye));
+            matViewEye = MatrixMultiply(matView, rlGetMatrixViewOffsetStereo(eye));
+            matModelViewProjection = MatrixMultiply(matViewEye, rlGetMatrixProjectionStereo(eye));
+        }
+
+        if (fullscreen)
+        {
+            // The sky is at an infinite distance, the view rays are unprojected without the translation
+            matViewEye.m12 = matViewEye.m13 = matViewEye.m14 = 0.0f;
+            Matrix matProjectionEye = (eyeCount == 1) ? matProjection : rlGetMatrixProjectionStereo(eye);
+            Matrix matInvViewProj = MatrixInvert(MatrixMultiply(matViewEye, matProjectionEye));
+            RLG_SetUniformMatrix(rlgCtx->skybox.locInvViewProj, matInvViewProj);
+
+            // Draw the fullscreen triangle, stored after the cube vertices
+            rlDrawVertexArray(8, 3);
+            continue;
         }
 
         // Send combined model-view-projection matrix to shader
-        rlSetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
+        RLG_SetUniformMatrix(shader->locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
 
         // Draw mesh
         if (rlgCtx->skybox.ebo != 0)
@@ -3856,7 +10157,7 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
     rlDisableVertexBufferElement();
 
     // Disable shader program
-    rlDisableShader();
+    RLG_DisableShader();
 
     // Restore rlgl internal modelview and projection matrices
     rlSetMatrixModelview(matView);
@@ -3864,76 +10165,17 @@ void RLG_DrawSkybox(RLG_Skybox skybox)
 
     rlEnableBackfaceCulling();
     rlEnableDepthMask();
+    if (fullscreen && !depthTest) rlDisableDepthTest();
 }
 
 /* Helper Function Declarations */
 
 unsigned int EXT_LoadShaderEx(const char** vsCodes, const char** fsCodes, int vsCount, int fsCount)
 {
-    GLint success;
-    GLchar infoLog[512];
-
-    /* Compile Vertex Shader */
-
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vs, vsCount, vsCodes, 0);
-    glCompileShader(vs);
-
-    glGetShaderiv(vs, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vs, sizeof(infoLog), 0, infoLog);
-        TraceLog(LOG_ERROR, "Failed to compile vertex shader: %s\n", infoLog);
-        glDeleteShader(vs);
-        return 0;
-    }
-
-    /* Compile Fragment Shader */
-
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fs, fsCount, fsCodes, 0);
-    glCompileShader(fs);
-
-    glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fs, sizeof(infoLog), 0, infoLog);
-        TraceLog(LOG_ERROR, "Failed to compile fragment shader: %s\n", infoLog);
-        glDeleteShader(fs);
-        return 0;
-    }
-
-    /* Link Shaders */
-
-    GLuint program = glCreateProgram();
-
-    if (program == 0) {
-        TraceLog(LOG_ERROR, "Failed to create shader program\n");
-        glDeleteShader(vs);
-        glDeleteShader(fs);
-        return 0;
-    }
+    struct RLG_PendingProgram pending = { 0 };
+    RLG_CompileProgram(&pending, vsCodes, fsCodes, NULL, vsCount, fsCount);
 
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-
-    glBindAttribLocation(program, 0, RLG_SHADER_ATTRIB_POSITION);
-    glBindAttribLocation(program, 1, RLG_SHADER_ATTRIB_TEXCOORD);
-    glBindAttribLocation(program, 2, RLG_SHADER_ATTRIB_NORMAL);
-    glBindAttribLocation(program, 3, RLG_SHADER_ATTRIB_COLOR);
-    glBindAttribLocation(program, 4, RLG_SHADER_ATTRIB_TANGENT);
-    glBindAttribLocation(program, 5, RLG_SHADER_ATTRIB_TEXCOORD2);
-
-    glLinkProgram(program);
-
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, sizeof(infoLog), 0, infoLog);
-        TraceLog(LOG_ERROR, "Failed to link program shader: %s\n", infoLog);
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    return program;
+    return RLG_FinishProgram(&pending);
 }
 
 #undef TOSTRING
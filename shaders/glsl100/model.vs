@@ -1,4 +1,6 @@
-#version 100
+// NOTE: Same code as the model vertex shader embedded in rlights.h, it is compiled after the
+//       '#version' directive, the 'NUM_LIGHTS' definition (RLG_MAX_LIGHTS_PER_MATERIAL) and the
+//       permutation defines added by rlights.h (see RLG_SetCustomShaderCode)
 
 attribute vec3 vertexPosition;
 attribute vec2 vertexTexCoord;
@@ -19,17 +21,20 @@ varying mat3 TBN;
 
 void main()
 {
-    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
+    mat4 modelMatrix = matModel;
+
+    fragPosition = vec3(modelMatrix*vec4(vertexPosition, 1.0));
     fragNormal = (matNormal*vec4(vertexNormal, 0.0)).xyz;
 
-    fragTexCoord = vertexTexCoord ;
-    fragColor = vertexColor ;
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
 
     // The TBN matrix is used to transform vectors from tangent space to world space
     // It is currently used to transform normals from a normal map to world space normals
-    vec3 T = normalize(vec3(matModel*vec4(vertexTangent.xyz, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix*vec4(vertexTangent.xyz, 0.0)));
     vec3 B = cross(fragNormal, T)*vertexTangent.w;
     TBN = mat3(T, B, fragNormal);
 
     gl_Position = mvp*vec4(vertexPosition, 1.0);
-}
\ No newline at end of file
+}
+
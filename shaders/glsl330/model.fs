@@ -1,57 +1,70 @@
-#version 330
+// NOTE: Same code as the model fragment shader embedded in rlights.h, it is compiled after the
+//       '#version' directive, the 'NUM_LIGHTS' definition (RLG_MAX_LIGHTS_PER_MATERIAL) and the
+//       permutation defines added by rlights.h (see RLG_SetCustomShaderCode)
 
-#define NUM_LIGHTS              %i
-#define NUM_MATERIAL_MAPS       7
-#define NUM_MATERIAL_CUBEMAPS   2
+#define TEX texture
+#define TEXCUBE texture
+#define TEXCUBELOD textureLod
 
-#define DIRLIGHT                0
-#define OMNILIGHT               1
-#define SPOTLIGHT               2
+#define NUM_MATERIAL_MAPS 8
+#define NUM_MATERIAL_CUBEMAPS 3
 
-#define ALBEDO                  0
-#define METALNESS               1
-#define NORMAL                  2
-#define ROUGHNESS               3
-#define OCCLUSION               4
-#define EMISSION                5
-#define HEIGHT                  6
+#define DIRLIGHT 0
+#define OMNILIGHT 1
+#define SPOTLIGHT 2
 
-#define CUBEMAP                 0
-#define IRRADIANCE              1
+#define ALBEDO 0
+#define METALNESS 1
+#define NORMAL 2
+#define ROUGHNESS 3
+#define OCCLUSION 4
+#define EMISSION 5
+#define HEIGHT 6
+#define BRDF 7
+
+#define CUBEMAP 0
+#define IRRADIANCE 1
+#define PREFILTER 2
+
+#define PREFILTER_MAX_LOD (float(5) - 1.0)   // 5 is RLG_PREFILTER_MIP_LEVELS
 
 #define PI 3.1415926535897932384626433832795028
 
 in vec4 fragPosLightSpace[NUM_LIGHTS];
+
 in vec3 fragPosition;
 in vec2 fragTexCoord;
 in vec3 fragNormal;
 in vec4 fragColor;
 in mat3 TBN;
 
-out vec4 outColor;
+#ifdef DEFERRED
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormal;
+layout(location = 2) out vec4 gORM;       ///< Direct light occlusion, roughness, metalness, specular light factor
+layout(location = 3) out vec4 gEmission;  ///< Emission, ambient and skybox reflection
+#else
+out vec4 _;
+#endif
 
 struct MaterialMap {
-    sampler2D texture;
     mediump vec4 color;
     mediump float value;
-    lowp int active;
+    lowp int enabled;
 };
 
 struct MaterialCubemap {
-    samplerCube texture;
     mediump vec4 color;
     mediump float value;
-    lowp int active;
+    lowp int enabled;
 };
 
 struct Light {
-    samplerCube shadowCubemap;    ///< Sampler for the shadow map texture
-    sampler2D shadowMap;          ///< Sampler for the shadow map texture
     vec3 position;                ///< Position of the light in world coordinates
-    vec3 direction;               ///< Direction vector of the light (for directional and spotlights)
-    vec3 color;                   ///< Diffuse color of the light
     float energy;                 ///< Energy factor of the diffuse light color
+    vec3 direction;               ///< Direction vector of the light (for directional and spotlights)
     float specular;               ///< Specular amount of the light
+    vec3 color;                   ///< Diffuse color of the light
     float size;                   ///< Light size (spotlight, omnilight only)
     float innerCutOff;            ///< Inner cutoff angle for spotlights (cosine of the angle)
     float outerCutOff;            ///< Outer cutoff angle for spotlights (cosine of the angle)
@@ -62,20 +75,68 @@ struct Light {
     lowp int type;                ///< Type of the light (e.g., point, directional, spotlight)
     lowp int shadow;              ///< Indicates if the light casts shadows (1 for true, 0 for false)
     lowp int enabled;             ///< Indicates if the light is active (1 for true, 0 for false)
+    lowp int cascades;            ///< Number of shadow cascades of directional lights, 1 without cascades (GLSL 330 or higher)
+    vec4 shadowRect;              ///< Area of the light in the shadow atlas (offset and size of one tile in UV)
 };
 
-uniform MaterialCubemap cubemaps[NUM_MATERIAL_CUBEMAPS];
-uniform MaterialMap maps[NUM_MATERIAL_MAPS];
-uniform Light lights[NUM_LIGHTS];
+// NOTE: Must be identical in the vertex and fragment shaders, 4 is RLG_MAX_SHADOW_CASCADES
+layout(std140) uniform LightBlock {
+    Light lights[NUM_LIGHTS];
+    mat4 matLights[NUM_LIGHTS];
+    mat4 matCascades[NUM_LIGHTS*4];
+    vec4 cascadeSplits[NUM_LIGHTS]; ///< View depth at which each cascade ends
+};
 
-uniform lowp int parallaxMinLayers;
-uniform lowp int parallaxMaxLayers;
+layout(std140) uniform MaterialBlock {
+    MaterialMap maps[NUM_MATERIAL_MAPS];
+    MaterialCubemap cubemaps[NUM_MATERIAL_CUBEMAPS];
+    lowp int parallaxMinLayers;
+    lowp int parallaxMaxLayers;
+};
+
+// NOTE: Samplers are kept out of the structs, they cannot be stored in uniform blocks
+uniform sampler2D mapTextures[NUM_MATERIAL_MAPS];
+uniform samplerCube cubemapTextures[NUM_MATERIAL_CUBEMAPS];
+uniform sampler2DShadow shadowAtlas; ///< Shadow maps of all the lights, each one reads its area of the atlas
+
+uniform samplerBuffer clusterLights;  ///< Light records of the clustered lights (4 texels per light)
+uniform usamplerBuffer clusterItems;  ///< Offset and count of each cluster, followed by the light indices
+uniform ivec3 clusterGrid;            ///< Number of clusters along X, Y and Z
+uniform vec3 clusterDepth;            ///< Depth slice scale, bias and logarithmic distribution flag
+uniform lowp int useClusters;
+
+uniform mat4 matView;
+uniform mat4 matProjection;
 
-uniform float farPlane;     ///< Used to scale depth values ​​when reading the depth cubemap (point shadows)
+uniform float farPlane;   ///< Used to scale depth values ​​when reading the depth cubemap (point shadows)
+uniform bool linearOmniShadows;   ///< The omnilight shadow maps store the distance to the light (see RLG_UseLinearOmniShadows)
 
 uniform vec3 colAmbient;
 uniform vec3 viewPos;
 
+uniform vec3 ambientSH[9];   ///< L2 spherical harmonics of the ambient light (see RLG_SetAmbientSH)
+uniform bool useAmbientSH;
+
+// Features of the material, defined as constants by the prefix of the permutations
+// NOTE: The branches on these constants are removed by the compiler (see RLG_ShaderFlag)
+#ifndef PERMUTATION
+#define USE_ALBEDO_MAP (maps[ALBEDO].enabled != 0)
+#define USE_METALNESS_MAP (maps[METALNESS].enabled != 0)
+#define USE_NORMAL_MAP (maps[NORMAL].enabled != 0)
+#define USE_ROUGHNESS_MAP (maps[ROUGHNESS].enabled != 0)
+#define USE_OCCLUSION_MAP (maps[OCCLUSION].enabled != 0)
+#define USE_EMISSION_MAP (maps[EMISSION].enabled != 0)
+#define USE_HEIGHT_MAP (maps[HEIGHT].enabled != 0)
+#define USE_CUBEMAP (cubemaps[CUBEMAP].enabled != 0)
+#define USE_IRRADIANCE_MAP (cubemaps[IRRADIANCE].enabled != 0)
+#define USE_DEEP_PARALLAX (parallaxMinLayers > 0 && parallaxMaxLayers > 1)
+#define RECEIVE_SHADOW true
+#define USE_CLUSTERS (useClusters != 0)
+#endif
+
+// The split-sum reflection needs both the prefiltered cubemap and the BRDF LUT of the skybox
+#define USE_PREFILTER_MAP (USE_CUBEMAP && cubemaps[PREFILTER].enabled != 0 && maps[BRDF].enabled != 0)
+
 float DistributionGGX(float cosTheta, float alpha)
 {
     float a = cosTheta*alpha;
@@ -83,7 +144,7 @@ float DistributionGGX(float cosTheta, float alpha)
     return k*k*(1.0/PI);
 }
 
-// From Earl Hammon, Jr. PBR Diffuse Lighting for GGX+Smith Microsurfaces
+// From Earl Hammon, Jr. "PBR Diffuse Lighting for GGX+Smith Microsurfaces"
 // SEE: https://www.gdcvault.com/play/1024478/PBR-Diffuse-Lighting-for-GGX
 float GeometrySmith(float NdotL, float NdotV, float alpha)
 {
@@ -94,7 +155,7 @@ float SchlickFresnel(float u)
 {
     float m = 1.0 - u;
     float m2 = m*m;
-    return m2*m2*m; // pow(m,5)
+    return m2*m2*m;  // pow(m,5)
 }
 
 vec3 ComputeF0(float metallic, float specular, vec3 albedo)
@@ -105,9 +166,172 @@ vec3 ComputeF0(float metallic, float specular, vec3 albedo)
     return mix(vec3(dielectric), albedo, vec3(metallic));
 }
 
+struct LightData {  ///< Light parameters shared by the forward, clustered and deferred light loops
+    vec3 position;
+    vec3 direction;
+    vec3 color;  ///< Diffuse color of the light already multiplied by its energy
+    float specular;
+    float size;
+    float innerCutOff;
+    float outerCutOff;
+    float distance;
+    float attenuation;
+    lowp int type;
+};
+
+// Computes the diffuse and specular contributions of a light without its shadow,
+// returns the distance attenuation and spotlight factor to apply to them
+float ComputeLight(LightData light, vec3 N, vec3 V, float cNdotV, vec3 F0, float metalness, float roughness,
+    out vec3 diffLight, out vec3 specLight, out float cNdotL)
+{
+    float size_A = 0.0;
+    vec3 L = vec3(0.0);
+
+    // Compute the light direction vector
+    if (light.type != DIRLIGHT)
+    {
+        vec3 LV = light.position - fragPosition;
+        L = normalize(LV);
+
+        // If the light has a size, compute the attenuation factor based on the distance
+        if (light.size > 0.0)
+        {
+            float t = light.size/max(0.001, length(LV));
+            size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));
+        }
+    }
+    else
+    {
+        // For directional lights, use the negative direction as the light direction
+        L = normalize(-light.direction);
+    }
+
+    // Compute the dot product of the normal and light direction, adjusted by size_A
+    float NdotL = min(size_A + dot(N, L), 1.0);
+    cNdotL = max(NdotL, 0.0);  // clamped NdotL
+
+    // Compute the halfway vector between the view and light directions
+    vec3 H = normalize(V + L);
+    float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);
+    float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);
+
+    // Compute diffuse lighting (Burley model) if the material is not fully metallic
+    diffLight = vec3(0.0);
+    if (metalness < 1.0)
+    {
+        float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;
+        float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);
+        float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);
+
+        float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;
+        diffLight = diffBRDF*light.color;
+    }
+
+    // Compute specular lighting using the Schlick-GGX model
+    // NOTE: When roughness is 0, specular light should not be entirely disabled.
+    // TODO: Handle perfect mirror reflection when roughness is 0.
+    specLight = vec3(0.0);
+    if (roughness > 0.0)
+    {
+        float alphaGGX = roughness*roughness;
+        float D = DistributionGGX(cNdotH, alphaGGX);
+        float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);
+
+        float cLdotH5 = SchlickFresnel(cLdotH);
+        float F90 = clamp(50.0*F0.g, 0.0, 1.0);
+        vec3 F = F0 + (F90 - F0)*cLdotH5;
+
+        vec3 specBRDF = cNdotL*D*F*G;
+        specLight = specBRDF*light.color*light.specular;
+    }
+
+    float factor = 1.0;
+
+    // Apply attenuation based on the distance from the light
+    if (light.type != DIRLIGHT)
+    {
+        float distance = length(light.position - fragPosition);
+        float atten = 1.0 - clamp(distance/light.distance, 0.0, 1.0);
+        factor *= atten*light.attenuation;
+    }
+
+    // Apply spotlight effect if the light is a spotlight
+    if (light.type == SPOTLIGHT)
+    {
+        float theta = dot(L, normalize(-light.direction));
+        float epsilon = (light.innerCutOff - light.outerCutOff);
+        factor *= smoothstep(0.0, 1.0, (theta - light.outerCutOff)/epsilon);
+    }
+
+    return factor;
+}
+
+// Returns the coordinates of a direction in its cube face and the index of the face,
+// following the cubemap conventions used to render the faces (+X, -X, +Y, -Y, +Z, -Z)
+vec3 CubeFace(vec3 v)
+{
+    vec3 a = abs(v);
+
+    if (a.x >= a.y && a.x >= a.z)
+    {
+        return (v.x > 0.0) ? vec3(vec2(-v.z, -v.y)/a.x*0.5 + 0.5, 0.0) : vec3(vec2(v.z, -v.y)/a.x*0.5 + 0.5, 1.0);
+    }
+
+    if (a.y >= a.z)
+    {
+        return (v.y > 0.0) ? vec3(vec2(v.x, v.z)/a.y*0.5 + 0.5, 2.0) : vec3(vec2(v.x, -v.z)/a.y*0.5 + 0.5, 3.0);
+    }
+
+    return (v.z > 0.0) ? vec3(vec2(v.x, -v.y)/a.z*0.5 + 0.5, 4.0) : vec3(vec2(-v.x, -v.y)/a.z*0.5 + 0.5, 5.0);
+}
+
+// Returns the depth stored in the shadow map of an omnilight for a fragment at 'v' from the light,
+// 'bias' being subtracted in world units: the distance to the light scaled by the far plane,
+// or the hardware depth of the projection of the face, from the near plane to 'distance'
+float OmniDepth(vec3 v, float bias, float distance)
+{
+    if (linearOmniShadows) return (length(v) - bias)/farPlane;
+
+    vec3 a = abs(v);
+    float n = 0.01;    // RLG_SHADOW_NEAR_PLANE
+    float z = max(max(max(a.x, a.y), a.z) - bias, n);
+    return (distance + n - 2.0*distance*n/z)/(distance - n)*0.5 + 0.5;
+}
+
+// Compares 'depth' with the depth stored at 'uv' in a tile of the area of a light, returns 1.0 if lit,
+// the coordinates are clamped to the tile so that the filtering never reads the shadow map of another light
+float ShadowCompare(vec4 rect, float texel, vec2 tile, vec2 uv, float depth)
+{
+    uv = clamp(uv, vec2(0.5*texel), vec2(1.0 - 0.5*texel));
+    return texture(shadowAtlas, vec3(rect.xy + (tile + uv)*rect.zw, depth));
+}
+
+// Percentage closer filtering over 3x3 texels, with GLSL 330 each tap is filtered bilinearly
+// by the hardware, 4 taps placed between the texels then cover the same area as 9 fetches
+float ShadowPCF(vec4 rect, float texel, vec2 tile, vec2 uv, float depth)
+{
+    float shadow = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        vec2 offset = vec2(float(i%2), float(i/2)) - 0.5;
+        shadow += ShadowCompare(rect, texel, tile, uv + offset*texel, depth);
+    }
+    return shadow/4.0;
+}
+
+// Irradiance in the direction 'n' given by the spherical harmonics of the ambient light
+vec3 IrradianceSH(vec3 n)
+{
+    return ambientSH[0]
+        + ambientSH[1]*n.y + ambientSH[2]*n.z + ambientSH[3]*n.x
+        + ambientSH[4]*n.x*n.y + ambientSH[5]*n.y*n.z
+        + ambientSH[6]*(3.0*n.z*n.z - 1.0)
+        + ambientSH[7]*n.x*n.z + ambientSH[8]*(n.x*n.x - n.y*n.y);
+}
+
 vec2 Parallax(vec2 uv, vec3 V)
 {
-    float height = 1.0 - texture(maps[HEIGHT].texture, uv).r;
+    float height = 1.0 - TEX(mapTextures[HEIGHT], uv).r;
     return uv - vec2(V.xy/V.z)*height*maps[HEIGHT].value;
 }
 
@@ -125,18 +349,18 @@ vec2 DeepParallax(vec2 uv, vec3 V)
     vec2 deltaTexCoord = P/numLayers;
 
     vec2 currentUV = uv;
-    float currentDepthMapValue = 1.0 - texture(maps[HEIGHT].texture, currentUV).y;
-    
+    float currentDepthMapValue = 1.0 - TEX(mapTextures[HEIGHT], currentUV).y;
+
     while(currentLayerDepth < currentDepthMapValue)
     {
         currentUV += deltaTexCoord;
         currentLayerDepth += layerDepth;
-        currentDepthMapValue = 1.0 - texture(maps[HEIGHT].texture, currentUV).y;
+        currentDepthMapValue = 1.0 - TEX(mapTextures[HEIGHT], currentUV).y;
     }
 
     vec2 prevTexCoord = currentUV - deltaTexCoord;
     float afterDepth  = currentDepthMapValue + currentLayerDepth;
-    float beforeDepth = 1.0 - texture(maps[HEIGHT].texture,
+    float beforeDepth = 1.0 - TEX(mapTextures[HEIGHT],
         prevTexCoord).y - currentLayerDepth - layerDepth;
 
     float weight = afterDepth/(afterDepth - beforeDepth);
@@ -146,55 +370,56 @@ vec2 DeepParallax(vec2 uv, vec3 V)
 float ShadowOmni(int i, float cNdotL)
 {
     vec3 fragToLight = fragPosition - lights[i].position;
-    float closestDepth = texture(lights[i].shadowCubemap, fragToLight).r;
-    closestDepth *= farPlane; // Rescale depth
-    float currentDepth = length(fragToLight);
+    vec3 face = CubeFace(fragToLight);  // The faces are stored on 3 columns and 2 rows
+    vec2 tile = vec2(mod(face.z, 3.0), floor(face.z/3.0));
     float bias = lights[i].depthBias*max(1.0 - cNdotL, 0.05);
-    return currentDepth - bias > closestDepth ? 0.0 : 1.0;
+    float depth = OmniDepth(fragToLight, bias, lights[i].distance);
+    return ShadowCompare(lights[i].shadowRect, lights[i].shadowMapTxlSz, tile, face.xy, depth);
 }
 
 float Shadow(int i, float cNdotL)
 {
     vec4 p = fragPosLightSpace[i];
 
+    vec2 tile = vec2(0.0);
+
+    // Select the first cascade that ends beyond the view depth of the fragment, the cascades are stored on one row
+    if (lights[i].cascades > 1)
+    {
+        float viewZ = -(matView*vec4(fragPosition, 1.0)).z;
+        if (viewZ > cascadeSplits[i][lights[i].cascades - 1]) return 1.0;
+
+        int cascade = 0;
+        while (viewZ > cascadeSplits[i][cascade]) cascade++;
+
+        p = matCascades[i*4 + cascade]*vec4(fragPosition, 1.0);
+        tile.x = float(cascade);
+    }
+
     vec3 projCoords = p.xyz/p.w;
     projCoords = projCoords*0.5 + 0.5;
 
     float bias = max(lights[i].depthBias*(1.0 - cNdotL), 0.00002) + 0.00001;
     projCoords.z -= bias;
 
-    if (projCoords.z > 1.0 || projCoords.x > 1.0 || projCoords.y > 1.0)
+    if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.y < 0.0 || projCoords.x > 1.0 || projCoords.y > 1.0)
     {
         return 1.0;
     }
 
-    float depth = projCoords.z;
-    float shadow = 0.0;
-
-    // NOTE: You can increase iterations to improve PCF quality
-    for (int x = -1; x <= 1; x++)
-    {
-        for (int y = -1; y <= 1; y++)
-        {
-            float pcfDepth = texture(lights[i].shadowMap, projCoords.xy + vec2(x, y)*lights[i].shadowMapTxlSz).r;
-            shadow += step(depth, pcfDepth);
-        }
-    }
-
-    return shadow/9.0;
+    return ShadowPCF(lights[i].shadowRect, lights[i].shadowMapTxlSz, tile, projCoords.xy, projCoords.z);
 }
 
 void main()
 {
     // Compute the view direction vector for this fragment
-    vec3 V = normalize( viewPos  - fragPosition);
+    vec3 V = normalize(viewPos - fragPosition);
 
     // Compute fragTexCoord (UV), apply parallax if height map is enabled
     vec2 uv = fragTexCoord;
-    if (maps[HEIGHT].active != 0)
+    if (USE_HEIGHT_MAP)
     {
-        uv = (parallaxMinLayers > 0 && parallaxMaxLayers > 1)
-            ? DeepParallax(uv, V) : Parallax(uv, V);
+        uv = (USE_DEEP_PARALLAX) ? DeepParallax(uv, V) : Parallax(uv, V);
 
         if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0)
         {
@@ -204,25 +429,25 @@ void main()
 
     // Compute albedo (base color) by sampling the texture and multiplying by the diffuse color
     vec3 albedo = maps[ALBEDO].color.rgb*fragColor.rgb;
-    if (maps[ALBEDO].active != 0)
-        albedo *= texture(maps[ALBEDO].texture, uv).rgb;
+    if (USE_ALBEDO_MAP)
+        albedo *= TEX(mapTextures[ALBEDO], uv).rgb;
 
     // Compute metallic factor; if a metalness map is used, sample it
     float metalness = maps[METALNESS].value;
-    if (maps[METALNESS].active != 0)
-        metalness *= texture(maps[METALNESS].texture, uv).b;
+    if (USE_METALNESS_MAP)
+        metalness *= TEX(mapTextures[METALNESS], uv).b;
 
     // Compute roughness factor; if a roughness map is used, sample it
     float roughness = maps[ROUGHNESS].value;
-    if (maps[ROUGHNESS].active != 0)
-        roughness *= texture(maps[ROUGHNESS].texture, uv).g;
+    if (USE_ROUGHNESS_MAP)
+        roughness *= TEX(mapTextures[ROUGHNESS], uv).g;
 
     // Compute F0 (reflectance at normal incidence) based on the metallic factor
     vec3 F0 = ComputeF0(metalness, 0.5, albedo);
 
     // Compute the normal vector; if a normal map is used, transform it to tangent space
-    vec3 N = (maps[NORMAL].active == 0) ? normalize(fragNormal)
-        : normalize(TBN*(texture(maps[NORMAL].texture, uv).rgb*2.0 - 1.0));
+    vec3 N = (USE_NORMAL_MAP) ? normalize(TBN*(TEX(mapTextures[NORMAL], uv).rgb*2.0 - 1.0))
+        : normalize(fragNormal);
 
     // Compute the dot product of the normal and view direction
     float NdotV = dot(N, V);
@@ -232,142 +457,129 @@ void main()
     vec3 diffLighting = vec3(0.0);
     vec3 specLighting = vec3(0.0);
 
-    // Loop through all lights
+    // Loop through all lights (done by the lighting passes when rendering the G-buffer)
+#ifndef DEFERRED
     for (int i = 0; i < NUM_LIGHTS; i++)
     {
         if (lights[i].enabled != 0)
         {
-            float size_A = 0.0;
-            vec3 L = vec3(0.0);
+            LightData light = LightData(
+                lights[i].position, lights[i].direction, lights[i].color*lights[i].energy,
+                lights[i].specular, lights[i].size, lights[i].innerCutOff, lights[i].outerCutOff,
+                lights[i].distance, lights[i].attenuation, lights[i].type);
 
-            // Compute the light direction vector
-            if (lights[i].type != DIRLIGHT)
-            {
-                vec3 LV = lights[i].position - fragPosition;
-                L = normalize(LV);
-
-                // If the light has a size, compute the attenuation factor based on the distance
-                if (lights[i].size > 0.0)
-                {
-                    float t = lights[i].size/max(0.001, length(LV));
-                    size_A = max(0.0, 1.0 - 1.0/sqrt(1.0 + t*t));
-                }
-            }
-            else
+            vec3 diffLight, specLight; float cNdotL;
+            float factor = ComputeLight(light, N, V, cNdotV, F0, metalness, roughness, diffLight, specLight, cNdotL);
+
+            // Apply shadow factor if the light casts shadows
+            if (RECEIVE_SHADOW && lights[i].shadow != 0)
             {
-                // For directional lights, use the negative direction as the light direction
-                L = normalize(-lights[i].direction);
+                factor *= (lights[i].type == OMNILIGHT)
+                    ? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);
             }
 
-            // Compute the dot product of the normal and light direction, adjusted by size_A
-            float NdotL = min(size_A + dot(N, L), 1.0);
-            float cNdotL = max(NdotL, 0.0); // clamped NdotL
-
-            // Compute the halfway vector between the view and light directions
-            vec3 H = normalize(V + L);
-            float cNdotH = clamp(size_A + dot(N, H), 0.0, 1.0);
-            float cLdotH = clamp(size_A + dot(L, H), 0.0, 1.0);
+            // Accumulate the diffuse and specular lighting contributions
+            diffLighting += diffLight*factor;
+            specLighting += specLight*factor;
+        }
+    }
 
-            // Compute light color energy
-            vec3 lightColE = lights[i].color*lights[i].energy;
+    // Loop through the lights binned in the cluster of this fragment
+    if (USE_CLUSTERS)
+    {
+        vec4 viewPosition = matView*vec4(fragPosition, 1.0);
+        vec4 clipPosition = matProjection*viewPosition;
+        vec2 ndc = clamp(clipPosition.xy/clipPosition.w*0.5 + 0.5, 0.0, 0.999);
 
-            // Compute diffuse lighting (Burley model) if the material is not fully metallic
-            vec3 diffLight = vec3(0.0);
-            if (metalness < 1.0)
-            {
-                float FD90_minus_1 = 2.0*cLdotH*cLdotH*roughness - 0.5;
-                float FdV = 1.0 + FD90_minus_1*SchlickFresnel(cNdotV);
-                float FdL = 1.0 + FD90_minus_1*SchlickFresnel(cNdotL);
+        float viewZ = max(-viewPosition.z, 1e-4);
+        float slice = ((clusterDepth.z != 0.0) ? log(viewZ) : viewZ)*clusterDepth.x + clusterDepth.y;
 
-                float diffBRDF = (1.0/PI)*FdV*FdL*cNdotL;
-                diffLight = diffBRDF*lightColE;
-            }
+        ivec3 cell = ivec3(ivec2(ndc*vec2(clusterGrid.xy)), clamp(int(slice), 0, clusterGrid.z - 1));
+        int cluster = cell.x + clusterGrid.x*(cell.y + clusterGrid.y*cell.z);
 
-            // Compute specular lighting using the Schlick-GGX model
-            // NOTE: When roughness is 0, specular light should not be entirely disabled.
-            // TODO: Handle perfect mirror reflection when roughness is 0.
-            vec3 specLight = vec3(0.0);
-            if (roughness > 0.0)
-            {
-                float alphaGGX = roughness*roughness;
-                float D = DistributionGGX(cNdotH, alphaGGX);
-                float G = GeometrySmith(cNdotL, cNdotV, alphaGGX);
+        int offset = int(texelFetch(clusterItems, 2*cluster).r);
+        int count = int(texelFetch(clusterItems, 2*cluster + 1).r);
 
-                float cLdotH5 = SchlickFresnel(cLdotH);
-                float F90 = clamp(50.0*F0.g, 0.0, 1.0);
-                vec3 F = F0 + (F90 - F0)*cLdotH5;
-
-                vec3 specBRDF = cNdotL*D*F*G;
-                specLight = specBRDF*lightColE*lights[i].specular;
-            }
+        for (int k = 0; k < count; k++)
+        {
+            int index = 4*int(texelFetch(clusterItems, offset + k).r);
 
-            // Apply shadow factor if the light casts shadows
-            float shadow = 1.0;
-            if (lights[i].shadow != 0)
-            {
-                shadow = (lights[i].type == OMNILIGHT)
-                    ? ShadowOmni(i, cNdotL) : Shadow(i, cNdotL);
-            }
+            vec4 t0 = texelFetch(clusterLights, index);       // position, distance
+            vec4 t1 = texelFetch(clusterLights, index + 1);   // direction, type
+            vec4 t2 = texelFetch(clusterLights, index + 2);   // color*energy, specular
+            vec4 t3 = texelFetch(clusterLights, index + 3);   // size, innerCutOff, outerCutOff, attenuation
 
-            // Apply attenuation based on the distance from the light
-            if (lights[i].type != DIRLIGHT) {
-                float distance = length(lights[i].position - fragPosition);
-                float atten = 1.0 - clamp(distance / lights[i].distance, 0.0, 1.0);
-                shadow *= atten*lights[i].attenuation;
-            }
+            LightData light = LightData(t0.xyz, t1.xyz, t2.xyz, t2.w, t3.x, t3.y, t3.z, t0.w, t3.w, int(t1.w));
 
-            // Apply spotlight effect if the light is a spotlight
-            float intensity = 1.0;
-            if (lights[i].type == SPOTLIGHT)
-            {
-                float theta = dot(L, normalize(-lights[i].direction));
-                float epsilon = (lights[i].innerCutOff - lights[i].outerCutOff);
-                intensity = smoothstep(0.0, 1.0, (theta - lights[i].outerCutOff)/epsilon);
-            }
+            vec3 diffLight, specLight; float cNdotL;
+            float factor = ComputeLight(light, N, V, cNdotV, F0, metalness, roughness, diffLight, specLight, cNdotL);
 
-            // Accumulate the diffuse and specular lighting contributions
-            diffLighting += diffLight*shadow;
-            specLighting += specLight*shadow;
+            diffLighting += diffLight*factor;
+            specLighting += specLight*factor;
         }
     }
+#endif
 
     // Compute ambient
     vec3 ambient = colAmbient;
-    if (cubemaps[IRRADIANCE].active != 0)
+    if (useAmbientSH || USE_IRRADIANCE_MAP)
     {
         vec3 kS = F0 + (1.0 - F0)*SchlickFresnel(cNdotV);
         vec3 kD = (1.0 - kS)*(1.0 - metalness);
-        ambient = kD*texture(cubemaps[IRRADIANCE].texture, N).rgb;
+        ambient = kD*(useAmbientSH ? IrradianceSH(N) : TEXCUBE(cubemapTextures[IRRADIANCE], N).rgb);
     }
 
-    // Compute ambient occlusion
-    if (maps[OCCLUSION].active != 0)
+    // Compute ambient occlusion, also affects direct lighting according to the map value
+    float lightAffect = 1.0;
+    if (USE_OCCLUSION_MAP)
     {
-        float ao = texture(maps[OCCLUSION].texture, uv).r;
+        float ao = TEX(mapTextures[OCCLUSION], uv).r;
         ambient *= ao;
 
-        float lightAffect = mix(1.0, ao, maps[OCCLUSION].value);
-        diffLighting *= lightAffect;
-        specLighting *= lightAffect;
+        lightAffect = mix(1.0, ao, maps[OCCLUSION].value);
     }
 
-    // Skybox reflection
-    if (cubemaps[CUBEMAP].active != 0)
+    // Skybox reflection, the prefiltered radiance of the roughness is scaled by the BRDF LUT (split-sum),
+    // otherwise the specular lighting is blended with the mirror reflection according to the roughness
+    vec3 reflection = vec3(0.0);
+    float specAffect = lightAffect;
+    if (USE_PREFILTER_MAP)
     {
-        vec3 reflectCol = texture(cubemaps[CUBEMAP].texture, reflect(-V, N)).rgb;
-        specLighting = mix(specLighting, reflectCol, 1.0 - roughness);
+        vec3 prefiltered = TEXCUBELOD(cubemapTextures[PREFILTER], reflect(-V, N), roughness*PREFILTER_MAX_LOD).rgb;
+        vec2 brdf = TEX(mapTextures[BRDF], vec2(cNdotV, roughness)).rg;
+        reflection = prefiltered*(F0*brdf.x + brdf.y);
+    }
+    else if (USE_CUBEMAP)
+    {
+        vec3 reflectCol = TEXCUBE(cubemapTextures[CUBEMAP], reflect(-V, N)).rgb;
+        reflection = reflectCol*(1.0 - roughness);
+        specAffect *= roughness;
     }
-
-    // Compute the final diffuse color, including ambient and diffuse lighting contributions
-    vec3 diffuse = albedo*(ambient + diffLighting);
 
     // Compute emission color; if an emissive map is used, sample it
     vec3 emission = maps[EMISSION].color.rgb;
-    if (maps[EMISSION].active != 0)
+    if (USE_EMISSION_MAP)
     {
-        emission *= texture(maps[EMISSION].texture, uv).rgb;
+        emission *= TEX(mapTextures[EMISSION], uv).rgb;
     }
 
+#ifdef DEFERRED
+
+    // Write the surface to the G-buffer, the lighting passes will add the lights contributions
+    gAlbedo = vec4(albedo, 1.0);
+    gNormal = vec4(N, 1.0);
+    gORM = vec4(lightAffect, roughness, metalness, specAffect);
+    gEmission = vec4(albedo*ambient + reflection + emission, 1.0);
+
+#else
+
+    // Compute the final diffuse color, including ambient and diffuse lighting contributions
+    vec3 diffuse = albedo*(ambient + diffLighting*lightAffect);
+    vec3 specular = specLighting*specAffect + reflection;
+
     // Compute the final fragment color by combining diffuse, specular, and emission contributions
-    outColor = vec4(diffuse + specLighting + emission, 1.0);
+    _ = vec4(diffuse + specular + emission, 1.0);
+
+#endif
 }
+
@@ -1,6 +1,43 @@
-#version 330
+// NOTE: Same code as the model vertex shader embedded in rlights.h, it is compiled after the
+//       '#version' directive, the 'NUM_LIGHTS' definition (RLG_MAX_LIGHTS_PER_MATERIAL) and the
+//       permutation defines added by rlights.h (see RLG_SetCustomShaderCode)
 
-#define NUM_LIGHTS %i
+struct Light {
+    vec3 position;                ///< Position of the light in world coordinates
+    float energy;                 ///< Energy factor of the diffuse light color
+    vec3 direction;               ///< Direction vector of the light (for directional and spotlights)
+    float specular;               ///< Specular amount of the light
+    vec3 color;                   ///< Diffuse color of the light
+    float size;                   ///< Light size (spotlight, omnilight only)
+    float innerCutOff;            ///< Inner cutoff angle for spotlights (cosine of the angle)
+    float outerCutOff;            ///< Outer cutoff angle for spotlights (cosine of the angle)
+    float distance;               ///< Indicates the distance up to which the spotlights and omnilights shine
+    float attenuation;            ///< Light attenuation factor along the illumination distance of spotlights and omnilights
+    float shadowMapTxlSz;         ///< Texel size of the shadow map
+    float depthBias;              ///< Bias value to avoid self-shadowing artifacts
+    lowp int type;                ///< Type of the light (e.g., point, directional, spotlight)
+    lowp int shadow;              ///< Indicates if the light casts shadows (1 for true, 0 for false)
+    lowp int enabled;             ///< Indicates if the light is active (1 for true, 0 for false)
+    lowp int cascades;            ///< Number of shadow cascades of directional lights, 1 without cascades (GLSL 330 or higher)
+    vec4 shadowRect;              ///< Area of the light in the shadow atlas (offset and size of one tile in UV)
+};
+
+// NOTE: Must be identical in the vertex and fragment shaders, 4 is RLG_MAX_SHADOW_CASCADES
+layout(std140) uniform LightBlock {
+    Light lights[NUM_LIGHTS];
+    mat4 matLights[NUM_LIGHTS];
+    mat4 matCascades[NUM_LIGHTS*4];
+    vec4 cascadeSplits[NUM_LIGHTS]; ///< View depth at which each cascade ends
+};
+
+out vec4 fragPosLightSpace[NUM_LIGHTS];
+
+// NOTE: Only the permutations compiled for RLG_DrawMeshInstanced() read the instance matrices
+#ifndef PERMUTATION
+#define USE_INSTANCING false
+#endif
+
+in mat4 instanceTransform;
 
 in vec3 vertexPosition;
 in vec2 vertexTexCoord;
@@ -8,13 +45,11 @@ in vec4 vertexTangent;
 in vec3 vertexNormal;
 in vec4 vertexColor;
 
-uniform mat4 matLights[NUM_LIGHTS];
 uniform lowp int useNormalMap;
 uniform mat4 matNormal;
 uniform mat4 matModel;
 uniform mat4 mvp;
 
-out vec4 fragPosLightSpace[NUM_LIGHTS];
 out vec3 fragPosition;
 out vec2 fragTexCoord;
 out vec3 fragNormal;
@@ -23,15 +58,19 @@ out mat3 TBN;
 
 void main()
 {
-    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
-    fragNormal = (matNormal*vec4(vertexNormal, 0.0)).xyz;
+    // The instance matrices are streamed as raylib stores them (row-major), hence the transposition
+    mat4 modelMatrix = (USE_INSTANCING) ? transpose(instanceTransform) : matModel;
+    mat3 normalMatrix = (USE_INSTANCING) ? transpose(inverse(mat3(modelMatrix))) : mat3(matNormal);
 
-    fragTexCoord = vertexTexCoord ;
-    fragColor = vertexColor ;
+    fragPosition = vec3(modelMatrix*vec4(vertexPosition, 1.0));
+    fragNormal = normalMatrix*vertexNormal;
+
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
 
     // The TBN matrix is used to transform vectors from tangent space to world space
     // It is currently used to transform normals from a normal map to world space normals
-    vec3 T = normalize(vec3(matModel*vec4(vertexTangent.xyz, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix*vec4(vertexTangent.xyz, 0.0)));
     vec3 B = cross(fragNormal, T)*vertexTangent.w;
     TBN = mat3(T, B, fragNormal);
 
@@ -40,5 +79,7 @@ void main()
         fragPosLightSpace[i] = matLights[i]*vec4(fragPosition, 1.0);
     }
 
-    gl_Position = mvp*vec4(vertexPosition, 1.0);
+    // NOTE: The MVP of an instanced draw does not contain the model matrix
+    gl_Position = mvp*((USE_INSTANCING) ? modelMatrix*vec4(vertexPosition, 1.0) : vec4(vertexPosition, 1.0));
 }
+